@@ -0,0 +1,64 @@
+#pragma once
+
+#include <indium/base.hpp>
+#include <indium/types.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace Indium {
+	class Device;
+	class Buffer;
+	class Texture;
+	class SamplerState;
+
+	struct ArgumentDescriptor {
+		DataType dataType = DataType::None;
+		size_t index = 0;
+		size_t arrayLength = 0;
+		BindingAccess access = BindingAccess::ReadOnly;
+		TextureType textureType = TextureType::e2D;
+		size_t constantBlockAlignment = 0;
+	};
+
+	/**
+	 * Argument encoders write resources into argument buffers.
+	 *
+	 * Buffers are encoded as their GPU addresses and textures and samplers are encoded as their resource IDs,
+	 * so a whole set of resources can be bound with a single buffer binding.
+	 * Note that (as in Metal) argument buffers don't keep the resources they reference alive;
+	 * use `useResource()` on the encoder that uses the argument buffer to make sure they stay alive until the command buffer completes.
+	 *
+	 * Limitations (these throw when the argument buffer is described or used, rather than misbehaving later):
+	 *   - argument buffers must be CPU-accessible (i.e. not use StorageMode::Private), since they're encoded directly into their contents.
+	 *   - textures must only be sampled or read (writable textures need descriptors of their own), and they can't be multisampled textures or texture buffers.
+	 *   - textures and samplers need a device that supports descriptor indexing, since they're looked up in a device-wide table.
+	 *   - nested argument encoders aren't supported; a nested argument buffer can still be encoded with its own encoder
+	 *     (created with Device::newArgumentEncoder()) and set with `setBuffer()`, since buffers are encoded as their addresses.
+	 */
+	class ArgumentEncoder {
+	public:
+		virtual ~ArgumentEncoder() = 0;
+
+		virtual std::shared_ptr<Device> device() = 0;
+
+		virtual size_t encodedLength() const = 0;
+		virtual size_t alignment() const = 0;
+
+		virtual void setArgumentBuffer(std::shared_ptr<Buffer> argumentBuffer, size_t offset) = 0;
+		virtual void setArgumentBuffer(std::shared_ptr<Buffer> argumentBuffer, size_t startOffset, size_t arrayElement) = 0;
+
+		virtual void setBuffer(std::shared_ptr<Buffer> buffer, size_t offset, size_t index) = 0;
+		virtual void setBuffers(const std::vector<std::shared_ptr<Buffer>>& buffers, const std::vector<size_t>& offsets, Range<size_t> range) = 0;
+
+		virtual void setTexture(std::shared_ptr<Texture> texture, size_t index) = 0;
+		virtual void setTextures(const std::vector<std::shared_ptr<Texture>>& textures, Range<size_t> range) = 0;
+
+		virtual void setSamplerState(std::shared_ptr<SamplerState> sampler, size_t index) = 0;
+		virtual void setSamplerStates(const std::vector<std::shared_ptr<SamplerState>>& samplers, Range<size_t> range) = 0;
+
+		virtual void* constantData(size_t index) = 0;
+
+		virtual std::shared_ptr<ArgumentEncoder> newArgumentEncoder(size_t index) = 0;
+	};
+};
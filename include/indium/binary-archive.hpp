@@ -1,6 +1,35 @@
 #pragma once
 
+#include <memory>
+#include <string>
+
 namespace Indium {
+	class Device;
+	struct RenderPipelineDescriptor;
+	struct ComputePipelineDescriptor;
+
+	struct BinaryArchiveDescriptor {
+		/**
+		 * The file to load the archive from. If this is empty, a new empty archive is created.
+		 *
+		 * Creating the archive throws if the file isn't a binary archive or if it was written by an incompatible version of Indium
+		 * (in which case it should be regenerated).
+		 */
+		std::string url;
+	};
+
 	class BinaryArchive {
+	public:
+		virtual ~BinaryArchive() = 0;
+
+		virtual std::shared_ptr<Device> device() = 0;
+
+		virtual void addRenderPipelineFunctions(const RenderPipelineDescriptor& descriptor) = 0;
+		virtual void addComputePipelineFunctions(const ComputePipelineDescriptor& descriptor) = 0;
+
+		/**
+		 * Writes the archive to the given file, replacing it if it already exists.
+		 */
+		virtual void serializeToURL(const std::string& url) = 0;
 	};
 };
@@ -10,6 +10,7 @@
 namespace Indium {
 	class Texture;
 	class Buffer;
+	class Fence;
 
 	// TODO: check what the actual value is (this is just a good guess)
 	static constexpr size_t counterDontSample = SIZE_MAX;
@@ -36,5 +37,8 @@ namespace Indium {
 		virtual void copy(std::shared_ptr<Texture> source, size_t sourceSlice, size_t sourceLevel, Origin sourceOrigin, Size sourceSize, std::shared_ptr<Texture> destination, size_t destinationSlice, size_t destinationLevel, Origin destinationOrigin) = 0;
 		virtual void fillBuffer(std::shared_ptr<Buffer> buffer, Range<size_t> range, uint8_t value) = 0;
 		virtual void generateMipmapsForTexture(std::shared_ptr<Texture> texture) = 0;
+
+		virtual void updateFence(std::shared_ptr<Fence> fence) = 0;
+		virtual void waitForFence(std::shared_ptr<Fence> fence) = 0;
 	};
 };
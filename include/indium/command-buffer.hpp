@@ -12,6 +12,7 @@ namespace Indium {
 	class CommandQueue;
 	class Device;
 	class Drawable;
+	class Event;
 
 	class CommandBuffer {
 	public:
@@ -27,6 +28,9 @@ namespace Indium {
 		virtual void commit() = 0;
 		virtual void presentDrawable(std::shared_ptr<Drawable> drawable) = 0;
 
+		virtual void encodeSignalEvent(std::shared_ptr<Event> event, uint64_t value) = 0;
+		virtual void encodeWaitForEvent(std::shared_ptr<Event> event, uint64_t value) = 0;
+
 		using Handler = std::function<void(std::shared_ptr<CommandBuffer>)>;
 		virtual void addScheduledHandler(Handler handler) = 0;
 		virtual void addCompletedHandler(Handler handler) = 0;
@@ -34,5 +38,7 @@ namespace Indium {
 
 		virtual std::shared_ptr<CommandQueue> commandQueue() = 0;
 		virtual std::shared_ptr<Device> device() = 0;
+
+		virtual bool retainedReferences() const = 0;
 	};
 };
@@ -12,6 +12,12 @@ namespace Indium {
 
 		virtual std::shared_ptr<CommandBuffer> commandBuffer() = 0;
 
+		/**
+		 * Creates a command buffer that doesn't keep the resources used by its commands alive.
+		 * The caller is responsible for keeping them alive until the command buffer completes.
+		 */
+		virtual std::shared_ptr<CommandBuffer> commandBufferWithUnretainedReferences() = 0;
+
 		virtual std::shared_ptr<Device> device() = 0;
 	};
 };
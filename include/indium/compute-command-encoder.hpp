@@ -12,6 +12,9 @@ namespace Indium {
 	class Buffer;
 	class SamplerState;
 	class Texture;
+	class Fence;
+	class Resource;
+	class IndirectCommandBuffer;
 
 	struct ComputePassSampleBufferAttachmentDescriptor {
 		std::shared_ptr<CounterSampleBuffer> sampleBuffer;
@@ -48,10 +51,26 @@ namespace Indium {
 		virtual void dispatchThreadgroups(Size threadgroupsPerGrid, Size threadsPerThreadgroup) = 0;
 		virtual void dispatchThreads(Size threadsPerGrid, Size threadsPerThreadgroup) = 0;
 
+		/**
+		 * Dispatches a grid whose size (in threadgroups) is read from a buffer (laid out like Metal's `MTLDispatchThreadgroupsIndirectArguments`).
+		 */
+		virtual void dispatchThreadgroups(std::shared_ptr<Buffer> indirectBuffer, size_t indirectBufferOffset, Size threadsPerThreadgroup) = 0;
+
+		/**
+		 * Executes the given range of commands from an indirect command buffer; see RenderCommandEncoder::executeCommandsInBuffer().
+		 */
+		virtual void executeCommandsInBuffer(std::shared_ptr<IndirectCommandBuffer> indirectCommandBuffer, Range<size_t> executionRange) = 0;
+
 		virtual void setImageblockSize(size_t width, size_t height) = 0;
 
 		virtual void setStageInRegion(Region region) = 0;
 
 		virtual DispatchType dispatchType() = 0;
+
+		virtual void useResource(std::shared_ptr<Resource> resource, ResourceUsage usage) = 0;
+		virtual void useResources(const std::vector<std::shared_ptr<Resource>>& resources, ResourceUsage usage) = 0;
+
+		virtual void updateFence(std::shared_ptr<Fence> fence) = 0;
+		virtual void waitForFence(std::shared_ptr<Fence> fence) = 0;
 	};
 };
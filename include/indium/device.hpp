@@ -6,6 +6,7 @@
 #include <indium/init.hpp>
 #include <indium/base.hpp>
 #include <indium/types.hpp>
+#include <indium/pipeline.hpp>
 
 namespace Indium {
 	class CommandQueue;
@@ -23,6 +24,16 @@ namespace Indium {
 	struct ComputePipelineDescriptor;
 	class ComputePipelineReflection;
 	class Function;
+	class Fence;
+	class Event;
+	class SharedEvent;
+	struct SharedEventHandle;
+	class BinaryArchive;
+	struct BinaryArchiveDescriptor;
+	class ArgumentEncoder;
+	struct ArgumentDescriptor;
+	class IndirectCommandBuffer;
+	struct IndirectCommandBufferDescriptor;
 
 	class Device {
 	public:
@@ -34,12 +45,47 @@ namespace Indium {
 		virtual std::shared_ptr<RenderPipelineState> newRenderPipelineState(const RenderPipelineDescriptor& descriptor) = 0;
 		virtual std::shared_ptr<ComputePipelineState> newComputePipelineState(const ComputePipelineDescriptor& descriptor, PipelineOption options, std::shared_ptr<ComputePipelineReflection> reflection) = 0;
 		virtual std::shared_ptr<ComputePipelineState> newComputePipelineState(std::shared_ptr<Function> computeFunction, PipelineOption options = PipelineOption::None, std::shared_ptr<ComputePipelineReflection> reflection = nullptr) = 0;
+
+		// asynchronous pipeline state creation; these return immediately and create the pipeline state on an internal thread pool
+		virtual std::shared_ptr<CompileTask> newRenderPipelineState(const RenderPipelineDescriptor& descriptor, NewRenderPipelineStateCompletionHandler completionHandler, CompilePriority priority = CompilePriority::Normal) = 0;
+		// note: `priority` doesn't have a default here because `newComputePipelineState(descriptor, options, nullptr)` would be ambiguous otherwise
+		virtual std::shared_ptr<CompileTask> newComputePipelineState(const ComputePipelineDescriptor& descriptor, PipelineOption options, NewComputePipelineStateCompletionHandler completionHandler, CompilePriority priority) = 0;
+		virtual std::shared_ptr<CompileTask> newComputePipelineState(std::shared_ptr<Function> computeFunction, NewComputePipelineStateCompletionHandler completionHandler, CompilePriority priority = CompilePriority::Normal) = 0;
+
 		virtual std::shared_ptr<Buffer> newBuffer(size_t length, ResourceOptions options) = 0;
 		virtual std::shared_ptr<Buffer> newBuffer(const void* pointer, size_t length, ResourceOptions options) = 0;
 		virtual std::shared_ptr<Library> newLibrary(const void* data, size_t length) = 0;
 		virtual std::shared_ptr<Texture> newTexture(const TextureDescriptor& descriptor) = 0;
 		virtual std::shared_ptr<SamplerState> newSamplerState(const SamplerDescriptor& descriptor) = 0;
 		virtual std::shared_ptr<DepthStencilState> newDepthStencilState(const DepthStencilDescriptor& descriptor) = 0;
+		virtual std::shared_ptr<Fence> newFence() = 0;
+		virtual std::shared_ptr<Event> newEvent() = 0;
+		virtual std::shared_ptr<SharedEvent> newSharedEvent() = 0;
+		virtual std::shared_ptr<SharedEvent> newSharedEvent(const SharedEventHandle& handle) = 0;
+		virtual std::shared_ptr<BinaryArchive> newBinaryArchive(const BinaryArchiveDescriptor& descriptor) = 0;
+		virtual std::shared_ptr<ArgumentEncoder> newArgumentEncoder(const std::vector<ArgumentDescriptor>& arguments) = 0;
+		virtual std::shared_ptr<IndirectCommandBuffer> newIndirectCommandBuffer(const IndirectCommandBufferDescriptor& descriptor, size_t maxCommandCount, ResourceOptions options) = 0;
+
+		// --- pipeline prewarming ---
+
+		/**
+		 * Starts recording every pipeline state used on this device (along with the pipeline variants each one actually needs) into a pipeline manifest.
+		 */
+		virtual void startPipelineRecording() = 0;
+
+		/**
+		 * Stops recording and writes the recorded pipeline manifest to the given URL.
+		 */
+		virtual void stopPipelineRecording(const std::string& manifestURL) = 0;
+
+		/**
+		 * Compiles all the pipelines in the given pipeline manifest on background threads.
+		 * Pipeline states created afterwards with the same descriptors reuse these pipelines instead of compiling their own.
+		 *
+		 * @note Pipelines are only prewarmed for libraries that have already been loaded on this device
+		 *       (either with newLibrary() or by loading a binary archive that contains them); all others are skipped.
+		 */
+		virtual void prewarm(const std::string& manifestURL) = 0;
 
 		// --- support api ---
 
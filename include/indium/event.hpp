@@ -0,0 +1,45 @@
+#pragma once
+
+#include <memory>
+#include <functional>
+#include <cstdint>
+
+namespace Indium {
+	class Device;
+
+	class Event {
+	public:
+		virtual ~Event() = 0;
+
+		virtual std::shared_ptr<Device> device() = 0;
+	};
+
+	/**
+	 * A handle that can be used to share an event with another process (or another device).
+	 *
+	 * The file descriptor is owned by whoever holds the handle. Importing it with `Device::newSharedEvent` transfers
+	 * ownership of it to the new event.
+	 */
+	struct SharedEventHandle {
+		int fd = -1;
+	};
+
+	class SharedEvent: public Event {
+	public:
+		using NotificationHandler = std::function<void(std::shared_ptr<SharedEvent>, uint64_t)>;
+
+		virtual ~SharedEvent() = 0;
+
+		virtual uint64_t signaledValue() = 0;
+		virtual void setSignaledValue(uint64_t value) = 0;
+
+		/**
+		 * Invokes the given handler once the event reaches the given value.
+		 *
+		 * @note Just like command buffer completion handlers, handlers are invoked from the device's event loop (see `Device::pollEvents`).
+		 */
+		virtual void notifyListener(uint64_t value, NotificationHandler handler) = 0;
+
+		virtual SharedEventHandle newSharedEventHandle() = 0;
+	};
+};
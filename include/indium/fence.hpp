@@ -0,0 +1,14 @@
+#pragma once
+
+#include <memory>
+
+namespace Indium {
+	class Device;
+
+	class Fence {
+	public:
+		virtual ~Fence() = 0;
+
+		virtual std::shared_ptr<Device> device() = 0;
+	};
+};
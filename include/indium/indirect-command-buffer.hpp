@@ -0,0 +1,79 @@
+#pragma once
+
+#include <indium/base.hpp>
+#include <indium/resource.hpp>
+#include <indium/types.hpp>
+
+#include <memory>
+
+namespace Indium {
+	class Buffer;
+	class RenderPipelineState;
+	class ComputePipelineState;
+
+	enum class IndirectCommandType: size_t {
+		Draw                      = 1 << 0,
+		DrawIndexed               = 1 << 1,
+		DrawPatches               = 1 << 2,
+		DrawIndexedPatches        = 1 << 3,
+		ConcurrentDispatch        = 1 << 5,
+		ConcurrentDispatchThreads = 1 << 6,
+	};
+	INDIUM_BITFLAG_ENUM_CLASS(IndirectCommandType);
+
+	struct IndirectCommandBufferDescriptor {
+		IndirectCommandType commandTypes = IndirectCommandType::Draw;
+		bool inheritPipelineState = true;
+		bool inheritBuffers = true;
+		size_t maxVertexBufferBindCount = 0;
+		size_t maxFragmentBufferBindCount = 0;
+		size_t maxKernelBufferBindCount = 0;
+	};
+
+	class IndirectRenderCommand {
+	public:
+		virtual ~IndirectRenderCommand() = 0;
+
+		virtual void setRenderPipelineState(std::shared_ptr<RenderPipelineState> pipelineState) = 0;
+		virtual void setVertexBuffer(std::shared_ptr<Buffer> buffer, size_t offset, size_t index) = 0;
+		virtual void setFragmentBuffer(std::shared_ptr<Buffer> buffer, size_t offset, size_t index) = 0;
+
+		virtual void drawPrimitives(PrimitiveType primitiveType, size_t vertexStart, size_t vertexCount, size_t instanceCount, size_t baseInstance) = 0;
+		virtual void drawIndexedPrimitives(PrimitiveType primitiveType, size_t indexCount, IndexType indexType, std::shared_ptr<Buffer> indexBuffer, size_t indexBufferOffset, size_t instanceCount, int64_t baseVertex, size_t baseInstance) = 0;
+
+		virtual void reset() = 0;
+	};
+
+	class IndirectComputeCommand {
+	public:
+		virtual ~IndirectComputeCommand() = 0;
+
+		virtual void setComputePipelineState(std::shared_ptr<ComputePipelineState> pipelineState) = 0;
+		virtual void setKernelBuffer(std::shared_ptr<Buffer> buffer, size_t offset, size_t index) = 0;
+
+		virtual void concurrentDispatchThreadgroups(Size threadgroupsPerGrid, Size threadsPerThreadgroup) = 0;
+		virtual void concurrentDispatchThreads(Size threadsPerGrid, Size threadsPerThreadgroup) = 0;
+
+		virtual void reset() = 0;
+	};
+
+	/**
+	 * Indirect command buffers hold commands that are encoded once and then executed any number of times
+	 * (with `executeCommandsInBuffer()` on a render or compute command encoder).
+	 *
+	 * Commands are encoded on the CPU with the objects returned by `indirectRenderCommandAtIndex()` and `indirectComputeCommandAtIndex()`
+	 * and stay in the buffer until they're reset or overwritten, so static scenes don't need to be re-encoded every frame.
+	 * Unlike argument buffers, the commands keep the resources they reference alive for as long as they're in the buffer.
+	 */
+	class IndirectCommandBuffer: public Resource {
+	public:
+		virtual ~IndirectCommandBuffer() = 0;
+
+		virtual size_t size() const = 0;
+
+		virtual std::shared_ptr<IndirectRenderCommand> indirectRenderCommandAtIndex(size_t commandIndex) = 0;
+		virtual std::shared_ptr<IndirectComputeCommand> indirectComputeCommandAtIndex(size_t commandIndex) = 0;
+
+		virtual void reset(Range<size_t> range) = 0;
+	};
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <indium/argument-encoder.hpp>
 #include <indium/base.hpp>
 #include <indium/binary-archive.hpp>
 #include <indium/blit-command-encoder.hpp>
@@ -13,6 +14,9 @@
 #include <indium/depth-stencil.hpp>
 #include <indium/device.hpp>
 #include <indium/drawable.hpp>
+#include <indium/event.hpp>
+#include <indium/fence.hpp>
+#include <indium/indirect-command-buffer.hpp>
 #include <indium/init.hpp>
 #include <indium/library.hpp>
 #include <indium/linked-functions.hpp>
@@ -9,6 +9,7 @@
 namespace Indium {
 	class Device;
 	class Library;
+	class ArgumentEncoder;
 
 	class Function {
 	public:
@@ -16,6 +17,11 @@ namespace Indium {
 
 		virtual std::shared_ptr<Device> device() = 0;
 
+		/**
+		 * Creates an argument encoder for the argument buffer that the function expects at the given buffer index.
+		 */
+		virtual std::shared_ptr<ArgumentEncoder> newArgumentEncoder(size_t bufferIndex) = 0;
+
 		INDIUM_PROPERTY_READONLY(std::string, n, N,ame);
 	};
 
@@ -3,10 +3,43 @@
 #include <indium/base.hpp>
 #include <indium/types.hpp>
 
+#include <exception>
+#include <functional>
 #include <memory>
 
 namespace Indium {
+	class RenderPipelineState;
+	class ComputePipelineState;
+
 	struct PipelineBufferDescriptor {
 		Mutability mutability = Mutability::Default;
 	};
+
+	enum class CompilePriority {
+		Low,
+		Normal,
+		High,
+	};
+
+	/**
+	 * A handle to a pipeline state being created asynchronously.
+	 */
+	class CompileTask {
+	public:
+		virtual ~CompileTask() = 0;
+
+		/**
+		 * Cancels the task if it hasn't started yet.
+		 *
+		 * @returns `true` if the task was cancelled, in which case its completion handler will never be called.
+		 */
+		virtual bool cancel() = 0;
+	};
+
+	/**
+	 * Called once the pipeline state has been created. If creation failed, the pipeline state is null and the exception is set instead.
+	 * Note that completion handlers are called on an internal compilation thread.
+	 */
+	using NewRenderPipelineStateCompletionHandler = std::function<void(std::shared_ptr<RenderPipelineState> renderPipelineState, std::exception_ptr error)>;
+	using NewComputePipelineStateCompletionHandler = std::function<void(std::shared_ptr<ComputePipelineState> computePipelineState, std::exception_ptr error)>;
 };
@@ -14,6 +14,19 @@ namespace Indium {
 	class DepthStencilState;
 	class SamplerState;
 	class Resource;
+	class Fence;
+	class IndirectCommandBuffer;
+
+	/**
+	 * Statistics about the commands an encoder has recorded so far.
+	 *
+	 * Commands that wouldn't change any state (e.g. setting the same cull mode twice or re-binding the same vertex buffers)
+	 * are filtered out by the encoder and counted as elided instead of recorded.
+	 */
+	struct RenderCommandCounters {
+		size_t recordedCommands = 0;
+		size_t elidedCommands = 0;
+	};
 
 	class RenderCommandEncoder: public CommandEncoder {
 	public:
@@ -45,6 +58,40 @@ namespace Indium {
 		virtual void drawIndexedPrimitives(PrimitiveType primitiveType, size_t indexCount, IndexType indexType, std::shared_ptr<Buffer> indexBuffer, size_t indexBufferOffset, size_t instanceCount) = 0;
 		virtual void drawIndexedPrimitives(PrimitiveType primitiveType, size_t indexCount, IndexType indexType, std::shared_ptr<Buffer> indexBuffer, size_t indexBufferOffset) = 0;
 
+		/**
+		 * Draws with arguments read from a buffer (laid out like Metal's `MTLDrawPrimitivesIndirectArguments`).
+		 */
+		virtual void drawPrimitives(PrimitiveType primitiveType, std::shared_ptr<Buffer> indirectBuffer, size_t indirectBufferOffset) = 0;
+
+		/**
+		 * Draws with arguments read from a buffer (laid out like Metal's `MTLDrawIndexedPrimitivesIndirectArguments`).
+		 */
+		virtual void drawIndexedPrimitives(PrimitiveType primitiveType, IndexType indexType, std::shared_ptr<Buffer> indexBuffer, size_t indexBufferOffset, std::shared_ptr<Buffer> indirectBuffer, size_t indirectBufferOffset) = 0;
+
+		/**
+		 * Indium extension: issues multiple indirect draws with a single command.
+		 *
+		 * The indirect buffer contains a tightly-packed array of `MTLDrawPrimitivesIndirectArguments`-style structures and
+		 * the number of draws to perform is read (as a `uint32_t`) from the count buffer on the GPU, clamped to `maxDrawCount`.
+		 * This lets GPU-driven pipelines (e.g. culling in a compute pass) generate draws without a round-trip to the CPU.
+		 *
+		 * @note This requires the device to support indirect draw counts (Vulkan's `drawIndirectCount` and `multiDrawIndirect` features).
+		 */
+		virtual void drawPrimitives(PrimitiveType primitiveType, std::shared_ptr<Buffer> indirectBuffer, size_t indirectBufferOffset, std::shared_ptr<Buffer> countBuffer, size_t countBufferOffset, size_t maxDrawCount) = 0;
+
+		/**
+		 * Indium extension: the indexed version of the multi-draw drawPrimitives() above, using `MTLDrawIndexedPrimitivesIndirectArguments`-style structures.
+		 */
+		virtual void drawIndexedPrimitives(PrimitiveType primitiveType, IndexType indexType, std::shared_ptr<Buffer> indexBuffer, size_t indexBufferOffset, std::shared_ptr<Buffer> indirectBuffer, size_t indirectBufferOffset, std::shared_ptr<Buffer> countBuffer, size_t countBufferOffset, size_t maxDrawCount) = 0;
+
+		/**
+		 * Executes the given range of commands from an indirect command buffer.
+		 *
+		 * State the indirect command buffer doesn't set itself (i.e. state it inherits) is taken from the encoder.
+		 * The encoder's own pipeline state and buffer bindings are unaffected by this.
+		 */
+		virtual void executeCommandsInBuffer(std::shared_ptr<IndirectCommandBuffer> indirectCommandBuffer, Range<size_t> executionRange) = 0;
+
 		virtual void setVertexBytes(const void* bytes, size_t length, size_t index) = 0;
 		virtual void setVertexBuffer(std::shared_ptr<Buffer> buffer, size_t offset, size_t index) = 0;
 		virtual void setVertexBuffers(const std::vector<std::shared_ptr<Buffer>>& buffers, const std::vector<size_t>& offsets, Range<size_t> range) = 0;
@@ -71,5 +118,10 @@ namespace Indium {
 		virtual void useResources(const std::vector<std::shared_ptr<Resource>>& resources, ResourceUsage usage, RenderStages stages) = 0;
 		virtual void useResource(std::shared_ptr<Resource> resource, ResourceUsage usage) = 0;
 		virtual void useResources(const std::vector<std::shared_ptr<Resource>>& resources, ResourceUsage usage) = 0;
+
+		virtual void updateFence(std::shared_ptr<Fence> fence, RenderStages afterStages) = 0;
+		virtual void waitForFence(std::shared_ptr<Fence> fence, RenderStages beforeStages) = 0;
+
+		virtual RenderCommandCounters commandCounters() const = 0;
 	};
 };
@@ -17,6 +17,8 @@ namespace Indium {
 		size_t slice = 0;
 		size_t depthPlane = 0;
 		std::shared_ptr<Texture> resolveTexture;
+		// any level can be resolved into, but only 2D array textures can be resolved into slices other than 0,
+		// and resolving into depth planes other than 0 isn't supported (render command encoders throw when they're created otherwise)
 		size_t resolveLevel = 0;
 		size_t resolveSlice = 0;
 		size_t resolveDepthPlane = 0;
@@ -46,7 +48,8 @@ namespace Indium {
 
 	struct RenderPassDepthAttachmentDescriptor: public RenderPassAttachmentDescriptor {
 		double clearDepth;
-		MultisampleDepthResolveFilter depthResolveFilter;
+		// `Min` and `Max` are only available on devices that support them natively (render command encoders throw when they're created otherwise)
+		MultisampleDepthResolveFilter depthResolveFilter = MultisampleDepthResolveFilter::Sample0;
 	};
 
 	struct RenderPassStencilAttachmentDescriptor: public RenderPassAttachmentDescriptor {
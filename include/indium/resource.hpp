@@ -1,5 +1,7 @@
 #pragma once
 
+#include <indium/types.hpp>
+
 #include <memory>
 
 namespace Indium {
@@ -10,6 +12,7 @@ namespace Indium {
 		virtual ~Resource() = 0;
 
 		virtual std::shared_ptr<Device> device() = 0;
+		virtual HazardTrackingMode hazardTrackingMode() const = 0;
 
 		// TODO: other properties
 	};
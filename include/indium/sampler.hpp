@@ -31,5 +31,12 @@ namespace Indium {
 		virtual ~SamplerState() = 0;
 
 		virtual std::shared_ptr<Device> device() = 0;
+
+		/**
+		 * Returns the sampler's resource ID, which can be written into argument buffers directly.
+		 *
+		 * @note This throws on devices that don't support descriptor indexing.
+		 */
+		virtual ResourceID gpuResourceID() = 0;
 	};
 };
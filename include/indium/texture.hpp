@@ -71,6 +71,13 @@ namespace Indium {
 		virtual bool shareable() const = 0;
 		virtual TextureSwizzleChannels swizzle() const = 0;
 
+		/**
+		 * Returns the texture's resource ID, which can be written into argument buffers directly.
+		 *
+		 * @note This throws on devices that don't support descriptor indexing.
+		 */
+		virtual ResourceID gpuResourceID() = 0;
+
 		// derived classes can optionally implement these
 		//
 		// the default implementations return `nullptr` and `0` (as appropriate)
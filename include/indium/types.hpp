@@ -661,6 +661,81 @@ namespace Indium {
 		ThreadPositionInGridYIndexed = 8,
 	};
 
+	enum class DataType: size_t {
+		None = 0,
+		Struct = 1,
+		Array = 2,
+		Float = 3,
+		Float2 = 4,
+		Float3 = 5,
+		Float4 = 6,
+		Float2x2 = 7,
+		Float2x3 = 8,
+		Float2x4 = 9,
+		Float3x2 = 10,
+		Float3x3 = 11,
+		Float3x4 = 12,
+		Float4x2 = 13,
+		Float4x3 = 14,
+		Float4x4 = 15,
+		Half = 16,
+		Half2 = 17,
+		Half3 = 18,
+		Half4 = 19,
+		Int = 29,
+		Int2 = 30,
+		Int3 = 31,
+		Int4 = 32,
+		UInt = 33,
+		UInt2 = 34,
+		UInt3 = 35,
+		UInt4 = 36,
+		Short = 37,
+		Short2 = 38,
+		Short3 = 39,
+		Short4 = 40,
+		UShort = 41,
+		UShort2 = 42,
+		UShort3 = 43,
+		UShort4 = 44,
+		Char = 45,
+		Char2 = 46,
+		Char3 = 47,
+		Char4 = 48,
+		UChar = 49,
+		UChar2 = 50,
+		UChar3 = 51,
+		UChar4 = 52,
+		Bool = 53,
+		Bool2 = 54,
+		Bool3 = 55,
+		Bool4 = 56,
+		Texture = 58,
+		Sampler = 59,
+		Pointer = 60,
+		Long = 81,
+		Long2 = 82,
+		Long3 = 83,
+		Long4 = 84,
+		ULong = 85,
+		ULong2 = 86,
+		ULong3 = 87,
+		ULong4 = 88,
+	};
+
+	enum class BindingAccess: size_t {
+		ReadOnly = 0,
+		ReadWrite = 1,
+		WriteOnly = 2,
+	};
+
+	/**
+	 * An opaque handle to a texture or sampler that can be written into argument buffers directly (see Texture::gpuResourceID() and SamplerState::gpuResourceID()).
+	 */
+	struct ResourceID {
+		uint64_t impl = 0;
+	};
+
 	enum class PipelineOption: size_t {
 		None = 0,
 		ArgumentInfo = 1 << 0,
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 
 #include <vector>
 #include <unordered_map>
@@ -21,6 +23,10 @@ namespace Iridium {
 		Texture,
 		Sampler,
 		VertexInput,
+		// a small constant buffer that's passed by value in the push constant block rather than by address
+		// (see BindingInfo::pushConstantOffset and BindingInfo::pushConstantSize).
+		// the buffer also has a regular `Buffer` binding with the same index; the function reads the contents from that address instead if it's non-null.
+		PushConstantBuffer,
 	};
 
 	enum class TextureAccessType {
@@ -36,6 +42,95 @@ namespace Iridium {
 		size_t internalIndex;
 		TextureAccessType textureAccessType;
 		size_t embeddedSamplerIndex;
+		// for push constant buffers, this is where the buffer's contents are placed in the push constant block.
+		// for buffers, a non-zero size means that the buffer's address is passed in the push constant block rather than in the address UBO.
+		// for textures and samplers, a non-zero size means that the resource's ID is passed as a `uint32_t` in the push constant block (see TranslationOptions).
+		// the offset is relative to the start of the push constant block (not the function's range).
+		size_t pushConstantOffset;
+		size_t pushConstantSize;
+	};
+
+	struct PushConstantRange {
+		size_t offset;
+		size_t size;
+	};
+
+	/**
+	 * The largest push constant block Iridium will use, even if the device allows more.
+	 *
+	 * Push constants are recorded into every draw and dispatch, so there's no point in making them much bigger than this;
+	 * anything that doesn't fit is spilled into a uniform buffer instead.
+	 */
+	static constexpr size_t maxPushConstantBlockSize = 256;
+
+	/**
+	 * Returns the size of the push constant block Iridium will use on a device with the given `maxPushConstantsSize` limit.
+	 *
+	 * This is capped at `maxPushConstantBlockSize` and rounded down so that each half stays 8-byte aligned.
+	 */
+	inline size_t pushConstantBlockSize(size_t maxPushConstantsSize) {
+		return std::min(maxPushConstantsSize, maxPushConstantBlockSize) & ~size_t(15);
+	};
+
+	/**
+	 * Functions are translated independently of each other, so each function type gets a fixed part of the push constant block
+	 * (vertex and fragment functions are used together in the same pipeline, so they have to split it in half).
+	 *
+	 * `blockSize` is the value returned by `pushConstantBlockSize()` for the device; Vulkan guarantees at least 128 bytes.
+	 */
+	inline PushConstantRange pushConstantRangeForFunctionType(FunctionType type, size_t blockSize = 128) {
+		switch (type) {
+			case FunctionType::Vertex:
+				return PushConstantRange { 0, blockSize / 2 };
+			case FunctionType::Fragment:
+				return PushConstantRange { blockSize / 2, blockSize / 2 };
+			case FunctionType::Kernel:
+			default:
+				return PushConstantRange { 0, blockSize };
+		}
+	};
+
+	/**
+	 * Textures and samplers in argument buffers are referenced by "resource IDs" (see `Texture::gpuResourceID()` in Indium).
+	 * The low 32 bits of a resource ID are the resource's slot in a device-wide table of descriptor arrays, which lives in its own descriptor set
+	 * after the function's regular set(s).
+	 */
+	inline uint32_t resourceTableSetForFunctionType(FunctionType type) {
+		return (type == FunctionType::Kernel) ? 1 : 2;
+	};
+
+	constexpr uint32_t resourceTableTextureBinding = 0;
+	constexpr uint32_t resourceTableSamplerBinding = 1;
+
+	enum class ArgumentType {
+		// plain data (e.g. floats or structures)
+		Constant,
+		// a buffer address
+		Buffer,
+		// a texture resource ID
+		Texture,
+		// a sampler resource ID
+		Sampler,
+	};
+
+	struct ArgumentInfo {
+		ArgumentType type;
+		// the argument's ID (i.e. `[[id(n)]]`)
+		size_t index;
+		// the offset of the argument within the argument buffer
+		size_t offset;
+		// the size of a single element of the argument
+		size_t size;
+		// 0 if the argument isn't an array
+		size_t arrayLength;
+	};
+
+	struct ArgumentBufferInfo {
+		// the buffer index of the parameter that uses this argument buffer (i.e. `[[buffer(n)]]`)
+		size_t bufferIndex;
+		size_t encodedLength;
+		size_t alignment;
+		std::vector<ArgumentInfo> arguments;
 	};
 
 	struct EmbeddedSampler {
@@ -94,14 +189,38 @@ namespace Iridium {
 		FunctionType type;
 		std::vector<BindingInfo> bindings;
 		std::vector<EmbeddedSampler> embeddedSamplers;
+		// the layouts of any argument buffers (buffer parameters that contain textures, samplers, or buffer addresses) the function uses
+		std::vector<ArgumentBufferInfo> argumentBuffers;
+		// whether the function loads textures or samplers from the resource table (see resourceTableSetForFunctionType())
+		bool usesResourceTable = false;
 	};
 
 	struct OutputInfo {
 		std::unordered_map<std::string, FunctionInfo> functionInfos;
 	};
 
+	struct TranslationOptions {
+		// whether texture and sampler parameters should be looked up in the resource table (by resource IDs passed in the push constant block)
+		// rather than bound individually. this requires the same device support as the resource table itself.
+		bool bindlessResources = false;
+
+		// the size of the push constant block to lay parameters out in (see `pushConstantBlockSize()`).
+		// parameters that don't fit within the function's part of it are spilled into a uniform buffer.
+		size_t pushConstantBlockSize = 128;
+	};
+
+	/**
+	 * Builds a compute shader (entry point `main`, one thread per threadgroup) that adds the `uint64_t` at one address to the `uint64_t` at another.
+	 * Both addresses are passed in the push constant block: the source at offset 0 and the destination at offset 8.
+	 *
+	 * Indium uses this to combine visibility results on the GPU.
+	 *
+	 * @returns A pointer allocated with `malloc`.
+	 */
+	void* buildAccumulateShader(size_t& outputSize);
+
 	/**
 	 * @returns A pointer allocated with `malloc`, or `nullptr` if translation failed.
 	 */
-	void* translate(const void* inputData, size_t inputSize, size_t& outputSize, OutputInfo& outputInfo);
+	void* translate(const void* inputData, size_t inputSize, size_t& outputSize, OutputInfo& outputInfo, const TranslationOptions& options = {});
 };
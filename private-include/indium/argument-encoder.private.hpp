@@ -0,0 +1,60 @@
+#pragma once
+
+#include <indium/argument-encoder.hpp>
+
+#include <iridium/iridium.hpp>
+
+namespace Indium {
+	class PrivateDevice;
+	class PrivateBuffer;
+
+	/**
+	 * Computes the argument buffer layout for the given argument descriptors (for Device::newArgumentEncoder()).
+	 *
+	 * This uses the same layout as Metal: each argument is aligned to its natural alignment (8 bytes for buffers, textures, and samplers)
+	 * and arguments are laid out in the order they were given in.
+	 */
+	Iridium::ArgumentBufferInfo argumentBufferInfoForDescriptors(const std::vector<ArgumentDescriptor>& arguments);
+
+	/**
+	 * Argument encoders write directly into the (host-visible) contents of the argument buffer.
+	 * Buffers are written as their GPU addresses and textures and samplers as their resource IDs (i.e. their slots in the device's resource table).
+	 */
+	class PrivateArgumentEncoder: public ArgumentEncoder {
+	private:
+		std::shared_ptr<PrivateDevice> _privateDevice;
+		Iridium::ArgumentBufferInfo _info;
+
+		std::shared_ptr<PrivateBuffer> _argumentBuffer;
+		char* _argumentData = nullptr;
+
+		/**
+		 * Returns a pointer to the data for the given argument (or element of an argument array) in the current argument buffer.
+		 */
+		void* argumentPointer(Iridium::ArgumentType type, size_t index);
+
+	public:
+		PrivateArgumentEncoder(std::shared_ptr<PrivateDevice> device, const Iridium::ArgumentBufferInfo& info);
+
+		virtual std::shared_ptr<Device> device() override;
+
+		virtual size_t encodedLength() const override;
+		virtual size_t alignment() const override;
+
+		virtual void setArgumentBuffer(std::shared_ptr<Buffer> argumentBuffer, size_t offset) override;
+		virtual void setArgumentBuffer(std::shared_ptr<Buffer> argumentBuffer, size_t startOffset, size_t arrayElement) override;
+
+		virtual void setBuffer(std::shared_ptr<Buffer> buffer, size_t offset, size_t index) override;
+		virtual void setBuffers(const std::vector<std::shared_ptr<Buffer>>& buffers, const std::vector<size_t>& offsets, Range<size_t> range) override;
+
+		virtual void setTexture(std::shared_ptr<Texture> texture, size_t index) override;
+		virtual void setTextures(const std::vector<std::shared_ptr<Texture>>& textures, Range<size_t> range) override;
+
+		virtual void setSamplerState(std::shared_ptr<SamplerState> sampler, size_t index) override;
+		virtual void setSamplerStates(const std::vector<std::shared_ptr<SamplerState>>& samplers, Range<size_t> range) override;
+
+		virtual void* constantData(size_t index) override;
+
+		virtual std::shared_ptr<ArgumentEncoder> newArgumentEncoder(size_t index) override;
+	};
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <indium/binary-archive.hpp>
+#include <indium/base.hpp>
+#include <indium/library.private.hpp>
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace Indium {
+	class PrivateDevice;
+	class PrivateFunction;
+	struct TranslatedLibrary;
+
+	/**
+	 * Binary archives contain the pipeline cache data for the device together with the translated SPIR-V (and function information)
+	 * for the libraries used by the pipelines added to it.
+	 *
+	 * The pipeline cache is shared by the whole device, so any archive that's loaded warms up all pipeline creation on the device
+	 * (not just for pipelines that list the archive in their descriptor). Likewise, serializing an archive saves everything
+	 * the device has compiled so far.
+	 */
+	class PrivateBinaryArchive: public BinaryArchive {
+	private:
+		std::mutex _librariesMutex;
+		std::unordered_map<LibraryKey, std::shared_ptr<const TranslatedLibrary>> _libraries;
+
+		void addFunction(std::shared_ptr<PrivateFunction> function);
+		void load(const std::string& path);
+
+	public:
+		PrivateBinaryArchive(std::shared_ptr<PrivateDevice> device, const BinaryArchiveDescriptor& descriptor);
+		virtual ~PrivateBinaryArchive();
+
+		virtual std::shared_ptr<Device> device() override;
+
+		virtual void addRenderPipelineFunctions(const RenderPipelineDescriptor& descriptor) override;
+		virtual void addComputePipelineFunctions(const ComputePipelineDescriptor& descriptor) override;
+
+		virtual void serializeToURL(const std::string& url) override;
+
+		INDIUM_PROPERTY_READONLY_OBJECT(PrivateDevice, p, P,rivateDevice);
+	};
+};
@@ -18,6 +18,7 @@ namespace Indium {
 		std::weak_ptr<PrivateCommandBuffer> _privateCommandBuffer;
 		std::shared_ptr<PrivateDevice> _privateDevice;
 		BlitPassDescriptor _descriptor;
+		VkPipelineStageFlags _fenceUpdateStages = VK_PIPELINE_STAGE_NONE;
 
 		void copy(std::shared_ptr<Texture> source, size_t sourceSlice, size_t sourceLevel, Origin sourceOrigin, std::shared_ptr<Texture> destination, size_t destinationSlice, size_t destinationLevel, Origin destinationOrigin, size_t sliceCount, size_t levelCount, Size size);
 
@@ -35,6 +36,9 @@ namespace Indium {
 		virtual void fillBuffer(std::shared_ptr<Buffer> buffer, Range<size_t> range, uint8_t value) override;
 		virtual void generateMipmapsForTexture(std::shared_ptr<Texture> texture) override;
 
+		virtual void updateFence(std::shared_ptr<Fence> fence) override;
+		virtual void waitForFence(std::shared_ptr<Fence> fence) override;
+
 		virtual void endEncoding() override;
 	};
 };
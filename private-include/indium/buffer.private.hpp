@@ -12,6 +12,7 @@ namespace Indium {
 		std::shared_ptr<PrivateDevice> _privateDevice;
 		size_t _length;
 		StorageMode _storageMode;
+		HazardTrackingMode _hazardTrackingMode;
 		void* _mapped = nullptr;
 
 	public:
@@ -20,6 +21,7 @@ namespace Indium {
 		~PrivateBuffer();
 
 		virtual std::shared_ptr<Device> device() override;
+		virtual HazardTrackingMode hazardTrackingMode() const override;
 
 		virtual size_t length() const override;
 		virtual void* contents() override;
@@ -4,6 +4,8 @@
 
 #include <indium/command-buffer.hpp>
 #include <indium/command-encoder.hpp>
+#include <indium/transient-arena.private.hpp>
+#include <indium/upload-heap.private.hpp>
 
 #include <vector>
 #include <mutex>
@@ -15,6 +17,17 @@ namespace Indium {
 
 	class PrivateCommandBuffer: public CommandBuffer, public std::enable_shared_from_this<PrivateCommandBuffer> {
 	private:
+		// events need to be waited on and signaled in between commands, so we split the command buffer into
+		// multiple Vulkan command buffers (each one a separate batch in the same submission) whenever necessary.
+		// the last batch is always the one we're currently recording into.
+		struct Batch {
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			// the number of encoders that had been created when this batch began
+			size_t firstEncoderIndex = 0;
+			std::vector<VkSemaphoreSubmitInfo> waitInfos;
+			std::vector<VkSemaphoreSubmitInfo> signalInfos;
+		};
+
 		std::mutex _mutex;
 		// we have to keep some encoders (e.g. render encoders) alive until the buffer has finished executing.
 		// the encoders themselves aren't too important, but the resources they reference are.
@@ -25,9 +38,19 @@ namespace Indium {
 		bool _committed = false;
 		std::condition_variable _completedCondvar;
 		bool _completed = false;
+		std::vector<Batch> _batches;
+		std::vector<std::shared_ptr<Event>> _events;
+		bool _retainedReferences;
+		// scratch memory for the encoders' temporary structures (taken from and returned to the command queue's pool)
+		std::unique_ptr<TransientArena> _arena;
+		// memory for data the encoders pass to the GPU (taken from and returned to the command queue's pool like the arena).
+		// we're kept alive until we complete, so this is only recycled once the GPU is done with it.
+		std::unique_ptr<UploadHeap> _uploadHeap;
+
+		void beginBatch();
 
 	public:
-		PrivateCommandBuffer(std::shared_ptr<PrivateCommandQueue> commandQueue);
+		PrivateCommandBuffer(std::shared_ptr<PrivateCommandQueue> commandQueue, bool retainedReferences = true);
 		~PrivateCommandBuffer();
 
 		virtual std::shared_ptr<RenderCommandEncoder> renderCommandEncoder(const RenderPassDescriptor& descriptor) override;
@@ -39,6 +62,8 @@ namespace Indium {
 
 		virtual void commit() override;
 		virtual void presentDrawable(std::shared_ptr<Drawable> drawable) override;
+		virtual void encodeSignalEvent(std::shared_ptr<Event> event, uint64_t value) override;
+		virtual void encodeWaitForEvent(std::shared_ptr<Event> event, uint64_t value) override;
 		virtual void addScheduledHandler(std::function<void(std::shared_ptr<CommandBuffer>)> handler) override;
 		virtual void addCompletedHandler(std::function<void(std::shared_ptr<CommandBuffer>)> handler) override;
 		virtual void waitUntilCompleted() override;
@@ -46,6 +71,16 @@ namespace Indium {
 		virtual std::shared_ptr<CommandQueue> commandQueue() override;
 		virtual std::shared_ptr<Device> device() override;
 
+		virtual bool retainedReferences() const override;
+
+		TransientArena& arena() {
+			return *_arena;
+		};
+
+		UploadHeap& uploadHeap() {
+			return *_uploadHeap;
+		};
+
 		void addScheduledHandlerLocked(std::function<void(std::shared_ptr<CommandBuffer>)> handler);
 		void addCompletedHandlerLocked(std::function<void(std::shared_ptr<CommandBuffer>)> handler);
 
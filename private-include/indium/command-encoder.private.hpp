@@ -4,7 +4,12 @@
 #include <memory>
 #include <optional>
 #include <array>
+#include <bitset>
 #include <forward_list>
+#include <memory_resource>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
 
 #include <indium/command-encoder.hpp>
 #include <indium/device.private.hpp>
@@ -13,179 +18,525 @@
 #include <indium/buffer.private.hpp>
 #include <indium/texture.private.hpp>
 #include <indium/library.private.hpp>
+#include <indium/pipeline.private.hpp>
+#include <indium/resource-table.private.hpp>
+#include <indium/transient-arena.private.hpp>
+#include <indium/upload-heap.private.hpp>
 #include <indium/dynamic-vk.hpp>
 
 #include <iridium/iridium.hpp>
 
 namespace Indium {
+	/**
+	 * The resources bound for a single function stage.
+	 *
+	 * Bindings are kept in fixed-size tables (using Metal's binding limits) of raw handles, so that the draw path can use them
+	 * without any casts or allocations. The strong references that keep those handles valid are kept separately (see BindingState).
+	 */
 	struct FunctionResources {
-		std::vector<std::pair<std::shared_ptr<Buffer>, size_t>> buffers;
-		std::vector<std::shared_ptr<Texture>> textures;
-		std::vector<std::shared_ptr<SamplerState>> samplers;
+		// raw handles for the bound resources; these are only valid as long as the corresponding strong reference is
+		std::array<PrivateBuffer*, maxBufferBindings> bufferHandles {};
+		std::array<size_t, maxBufferBindings> bufferOffsets {};
+		std::array<PrivateTexture*, maxTextureBindings> textureHandles {};
+		std::array<PrivateSamplerState*, maxSamplerBindings> samplerHandles {};
+
+		// strong references for the bound resources
+		std::array<std::shared_ptr<Buffer>, maxBufferBindings> buffers;
+		std::array<std::shared_ptr<Texture>, maxTextureBindings> textures;
+		std::array<std::shared_ptr<SamplerState>, maxSamplerBindings> samplers;
+
+		// the contents of bindings set with setBytes(). depending on the function that uses them, these are either passed directly in push constants
+		// or passed in a buffer, so we only upload them once a function actually needs them in a buffer (see buffer()).
+		std::array<std::vector<char>, maxBufferBindings> bytes;
+		std::array<std::pair<PrivateBuffer*, size_t>, maxBufferBindings> bytesUploads {};
+
+		// transient resource table slots for bound textures and samplers that couldn't get slots of their own because the table was full.
+		// these stay assigned for as long as the binding does (see textureResourceID() and samplerResourceID()).
+		std::array<std::shared_ptr<const uint32_t>, maxTextureBindings> transientTextureSlots;
+		std::array<std::shared_ptr<const uint32_t>, maxSamplerBindings> transientSamplerSlots;
+
+		// whether the bindings have changed since the last time descriptor sets were created for them
+		bool dirty = true;
+		// whether the descriptor set for the bindings has to be bound again even though the bindings haven't changed
+		// (e.g. because indirect commands bound their own sets in the meantime)
+		bool needsRebind = false;
+		// the descriptor set last written for the bindings (unless it was a push descriptor set), which can be rebound as-is when only `needsRebind` is set
+		VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+		// whether the bindings passed in push constants (buffer contents, buffer addresses, and resource IDs) have changed since the last time they were pushed
+		bool pushConstantsDirty = true;
+		// the bindings that have changed since the last command (one bit per binding index).
+		// whether these need new descriptor sets or just new push constants depends on the function they're used with; see resolveDirtyBindings().
+		std::bitset<maxBufferBindings> dirtyBuffers;
+		std::bitset<maxTextureBindings> dirtyTextures;
+		std::bitset<maxSamplerBindings> dirtySamplers;
+
+		// we do copy-on-write retention for bound resources: a resource referenced by a recorded command stays alive
+		// through its binding, so we only need to retain it separately once that binding gets overwritten.
+		//
+		// `generation` is bumped every time a command using the current bindings is recorded, and each binding remembers
+		// the generation it was set in. a binding set before the last recorded command is still referenced by that command.
+		struct BindingState {
+			uint64_t generation = 0;
+			// resources we created ourselves (e.g. for setBytes) always need to be retained, even when the command buffer
+			// doesn't retain references; nobody else is going to keep them alive.
+			bool internal = false;
+		};
+
+		bool retainReferences = true;
+		uint64_t generation = 0;
+		std::array<BindingState, maxBufferBindings> bufferStates;
+		std::array<BindingState, maxTextureBindings> textureStates;
+		std::array<BindingState, maxSamplerBindings> samplerStates;
+		std::vector<std::shared_ptr<void>> retainedResources;
 
-		void setBytes(std::shared_ptr<Device> device, const void* bytes, size_t length, size_t index) {
-			// TODO: we can make this "Private" instead
-			auto buf = device->newBuffer(bytes, length, ResourceOptions::StorageModeShared);
+		void markUsed() {
+			++generation;
+		};
 
-			if (buffers.size() <= index) {
-				buffers.resize(index + 1);
+		template<typename T>
+		void replaceBinding(std::shared_ptr<T>& binding, BindingState& state, std::shared_ptr<T> newValue, bool internal) {
+			// rebinding the same resource (e.g. with a different offset) keeps it referenced, so it doesn't need to be retained separately
+			if (binding && binding != newValue && state.generation < generation && (retainReferences || state.internal)) {
+				retainedResources.push_back(std::move(binding));
 			}
 
-			buffers[index] = std::make_pair(buf, 0);
+			binding = std::move(newValue);
+			state.generation = generation;
+			state.internal = internal;
+		};
+
+		void releaseTransientSlot(std::shared_ptr<const uint32_t>& slot) {
+			// commands we've already recorded might still be using it
+			if (slot) {
+				retainedResources.push_back(std::move(slot));
+				slot = nullptr;
+			}
+		};
+
+		static void checkIndex(size_t index, size_t limit) {
+			if (index >= limit) {
+				throw std::runtime_error("Binding index out of range");
+			}
+		};
+
+		void setBytes(const void* data, size_t length, size_t index) {
+			checkIndex(index, maxBufferBindings);
+
+			if (buffers[index]) {
+				replaceBinding<Buffer>(buffers[index], bufferStates[index], nullptr, false);
+				bufferHandles[index] = nullptr;
+				bufferOffsets[index] = 0;
+			}
+
+			// note that this doesn't allocate anything when the new contents are no bigger than the old ones
+			bytes[index].assign(static_cast<const char*>(data), static_cast<const char*>(data) + length);
+
+			// the old contents stay in the command buffer's upload heap for any commands that still use them
+			bytesUploads[index] = {};
+
+			dirtyBuffers.set(index);
 		};
 
 		void setBuffer(std::shared_ptr<Buffer> buffer, size_t offset, size_t index) {
-			if (buffers.size() <= index) {
-				buffers.resize(index + 1);
+			checkIndex(index, maxBufferBindings);
+
+			if (buffers[index] == buffer && bufferOffsets[index] == offset && bytes[index].empty()) {
+				// nothing changed
+				return;
 			}
 
-			buffers[index] = std::make_pair(buffer, offset);
+			bufferHandles[index] = buffer ? std::dynamic_pointer_cast<PrivateBuffer>(buffer).get() : nullptr;
+			replaceBinding(buffers[index], bufferStates[index], buffer, false);
+			bufferOffsets[index] = offset;
+			bytes[index].clear();
+			bytesUploads[index] = {};
+			dirtyBuffers.set(index);
 		};
 
 		void setBufferOffset(size_t offset, size_t index) {
-			buffers[index].second = offset;
+			checkIndex(index, maxBufferBindings);
+
+			if (bufferOffsets[index] == offset) {
+				return;
+			}
+			bufferOffsets[index] = offset;
+			dirtyBuffers.set(index);
 		};
 
-		void setSamplerState(std::shared_ptr<SamplerState> state, std::optional<std::pair<float, float>> lodClamps, size_t index) {
-			if (samplers.size() <= index) {
-				samplers.resize(index + 1);
+		/**
+		 * Returns the buffer bound at the given index along with its offset.
+		 * If the binding was set with setBytes(), this uploads its contents to the given heap (the first time they're needed).
+		 */
+		std::pair<PrivateBuffer*, size_t> buffer(size_t index, UploadHeap& uploadHeap) {
+			if (index >= maxBufferBindings) {
+				return std::make_pair(nullptr, 0);
+			}
+
+			if (!bufferHandles[index] && !bytes[index].empty()) {
+				if (!bytesUploads[index].first) {
+					bytesUploads[index] = uploadHeap.upload(bytes[index].data(), bytes[index].size());
+				}
+				return bytesUploads[index];
+			}
+
+			return std::make_pair(bufferHandles[index], bufferOffsets[index]);
+		};
+
+		/**
+		 * Returns the address to pass to the given function for the buffer bound at the given index.
+		 * For buffers whose contents the function takes by value, this is null when the binding was set with setBytes() (the contents are pushed instead).
+		 */
+		uint64_t bufferAddress(const BindingMap& bindingMap, size_t index, UploadHeap& uploadHeap) {
+			if (index < maxBufferBindings && bindingMap.pushConstantContentBuffers.test(index) && !bufferHandles[index]) {
+				return 0;
+			}
+
+			auto [buffer, offset] = this->buffer(index, uploadHeap);
+			return buffer ? (buffer->gpuAddress() + offset) : 0;
+		};
+
+		/**
+		 * Returns the resource ID to pass for the texture bound at the given index (or 0 if there's none).
+		 * This falls back to a transient slot if the texture can't get a slot of its own.
+		 */
+		uint32_t textureResourceID(std::shared_ptr<PrivateDevice> device, size_t index) {
+			auto texture = textureHandles[index];
+			if (!texture) {
+				return 0;
+			}
+
+			if (transientTextureSlots[index]) {
+				return *transientTextureSlots[index];
+			}
+
+			if (auto slot = texture->resourceTableSlot()) {
+				return *slot;
+			}
+
+			transientTextureSlots[index] = device->resourceTable().addTransientTexture(texture->imageView(), texture->imageLayout());
+			return *transientTextureSlots[index];
+		};
+
+		/**
+		 * Like textureResourceID(), but for samplers.
+		 */
+		uint32_t samplerResourceID(std::shared_ptr<PrivateDevice> device, size_t index) {
+			auto sampler = samplerHandles[index];
+			if (!sampler) {
+				return 0;
+			}
+
+			if (transientSamplerSlots[index]) {
+				return *transientSamplerSlots[index];
+			}
+
+			if (auto slot = sampler->resourceTableSlot()) {
+				return *slot;
+			}
+
+			transientSamplerSlots[index] = device->resourceTable().addTransientSampler(sampler->sampler());
+			return *transientSamplerSlots[index];
+		};
+
+		/**
+		 * Figures out whether the bindings that changed need new descriptor sets or just new push constants for the given function.
+		 */
+		void resolveDirtyBindings(const FunctionInfo& functionInfo) {
+			const auto& bindingMap = functionInfo.bindingMap;
+
+			// bindings the function doesn't use at all don't need anything
+			if ((dirtyBuffers & bindingMap.descriptorBuffers).any() || (dirtyTextures & bindingMap.descriptorTextures).any() || (dirtySamplers & bindingMap.descriptorSamplers).any()) {
+				dirty = true;
+			}
+
+			if ((dirtyBuffers & bindingMap.pushConstantBuffers).any() || (dirtyTextures & bindingMap.pushConstantTextures).any() || (dirtySamplers & bindingMap.pushConstantSamplers).any()) {
+				pushConstantsDirty = true;
+			}
+
+			dirtyBuffers.reset();
+			dirtyTextures.reset();
+			dirtySamplers.reset();
+		};
+
+		/**
+		 * Records the given function's push constant bindings (buffer contents, buffer addresses, and resource IDs) into the command buffer.
+		 */
+		void pushConstants(std::shared_ptr<PrivateDevice> device, VkCommandBuffer commandBuffer, VkPipelineLayout layout, const FunctionInfo& functionInfo, UploadHeap& uploadHeap) {
+			const auto& range = functionInfo.pushConstantRange;
+
+			// Iridium never uses more than this, no matter how much the device allows
+			std::array<char, Iridium::maxPushConstantBlockSize> data {};
+
+			for (const auto& bindingInfo: functionInfo.bindingMap.pushConstantBindings) {
+				auto target = data.data() + (bindingInfo.pushConstantOffset - range.offset);
+
+				if (bindingInfo.type == Iridium::BindingType::Buffer) {
+					auto address = bufferAddress(functionInfo.bindingMap, bindingInfo.index, uploadHeap);
+					memcpy(target, &address, sizeof(address));
+					continue;
+				}
+
+				if (bindingInfo.type == Iridium::BindingType::Texture || bindingInfo.type == Iridium::BindingType::Sampler) {
+					// resource IDs are always passed as 32-bit slots; the high bits are unused for now
+					auto slot = (bindingInfo.type == Iridium::BindingType::Texture) ? textureResourceID(device, bindingInfo.index) : samplerResourceID(device, bindingInfo.index);
+					memcpy(target, &slot, sizeof(slot));
+					continue;
+				}
+
+				// a regular buffer bound for this binding is read by the function through its address instead (see bufferAddress())
+				if (!bytes[bindingInfo.index].empty()) {
+					memcpy(target, bytes[bindingInfo.index].data(), std::min(bindingInfo.pushConstantSize, bytes[bindingInfo.index].size()));
+				}
 			}
 
+			DynamicVK::vkCmdPushConstants(commandBuffer, layout, range.stageFlags, range.offset, range.size, data.data());
+			pushConstantsDirty = false;
+		};
+
+		void setSamplerState(std::shared_ptr<SamplerState> state, std::optional<std::pair<float, float>> lodClamps, size_t index) {
+			checkIndex(index, maxSamplerBindings);
+
 			if (lodClamps) {
-				auto privateState = std::dynamic_pointer_cast<PrivateSamplerState>(state);
-				samplers[index] = privateState->cloneWithClamps(lodClamps->first, lodClamps->second);
-			} else {
-				samplers[index] = state;
+				auto privateState = std::dynamic_pointer_cast<PrivateSamplerState>(state)->cloneWithClamps(lodClamps->first, lodClamps->second);
+				samplerHandles[index] = privateState.get();
+				replaceBinding<SamplerState>(samplers[index], samplerStates[index], std::move(privateState), true);
+				releaseTransientSlot(transientSamplerSlots[index]);
+				dirtySamplers.set(index);
+			} else if (samplers[index] != state) {
+				samplerHandles[index] = state ? std::dynamic_pointer_cast<PrivateSamplerState>(state).get() : nullptr;
+				replaceBinding(samplers[index], samplerStates[index], state, false);
+				releaseTransientSlot(transientSamplerSlots[index]);
+				dirtySamplers.set(index);
 			}
 		};
 
 		void setTexture(std::shared_ptr<Texture> texture, size_t index) {
-			if (textures.size() <= index) {
-				textures.resize(index + 1);
+			checkIndex(index, maxTextureBindings);
+
+			if (textures[index] == texture) {
+				return;
 			}
 
-			textures[index] = texture;
+			textureHandles[index] = texture ? std::dynamic_pointer_cast<PrivateTexture>(texture).get() : nullptr;
+			replaceBinding(textures[index], textureStates[index], texture, false);
+			releaseTransientSlot(transientTextureSlots[index]);
+			dirtyTextures.set(index);
 		};
 	};
 
+	/**
+	 * The descriptor writes for a single set, along with the infos they point to.
+	 * These are only needed while recording a command, so they're allocated from the command buffer's arena.
+	 */
+	struct DescriptorSetWrites {
+	private:
+		// the writes point into the info lists
+		INDIUM_PREVENT_COPY(DescriptorSetWrites);
+
+	public:
+		std::pmr::vector<VkWriteDescriptorSet> writes;
+		std::pmr::forward_list<VkDescriptorBufferInfo> bufInfos;
+		std::pmr::forward_list<VkDescriptorImageInfo> imageInfos;
+
+		explicit DescriptorSetWrites(std::pmr::memory_resource* resource):
+			writes(resource),
+			bufInfos(resource),
+			imageInfos(resource)
+			{};
+	};
+
+	/**
+	 * Builds the descriptor writes for the given function's bindings.
+	 *
+	 * @param dstSet The set to write to. This is ignored for push descriptor sets (where it should be `VK_NULL_HANDLE`).
+	 */
+	inline void buildDescriptorSetWrites(DescriptorSetWrites& result, VkDescriptorSet dstSet, std::shared_ptr<PrivateDevice> privateDevice, FunctionResources& functionResources, const FunctionInfo& funcInfo, UploadHeap& uploadHeap) {
+		auto& writeDescSet = result.writes;
+		auto& bufInfos = result.bufInfos;
+		auto& imageInfos = result.imageInfos;
+
+		const auto& bindingMap = funcInfo.bindingMap;
+
+		if (!bindingMap.addressBindings.empty()) {
+			std::pmr::vector<uint64_t> addresses(writeDescSet.get_allocator().resource());
+			addresses.reserve(bindingMap.addressBindings.size());
+
+			for (const auto& bindingInfo: bindingMap.addressBindings) {
+				addresses.push_back(functionResources.bufferAddress(bindingMap, bindingInfo.index, uploadHeap));
+			}
+
+			// this lives in the command buffer's upload heap until the command buffer completes
+			auto [addressBuffer, addressOffset] = uploadHeap.upload(addresses.data(), addresses.size() * sizeof(uint64_t));
+
+			auto& info = bufInfos.emplace_front();
+			info.buffer = addressBuffer->buffer();
+			info.offset = addressOffset;
+			info.range = addresses.size() * sizeof(uint64_t);
+
+			auto& descSet = writeDescSet.emplace_back();
+			descSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descSet.dstSet = dstSet;
+			descSet.dstBinding = 0;
+			descSet.dstArrayElement = 0;
+			descSet.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			descSet.descriptorCount = 1;
+			descSet.pBufferInfo = &info;
+		}
+
+		for (const auto& bindingInfo: bindingMap.descriptorBindings) {
+			if (bindingInfo.type == Iridium::BindingType::Texture) {
+				auto texture = functionResources.textureHandles[bindingInfo.index];
+				if (!texture) {
+					continue;
+				}
+
+				auto& info = imageInfos.emplace_front();
+				info.imageView = texture->imageView();
+				info.imageLayout = texture->imageLayout();
+
+				auto& descSet = writeDescSet.emplace_back();
+				descSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				descSet.dstSet = dstSet;
+				descSet.dstBinding = bindingInfo.internalIndex;
+				descSet.dstArrayElement = 0;
+				descSet.descriptorType = (bindingInfo.textureAccessType == Iridium::TextureAccessType::Sample) ? VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+				descSet.descriptorCount = 1;
+				descSet.pImageInfo = &info;
+			} else {
+				// embedded samplers don't have a binding index
+				PrivateSamplerState* sampler = (bindingInfo.index == SIZE_MAX) ? funcInfo.embeddedSamplerStates[bindingInfo.embeddedSamplerIndex].get() : functionResources.samplerHandles[bindingInfo.index];
+				if (!sampler) {
+					continue;
+				}
+
+				auto& info = imageInfos.emplace_front();
+				info.sampler = sampler->sampler();
+
+				auto& descSet = writeDescSet.emplace_back();
+				descSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				descSet.dstSet = dstSet;
+				descSet.dstBinding = bindingInfo.internalIndex;
+				descSet.dstArrayElement = 0;
+				descSet.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+				descSet.descriptorCount = 1;
+				descSet.pImageInfo = &info;
+			}
+		}
+	};
+
+	/**
+	 * Writes and binds the descriptor sets for the given functions whose bindings are dirty (or that need to be rebound).
+	 *
+	 * Sets that use push descriptors (see DescriptorSetLayouts::processFunction()) are pushed directly into the command buffer;
+	 * all the others are allocated from the given pool. Sets whose bindings haven't changed are left alone, since they stay bound
+	 * as long as the pipeline layout doesn't change (and a pipeline layout change marks all the bindings dirty).
+	 *
+	 * @param arena The command buffer's arena; all the temporary structures we need are allocated from here (and freed before returning).
+	 */
 	template<size_t setCount>
-	std::array<VkDescriptorSet, setCount> createDescriptorSets(std::array<VkDescriptorSetLayout, setCount>& setLayouts, VkDescriptorPool pool, std::shared_ptr<PrivateDevice> privateDevice, const std::array<std::reference_wrapper<const FunctionResources>, setCount>& funcResources, const std::array<std::reference_wrapper<const FunctionInfo>, setCount>& functionInfos, std::vector<std::shared_ptr<Buffer>>& keepAliveBuffers) {
+	void bindDescriptorSets(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout, const DescriptorSetLayouts<setCount>& setLayouts, VkDescriptorPool pool, std::shared_ptr<PrivateDevice> privateDevice, const std::array<std::reference_wrapper<FunctionResources>, setCount>& funcResources, const std::array<std::reference_wrapper<const FunctionInfo>, setCount>& functionInfos, UploadHeap& uploadHeap, TransientArena& arena) {
+		TransientArena::Scope arenaScope(arena);
+
 		std::array<VkDescriptorSet, setCount> descriptorSets {};
+		std::array<bool, setCount> writeSets {};
+		std::pmr::vector<VkDescriptorSetLayout> allocatedLayouts(&arena);
 
-		VkDescriptorSetAllocateInfo setAllocateInfo {};
-		setAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-		setAllocateInfo.descriptorPool = pool;
-		setAllocateInfo.descriptorSetCount = descriptorSets.size();
-		setAllocateInfo.pSetLayouts = setLayouts.data();
+		for (size_t i = 0; i < setCount; ++i) {
+			FunctionResources& resources = funcResources[i];
 
-		if (DynamicVK::vkAllocateDescriptorSets(privateDevice->device(), &setAllocateInfo, descriptorSets.data()) != VK_SUCCESS) {
-			// TODO
-			abort();
-		}
+			if (setLayouts.isEmpty(i) || (!resources.dirty && !resources.needsRebind)) {
+				continue;
+			}
 
-		for (size_t i = 0; i < descriptorSets.size(); ++i) {
-			std::vector<VkWriteDescriptorSet> writeDescSet;
-			std::forward_list<VkDescriptorBufferInfo> bufInfos;
-			std::forward_list<VkDescriptorImageInfo> imageInfos;
+			if (!resources.dirty && !setLayouts.isPushDescriptor(i) && resources.descriptorSet) {
+				// the set we last wrote for these bindings is still up-to-date; it just needs to be bound again
+				DynamicVK::vkCmdBindDescriptorSets(commandBuffer, bindPoint, pipelineLayout, i, 1, &resources.descriptorSet, 0, nullptr);
+				resources.needsRebind = false;
+				continue;
+			}
 
-			const FunctionResources& functionResources = funcResources[i];
-			const FunctionInfo& funcInfo = functionInfos[i];
+			writeSets[i] = true;
 
-			if (functionResources.buffers.size() > 0) {
-				std::vector<uint64_t> addresses;
+			if (!setLayouts.isPushDescriptor(i)) {
+				allocatedLayouts.push_back(setLayouts.layouts[i]);
+			}
+		}
 
-				// find the right buffer for each binding (using the binding index)
-				for (size_t j = 0; j < funcInfo.bindings.size(); ++j) {
-					auto& bindingInfo = funcInfo.bindings[j];
+		if (!allocatedLayouts.empty()) {
+			std::pmr::vector<VkDescriptorSet> allocatedSets(allocatedLayouts.size(), &arena);
 
-					if (bindingInfo.type != Iridium::BindingType::Buffer) {
-						continue;
-					}
+			VkDescriptorSetAllocateInfo setAllocateInfo {};
+			setAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+			setAllocateInfo.descriptorPool = pool;
+			setAllocateInfo.descriptorSetCount = allocatedSets.size();
+			setAllocateInfo.pSetLayouts = allocatedLayouts.data();
 
-					if (bindingInfo.index >= functionResources.buffers.size()) {
-						addresses.push_back(0);
-						continue;
-					}
+			if (DynamicVK::vkAllocateDescriptorSets(privateDevice->device(), &setAllocateInfo, allocatedSets.data()) != VK_SUCCESS) {
+				// TODO
+				abort();
+			}
 
-					auto privateBuf = std::dynamic_pointer_cast<PrivateBuffer>(functionResources.buffers[bindingInfo.index].first);
-					addresses.push_back(privateBuf->gpuAddress() + functionResources.buffers[bindingInfo.index].second);
+			for (size_t i = 0, j = 0; i < setCount; ++i) {
+				if (writeSets[i] && !setLayouts.isPushDescriptor(i)) {
+					descriptorSets[i] = allocatedSets[j++];
 				}
+			}
+		}
 
-				auto addressBuffer = privateDevice->newBuffer(addresses.data(), functionResources.buffers.size() * 8, ResourceOptions::StorageModeShared);
-				auto privateAddrBuf = std::dynamic_pointer_cast<PrivateBuffer>(addressBuffer);
+		for (size_t i = 0; i < setCount; ++i) {
+			if (!writeSets[i]) {
+				continue;
+			}
 
-				// we need to keep this buffer alive until the operation is completed
-				keepAliveBuffers.push_back(addressBuffer);
+			FunctionResources& resources = funcResources[i];
+			resources.dirty = false;
+			resources.needsRebind = false;
+			resources.descriptorSet = descriptorSets[i];
 
-				auto& info = bufInfos.emplace_front();
-				info.buffer = privateAddrBuf->buffer();
-				info.offset = 0;
-				info.range = VK_WHOLE_SIZE;
+			DescriptorSetWrites setWrites(&arena);
+			buildDescriptorSetWrites(setWrites, descriptorSets[i], privateDevice, resources, functionInfos[i], uploadHeap);
 
-				auto& descSet = writeDescSet.emplace_back();
-				descSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-				descSet.dstSet = descriptorSets[i];
-				descSet.dstBinding = 0;
-				descSet.dstArrayElement = 0;
-				descSet.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-				descSet.descriptorCount = 1;
-				descSet.pBufferInfo = &info;
-			}
-
-			for (size_t j = 0; j < funcInfo.bindings.size(); ++j) {
-				auto& bindingInfo = funcInfo.bindings[j];
-
-				if (bindingInfo.type == Iridium::BindingType::Texture) {
-					if (bindingInfo.index >= functionResources.textures.size()) {
-						continue;
-					}
-
-					auto texture = functionResources.textures[bindingInfo.index];
-					auto privateTexture = std::dynamic_pointer_cast<PrivateTexture>(texture);
-
-					auto& info = imageInfos.emplace_front();
-					info.imageView = privateTexture->imageView();
-					info.imageLayout = privateTexture->imageLayout();
-
-					auto& descSet = writeDescSet.emplace_back();
-					descSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-					descSet.dstSet = descriptorSets[i];
-					descSet.dstBinding = bindingInfo.internalIndex;
-					descSet.dstArrayElement = 0;
-					descSet.descriptorType = (bindingInfo.textureAccessType == Iridium::TextureAccessType::Sample) ? VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-					descSet.descriptorCount = 1;
-					descSet.pImageInfo = &info;
-				} else if (bindingInfo.type == Iridium::BindingType::Sampler) {
-					bool embeddedSampler = false;
-
-					if (bindingInfo.index == SIZE_MAX) {
-						// this binding uses an embedded sampler
-						embeddedSampler = true;
-					} else if (bindingInfo.index >= functionResources.samplers.size()) {
-						continue;
-					}
-
-					auto sampler = embeddedSampler ? funcInfo.embeddedSamplerStates[bindingInfo.embeddedSamplerIndex] : functionResources.samplers[bindingInfo.index];
-					auto privateSampler = std::dynamic_pointer_cast<PrivateSamplerState>(sampler);
-
-					auto& info = imageInfos.emplace_front();
-					info.sampler = privateSampler->sampler();
-
-					auto& descSet = writeDescSet.emplace_back();
-					descSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-					descSet.dstSet = descriptorSets[i];
-					descSet.dstBinding = bindingInfo.internalIndex;
-					descSet.dstArrayElement = 0;
-					descSet.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
-					descSet.descriptorCount = 1;
-					descSet.pImageInfo = &info;
+			if (!setLayouts.isPushDescriptor(i)) {
+				DynamicVK::vkUpdateDescriptorSets(privateDevice->device(), setWrites.writes.size(), setWrites.writes.data(), 0, nullptr);
+				DynamicVK::vkCmdBindDescriptorSets(commandBuffer, bindPoint, pipelineLayout, i, 1, &descriptorSets[i], 0, nullptr);
+				continue;
+			}
+
+			// if every binding in the set was written, we can use the update template, which saves the driver from having to parse all the writes.
+			// otherwise (e.g. when some texture hasn't been bound), we fall back to pushing the individual writes.
+			const auto& templateBindings = setLayouts.templateBindings[i];
+			std::pmr::vector<PushDescriptorData> pushData(templateBindings.size(), &arena);
+			size_t filledSlots = 0;
+
+			for (const auto& write: setWrites.writes) {
+				auto it = std::lower_bound(templateBindings.begin(), templateBindings.end(), write.dstBinding, [](const VkDescriptorSetLayoutBinding& binding, uint32_t number) {
+					return binding.binding < number;
+				});
+				if (it == templateBindings.end() || it->binding != write.dstBinding) {
+					continue;
 				}
+
+				auto& data = pushData[it - templateBindings.begin()];
+				if (write.pBufferInfo) {
+					data.buffer = *write.pBufferInfo;
+				} else {
+					data.image = *write.pImageInfo;
+				}
+				++filledSlots;
 			}
 
-			DynamicVK::vkUpdateDescriptorSets(privateDevice->device(), writeDescSet.size(), writeDescSet.data(), 0, nullptr);
+			if (filledSlots == templateBindings.size()) {
+				DynamicVK::vkCmdPushDescriptorSetWithTemplateKHR(commandBuffer, setLayouts.updateTemplates[i], pipelineLayout, i, pushData.data());
+			} else if (!setWrites.writes.empty()) {
+				DynamicVK::vkCmdPushDescriptorSetKHR(commandBuffer, bindPoint, pipelineLayout, i, setWrites.writes.size(), setWrites.writes.data());
+			}
 		}
 
-		return descriptorSets;
+		// the resource table never changes (its contents are updated in place), but it still needs to be rebound whenever the pipeline layout changes
+		if (setLayouts.usesResourceTable) {
+			VkDescriptorSet resourceTableSet = privateDevice->resourceTable().descriptorSet();
+			DynamicVK::vkCmdBindDescriptorSets(commandBuffer, bindPoint, pipelineLayout, setCount, 1, &resourceTableSet, 0, nullptr);
+		}
 	};
 
 	static constexpr std::array<VkDescriptorPoolSize, 4> poolSizes {
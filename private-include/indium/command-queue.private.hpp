@@ -2,8 +2,15 @@
 
 #include <indium/command-queue.hpp>
 
+#include <indium/transient-arena.private.hpp>
+#include <indium/upload-heap.private.hpp>
+
 #include <vulkan/vulkan.h>
 
+#include <memory>
+#include <mutex>
+#include <vector>
+
 namespace Indium {
 	class PrivateDevice;
 
@@ -12,13 +19,33 @@ namespace Indium {
 			bool _supportsGraphics;
 			bool _supportsCompute;
 
+			// arenas and upload heaps from command buffers that have been destroyed; see takeArena()
+			std::mutex _arenaMutex;
+			std::vector<std::unique_ptr<TransientArena>> _arenas;
+			std::vector<std::unique_ptr<UploadHeap>> _uploadHeaps;
+
 		public:
 			PrivateCommandQueue(std::shared_ptr<PrivateDevice> device);
 			~PrivateCommandQueue();
 
 			virtual std::shared_ptr<CommandBuffer> commandBuffer() override;
+			virtual std::shared_ptr<CommandBuffer> commandBufferWithUnretainedReferences() override;
 			virtual std::shared_ptr<Device> device() override;
 
+			/**
+			 * Returns an arena for a new command buffer. Arenas are recycled between the command buffers created on a queue,
+			 * so a command buffer usually gets an arena that has already been warmed up by a previous one.
+			 */
+			std::unique_ptr<TransientArena> takeArena();
+			void recycleArena(std::unique_ptr<TransientArena> arena);
+
+			/**
+			 * Returns an upload heap for a new command buffer. These are recycled the same way as arenas (see takeArena()),
+			 * but they must only be recycled once the command buffer that used them has completed.
+			 */
+			std::unique_ptr<UploadHeap> takeUploadHeap();
+			void recycleUploadHeap(std::unique_ptr<UploadHeap> heap);
+
 			INDIUM_PROPERTY_READONLY_OBJECT(PrivateDevice, p, P,rivateDevice);
 
 			INDIUM_PROPERTY(VkCommandPool, c, C,ommandPool) = VK_NULL_HANDLE;
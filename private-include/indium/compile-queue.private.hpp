@@ -0,0 +1,85 @@
+#pragma once
+
+#include <indium/pipeline.hpp>
+#include <indium/base.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace Indium {
+	class PrivateCompileTask: public CompileTask {
+	public:
+		enum class State {
+			Pending,
+			Running,
+			Cancelled,
+			Done,
+		};
+
+	private:
+		std::atomic<State> _state = State::Pending;
+		std::function<void()> _work;
+
+	public:
+		PrivateCompileTask(CompilePriority priority, uint64_t sequence, std::function<void()> work);
+		virtual ~PrivateCompileTask();
+
+		virtual bool cancel() override;
+
+		/**
+		 * Runs the task if it hasn't been cancelled.
+		 */
+		void run();
+
+		const CompilePriority priority;
+		// used to run tasks with the same priority in the order they were submitted
+		const uint64_t sequence;
+	};
+
+	/**
+	 * A thread pool for creating pipeline states asynchronously.
+	 *
+	 * Threads are only started once the first task is submitted, so devices that never create pipelines asynchronously don't pay for them.
+	 */
+	class PrivateCompileQueue {
+	private:
+		INDIUM_PREVENT_COPY(PrivateCompileQueue);
+
+		struct TaskComparator {
+			bool operator()(const std::shared_ptr<PrivateCompileTask>& lhs, const std::shared_ptr<PrivateCompileTask>& rhs) const {
+				if (lhs->priority != rhs->priority) {
+					return lhs->priority < rhs->priority;
+				}
+				return lhs->sequence > rhs->sequence;
+			};
+		};
+
+		// this is shared with the worker threads so that they can safely outlive the queue.
+		// this can happen when the last reference to the device is dropped by a task running on one of the workers.
+		struct SharedState {
+			std::mutex mutex;
+			std::condition_variable condition;
+			bool stopping = false;
+			uint64_t nextSequence = 0;
+			std::priority_queue<std::shared_ptr<PrivateCompileTask>, std::vector<std::shared_ptr<PrivateCompileTask>>, TaskComparator> tasks;
+		};
+
+		std::shared_ptr<SharedState> _sharedState;
+		std::vector<std::thread> _threads;
+		size_t _threadCount;
+
+		static void runWorker(std::shared_ptr<SharedState> sharedState);
+
+	public:
+		explicit PrivateCompileQueue(size_t threadCount);
+		~PrivateCompileQueue();
+
+		std::shared_ptr<CompileTask> submit(CompilePriority priority, std::function<void()> work);
+	};
+};
@@ -4,6 +4,7 @@
 #include <indium/command-buffer.private.hpp>
 #include <indium/command-encoder.private.hpp>
 #include <indium/compute-pipeline.private.hpp>
+#include <indium/indirect-command-buffer.private.hpp>
 
 namespace Indium {
 	class PrivateComputeCommandEncoder: public ComputeCommandEncoder {
@@ -16,13 +17,22 @@ namespace Indium {
 		std::shared_ptr<PrivateComputePipelineState> _pso;
 		VkDescriptorPool _pool = VK_NULL_HANDLE;
 
-		// XXX: not sure if we actually need to store pipelines until the command buffer finishes executing,
-		//      but let's do it just in case.
-		std::vector<VkPipeline> _savedPipelines;
-		std::vector<FunctionResources> _savedFunctionResources;
+		// the pipelines are owned by the pipeline states, so we need to keep those alive until the command buffer finishes executing
+		std::vector<std::shared_ptr<PrivateComputePipelineState>> _keepAlivePipelineStates;
 		std::vector<std::shared_ptr<Buffer>> _keepAliveBuffers;
 
-		void updateBindings();
+		// see PrivateRenderCommandEncoder::_indirectFunctionResources
+		FunctionResources _indirectFunctionResources;
+		std::vector<std::shared_ptr<IndirectCommandBuffer>> _keepAliveIndirectCommandBuffers;
+		// see PrivateRenderCommandEncoder::_keepAliveIndirectRecordings
+		std::vector<std::shared_ptr<PrivateIndirectCommandRecording>> _keepAliveIndirectRecordings;
+
+		VkPipelineStageFlags _fenceUpdateStages = VK_PIPELINE_STAGE_NONE;
+
+		void updateBindings(FunctionResources& functionResources);
+		void updateBindings(FunctionResources& functionResources, PrivateComputePipelineState& pso, VkCommandBuffer commandBuffer, VkDescriptorPool pool, UploadHeap& uploadHeap);
+		void executeRecordedCommands(PrivateIndirectCommandBuffer& indirectCommandBuffer, Range<size_t> executionRange);
+		std::shared_ptr<PrivateIndirectCommandRecording> recordIndirectCommands(PrivateIndirectCommandBuffer& indirectCommandBuffer, Range<size_t> executionRange);
 
 	public:
 		PrivateComputeCommandEncoder(std::shared_ptr<PrivateCommandBuffer> commandBuffer, const ComputePassDescriptor& descriptor);
@@ -47,6 +57,8 @@ namespace Indium {
 
 		virtual void dispatchThreadgroups(Size threadgroupsPerGrid, Size threadsPerThreadgroup) override;
 		virtual void dispatchThreads(Size threadsPerGrid, Size threadsPerThreadgroup) override;
+		virtual void dispatchThreadgroups(std::shared_ptr<Buffer> indirectBuffer, size_t indirectBufferOffset, Size threadsPerThreadgroup) override;
+		virtual void executeCommandsInBuffer(std::shared_ptr<IndirectCommandBuffer> indirectCommandBuffer, Range<size_t> executionRange) override;
 
 		virtual void setImageblockSize(size_t width, size_t height) override;
 
@@ -54,6 +66,12 @@ namespace Indium {
 
 		virtual DispatchType dispatchType() override;
 
+		virtual void useResource(std::shared_ptr<Resource> resource, ResourceUsage usage) override;
+		virtual void useResources(const std::vector<std::shared_ptr<Resource>>& resources, ResourceUsage usage) override;
+
+		virtual void updateFence(std::shared_ptr<Fence> fence) override;
+		virtual void waitForFence(std::shared_ptr<Fence> fence) override;
+
 		virtual void endEncoding() override;
 	};
 };
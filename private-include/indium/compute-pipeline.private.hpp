@@ -2,6 +2,25 @@
 
 #include <indium/compute-pipeline.hpp>
 #include <indium/pipeline.private.hpp>
+#include <indium/variant-cache.private.hpp>
+
+#include <unordered_map>
+
+namespace Indium {
+	inline bool operator==(const Size& lhs, const Size& rhs) {
+		return lhs.width == rhs.width && lhs.height == rhs.height && lhs.depth == rhs.depth;
+	};
+};
+
+template<>
+struct std::hash<Indium::Size> {
+	size_t operator()(const Indium::Size& size) const noexcept {
+		size_t result = std::hash<size_t>()(size.width);
+		result = ((result << 1) ^ std::hash<size_t>()(size.height)) >> 1;
+		result = ((result << 1) ^ std::hash<size_t>()(size.depth)) >> 1;
+		return result;
+	};
+};
 
 namespace Indium {
 	class PrivateDevice;
@@ -11,16 +30,25 @@ namespace Indium {
 		std::shared_ptr<PrivateDevice> _privateDevice;
 		ComputePipelineDescriptor _descriptor;
 
+		// like render pipelines, these are compiled lazily (once for each threadgroup size they're dispatched with)
+		// and shared between all the encoders that use this pipeline state.
+		VariantCache<Size, VkPipeline> _pipelines;
+
+		// shared with other pipeline states that have the same binding signature
+		std::shared_ptr<SharedPipelineLayout> _sharedLayout;
+
+		VkPipeline compilePipeline(Size threadsPerThreadgroup);
+
 	public:
 		PrivateComputePipelineState(std::shared_ptr<PrivateDevice> device, const ComputePipelineDescriptor& descriptor);
 		~PrivateComputePipelineState();
 
-		// the pipeline unfortunately has to be recreated on every dispatch since Metal allows setting the number of threads-per-threadgroup
+		// the pipeline unfortunately has to be specialized for each threadgroup size since Metal allows setting the number of threads-per-threadgroup
 		// at dispatch-time in the API while Vulkan only allows setting it within shader code, which usually means it has to be baked-in at
 		// shader compilation time. however, Vulkan *does* allow it to be set with a specialization constant within the shader, which means
 		// that we can set it at pipeline-creation time. thus, we have to create a new pipeline with an updated set of specialization constants
-		// when dispatching the work.
-		VkPipeline createPipeline(Size threadsPerThreadgroup);
+		// for each threadgroup size we see. this returns the pipeline for the given threadgroup size, compiling it if necessary.
+		VkPipeline pipeline(Size threadsPerThreadgroup);
 
 		const FunctionInfo& functionInfo() const;
 
@@ -33,5 +61,8 @@ namespace Indium {
 
 		INDIUM_PROPERTY_REF(DescriptorSetLayouts<1>, d,D,escriptorSetLayouts);
 		INDIUM_PROPERTY_READONLY(VkPipelineLayout, l,L,ayout) = VK_NULL_HANDLE;
+
+		// identifies this pipeline state's descriptor in pipeline manifests (see pipeline-manifest.private.hpp)
+		INDIUM_PROPERTY_READONLY_REF(std::string, m, M,anifestKey);
 	};
 };
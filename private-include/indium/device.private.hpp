@@ -7,21 +7,48 @@
 
 #include <indium/device.hpp>
 #include <indium/types.private.hpp>
+#include <indium/compile-queue.private.hpp>
+#include <indium/intern-table.private.hpp>
+#include <indium/library.private.hpp>
+
+#include <iridium/iridium.hpp>
 
 #include <vector>
+#include <unordered_map>
 #include <mutex>
+#include <shared_mutex>
 #include <functional>
 #include <atomic>
 #include <optional>
 
 namespace Indium {
 	class PrivateDevice;
+	class PrivateLibrary;
+	class PrivateRenderPipelineState;
+	class PrivateComputePipelineState;
+	struct PipelineManifest;
+	struct RenderAttachmentKey;
+	struct RasterizationKey;
+	struct SharedDescriptorSetLayout;
+	struct SharedPipelineLayout;
+	class ResourceTable;
 
 	extern std::vector<std::shared_ptr<PrivateDevice>> globalDeviceList;
 
 	void initGlobalDeviceList();
 	void finitGlobalDeviceList();
 
+	struct TranslatedLibrary {
+		std::vector<char> spirv;
+		Iridium::OutputInfo outputInfo;
+	};
+
+	struct MemorylessAllocation {
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		uint32_t memoryTypeIndex = 0;
+		VkDeviceSize size = 0;
+	};
+
 	class PrivateDevice: public Device, public std::enable_shared_from_this<PrivateDevice> {
 	private:
 
@@ -35,15 +62,88 @@ namespace Indium {
 		std::vector<uint64_t> _eventLoopWaitValues;
 		std::vector<std::function<void()>> _eventLoopCallbacks;
 
+		// translating libraries is expensive, so we keep the results around (keyed by the original library data and the translation options).
+		// binary archives can also add entries to this cache.
+		std::mutex _translatedLibrariesMutex;
+		std::unordered_map<LibraryKey, std::shared_ptr<const TranslatedLibrary>> _translatedLibraries;
+
+		// vkMergePipelineCaches requires exclusive access to the destination cache, while pipeline creation only needs shared access
+		// (implementations synchronize concurrent pipeline creation internally)
+		std::shared_mutex _pipelineCacheMutex;
+
+		std::unique_ptr<PrivateCompileQueue> _compileQueue;
+
+		std::atomic_bool _recordingPipelines = false;
+		std::mutex _recordedPipelinesMutex;
+		std::unique_ptr<PipelineManifest> _recordedPipelines;
+
+		// identical objects are shared device-wide for as long as someone is using them.
+		// pipeline states are keyed by their manifest keys (which describe everything that affects their compilation),
+		// libraries by their library keys, and layouts by their binding signatures.
+		InternTable<std::string, PrivateRenderPipelineState> _renderPipelineStates;
+		InternTable<std::string, PrivateComputePipelineState> _computePipelineStates;
+		InternTable<LibraryKey, PrivateLibrary> _libraries;
+		InternTable<std::string, SharedDescriptorSetLayout> _descriptorSetLayouts;
+		InternTable<std::string, SharedPipelineLayout> _pipelineLayouts;
+
+		// pipeline states compiled by prewarm(); these are kept alive so that they're still in the intern tables when they're actually needed
+		std::mutex _prewarmedPipelineStatesMutex;
+		std::vector<std::shared_ptr<PrivateRenderPipelineState>> _prewarmedRenderPipelineStates;
+		std::vector<std::shared_ptr<PrivateComputePipelineState>> _prewarmedComputePipelineStates;
+
+		// created the first time something needs it (most apps never use resource IDs)
+		std::mutex _resourceTableMutex;
+		std::unique_ptr<ResourceTable> _resourceTable;
+
+		// occlusion query pools that aren't in use by any render encoder; these have already been reset
+		std::mutex _occlusionQueryPoolsMutex;
+		std::vector<VkQueryPool> _occlusionQueryPools;
+
+		// created the first time something needs it (see accumulatePipeline())
+		std::mutex _accumulatePipelineMutex;
+		VkPipelineLayout _accumulatePipelineLayout = VK_NULL_HANDLE;
+		VkPipeline _accumulatePipeline = VK_NULL_HANDLE;
+
+		// memory for memoryless textures that isn't in use (only used when the device has no lazily-allocated memory).
+		// memoryless textures never need their contents to outlive a render pass, so successive ones can reuse the same memory.
+		std::mutex _memorylessAllocationsMutex;
+		std::vector<MemorylessAllocation> _memorylessAllocations;
+
+		std::shared_ptr<PrivateLibrary> createLibrary(const LibraryKey& key, std::shared_ptr<const TranslatedLibrary> translated);
+
 	public:
 		PrivateDevice(VkPhysicalDevice physicalDevice);
 		~PrivateDevice();
 
 		enum class Feature: uint64_t {
-			Swapchain           = 1 << 0,
-			ExternalMemoryFD    = 1 << 1,
-			ExternalSemaphoreFD = 1 << 2,
-			NonSemanticInfo     = 1 << 3,
+			Swapchain                     = 1 << 0,
+			ExternalMemoryFD              = 1 << 1,
+			ExternalSemaphoreFD           = 1 << 2,
+			NonSemanticInfo               = 1 << 3,
+			PipelineLibrary               = 1 << 4,
+			GraphicsPipelineLibrary       = 1 << 5,
+			ExtendedDynamicState3         = 1 << 6,
+			// not an extension; this means that the primitive topology can be dynamically changed to one in a different topology class
+			// (from VK_EXT_extended_dynamic_state3)
+			UnrestrictedPrimitiveTopology = 1 << 7,
+			PushDescriptor                = 1 << 8,
+			// not an extension; this means that the device supports the descriptor indexing features needed for the resource table
+			// (update-after-bind, partially-bound, non-uniformly indexed runtime arrays of sampled images and samplers)
+			DescriptorIndexing            = 1 << 9,
+			// not an extension; this means that the device supports multi-draw indirect with a count buffer
+			// (the `drawIndirectCount` and `multiDrawIndirect` features)
+			DrawIndirectCount             = 1 << 10,
+			// not an extension; this means that occlusion queries can return actual sample counts (the `occlusionQueryPrecise` feature)
+			PreciseOcclusionQuery         = 1 << 11,
+			// not an extension; this means that query pools can be reset on the host (the `hostQueryReset` feature)
+			HostQueryReset                = 1 << 12,
+			// not an extension; this means that triangles can be rasterized as lines (the `fillModeNonSolid` feature)
+			FillModeNonSolid              = 1 << 13,
+			// not an extension; this means that depth can be clamped rather than clipped (the `depthClamp` feature)
+			DepthClamp                    = 1 << 14,
+			// VK_EXT_nested_command_buffer, but only if a rendering instance can mix inline commands with secondary command buffers
+			// (the `nestedCommandBuffer` feature)
+			NestedCommandBuffer           = 1 << 15,
 		};
 
 		friend inline Feature operator|(Feature lhs, Feature rhs) {
@@ -63,12 +163,26 @@ namespace Indium {
 		virtual std::shared_ptr<RenderPipelineState> newRenderPipelineState(const RenderPipelineDescriptor& descriptor) override;
 		virtual std::shared_ptr<ComputePipelineState> newComputePipelineState(const ComputePipelineDescriptor& descriptor, PipelineOption options, std::shared_ptr<ComputePipelineReflection> reflection) override;
 		virtual std::shared_ptr<ComputePipelineState> newComputePipelineState(std::shared_ptr<Function> computeFunction, PipelineOption options = PipelineOption::None, std::shared_ptr<ComputePipelineReflection> reflection = nullptr) override;
+		virtual std::shared_ptr<CompileTask> newRenderPipelineState(const RenderPipelineDescriptor& descriptor, NewRenderPipelineStateCompletionHandler completionHandler, CompilePriority priority = CompilePriority::Normal) override;
+		virtual std::shared_ptr<CompileTask> newComputePipelineState(const ComputePipelineDescriptor& descriptor, PipelineOption options, NewComputePipelineStateCompletionHandler completionHandler, CompilePriority priority) override;
+		virtual std::shared_ptr<CompileTask> newComputePipelineState(std::shared_ptr<Function> computeFunction, NewComputePipelineStateCompletionHandler completionHandler, CompilePriority priority = CompilePriority::Normal) override;
 		virtual std::shared_ptr<Buffer> newBuffer(size_t length, ResourceOptions options) override;
 		virtual std::shared_ptr<Buffer> newBuffer(const void* pointer, size_t length, ResourceOptions options) override;
 		virtual std::shared_ptr<Library> newLibrary(const void* data, size_t length) override;
 		virtual std::shared_ptr<Texture> newTexture(const TextureDescriptor& descriptor) override;
 		virtual std::shared_ptr<SamplerState> newSamplerState(const SamplerDescriptor& descriptor) override;
 		virtual std::shared_ptr<DepthStencilState> newDepthStencilState(const DepthStencilDescriptor& descriptor) override;
+		virtual std::shared_ptr<Fence> newFence() override;
+		virtual std::shared_ptr<Event> newEvent() override;
+		virtual std::shared_ptr<SharedEvent> newSharedEvent() override;
+		virtual std::shared_ptr<SharedEvent> newSharedEvent(const SharedEventHandle& handle) override;
+		virtual std::shared_ptr<BinaryArchive> newBinaryArchive(const BinaryArchiveDescriptor& descriptor) override;
+		virtual std::shared_ptr<ArgumentEncoder> newArgumentEncoder(const std::vector<ArgumentDescriptor>& arguments) override;
+		virtual std::shared_ptr<IndirectCommandBuffer> newIndirectCommandBuffer(const IndirectCommandBufferDescriptor& descriptor, size_t maxCommandCount, ResourceOptions options) override;
+
+		virtual void startPipelineRecording() override;
+		virtual void stopPipelineRecording(const std::string& manifestURL) override;
+		virtual void prewarm(const std::string& manifestURL) override;
 
 		virtual void pollEvents(uint64_t timeoutNanoseconds) override;
 		virtual void wakeupEventLoop() override;
@@ -93,6 +207,90 @@ namespace Indium {
 
 		std::shared_ptr<BinarySemaphore> getWrappedBinarySemaphore(bool exportable = false);
 
+		// must be held while creating pipelines with pipelineCache()
+		std::shared_lock<std::shared_mutex> lockPipelineCache();
+
+		std::shared_ptr<const TranslatedLibrary> translatedLibrary(const LibraryKey& key);
+		void addTranslatedLibrary(const LibraryKey& key, std::shared_ptr<const TranslatedLibrary> library);
+
+		/**
+		 * Returns the library for an already-translated library, creating it if there isn't one alive already.
+		 */
+		std::shared_ptr<PrivateLibrary> newLibrary(const LibraryKey& key, std::shared_ptr<const TranslatedLibrary> translated);
+
+		std::shared_ptr<SharedDescriptorSetLayout> internDescriptorSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings, bool pushDescriptor = false);
+		/**
+		 * @param useResourceTable Whether to add the resource table's set layout after the given set layouts.
+		 */
+		std::shared_ptr<SharedPipelineLayout> internPipelineLayout(const std::vector<std::shared_ptr<SharedDescriptorSetLayout>>& setLayouts, const std::vector<VkPushConstantRange>& pushConstantRanges, bool useResourceTable = false);
+
+		/**
+		 * Returns the device-wide resource table, creating it if necessary.
+		 *
+		 * @note This requires Feature::DescriptorIndexing.
+		 */
+		ResourceTable& resourceTable();
+
+		// the number of queries in each pool returned by takeOcclusionQueryPool()
+		static constexpr uint32_t occlusionQueryPoolSize = 64;
+
+		/**
+		 * Returns an occlusion query pool (with `occlusionQueryPoolSize` queries) that's ready to be used, creating one if necessary.
+		 *
+		 * @note This requires Feature::HostQueryReset.
+		 */
+		VkQueryPool takeOcclusionQueryPool();
+
+		/**
+		 * Resets the given occlusion query pool and makes it available to takeOcclusionQueryPool() again.
+		 * This must only be called once the GPU is done with the pool.
+		 */
+		void recycleOcclusionQueryPool(VkQueryPool pool);
+
+		/**
+		 * Returns a compute pipeline (and its layout) that adds the `uint64_t` at one address to the `uint64_t` at another, creating it if necessary.
+		 * The addresses are passed as push constants (see Iridium::buildAccumulateShader()), and each addition is a single threadgroup.
+		 */
+		std::pair<VkPipeline, VkPipelineLayout> accumulatePipeline();
+
+		/**
+		 * Returns memory of the given type that's at least `size` bytes long for a memoryless texture, reusing memory from a previous one if possible.
+		 */
+		MemorylessAllocation takeMemorylessAllocation(uint32_t memoryTypeIndex, VkDeviceSize size);
+
+		/**
+		 * Makes the given memory available to takeMemorylessAllocation() again.
+		 * This must only be called once the GPU is done with the texture that was using it.
+		 */
+		void recycleMemorylessAllocation(const MemorylessAllocation& allocation);
+
+		/**
+		 * Records that the given pipeline variant was used, if pipeline recording is active.
+		 */
+		void recordRenderPipelineVariant(const std::string& manifestKey, PrimitiveTopologyClass topologyClass, const RenderAttachmentKey& attachmentKey, const RasterizationKey& rasterizationKey);
+		void recordComputePipelineVariant(const std::string& manifestKey, Size threadsPerThreadgroup);
+
+		// returns the threadgroup sizes recorded for the given compute pipeline so far (nothing if the device isn't recording)
+		std::vector<Size> recordedComputePipelineVariants(const std::string& manifestKey);
+
+		/**
+		 * Drops all the pipeline states compiled by prewarm().
+		 *
+		 * @note Pipeline states keep their device alive, so this has to be called before the device can be destroyed.
+		 */
+		void discardPrewarmedPipelineStates();
+
+		/**
+		 * Retrieves the current contents of the device-wide pipeline cache.
+		 */
+		std::vector<char> pipelineCacheData();
+
+		/**
+		 * Merges the given pipeline cache data (previously retrieved with pipelineCacheData()) into the device-wide pipeline cache.
+		 * Data that isn't compatible with this device is ignored.
+		 */
+		void mergePipelineCacheData(const void* data, size_t length);
+
 		INDIUM_PROPERTY(VkPhysicalDevice, p, P,hysicalDevice) = VK_NULL_HANDLE;
 		INDIUM_PROPERTY(VkPhysicalDeviceProperties, p, P,roperties);
 		INDIUM_PROPERTY(VkDevice, d, D,evice) = VK_NULL_HANDLE;
@@ -108,8 +306,14 @@ namespace Indium {
 		INDIUM_PROPERTY(VkQueue, t, T,ransferQueue) = VK_NULL_HANDLE;
 		//INDIUM_PROPERTY(VkQueue, p, P,resentQueue) = VK_NULL_HANDLE;
 		INDIUM_PROPERTY(VkCommandPool, o,O,neshotCommandPool) = VK_NULL_HANDLE;
+		// used for all pipelines created on this device
+		INDIUM_PROPERTY(VkPipelineCache, p, P,ipelineCache) = VK_NULL_HANDLE;
 
 		INDIUM_PROPERTY(VkPhysicalDeviceMemoryProperties, m, M,emoryProperties);
 		INDIUM_PROPERTY_READONLY(Feature, f, F,eatures);
+		// only valid with Feature::PushDescriptor
+		INDIUM_PROPERTY_READONLY(uint32_t, m, M,axPushDescriptors) = 0;
+		// sample-zero resolves are always supported; min and max resolves are optional
+		INDIUM_PROPERTY_READONLY(VkResolveModeFlags, s, S,upportedDepthResolveModes) = VK_RESOLVE_MODE_SAMPLE_ZERO_BIT;
 	};
 };
@@ -74,7 +74,8 @@ namespace Indium {
 			_macro(vkBeginCommandBuffer) \
 			_macro(vkBindBufferMemory) \
 			_macro(vkBindImageMemory) \
-			_macro(vkCmdBeginRenderPass) \
+			_macro(vkCmdBeginQuery) \
+			_macro(vkCmdBeginRendering) \
 			_macro(vkCmdBindDescriptorSets) \
 			_macro(vkCmdBindIndexBuffer) \
 			_macro(vkCmdBindPipeline) \
@@ -84,21 +85,34 @@ namespace Indium {
 			_macro(vkCmdCopyBufferToImage) \
 			_macro(vkCmdCopyImage) \
 			_macro(vkCmdCopyImageToBuffer) \
+			_macro(vkCmdCopyQueryPoolResults) \
 			_macro(vkCmdDispatch) \
+			_macro(vkCmdDispatchIndirect) \
 			_macro(vkCmdDraw) \
 			_macro(vkCmdDrawIndexed) \
-			_macro(vkCmdEndRenderPass) \
+			_macro(vkCmdDrawIndexedIndirect) \
+			_macro(vkCmdDrawIndexedIndirectCount) \
+			_macro(vkCmdDrawIndirect) \
+			_macro(vkCmdDrawIndirectCount) \
+			_macro(vkCmdEndQuery) \
+			_macro(vkCmdEndRendering) \
+			_macro(vkCmdExecuteCommands) \
 			_macro(vkCmdFillBuffer) \
 			_macro(vkCmdPipelineBarrier) \
+			_macro(vkCmdPushConstants) \
+			_macro(vkCmdPushDescriptorSetKHR) \
+			_macro(vkCmdPushDescriptorSetWithTemplateKHR) \
 			_macro(vkCmdSetBlendConstants) \
 			_macro(vkCmdSetCullMode) \
 			_macro(vkCmdSetDepthBias) \
 			_macro(vkCmdSetDepthBiasEnable) \
 			_macro(vkCmdSetDepthBoundsTestEnable) \
+			_macro(vkCmdSetDepthClampEnableEXT) \
 			_macro(vkCmdSetDepthCompareOp) \
 			_macro(vkCmdSetDepthTestEnable) \
 			_macro(vkCmdSetDepthWriteEnable) \
 			_macro(vkCmdSetFrontFace) \
+			_macro(vkCmdSetPolygonModeEXT) \
 			_macro(vkCmdSetPrimitiveTopology) \
 			_macro(vkCmdSetRasterizerDiscardEnable) \
 			_macro(vkCmdSetScissorWithCount) \
@@ -114,14 +128,15 @@ namespace Indium {
 			_macro(vkCreateDebugUtilsMessengerEXT) \
 			_macro(vkCreateDescriptorPool) \
 			_macro(vkCreateDescriptorSetLayout) \
+			_macro(vkCreateDescriptorUpdateTemplate) \
 			_macro(vkCreateDevice) \
 			_macro(vkCreateFence) \
-			_macro(vkCreateFramebuffer) \
 			_macro(vkCreateGraphicsPipelines) \
 			_macro(vkCreateImage) \
 			_macro(vkCreateImageView) \
+			_macro(vkCreatePipelineCache) \
 			_macro(vkCreatePipelineLayout) \
-			_macro(vkCreateRenderPass) \
+			_macro(vkCreateQueryPool) \
 			_macro(vkCreateSampler) \
 			_macro(vkCreateSemaphore) \
 			_macro(vkCreateShaderModule) \
@@ -131,15 +146,16 @@ namespace Indium {
 			_macro(vkDestroyDebugUtilsMessengerEXT) \
 			_macro(vkDestroyDescriptorPool) \
 			_macro(vkDestroyDescriptorSetLayout) \
+			_macro(vkDestroyDescriptorUpdateTemplate) \
 			_macro(vkDestroyDevice) \
 			_macro(vkDestroyFence) \
-			_macro(vkDestroyFramebuffer) \
 			_macro(vkDestroyImage) \
 			_macro(vkDestroyImageView) \
 			_macro(vkDestroyInstance) \
 			_macro(vkDestroyPipeline) \
+			_macro(vkDestroyPipelineCache) \
 			_macro(vkDestroyPipelineLayout) \
-			_macro(vkDestroyRenderPass) \
+			_macro(vkDestroyQueryPool) \
 			_macro(vkDestroySampler) \
 			_macro(vkDestroySemaphore) \
 			_macro(vkDestroyShaderModule) \
@@ -163,12 +179,17 @@ namespace Indium {
 			_macro(vkGetPhysicalDeviceSurfaceCapabilitiesKHR) \
 			_macro(vkGetPhysicalDeviceSurfaceFormatsKHR) \
 			_macro(vkGetPhysicalDeviceSurfacePresentModesKHR) \
+			_macro(vkGetPipelineCacheData) \
 			_macro(vkGetSemaphoreCounterValue) \
+			_macro(vkGetSemaphoreFdKHR) \
 			_macro(vkGetSwapchainImagesKHR) \
+			_macro(vkImportSemaphoreFdKHR) \
 			_macro(vkMapMemory) \
+			_macro(vkMergePipelineCaches) \
 			_macro(vkQueuePresentKHR) \
 			_macro(vkQueueSubmit) \
 			_macro(vkQueueSubmit2) \
+			_macro(vkResetQueryPool) \
 			_macro(vkSignalSemaphore) \
 			_macro(vkUnmapMemory) \
 			_macro(vkUpdateDescriptorSets) \
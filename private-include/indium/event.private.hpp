@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <indium/event.hpp>
+#include <indium/base.hpp>
+
+namespace Indium {
+	class PrivateDevice;
+
+	/**
+	 * Events are backed by timeline semaphores, so they can be waited on and signaled directly in queue submissions.
+	 *
+	 * Plain (non-shared) events are just shared events that can't be exported.
+	 */
+	class PrivateSharedEvent: public SharedEvent, public std::enable_shared_from_this<PrivateSharedEvent> {
+	private:
+		std::shared_ptr<PrivateDevice> _privateDevice;
+		bool _exportable;
+
+	public:
+		PrivateSharedEvent(std::shared_ptr<PrivateDevice> device, bool exportable);
+		PrivateSharedEvent(std::shared_ptr<PrivateDevice> device, const SharedEventHandle& handle);
+		virtual ~PrivateSharedEvent();
+
+		virtual std::shared_ptr<Indium::Device> device() override;
+
+		virtual uint64_t signaledValue() override;
+		virtual void setSignaledValue(uint64_t value) override;
+		virtual void notifyListener(uint64_t value, NotificationHandler handler) override;
+		virtual SharedEventHandle newSharedEventHandle() override;
+
+		INDIUM_PROPERTY(VkSemaphore, s, S,emaphore) = VK_NULL_HANDLE;
+	};
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <indium/fence.hpp>
+
+namespace Indium {
+	class PrivateDevice;
+
+	/**
+	 * Fences are implemented with plain pipeline barriers.
+	 *
+	 * All of our command buffers are submitted on the same queue, so a barrier recorded when an encoder that updates
+	 * a fence ends is enough to order it before everything submitted after it (including later command buffers).
+	 * This means waiting on a fence doesn't need to record anything, which is nice because waits in render encoders
+	 * happen inside a render pass.
+	 */
+	class PrivateFence: public Fence {
+	private:
+		std::shared_ptr<PrivateDevice> _privateDevice;
+
+	public:
+		explicit PrivateFence(std::shared_ptr<PrivateDevice> device);
+		virtual ~PrivateFence();
+
+		virtual std::shared_ptr<Indium::Device> device() override;
+
+		/**
+		 * Records the barrier that makes all fence updates performed by an encoder visible to all subsequent commands.
+		 *
+		 * @param sourceStages The stages of the encoder that must complete before the fences are considered updated.
+		 *                     If this is `VK_PIPELINE_STAGE_NONE`, no fences were updated and nothing is recorded.
+		 */
+		static void encodeUpdates(VkCommandBuffer commandBuffer, VkPipelineStageFlags sourceStages);
+	};
+};
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <indium/indirect-command-buffer.hpp>
+#include <indium/upload-heap.private.hpp>
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <variant>
+#include <vector>
+
+namespace Indium {
+	class PrivateDevice;
+	class PrivateBuffer;
+	class PrivateRenderPipelineState;
+	class PrivateComputePipelineState;
+
+	/**
+	 * A range of commands from an indirect command buffer, recorded into a secondary command buffer so that executing them again
+	 * is just a matter of executing that command buffer.
+	 *
+	 * Secondary command buffers don't inherit any state from the command buffer that executes them, so a recording is only valid for the state
+	 * it was recorded with: along with the range, each recording has a key that describes everything else it depends on (e.g. a render encoder's attachment formats
+	 * and dynamic state). The recording owns everything its commands need that would otherwise come from the executing command buffer
+	 * (descriptor sets and uploads), and it keeps the resources its commands use alive, since the indirect command buffer itself can change in the meantime.
+	 */
+	class PrivateIndirectCommandRecording {
+		INDIUM_PREVENT_COPY(PrivateIndirectCommandRecording);
+
+	private:
+		std::shared_ptr<PrivateDevice> _privateDevice;
+		VkCommandPool _commandPool = VK_NULL_HANDLE;
+		VkCommandBuffer _commandBuffer = VK_NULL_HANDLE;
+		VkDescriptorPool _descriptorPool = VK_NULL_HANDLE;
+		UploadHeap _uploadHeap;
+		Range<size_t> _range;
+		std::vector<char> _key;
+		std::vector<std::shared_ptr<void>> _resources;
+
+	public:
+		/**
+		 * @param descriptorSetCount The maximum number of descriptor sets the commands can allocate.
+		 */
+		PrivateIndirectCommandRecording(std::shared_ptr<PrivateDevice> device, Range<size_t> range, std::vector<char> key, size_t descriptorSetCount);
+		~PrivateIndirectCommandRecording();
+
+		/**
+		 * Begins recording.
+		 *
+		 * @param inheritanceInfo The `pNext` chain for the command buffer's inheritance info (e.g. the rendering info for render commands), if any.
+		 */
+		void begin(VkCommandBufferUsageFlags flags, const void* inheritanceInfo);
+		void end();
+
+		/**
+		 * Keeps the given resource alive for as long as this recording is.
+		 */
+		void retain(std::shared_ptr<void> resource) {
+			if (_resources.empty() || _resources.back() != resource) {
+				_resources.push_back(std::move(resource));
+			}
+		};
+
+		VkCommandBuffer commandBuffer() const {
+			return _commandBuffer;
+		};
+
+		VkDescriptorPool descriptorPool() const {
+			return _descriptorPool;
+		};
+
+		UploadHeap& uploadHeap() {
+			return _uploadHeap;
+		};
+
+		bool matches(Range<size_t> range, const std::vector<char>& key) const {
+			return _range.start == range.start && _range.length == range.length && _key == key;
+		};
+	};
+
+	/**
+	 * Indirect command buffers are stored on the CPU, where each command is stored fully resolved (with the casts and validation already done).
+	 *
+	 * Wherever we can, encoders record the commands they execute into secondary command buffers (see PrivateIndirectCommandRecording) and cache them here,
+	 * so that executing the same commands again with the same state doesn't have to record anything. Compute commands can always be executed this way,
+	 * but render commands need VK_EXT_nested_command_buffer, since a rendering instance can't otherwise mix inline commands with secondary command buffers.
+	 * Otherwise (or when the commands inherit the encoder's pipeline state or buffers, which secondary command buffers can't), the encoders replay
+	 * the commands themselves, which is about as cheap as recording the Vulkan commands directly.
+	 */
+	class PrivateIndirectCommandBuffer: public IndirectCommandBuffer, public std::enable_shared_from_this<PrivateIndirectCommandBuffer> {
+	public:
+		struct BufferBinding {
+			std::shared_ptr<Buffer> buffer;
+			size_t offset = 0;
+		};
+
+		struct Draw {
+			PrimitiveType primitiveType;
+			size_t vertexStart;
+			size_t vertexCount;
+			size_t instanceCount;
+			size_t baseInstance;
+		};
+
+		struct DrawIndexed {
+			PrimitiveType primitiveType;
+			size_t indexCount;
+			IndexType indexType;
+			std::shared_ptr<PrivateBuffer> indexBuffer;
+			size_t indexBufferOffset;
+			size_t instanceCount;
+			int64_t baseVertex;
+			size_t baseInstance;
+		};
+
+		struct Dispatch {
+			Size threadgroupsPerGrid;
+			Size threadsPerThreadgroup;
+		};
+
+		struct RenderCommand {
+			// only used if the buffer doesn't inherit the pipeline state
+			std::shared_ptr<PrivateRenderPipelineState> pipelineState;
+			// indexed by stage (0 is vertex, 1 is fragment); only used if the buffer doesn't inherit buffers
+			std::array<std::vector<BufferBinding>, 2> buffers;
+			// empty commands (i.e. ones that were never encoded or were reset) are skipped
+			std::variant<std::monostate, Draw, DrawIndexed> draw;
+		};
+
+		struct ComputeCommand {
+			std::shared_ptr<PrivateComputePipelineState> pipelineState;
+			std::vector<BufferBinding> buffers;
+			std::optional<Dispatch> dispatch;
+		};
+
+	private:
+		std::shared_ptr<PrivateDevice> _privateDevice;
+		IndirectCommandBufferDescriptor _descriptor;
+		size_t _size;
+		HazardTrackingMode _hazardTrackingMode;
+		// whether this buffer contains render commands (rather than compute commands); buffers can't mix the two
+		bool _containsRenderCommands;
+
+		std::vector<RenderCommand> _renderCommands;
+		std::vector<ComputeCommand> _computeCommands;
+
+		// every command buffer that executes a recording keeps it alive, so dropping one here never affects commands that were already encoded
+		std::mutex _recordingsMutex;
+		std::vector<std::shared_ptr<PrivateIndirectCommandRecording>> _recordings;
+
+		void checkIndex(size_t commandIndex) const;
+
+	public:
+		PrivateIndirectCommandBuffer(std::shared_ptr<PrivateDevice> device, const IndirectCommandBufferDescriptor& descriptor, size_t maxCommandCount, ResourceOptions options);
+
+		virtual std::shared_ptr<Device> device() override;
+		virtual HazardTrackingMode hazardTrackingMode() const override;
+
+		virtual size_t size() const override;
+
+		virtual std::shared_ptr<IndirectRenderCommand> indirectRenderCommandAtIndex(size_t commandIndex) override;
+		virtual std::shared_ptr<IndirectComputeCommand> indirectComputeCommandAtIndex(size_t commandIndex) override;
+
+		virtual void reset(Range<size_t> range) override;
+
+		const IndirectCommandBufferDescriptor& descriptor() const {
+			return _descriptor;
+		};
+
+		/**
+		 * Throws if the given range isn't entirely within this buffer.
+		 */
+		void checkRange(Range<size_t> range) const;
+
+		bool containsRenderCommands() const {
+			return _containsRenderCommands;
+		};
+
+		bool containsComputeCommands() const {
+			return !_containsRenderCommands;
+		};
+
+		RenderCommand& renderCommand(size_t commandIndex) {
+			return _renderCommands[commandIndex];
+		};
+
+		ComputeCommand& computeCommand(size_t commandIndex) {
+			return _computeCommands[commandIndex];
+		};
+
+		/**
+		 * Returns the cached recording of the given range with the given key, if there is one.
+		 */
+		std::shared_ptr<PrivateIndirectCommandRecording> findRecording(Range<size_t> range, const std::vector<char>& key);
+
+		/**
+		 * Caches the given recording. Only the most recent few recordings are kept.
+		 */
+		void addRecording(std::shared_ptr<PrivateIndirectCommandRecording> recording);
+
+		/**
+		 * Drops all the cached recordings; this has to be called whenever a command changes.
+		 */
+		void invalidateRecordings();
+	};
+
+	class PrivateIndirectRenderCommand: public IndirectRenderCommand {
+	private:
+		// keeps the buffer alive for as long as someone is still encoding into it
+		std::shared_ptr<PrivateIndirectCommandBuffer> _commandBuffer;
+		PrivateIndirectCommandBuffer::RenderCommand& _command;
+
+		void setBuffer(size_t stage, size_t maxBindCount, std::shared_ptr<Buffer> buffer, size_t offset, size_t index);
+
+	public:
+		PrivateIndirectRenderCommand(std::shared_ptr<PrivateIndirectCommandBuffer> commandBuffer, size_t commandIndex);
+
+		virtual void setRenderPipelineState(std::shared_ptr<RenderPipelineState> pipelineState) override;
+		virtual void setVertexBuffer(std::shared_ptr<Buffer> buffer, size_t offset, size_t index) override;
+		virtual void setFragmentBuffer(std::shared_ptr<Buffer> buffer, size_t offset, size_t index) override;
+
+		virtual void drawPrimitives(PrimitiveType primitiveType, size_t vertexStart, size_t vertexCount, size_t instanceCount, size_t baseInstance) override;
+		virtual void drawIndexedPrimitives(PrimitiveType primitiveType, size_t indexCount, IndexType indexType, std::shared_ptr<Buffer> indexBuffer, size_t indexBufferOffset, size_t instanceCount, int64_t baseVertex, size_t baseInstance) override;
+
+		virtual void reset() override;
+	};
+
+	class PrivateIndirectComputeCommand: public IndirectComputeCommand {
+	private:
+		std::shared_ptr<PrivateIndirectCommandBuffer> _commandBuffer;
+		PrivateIndirectCommandBuffer::ComputeCommand& _command;
+
+	public:
+		PrivateIndirectComputeCommand(std::shared_ptr<PrivateIndirectCommandBuffer> commandBuffer, size_t commandIndex);
+
+		virtual void setComputePipelineState(std::shared_ptr<ComputePipelineState> pipelineState) override;
+		virtual void setKernelBuffer(std::shared_ptr<Buffer> buffer, size_t offset, size_t index) override;
+
+		virtual void concurrentDispatchThreadgroups(Size threadgroupsPerGrid, Size threadsPerThreadgroup) override;
+		virtual void concurrentDispatchThreads(Size threadsPerGrid, Size threadsPerThreadgroup) override;
+
+		virtual void reset() override;
+	};
+};
@@ -3,21 +3,28 @@
 #include <indium/indium.hpp>
 
 #include <indium/base.private.hpp>
+#include <indium/binary-archive.private.hpp>
 #include <indium/blit-command-encoder.private.hpp>
 #include <indium/buffer.private.hpp>
 #include <indium/command-buffer.private.hpp>
 #include <indium/command-encoder.hpp>
 #include <indium/command-queue.private.hpp>
+#include <indium/compile-queue.private.hpp>
 #include <indium/compute-command-encoder.private.hpp>
 #include <indium/compute-pipeline.private.hpp>
 #include <indium/depth-stencil.private.hpp>
 #include <indium/device.private.hpp>
 #include <indium/drawable.private.hpp>
 #include <indium/dynamic-vk.hpp>
+#include <indium/event.private.hpp>
+#include <indium/fence.private.hpp>
 #include <indium/instance.private.hpp>
+#include <indium/intern-table.private.hpp>
 #include <indium/library.private.hpp>
+#include <indium/pipeline-manifest.private.hpp>
 #include <indium/render-command-encoder.private.hpp>
 #include <indium/render-pipeline.private.hpp>
 #include <indium/sampler.private.hpp>
+#include <indium/serialization.private.hpp>
 #include <indium/texture.private.hpp>
 #include <indium/types.private.hpp>
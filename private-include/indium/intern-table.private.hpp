@@ -0,0 +1,68 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace Indium {
+	/**
+	 * A thread-safe table of weak references to shared objects, keyed by some description of the object.
+	 *
+	 * This lets us share identical objects (e.g. pipeline states and layouts) without keeping them alive any longer than their users do.
+	 */
+	template<typename Key, typename Value>
+	class InternTable {
+	private:
+		std::mutex _mutex;
+		std::unordered_map<Key, std::weak_ptr<Value>> _entries;
+		size_t _insertionsSinceSweep = 0;
+
+		void sweep() {
+			for (auto it = _entries.begin(); it != _entries.end();) {
+				if (it->second.expired()) {
+					it = _entries.erase(it);
+				} else {
+					++it;
+				}
+			}
+			_insertionsSinceSweep = 0;
+		};
+
+	public:
+		/**
+		 * Returns the live object for the given key, if there is one. Otherwise, this creates a new one with `create` and adds it to the table.
+		 *
+		 * @note The lock isn't held while creating the object (creation can be expensive and can intern other objects),
+		 *       so it's possible for two threads to create an object for the same key at the same time.
+		 *       In that case, the first one to finish wins and the other object is dropped.
+		 */
+		template<typename Factory>
+		std::shared_ptr<Value> intern(const Key& key, Factory&& create) {
+			{
+				std::unique_lock lock(_mutex);
+				auto it = _entries.find(key);
+				if (it != _entries.end()) {
+					if (auto value = it->second.lock()) {
+						return value;
+					}
+				}
+			}
+
+			std::shared_ptr<Value> value = create();
+
+			std::unique_lock lock(_mutex);
+			auto& entry = _entries[key];
+			if (auto existing = entry.lock()) {
+				return existing;
+			}
+			entry = value;
+
+			// expired entries are cleaned up every once in a while (amortized over insertions) so that the table doesn't grow forever
+			if (++_insertionsSinceSweep > _entries.size()) {
+				sweep();
+			}
+
+			return value;
+		};
+	};
+};
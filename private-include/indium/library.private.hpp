@@ -4,6 +4,12 @@
 
 #include <vulkan/vulkan.h>
 
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <type_traits>
 #include <unordered_map>
 #include <string>
 #include <vector>
@@ -15,7 +21,42 @@
 namespace Indium {
 	class PrivateLibrary;
 	class PrivateDevice;
-	class SamplerState;
+	class PrivateSamplerState;
+
+	// Metal's per-function binding limits (for each resource type)
+	static constexpr size_t maxBufferBindings = 31;
+	static constexpr size_t maxTextureBindings = 128;
+	static constexpr size_t maxSamplerBindings = 16;
+
+	/**
+	 * A precomputed summary of a function's bindings, split up by how they're passed to the function.
+	 * This saves the command encoders from having to walk and classify every binding on every draw.
+	 */
+	struct BindingMap {
+		// the Metal binding indices (for each resource type) that end up in the function's descriptor set
+		std::bitset<maxBufferBindings> descriptorBuffers;
+		std::bitset<maxTextureBindings> descriptorTextures;
+		std::bitset<maxSamplerBindings> descriptorSamplers;
+
+		// the Metal binding indices (for each resource type) that are passed in push constants
+		std::bitset<maxBufferBindings> pushConstantBuffers;
+		std::bitset<maxTextureBindings> pushConstantTextures;
+		std::bitset<maxSamplerBindings> pushConstantSamplers;
+
+		// the Metal buffer binding indices whose contents are passed by value in push constants when they're set with setBytes().
+		// these also have an address (which is null in that case) for when they're set with setBuffer().
+		std::bitset<maxBufferBindings> pushConstantContentBuffers;
+
+		// buffers whose addresses are passed in the address UBO, in the order they appear in it
+		std::vector<Iridium::BindingInfo> addressBindings;
+		// textures and samplers (including embedded samplers) that have descriptors of their own
+		std::vector<Iridium::BindingInfo> descriptorBindings;
+		// everything passed in push constants (buffer contents, buffer addresses, and resource IDs)
+		std::vector<Iridium::BindingInfo> pushConstantBindings;
+
+		BindingMap() = default;
+		explicit BindingMap(const std::vector<Iridium::BindingInfo>& bindings);
+	};
 
 	struct FunctionInfo {
 		FunctionType functionType;
@@ -25,14 +66,53 @@ namespace Indium {
 		// in this indexing scheme, all buffers are bound first, followed by stage-ins, followed by textures, followed by samplers.
 		std::vector<Iridium::BindingInfo> bindings;
 		std::vector<Iridium::EmbeddedSampler> embeddedSamplers;
-		std::vector<std::shared_ptr<SamplerState>> embeddedSamplerStates;
+		std::vector<std::shared_ptr<PrivateSamplerState>> embeddedSamplerStates;
+		// the part of the push constant block used by this function (empty if it doesn't use push constants)
+		VkPushConstantRange pushConstantRange {};
+		std::vector<Iridium::ArgumentBufferInfo> argumentBuffers;
+		// whether the function indexes into the device's resource table (e.g. for textures and samplers loaded from argument buffers)
+		bool usesResourceTable = false;
+		// derived from `bindings`
+		BindingMap bindingMap;
+	};
+
+	/**
+	 * Identifies a translated library: the original library data it was translated from, together with the options it was translated with
+	 * (the same library translated with different options produces different SPIR-V and bindings, so they're not interchangeable).
+	 *
+	 * This is written to binary archives and pipeline manifests as-is, so it must not contain any padding.
+	 */
+	struct LibraryKey {
+		enum TranslationFlags: uint64_t {
+			TranslationFlagBindlessResources = 1 << 0,
+
+			// the upper 32 bits hold the push constant block size the library was laid out for
+			TranslationFlagsPushConstantBlockSizeShift = 32,
+		};
+
+		// the SHA-256 digest of the original (untranslated) library data; this has to be stable across runs since it's persisted
+		std::array<uint8_t, 32> sourceDigest {};
+		// the length of the original library data, as an extra check against digest collisions
+		uint64_t sourceLength = 0;
+		// the options the library was translated with (see TranslationFlags)
+		uint64_t translationFlags = 0;
+
+		LibraryKey() = default;
+		LibraryKey(const void* data, size_t length, const Iridium::TranslationOptions& options);
+
+		bool operator==(const LibraryKey& other) const {
+			return sourceDigest == other.sourceDigest && sourceLength == other.sourceLength && translationFlags == other.translationFlags;
+		};
 	};
 
+	static_assert(std::is_trivially_copyable_v<LibraryKey> && sizeof(LibraryKey) == 48);
+
 	class PrivateFunction: public Function {
 	public:
 		PrivateFunction(std::shared_ptr<PrivateLibrary> library, const std::string& name, const FunctionInfo& functionInfo);
 
 		virtual std::shared_ptr<Device> device() override;
+		virtual std::shared_ptr<ArgumentEncoder> newArgumentEncoder(size_t bufferIndex) override;
 
 		INDIUM_PROPERTY_READONLY_OBJECT(PrivateDevice, p, P,rivateDevice);
 
@@ -49,10 +129,11 @@ namespace Indium {
 
 	public:
 		/**
+		 * @param key Identifies the original library data that this library was translated from (and how it was translated).
 		 * @param data A buffer containing the SPIR-V bytecode for the library.
 		 * @param functionInfos A map containing function information for each function in the library, keyed by function name.
 		 */
-		PrivateLibrary(std::shared_ptr<PrivateDevice> device, const char* data, size_t dataLength, FunctionInfoMap functionInfos);
+		PrivateLibrary(std::shared_ptr<PrivateDevice> device, const LibraryKey& key, const char* data, size_t dataLength, FunctionInfoMap functionInfos);
 		~PrivateLibrary();
 
 		virtual std::shared_ptr<Function> newFunction(const std::string& name) override;
@@ -61,5 +142,20 @@ namespace Indium {
 		INDIUM_PROPERTY_READONLY_OBJECT(PrivateDevice, p, P,rivateDevice);
 
 		INDIUM_PROPERTY(VkShaderModule, s, S,haderModule) = VK_NULL_HANDLE;
+		// used to look up the translated library in the device
+		INDIUM_PROPERTY_READONLY(LibraryKey, k, K,ey);
+	};
+};
+
+template<>
+struct std::hash<Indium::LibraryKey> {
+	size_t operator()(const Indium::LibraryKey& key) const {
+		// the digest is already uniformly distributed, so any part of it makes a good hash
+		uint64_t digestPrefix;
+		memcpy(&digestPrefix, key.sourceDigest.data(), sizeof(digestPrefix));
+		size_t result = std::hash<uint64_t>()(digestPrefix);
+		result = ((result << 1) ^ std::hash<uint64_t>()(key.sourceLength)) >> 1;
+		result = ((result << 1) ^ std::hash<uint64_t>()(key.translationFlags)) >> 1;
+		return result;
 	};
 };
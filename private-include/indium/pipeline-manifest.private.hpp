@@ -0,0 +1,47 @@
+#pragma once
+
+#include <indium/render-pipeline.private.hpp>
+#include <indium/compute-pipeline.private.hpp>
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace Indium {
+	class PrivateDevice;
+
+	/**
+	 * Pipeline manifests record the pipeline states created on a device together with the pipeline variants that were actually used with each one
+	 * (topology classes and attachment formats for render pipelines, threadgroup sizes for compute pipelines).
+	 * Replaying a manifest with Device::prewarm() compiles all of those variants in the background so they're ready by the time they're needed.
+	 *
+	 * Pipeline states are identified by "manifest keys", which are serialized versions of the parts of their descriptors that affect compilation.
+	 * Functions are referenced by the source hash of their library plus their name, so a manifest can only be replayed for libraries
+	 * that have already been loaded on the device (either with Device::newLibrary() or by loading a binary archive that contains them).
+	 */
+	struct PipelineManifest {
+		std::unordered_map<std::string, std::unordered_set<RenderPipelineVariantKey>> renderPipelines;
+		std::unordered_map<std::string, std::unordered_set<Size>> computePipelines;
+
+		std::vector<char> serialize() const;
+
+		/**
+		 * @note Manifests written by a different version of Indium are treated as empty manifests.
+		 */
+		static PipelineManifest deserialize(const char* data, size_t length);
+	};
+
+	std::string renderPipelineManifestKey(const RenderPipelineDescriptor& descriptor);
+	std::string computePipelineManifestKey(const ComputePipelineDescriptor& descriptor);
+
+	/**
+	 * Reconstructs a pipeline descriptor from its manifest key.
+	 *
+	 * @returns The descriptor, or `std::nullopt` if it references a library that hasn't been loaded on the device.
+	 */
+	std::optional<RenderPipelineDescriptor> renderPipelineDescriptorFromManifestKey(std::shared_ptr<PrivateDevice> device, const std::string& key);
+	std::optional<ComputePipelineDescriptor> computePipelineDescriptorFromManifestKey(std::shared_ptr<PrivateDevice> device, const std::string& key);
+};
@@ -4,9 +4,96 @@
 #include <indium/device.private.hpp>
 #include <indium/dynamic-vk.hpp>
 
+#include <algorithm>
 #include <array>
 
 namespace Indium {
+	// descriptor set layouts and pipeline layouts are interned by the device (see PrivateDevice::internDescriptorSetLayout()
+	// and PrivateDevice::internPipelineLayout()), so pipeline states with the same binding signature share the same layouts
+
+	struct SharedDescriptorSetLayout {
+	private:
+		INDIUM_PREVENT_COPY(SharedDescriptorSetLayout);
+
+	public:
+		std::shared_ptr<PrivateDevice> privateDevice;
+		VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+		// whether this set is updated with push descriptors (rather than allocated from a pool)
+		bool pushDescriptor = false;
+		size_t bindingCount = 0;
+
+		SharedDescriptorSetLayout(std::shared_ptr<PrivateDevice> device, const std::vector<VkDescriptorSetLayoutBinding>& bindings, bool pushDescriptor):
+			privateDevice(device),
+			pushDescriptor(pushDescriptor),
+			bindingCount(bindings.size())
+		{
+			VkDescriptorSetLayoutCreateInfo layoutInfo {};
+			layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+			layoutInfo.flags = pushDescriptor ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR : 0;
+			layoutInfo.bindingCount = bindings.size();
+			layoutInfo.pBindings = bindings.data();
+
+			if (DynamicVK::vkCreateDescriptorSetLayout(privateDevice->device(), &layoutInfo, nullptr, &layout) != VK_SUCCESS) {
+				// TODO
+				abort();
+			}
+		};
+
+		~SharedDescriptorSetLayout() {
+			DynamicVK::vkDestroyDescriptorSetLayout(privateDevice->device(), layout, nullptr);
+		};
+	};
+
+	struct SharedPipelineLayout {
+	private:
+		INDIUM_PREVENT_COPY(SharedPipelineLayout);
+
+	public:
+		std::shared_ptr<PrivateDevice> privateDevice;
+		// the set layouts must outlive the pipeline layout
+		std::vector<std::shared_ptr<SharedDescriptorSetLayout>> setLayouts;
+		VkPipelineLayout layout = VK_NULL_HANDLE;
+
+		/**
+		 * @param resourceTableLayout If not null, this set layout is added after all the other set layouts.
+		 *                            This is the resource table's layout, which is owned by the device (so we don't need to keep it alive ourselves).
+		 */
+		SharedPipelineLayout(std::shared_ptr<PrivateDevice> device, const std::vector<std::shared_ptr<SharedDescriptorSetLayout>>& setLayouts, const std::vector<VkPushConstantRange>& pushConstantRanges, VkDescriptorSetLayout resourceTableLayout = VK_NULL_HANDLE):
+			privateDevice(device),
+			setLayouts(setLayouts)
+		{
+			std::vector<VkDescriptorSetLayout> vkSetLayouts;
+			for (const auto& setLayout: setLayouts) {
+				vkSetLayouts.push_back(setLayout->layout);
+			}
+			if (resourceTableLayout) {
+				vkSetLayouts.push_back(resourceTableLayout);
+			}
+
+			VkPipelineLayoutCreateInfo layoutInfo {};
+			layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+			layoutInfo.setLayoutCount = vkSetLayouts.size();
+			layoutInfo.pSetLayouts = vkSetLayouts.data();
+			layoutInfo.pushConstantRangeCount = pushConstantRanges.size();
+			layoutInfo.pPushConstantRanges = pushConstantRanges.data();
+
+			if (DynamicVK::vkCreatePipelineLayout(privateDevice->device(), &layoutInfo, nullptr, &layout) != VK_SUCCESS) {
+				// TODO
+				abort();
+			}
+		};
+
+		~SharedPipelineLayout() {
+			DynamicVK::vkDestroyPipelineLayout(privateDevice->device(), layout, nullptr);
+		};
+	};
+
+	// the data for push descriptor update templates is an array of these, one for each binding in the set (in binding order)
+	union PushDescriptorData {
+		VkDescriptorImageInfo image;
+		VkDescriptorBufferInfo buffer;
+	};
+
 	template<size_t count>
 	struct DescriptorSetLayouts {
 	private:
@@ -14,34 +101,77 @@ namespace Indium {
 
 	public:
 		std::array<VkDescriptorSetLayout, count> layouts;
+		std::array<std::shared_ptr<SharedDescriptorSetLayout>, count> sharedLayouts;
 		std::shared_ptr<PrivateDevice> privateDevice;
 
+		// only used for push descriptor sets; see createUpdateTemplates()
+		std::array<VkDescriptorUpdateTemplate, count> updateTemplates;
+		// the bindings of each push descriptor set, sorted by binding number (i.e. the binding for each element in the PushDescriptorData array)
+		std::array<std::vector<VkDescriptorSetLayoutBinding>, count> templateBindings;
+
+		// whether any of the functions index into the device's resource table (which is bound right after our sets, i.e. at set `count`)
+		bool usesResourceTable = false;
+
 		DescriptorSetLayouts(std::shared_ptr<PrivateDevice> device):
 			privateDevice(device)
 		{
 			for (size_t i = 0; i < layouts.size(); ++i) {
 				layouts[i] = VK_NULL_HANDLE;
+				updateTemplates[i] = VK_NULL_HANDLE;
 			}
 		};
 
 		~DescriptorSetLayouts() {
-			for (size_t i = 0; i < layouts.size(); ++i) {
-				if (layouts[i] == VK_NULL_HANDLE) {
-					continue;
+			for (auto& updateTemplate: updateTemplates) {
+				if (updateTemplate) {
+					DynamicVK::vkDestroyDescriptorUpdateTemplate(privateDevice->device(), updateTemplate, nullptr);
 				}
-				DynamicVK::vkDestroyDescriptorSetLayout(privateDevice->device(), layouts[i], nullptr);
 			}
 		};
 
-		void processFunction(std::shared_ptr<PrivateFunction> function, size_t layoutIndex) {
+		bool isPushDescriptor(size_t layoutIndex) const {
+			return sharedLayouts[layoutIndex] && sharedLayouts[layoutIndex]->pushDescriptor;
+		};
+
+		/**
+		 * Empty sets (e.g. for functions whose resources are all passed in push constants) never need to be allocated or bound.
+		 */
+		bool isEmpty(size_t layoutIndex) const {
+			return !sharedLayouts[layoutIndex] || sharedLayouts[layoutIndex]->bindingCount == 0;
+		};
+
+		/**
+		 * Returns the (interned) pipeline layout for these set layouts and the given push constant ranges.
+		 *
+		 * @note All the set layouts must have been filled in (with processFunction()) before calling this.
+		 */
+		std::shared_ptr<SharedPipelineLayout> pipelineLayout(const std::vector<VkPushConstantRange>& pushConstantRanges = {}) const {
+			return privateDevice->internPipelineLayout(std::vector<std::shared_ptr<SharedDescriptorSetLayout>>(sharedLayouts.begin(), sharedLayouts.end()), pushConstantRanges, usesResourceTable);
+		};
+
+		/**
+		 * @param allowPushDescriptor Whether this set may use push descriptors (if the device supports them).
+		 *                            Only one set in a pipeline layout can use push descriptors.
+		 */
+		void processFunction(std::shared_ptr<PrivateFunction> function, size_t layoutIndex, bool allowPushDescriptor = false) {
 			size_t index = 0;
 			std::vector<VkDescriptorSetLayoutBinding> bindings;
 
 			bool needUBO = false;
 
+			if (function->functionInfo().usesResourceTable) {
+				usesResourceTable = true;
+			}
+
 			for (const auto bindingInfo: function->functionInfo().bindings) {
 				if (bindingInfo.type == Iridium::BindingType::Buffer) {
-					needUBO = true;
+					// buffers whose addresses are passed in push constants don't need the UBO
+					if (bindingInfo.pushConstantSize == 0) {
+						needUBO = true;
+					}
+				} else if (bindingInfo.pushConstantSize > 0) {
+					// textures and samplers passed by resource ID are looked up in the resource table instead
+					continue;
 				} else if (bindingInfo.type == Iridium::BindingType::Texture) {
 					auto& binding = bindings.emplace_back();
 					binding.binding = bindingInfo.internalIndex;
@@ -66,19 +196,55 @@ namespace Indium {
 				binding.stageFlags = functionTypeToVkShaderStageFlags(function->functionInfo().functionType);
 			}
 
-			VkDescriptorSetLayoutCreateInfo layoutInfo {};
-			layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-			layoutInfo.bindingCount = bindings.size();
-			layoutInfo.pBindings = bindings.data();
+			bool pushDescriptor = allowPushDescriptor && !!(privateDevice->features() & PrivateDevice::Feature::PushDescriptor) && !bindings.empty() && bindings.size() <= privateDevice->maxPushDescriptors();
 
-			VkDescriptorSetLayout layout;
+			sharedLayouts[layoutIndex] = privateDevice->internDescriptorSetLayout(bindings, pushDescriptor);
+			layouts[layoutIndex] = sharedLayouts[layoutIndex]->layout;
 
-			if (DynamicVK::vkCreateDescriptorSetLayout(privateDevice->device(), &layoutInfo, nullptr, &layout) != VK_SUCCESS) {
-				// TODO
-				abort();
+			if (pushDescriptor) {
+				templateBindings[layoutIndex] = bindings;
+				std::sort(templateBindings[layoutIndex].begin(), templateBindings[layoutIndex].end(), [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) {
+					return a.binding < b.binding;
+				});
 			}
+		};
 
-			layouts[layoutIndex] = layout;
+		/**
+		 * Creates the descriptor update templates for the push descriptor sets.
+		 *
+		 * @note This must be called after all the set layouts have been filled in (with processFunction()).
+		 */
+		void createUpdateTemplates(VkPipelineLayout pipelineLayout, VkPipelineBindPoint bindPoint) {
+			for (size_t i = 0; i < count; ++i) {
+				if (!isPushDescriptor(i)) {
+					continue;
+				}
+
+				std::vector<VkDescriptorUpdateTemplateEntry> entries;
+				for (size_t j = 0; j < templateBindings[i].size(); ++j) {
+					auto& entry = entries.emplace_back();
+					entry.dstBinding = templateBindings[i][j].binding;
+					entry.dstArrayElement = 0;
+					entry.descriptorCount = 1;
+					entry.descriptorType = templateBindings[i][j].descriptorType;
+					entry.offset = j * sizeof(PushDescriptorData);
+					entry.stride = sizeof(PushDescriptorData);
+				}
+
+				VkDescriptorUpdateTemplateCreateInfo templateInfo {};
+				templateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+				templateInfo.descriptorUpdateEntryCount = entries.size();
+				templateInfo.pDescriptorUpdateEntries = entries.data();
+				templateInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR;
+				templateInfo.pipelineBindPoint = bindPoint;
+				templateInfo.pipelineLayout = pipelineLayout;
+				templateInfo.set = i;
+
+				if (DynamicVK::vkCreateDescriptorUpdateTemplate(privateDevice->device(), &templateInfo, nullptr, &updateTemplates[i]) != VK_SUCCESS) {
+					// TODO
+					abort();
+				}
+			}
 		};
 	};
 };
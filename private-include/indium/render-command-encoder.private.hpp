@@ -5,10 +5,16 @@
 #include <indium/sampler.private.hpp>
 #include <indium/device.hpp>
 #include <indium/command-encoder.private.hpp>
+#include <indium/render-pipeline.private.hpp>
+#include <indium/depth-stencil.hpp>
+#include <indium/indirect-command-buffer.private.hpp>
+#include <indium/serialization.private.hpp>
 
 #include <vulkan/vulkan.h>
 
 #include <array>
+#include <optional>
+#include <unordered_map>
 #include <variant>
 #include <vector>
 
@@ -26,16 +32,129 @@ namespace Indium {
 		std::weak_ptr<PrivateCommandBuffer> _privateCommandBuffer;
 		std::shared_ptr<PrivateDevice> _privateDevice;
 		std::shared_ptr<PrivateRenderPipelineState> _privatePSO;
-		VkFramebuffer _framebuffer = VK_NULL_HANDLE;
-		VkRenderPass _renderPass = VK_NULL_HANDLE;
+		RenderAttachmentKey _attachmentKey;
+		// without VK_EXT_extended_dynamic_state3, the fill mode and depth clip mode are baked into pipelines, so we keep track of them here
+		// (with it, this always has the defaults).
+		RasterizationKey _rasterizationKey;
+		// the pipelines we've used with the current pipeline state, indexed by topology class. our attachments never change,
+		// so these stay valid until the pipeline state (or the rasterization key) does, and most draws don't have to look anything up in the pipeline state.
+		std::array<VkPipeline, 4> _pipelinesByTopologyClass {};
 		VkDescriptorPool _pool = VK_NULL_HANDLE;
 
-		std::vector<FunctionResources> _savedFunctionResources;
+		// attachments are rendered to in attachment layouts; these transition them back to the layouts they're normally kept in once rendering ends
+		std::vector<VkImageMemoryBarrier> _attachmentEndBarriers;
 
 		std::array<FunctionResources, 2> _functionResources {};
 		std::vector<std::shared_ptr<Buffer>> _keepAliveBuffers;
 
-		void updateBindings();
+		// bindings for commands executed from indirect command buffers that don't inherit buffers.
+		// the indirect command buffers keep these alive, so these never need to retain anything themselves.
+		std::array<FunctionResources, 2> _indirectFunctionResources {};
+		std::vector<std::shared_ptr<IndirectCommandBuffer>> _keepAliveIndirectCommandBuffers;
+		// indirect command buffers drop their recordings whenever they change, so we need to keep the ones we execute alive ourselves
+		std::vector<std::shared_ptr<PrivateIndirectCommandRecording>> _keepAliveIndirectRecordings;
+		// the key for the recordings we execute (see writeIndirectRecordingKey()); we reuse this so that looking up a recording doesn't allocate
+		BinaryWriter _indirectRecordingKey;
+
+		// visibility results are implemented with occlusion queries. every call to setVisibilityResultMode() that enables them begins a new query,
+		// numbered sequentially across our query pools (which come from the device), and each query is copied into the visibility result buffer
+		// at the offset it was begun with once the encoder ends.
+		//
+		// a query can only be used once per render pass, so an offset that's enabled again gets another query. the results of the later queries
+		// for such an offset are added to the first one's on the GPU (see copyVisibilityResults()).
+		std::vector<VkQueryPool> _visibilityQueryPools;
+		std::vector<size_t> _visibilityQueryOffsets;
+		// for each query, the number of queries that were begun for the same offset before it
+		std::vector<size_t> _visibilityQueryReuseIndices;
+		// the number of queries begun for each offset
+		std::unordered_map<size_t, size_t> _visibilityResultOffsetQueryCounts;
+		VisibilityResultMode _visibilityResultMode = VisibilityResultMode::Disabled;
+		size_t _visibilityResultOffset = 0;
+
+		// the stages that have to complete before the fences updated by this encoder are considered updated
+		VkPipelineStageFlags _fenceUpdateStages = VK_PIPELINE_STAGE_NONE;
+
+		struct StencilOpState {
+			VkStencilOp failOp;
+			VkStencilOp passOp;
+			VkStencilOp depthFailOp;
+			VkCompareOp compareOp;
+
+			bool operator==(const StencilOpState& other) const {
+				return failOp == other.failOp && passOp == other.passOp && depthFailOp == other.depthFailOp && compareOp == other.compareOp;
+			};
+		};
+
+		// a copy of the state we've recorded into the command buffer so far.
+		// we use this to filter out commands that wouldn't actually change anything.
+		// an empty value means we haven't recorded that state yet (so it's undefined).
+		struct ShadowState {
+			VkPipeline pipeline = VK_NULL_HANDLE;
+			std::optional<VkPrimitiveTopology> primitiveTopology;
+			std::optional<VkFrontFace> frontFace;
+			std::optional<VkCullModeFlags> cullMode;
+			std::optional<bool> depthBiasEnable;
+			std::optional<std::array<float, 3>> depthBias;
+			std::vector<VkViewport> viewports;
+			std::vector<VkRect2D> scissors;
+			std::optional<std::array<float, 4>> blendConstants;
+			std::optional<bool> depthTestEnable;
+			std::optional<bool> depthWriteEnable;
+			std::optional<VkCompareOp> depthCompareOp;
+			std::optional<bool> depthBoundsTestEnable;
+			std::optional<bool> stencilTestEnable;
+			std::optional<bool> rasterizerDiscardEnable;
+			// only used with VK_EXT_extended_dynamic_state3
+			std::optional<VkPolygonMode> polygonMode;
+			std::optional<bool> depthClampEnable;
+			// indexed by face: 0 is front, 1 is back
+			std::array<std::optional<uint32_t>, 2> stencilCompareMask;
+			std::array<std::optional<uint32_t>, 2> stencilWriteMask;
+			std::array<std::optional<uint32_t>, 2> stencilReference;
+			std::array<std::optional<StencilOpState>, 2> stencilOp;
+			std::vector<VkBuffer> vertexBuffers;
+			std::vector<VkDeviceSize> vertexBufferOffsets;
+			VkBuffer indexBuffer = VK_NULL_HANDLE;
+			VkDeviceSize indexBufferOffset = 0;
+			VkIndexType indexType = VK_INDEX_TYPE_UINT16;
+		};
+
+		ShadowState _shadowState;
+		RenderCommandCounters _commandCounters;
+
+		// returns `true` if the command should be recorded
+		bool filterCommand(bool changed) {
+			if (changed) {
+				++_commandCounters.recordedCommands;
+			} else {
+				++_commandCounters.elidedCommands;
+			}
+			return changed;
+		};
+
+		// updates the given shadow state and returns `true` if the value changed (i.e. if the command should be recorded)
+		template<typename T>
+		bool updateShadowState(std::optional<T>& shadow, const T& value) {
+			if (!filterCommand(!shadow || !(*shadow == value))) {
+				return false;
+			}
+			shadow = value;
+			return true;
+		};
+
+		void setStencilFace(VkStencilFaceFlags face, size_t faceIndex, const std::optional<StencilDescriptor>& stencil);
+		void setStencilReference(VkStencilFaceFlags face, size_t faceIndex, uint32_t value);
+		void bindPipelineForPrimitive(PrimitiveType primitiveType);
+		void updateBindings(std::array<FunctionResources, 2>& functionResources);
+		void bindIndexBuffer(IndexType indexType, PrivateBuffer& indexBuffer, size_t indexBufferOffset);
+		void keepBufferAlive(std::shared_ptr<Buffer> buffer);
+		void finishDraw(std::array<FunctionResources, 2>& functionResources);
+		void recordDynamicState(VkCommandBuffer commandBuffer);
+		void writeIndirectRecordingKey();
+		void executeRecordedCommands(PrivateIndirectCommandBuffer& indirectCommandBuffer, Range<size_t> executionRange);
+		std::shared_ptr<PrivateIndirectCommandRecording> recordIndirectCommands(PrivateIndirectCommandBuffer& indirectCommandBuffer, Range<size_t> executionRange);
+		void endVisibilityQuery();
+		void copyVisibilityResults();
 
 	public:
 		PrivateRenderCommandEncoder(std::shared_ptr<PrivateCommandBuffer> commandBuffer, const RenderPassDescriptor& descriptor);
@@ -67,6 +186,13 @@ namespace Indium {
 		virtual void drawIndexedPrimitives(PrimitiveType primitiveType, size_t indexCount, IndexType indexType, std::shared_ptr<Buffer> indexBuffer, size_t indexBufferOffset, size_t instanceCount) override;
 		virtual void drawIndexedPrimitives(PrimitiveType primitiveType, size_t indexCount, IndexType indexType, std::shared_ptr<Buffer> indexBuffer, size_t indexBufferOffset) override;
 
+		virtual void drawPrimitives(PrimitiveType primitiveType, std::shared_ptr<Buffer> indirectBuffer, size_t indirectBufferOffset) override;
+		virtual void drawIndexedPrimitives(PrimitiveType primitiveType, IndexType indexType, std::shared_ptr<Buffer> indexBuffer, size_t indexBufferOffset, std::shared_ptr<Buffer> indirectBuffer, size_t indirectBufferOffset) override;
+		virtual void drawPrimitives(PrimitiveType primitiveType, std::shared_ptr<Buffer> indirectBuffer, size_t indirectBufferOffset, std::shared_ptr<Buffer> countBuffer, size_t countBufferOffset, size_t maxDrawCount) override;
+		virtual void drawIndexedPrimitives(PrimitiveType primitiveType, IndexType indexType, std::shared_ptr<Buffer> indexBuffer, size_t indexBufferOffset, std::shared_ptr<Buffer> indirectBuffer, size_t indirectBufferOffset, std::shared_ptr<Buffer> countBuffer, size_t countBufferOffset, size_t maxDrawCount) override;
+
+		virtual void executeCommandsInBuffer(std::shared_ptr<IndirectCommandBuffer> indirectCommandBuffer, Range<size_t> executionRange) override;
+
 		virtual void setVertexBytes(const void* bytes, size_t length, size_t index) override;
 		virtual void setVertexBuffer(std::shared_ptr<Buffer> buffer, size_t offset, size_t index) override;
 		virtual void setVertexBuffers(const std::vector<std::shared_ptr<Buffer>>& buffers, const std::vector<size_t>& offsets, Range<size_t> range) override;
@@ -94,6 +220,11 @@ namespace Indium {
 		virtual void useResource(std::shared_ptr<Resource> resource, ResourceUsage usage) override;
 		virtual void useResources(const std::vector<std::shared_ptr<Resource>>& resources, ResourceUsage usage) override;
 
+		virtual void updateFence(std::shared_ptr<Fence> fence, RenderStages afterStages) override;
+		virtual void waitForFence(std::shared_ptr<Fence> fence, RenderStages beforeStages) override;
+
+		virtual RenderCommandCounters commandCounters() const override;
+
 		virtual void endEncoding() override;
 
 		INDIUM_PROPERTY_OBJECT_VECTOR(Texture, r, R,eadOnlyTextures);
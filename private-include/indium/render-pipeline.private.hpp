@@ -2,24 +2,116 @@
 
 #include <indium/render-pipeline.hpp>
 #include <indium/pipeline.private.hpp>
+#include <indium/variant-cache.private.hpp>
 
 #include <vulkan/vulkan.h>
 
 #include <array>
+#include <mutex>
 #include <optional>
+#include <unordered_map>
 
 namespace Indium {
 	class PrivateDevice;
 	class PrivateFunction;
 	struct FunctionInfo;
 
+	// describes everything about the attachments of a render pass that a pipeline needs to be compatible with it
+	struct RenderAttachmentKey {
+		std::vector<VkFormat> colorFormats;
+		VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+		VkFormat stencilFormat = VK_FORMAT_UNDEFINED;
+		size_t sampleCount = 1;
+
+		bool operator==(const RenderAttachmentKey& other) const {
+			return colorFormats == other.colorFormats && depthFormat == other.depthFormat && stencilFormat == other.stencilFormat && sampleCount == other.sampleCount;
+		};
+	};
+
+	// rasterization state that's dynamic with VK_EXT_extended_dynamic_state3 but has to be baked into pipelines without it.
+	// with the extension, this is always left at the defaults.
+	struct RasterizationKey {
+		VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+		bool depthClampEnable = false;
+
+		bool operator==(const RasterizationKey& other) const {
+			return polygonMode == other.polygonMode && depthClampEnable == other.depthClampEnable;
+		};
+	};
+
+	struct RenderPipelineVariantKey {
+		PrimitiveTopologyClass topologyClass;
+		RenderAttachmentKey attachmentKey;
+		RasterizationKey rasterizationKey;
+
+		bool operator==(const RenderPipelineVariantKey& other) const {
+			return topologyClass == other.topologyClass && attachmentKey == other.attachmentKey && rasterizationKey == other.rasterizationKey;
+		};
+	};
+};
+
+template<>
+struct std::hash<Indium::RasterizationKey> {
+	size_t operator()(const Indium::RasterizationKey& key) const noexcept {
+		return (static_cast<size_t>(key.polygonMode) << 1) | (key.depthClampEnable ? 1 : 0);
+	};
+};
+
+template<>
+struct std::hash<Indium::RenderAttachmentKey> {
+	size_t operator()(const Indium::RenderAttachmentKey& key) const noexcept {
+		size_t result = std::hash<size_t>()(key.sampleCount);
+		result = ((result << 1) ^ std::hash<uint32_t>()(key.depthFormat)) >> 1;
+		result = ((result << 1) ^ std::hash<uint32_t>()(key.stencilFormat)) >> 1;
+		for (const auto& format: key.colorFormats) {
+			result = ((result << 1) ^ std::hash<uint32_t>()(format)) >> 1;
+		}
+		return result;
+	};
+};
+
+template<>
+struct std::hash<Indium::RenderPipelineVariantKey> {
+	size_t operator()(const Indium::RenderPipelineVariantKey& key) const noexcept {
+		size_t result = std::hash<Indium::PrimitiveTopologyClass>()(key.topologyClass);
+		result = ((result << 1) ^ std::hash<Indium::RenderAttachmentKey>()(key.attachmentKey)) >> 1;
+		result = ((result << 1) ^ std::hash<Indium::RasterizationKey>()(key.rasterizationKey)) >> 1;
+		return result;
+	};
+};
+
+namespace Indium {
 	class PrivateRenderPipelineState: public RenderPipelineState {
 		private:
 			std::vector<RenderPipelineColorAttachmentDescriptor> _colorAttachments;
 			PrimitiveTopologyClass _primitiveTopology;
+			bool _alphaToCoverageEnabled;
 			std::shared_ptr<PrivateFunction> _vertexFunction;
 			std::shared_ptr<PrivateFunction> _fragmentFunction;
 			std::optional<VertexDescriptor> _vertexDescriptor;
+			std::vector<VkVertexInputBindingDescription> _vertexBindingDescriptions;
+			std::vector<VkVertexInputAttributeDescription> _vertexAttributeDescriptions;
+
+			// pipelines are compiled lazily (the first time they're requested) and shared between all the encoders that use this pipeline state.
+			// this can happen concurrently from multiple threads; different variants can be compiled at the same time.
+			VariantCache<RenderPipelineVariantKey, VkPipeline> _pipelines;
+
+			// shared with other pipeline states that have the same binding signature
+			std::shared_ptr<SharedPipelineLayout> _sharedPipelineLayout;
+
+			// when VK_EXT_graphics_pipeline_library is available, pipelines are linked together from separately-compiled parts
+			// rather than compiled as a whole. each part is only compiled once for each distinct set of properties that affect it
+			// (e.g. the shaders never have to be recompiled when only the attachment formats change).
+			VariantCache<PrimitiveTopologyClass, VkPipeline> _vertexInputLibraries;
+			VariantCache<RasterizationKey, VkPipeline> _preRasterizationLibraries;
+			VariantCache<size_t, VkPipeline> _fragmentShaderLibraries; // keyed by sample count
+			VariantCache<RenderAttachmentKey, VkPipeline> _fragmentOutputLibraries;
+
+			/**
+			 * Compiles a complete pipeline or, if `libraryParts` is non-zero, a pipeline library containing just the given parts.
+			 */
+			VkPipeline compilePipeline(const RenderPipelineVariantKey& key, VkGraphicsPipelineLibraryFlagsEXT libraryParts = 0);
+			VkPipeline linkPipeline(const RenderPipelineVariantKey& key);
 
 		public:
 			PrivateRenderPipelineState(std::shared_ptr<PrivateDevice> device, const RenderPipelineDescriptor& descriptor);
@@ -27,29 +119,27 @@ namespace Indium {
 
 			virtual std::shared_ptr<Device> device() override;
 
-			// TODO: can the same render pipeline state be used in multiple render encoders simultaneously?
-			//       it shouldn't really matter since the render pipeline state must be compatible with the render encoder,
-			//       except that we would have to avoid race conditions when recreating the pipeline.
-			//
-			// TODO: see if we can take advantage of Vulkan render pass compatibility
-			//       and create a dummy render pass using the information we're given
-			//       (which does not include e.g. load and store ops).
-			//       if so, we would always be able to create the pipeline immediately
-			//       in the constructor.
-			void recreatePipeline(VkRenderPass compatibleRenderPass, bool force);
-
 			const FunctionInfo& vertexFunctionInfo();
 			const FunctionInfo& fragmentFunctionInfo();
 
+			/**
+			 * Returns the pipeline for the given topology class that's compatible with the given attachments (and, without VK_EXT_extended_dynamic_state3,
+			 * uses the given rasterization state), compiling it if necessary.
+			 */
+			VkPipeline pipeline(PrimitiveTopologyClass topologyClass, const RenderAttachmentKey& attachmentKey, const RasterizationKey& rasterizationKey = {});
+
 			INDIUM_PROPERTY_READONLY_OBJECT(PrivateDevice, p, P,rivateDevice);
 
-			// one for each topology class
-			using PipelineArray = std::array<VkPipeline, 3>;
-			INDIUM_PROPERTY(PipelineArray, p, P,ipelines) {};
 			INDIUM_PROPERTY(VkPipelineLayout, p, P,ipelineLayout) = VK_NULL_HANDLE;
 
 			INDIUM_PROPERTY_REF(DescriptorSetLayouts<2>, d, D,escriptorSetLayouts);
 
 			INDIUM_PROPERTY_READONLY_REF(std::vector<size_t>, v,V,ertexInputBindings);
+
+			// the attachments described by the descriptor this pipeline state was created with
+			INDIUM_PROPERTY_READONLY_REF(RenderAttachmentKey, d, D,efaultAttachmentKey);
+
+			// identifies this pipeline state's descriptor in pipeline manifests (see pipeline-manifest.private.hpp)
+			INDIUM_PROPERTY_READONLY_REF(std::string, m, M,anifestKey);
 	};
 };
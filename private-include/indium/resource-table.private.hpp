@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <indium/base.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace Indium {
+	/**
+	 * A device-wide descriptor set containing (potentially) every texture and sampler on the device.
+	 *
+	 * Textures and samplers are given slots in the table when their resource IDs are first requested (see PrivateTexture::gpuResourceID()
+	 * and PrivateSamplerState::gpuResourceID()) or when they're first bound to a function that looks them up in the table, and shaders index
+	 * into the table with those IDs (e.g. when loading them from argument buffers).
+	 * The set is created with update-after-bind, so slots can be added and removed while it's bound in command buffers that are still pending.
+	 *
+	 * Slot 0 is never handed out, so a zero resource ID can be used to mean "no resource".
+	 *
+	 * A small part of the table is kept aside for resources that have to be bound through the table while the rest of it is full
+	 * (see addTransientTexture() and addTransientSampler()). Those slots only stay assigned for as long as a binding needs them.
+	 *
+	 * @note This only holds a raw handle to the device (rather than a reference to the PrivateDevice) because it's owned by the device.
+	 */
+	class ResourceTable {
+		INDIUM_PREVENT_COPY(ResourceTable);
+
+	private:
+		VkDevice _device;
+		VkDescriptorPool _pool = VK_NULL_HANDLE;
+
+		std::mutex _mutex;
+		uint32_t _textureCapacity;
+		uint32_t _samplerCapacity;
+		uint32_t _nextTextureSlot = 1;
+		uint32_t _nextSamplerSlot = 1;
+		std::vector<uint32_t> _freeTextureSlots;
+		std::vector<uint32_t> _freeSamplerSlots;
+		std::vector<uint32_t> _freeTransientTextureSlots;
+		std::vector<uint32_t> _freeTransientSamplerSlots;
+
+		void writeDescriptor(uint32_t binding, uint32_t slot, const VkDescriptorImageInfo& imageInfo);
+		std::shared_ptr<const uint32_t> makeTransientSlot(uint32_t slot, std::vector<uint32_t>& freeList);
+
+	public:
+		ResourceTable(VkDevice device, uint32_t textureCapacity, uint32_t samplerCapacity);
+		~ResourceTable();
+
+		// the number of slots (for each resource type) kept aside for transient use
+		static constexpr uint32_t transientTextureSlots = 256;
+		static constexpr uint32_t transientSamplerSlots = 16;
+
+		/**
+		 * Gives the texture a slot that stays assigned until it's removed with removeTexture().
+		 *
+		 * @returns The texture's slot, or nothing if the table is full.
+		 */
+		std::optional<uint32_t> addTexture(VkImageView imageView, VkImageLayout imageLayout);
+		std::optional<uint32_t> addSampler(VkSampler sampler);
+
+		void removeTexture(uint32_t slot);
+		void removeSampler(uint32_t slot);
+
+		/**
+		 * Gives the texture one of the transient slots, which is freed once the returned slot is released.
+		 * The slot must be kept alive until every command using it has completed.
+		 */
+		std::shared_ptr<const uint32_t> addTransientTexture(VkImageView imageView, VkImageLayout imageLayout);
+		std::shared_ptr<const uint32_t> addTransientSampler(VkSampler sampler);
+
+		INDIUM_PROPERTY_READONLY(VkDescriptorSetLayout, s, S,etLayout) = VK_NULL_HANDLE;
+		INDIUM_PROPERTY_READONLY(VkDescriptorSet, d, D,escriptorSet) = VK_NULL_HANDLE;
+	};
+};
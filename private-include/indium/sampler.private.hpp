@@ -4,6 +4,9 @@
 
 #include <indium/sampler.hpp>
 
+#include <mutex>
+#include <optional>
+
 namespace Indium {
 	class PrivateDevice;
 
@@ -12,11 +15,22 @@ namespace Indium {
 		std::shared_ptr<PrivateDevice> _privateDevice = nullptr;
 		SamplerDescriptor _descriptor;
 
+		// our slot in the device's resource table; assigned the first time someone needs it (see resourceTableSlot())
+		std::mutex _resourceIDMutex;
+		std::optional<uint32_t> _resourceTableSlot;
+
 	public:
 		explicit PrivateSamplerState(std::shared_ptr<PrivateDevice> device, const SamplerDescriptor& descriptor);
 		virtual ~PrivateSamplerState();
 
 		virtual std::shared_ptr<Indium::Device> device() override;
+		virtual ResourceID gpuResourceID() override;
+
+		/**
+		 * Returns our slot in the resource table, assigning one if we don't have one yet.
+		 * Unlike gpuResourceID(), this returns nothing (rather than throwing) if the table is full.
+		 */
+		std::optional<uint32_t> resourceTableSlot();
 
 		std::shared_ptr<PrivateSamplerState> cloneWithClamps(float lodMinClamp, float lodMaxClamp);
 
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// helpers for the simple binary formats we write to disk (binary archives and pipeline manifests).
+// all integers are written in native byte order; none of these files are meant to be portable between machines anyway.
+
+namespace Indium {
+	struct BinaryWriter {
+		std::vector<char> data;
+
+		void write(const void* bytes, size_t length) {
+			data.insert(data.end(), static_cast<const char*>(bytes), static_cast<const char*>(bytes) + length);
+		};
+
+		template<typename T>
+		void write(const T& value) {
+			write(&value, sizeof(T));
+		};
+
+		void writeBlob(const void* bytes, size_t length) {
+			write<uint64_t>(length);
+			write(bytes, length);
+		};
+
+		void writeString(std::string_view string) {
+			writeBlob(string.data(), string.size());
+		};
+	};
+
+	struct BinaryReader {
+		const char* data;
+		size_t length;
+		size_t offset = 0;
+
+		const char* read(size_t count) {
+			if (length - offset < count) {
+				throw std::runtime_error("Invalid binary data (truncated)");
+			}
+			auto result = data + offset;
+			offset += count;
+			return result;
+		};
+
+		template<typename T>
+		T read() {
+			T value;
+			memcpy(&value, read(sizeof(T)), sizeof(T));
+			return value;
+		};
+
+		std::string_view readBlob() {
+			auto blobLength = read<uint64_t>();
+			return std::string_view(read(blobLength), blobLength);
+		};
+	};
+
+	inline std::string urlToPath(const std::string& url) {
+		static constexpr std::string_view fileScheme = "file://";
+
+		if (url.compare(0, fileScheme.size(), fileScheme) == 0) {
+			return url.substr(fileScheme.size());
+		}
+
+		return url;
+	};
+};
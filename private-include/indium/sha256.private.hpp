@@ -0,0 +1,15 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace Indium {
+	/**
+	 * Computes the SHA-256 digest of the given data.
+	 *
+	 * This identifies library data in caches that outlive the process (e.g. binary archives), so it has to be stable across runs and builds
+	 * (unlike `std::hash`) and strong enough that different data never realistically ends up with the same digest.
+	 */
+	std::array<uint8_t, 32> sha256(const void* data, size_t length);
+};
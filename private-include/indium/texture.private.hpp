@@ -4,8 +4,10 @@
 
 #include <indium/texture.hpp>
 #include <indium/types.private.hpp>
+#include <indium/device.private.hpp>
 
 #include <mutex>
+#include <optional>
 #include <unordered_map>
 
 namespace Indium {
@@ -27,6 +29,11 @@ namespace Indium {
 		std::shared_ptr<BinarySemaphore> _presentationSemaphore;
 		std::shared_ptr<PrivateDevice> _device;
 
+		// our slot in the device's resource table. this is assigned the first time someone needs it (see resourceTableSlot()),
+		// so textures that are never used through the table don't take up any room in it.
+		std::mutex _resourceIDMutex;
+		std::optional<uint32_t> _resourceTableSlot;
+
 	public:
 		explicit PrivateTexture(std::shared_ptr<PrivateDevice> device);
 		virtual ~PrivateTexture() = 0;
@@ -37,6 +44,20 @@ namespace Indium {
 
 		virtual std::shared_ptr<Indium::Device> device() override;
 
+		/**
+		 * Textures are tracked by default (e.g. drawables always need to be synchronized with presentation).
+		 * Textures created with `HazardTrackingModeUntracked` override this and are skipped when committing command buffers.
+		 */
+		virtual HazardTrackingMode hazardTrackingMode() const override;
+
+		virtual ResourceID gpuResourceID() override;
+
+		/**
+		 * Returns our slot in the resource table, assigning one if we don't have one yet.
+		 * Unlike gpuResourceID(), this returns nothing (rather than throwing) if the table is full.
+		 */
+		std::optional<uint32_t> resourceTableSlot();
+
 		/**
 		 * Returns a pointer to a Vulkan image view that Indium can use internally.
 		 *
@@ -57,6 +78,16 @@ namespace Indium {
 
 		virtual size_t vulkanArrayLength() const;
 
+		/**
+		 * The subresources of `image()` that this texture covers (e.g. for layout transitions).
+		 */
+		virtual VkImageSubresourceRange subresourceRange();
+
+		/**
+		 * Memoryless textures can only be used as render pass attachments that are neither loaded nor stored.
+		 */
+		virtual bool memoryless() const;
+
 		// TODO: figure out how to allow simultaneous reads and properly synchronize them with writes.
 		//       the problem is that we need to signal the timeline semaphore once the final read is done
 		//       because timeline semaphores only allow the counter to increase, but we can't know which
@@ -102,6 +133,7 @@ namespace Indium {
 		Range<size_t> _levels;
 		Range<size_t> _layers;
 		TextureSwizzleChannels _swizzle;
+		VkImageSubresourceRange _subresourceRange;
 
 	public:
 		TextureView(std::shared_ptr<PrivateTexture> original, PixelFormat pixelFormat, TextureType textureType, VkImageAspectFlags imageAspect, TextureSwizzleChannels swizzle, const Range<size_t>& levels, const Range<size_t>& layers);
@@ -127,7 +159,10 @@ namespace Indium {
 		virtual VkImageView imageView() override;
 		virtual VkImage image() override;
 		virtual std::shared_ptr<Device> device() override;
+		virtual HazardTrackingMode hazardTrackingMode() const override;
 		virtual VkImageLayout imageLayout() override;
+		virtual VkImageSubresourceRange subresourceRange() override;
+		virtual bool memoryless() const override;
 
 		virtual const TimelineSemaphore& acquire(uint64_t& waitValue, std::shared_ptr<BinarySemaphore>& extraWaitSemaphore, uint64_t& signalValue) override;
 		virtual void beginUpdatingPresentationSemaphore(std::shared_ptr<BinarySemaphore> presentationSemaphore) override;
@@ -150,6 +185,9 @@ namespace Indium {
 		VkImageView _imageView;
 		VkDeviceMemory _memory;
 		StorageMode _storageMode;
+		HazardTrackingMode _hazardTrackingMode;
+		// memoryless textures on devices without lazily-allocated memory get their memory from the device's pool
+		std::optional<MemorylessAllocation> _memorylessAllocation;
 
 	public:
 		ConcreteTexture(std::shared_ptr<PrivateDevice> device, const TextureDescriptor& descriptor);
@@ -168,10 +206,13 @@ namespace Indium {
 		virtual bool shareable() const override;
 		virtual TextureSwizzleChannels swizzle() const override;
 
+		virtual HazardTrackingMode hazardTrackingMode() const override;
+
 		virtual VkImageView imageView() override;
 		virtual VkImage image() override;
 		virtual VkImageLayout imageLayout() override;
 		virtual size_t vulkanArrayLength() const override;
+		virtual bool memoryless() const override;
 
 		virtual void replaceRegion(Indium::Region region, size_t mipmapLevel, const void* bytes, size_t bytesPerRow) override;
 		virtual void replaceRegion(Indium::Region region, size_t mipmapLevel, size_t slice, const void* bytes, size_t bytesPerRow, size_t bytesPerImage) override;
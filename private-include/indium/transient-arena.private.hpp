@@ -0,0 +1,87 @@
+#pragma once
+
+#include <indium/base.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace Indium {
+	/**
+	 * A bump allocator for the temporary structures we build while encoding commands (e.g. descriptor writes and barrier lists).
+	 *
+	 * Allocations are never freed individually; instead, everything allocated since a given point is freed at once by rewinding the arena
+	 * (usually with a Scope). The arena keeps its blocks around when it's rewound, so once it's warmed up, encoding doesn't hit the heap at all.
+	 *
+	 * This is a `std::pmr::memory_resource`, so it can be used with the `std::pmr` containers.
+	 *
+	 * @note This isn't thread-safe. Each command buffer has its own arena (see PrivateCommandBuffer::arena()) and command buffers are only encoded on one thread at a time.
+	 */
+	class TransientArena: public std::pmr::memory_resource {
+		INDIUM_PREVENT_COPY(TransientArena);
+
+	public:
+		static constexpr size_t defaultBlockSize = 64 * 1024;
+
+		struct Marker {
+			size_t blockIndex = 0;
+			size_t offset = 0;
+		};
+
+		/**
+		 * Rewinds the arena to where it was when the scope was created once the scope ends.
+		 */
+		class Scope {
+			INDIUM_PREVENT_COPY(Scope);
+
+		private:
+			TransientArena& _arena;
+			Marker _marker;
+
+		public:
+			explicit Scope(TransientArena& arena):
+				_arena(arena),
+				_marker(arena.mark())
+				{};
+			~Scope() {
+				_arena.rewind(_marker);
+			};
+		};
+
+	private:
+		struct Block {
+			std::unique_ptr<char[]> data;
+			size_t size = 0;
+		};
+
+		std::vector<Block> _blocks;
+		Marker _current;
+
+	protected:
+		virtual void* do_allocate(size_t bytes, size_t alignment) override;
+		virtual void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+		virtual bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+	public:
+		TransientArena() = default;
+
+		Marker mark() const {
+			return _current;
+		};
+
+		/**
+		 * Frees everything allocated since the given marker was taken.
+		 */
+		void rewind(Marker marker) {
+			_current = marker;
+		};
+
+		/**
+		 * Frees everything allocated from the arena (but keeps its memory around for reuse).
+		 */
+		void reset() {
+			rewind({});
+		};
+	};
+};
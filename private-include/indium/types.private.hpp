@@ -304,6 +304,34 @@ namespace Indium {
 		}
 	};
 
+	static constexpr bool pixelFormatIsInteger(PixelFormat pixelFormat) {
+		switch (pixelFormat) {
+			case PixelFormat::R8Uint:
+			case PixelFormat::R8Sint:
+			case PixelFormat::R16Uint:
+			case PixelFormat::R16Sint:
+			case PixelFormat::RG8Uint:
+			case PixelFormat::RG8Sint:
+			case PixelFormat::R32Uint:
+			case PixelFormat::R32Sint:
+			case PixelFormat::RG16Uint:
+			case PixelFormat::RG16Sint:
+			case PixelFormat::RGBA8Uint:
+			case PixelFormat::RGBA8Sint:
+			case PixelFormat::RGB10A2Uint:
+			case PixelFormat::RG32Uint:
+			case PixelFormat::RG32Sint:
+			case PixelFormat::RGBA16Uint:
+			case PixelFormat::RGBA16Sint:
+			case PixelFormat::RGBA32Uint:
+			case PixelFormat::RGBA32Sint:
+				return true;
+
+			default:
+				return false;
+		}
+	};
+
 	static constexpr VkImageAspectFlags pixelFormatToVkImageAspectFlags(PixelFormat pixelFormat) {
 		switch (pixelFormat) {
 			case PixelFormat::A8Unorm:
@@ -528,7 +556,7 @@ namespace Indium {
 			case StoreAction::DontCare:                   return VK_ATTACHMENT_STORE_OP_DONT_CARE;
 			case StoreAction::Store:                      return VK_ATTACHMENT_STORE_OP_STORE;
 			case StoreAction::MultisampleResolve:         return VK_ATTACHMENT_STORE_OP_DONT_CARE;
-			case StoreAction::StoreAndMultisampleResolve: return VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			case StoreAction::StoreAndMultisampleResolve: return VK_ATTACHMENT_STORE_OP_STORE;
 			case StoreAction::Unknown:                    return VK_ATTACHMENT_STORE_OP_DONT_CARE;
 			case StoreAction::CustomSampleDepthStore:     return VK_ATTACHMENT_STORE_OP_DONT_CARE;
 			case StoreAction::Default:                    return isColorAttachment ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
@@ -536,6 +564,19 @@ namespace Indium {
 		throw BadEnumValue();
 	};
 
+	static constexpr bool storeActionResolves(StoreAction storeAction) {
+		return storeAction == StoreAction::MultisampleResolve || storeAction == StoreAction::StoreAndMultisampleResolve;
+	};
+
+	static constexpr VkResolveModeFlagBits multisampleDepthResolveFilterToVkResolveMode(MultisampleDepthResolveFilter filter) {
+		switch (filter) {
+			case MultisampleDepthResolveFilter::Sample0: return VK_RESOLVE_MODE_SAMPLE_ZERO_BIT;
+			case MultisampleDepthResolveFilter::Min:     return VK_RESOLVE_MODE_MIN_BIT;
+			case MultisampleDepthResolveFilter::Max:     return VK_RESOLVE_MODE_MAX_BIT;
+		}
+		throw BadEnumValue();
+	};
+
 	static constexpr VkImageViewType textureTypeToVkImageViewType(TextureType format) {
 		switch (format) {
 			case TextureType::e1D:                 return VK_IMAGE_VIEW_TYPE_1D;
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <indium/base.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace Indium {
+	class PrivateDevice;
+	class PrivateBuffer;
+
+	/**
+	 * Host-visible memory for the small amounts of data that commands need to pass to the GPU themselves
+	 * (e.g. the contents of setBytes() bindings and buffer address tables).
+	 *
+	 * This works like a TransientArena, except that it allocates from large shared buffers: each upload is copied into the current buffer
+	 * and only when that fills up is another buffer created. The buffers are kept around when the heap is reset, so once it's warmed up,
+	 * uploading doesn't create any buffers at all.
+	 *
+	 * @note This isn't thread-safe. Each command buffer has its own heap (see PrivateCommandBuffer::uploadHeap()), and since the GPU may be reading from it
+	 *       until the command buffer completes, it must only be reset once the command buffer is done.
+	 */
+	class UploadHeap {
+		INDIUM_PREVENT_COPY(UploadHeap);
+
+	public:
+		static constexpr size_t defaultBlockSize = 256 * 1024;
+
+		// the largest offset alignment Vulkan lets implementations require for uniform and storage buffers,
+		// so uploads can be bound as either without having to check the device's limits
+		static constexpr size_t uploadAlignment = 256;
+
+	private:
+		std::shared_ptr<PrivateDevice> _privateDevice;
+		std::vector<std::shared_ptr<PrivateBuffer>> _blocks;
+		size_t _blockIndex = 0;
+		size_t _offset = 0;
+
+	public:
+		explicit UploadHeap(std::shared_ptr<PrivateDevice> device);
+
+		/**
+		 * Copies the given data into the heap and returns the buffer it was copied into along with its offset in that buffer.
+		 * The buffer stays valid (and keeps its contents) until the heap is reset.
+		 */
+		std::pair<PrivateBuffer*, size_t> upload(const void* data, size_t length);
+
+		/**
+		 * Like upload(), but leaves the memory uninitialized (e.g. for the GPU to write into).
+		 */
+		std::pair<PrivateBuffer*, size_t> allocate(size_t length);
+
+		/**
+		 * Frees everything uploaded to the heap (but keeps its buffers around for reuse).
+		 */
+		void reset() {
+			_blockIndex = 0;
+			_offset = 0;
+		};
+	};
+};
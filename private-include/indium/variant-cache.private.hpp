@@ -0,0 +1,91 @@
+#pragma once
+
+#include <exception>
+#include <future>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace Indium {
+	/**
+	 * A thread-safe map of lazily-compiled values (e.g. pipeline variants), where each value is only ever compiled once.
+	 *
+	 * Looking up a value that's already compiled only takes a shared lock. Values that are being compiled are tracked separately,
+	 * so a request for one of those waits for that compilation to finish, but requests for other keys never wait for it.
+	 */
+	template<typename Key, typename Value>
+	class VariantCache {
+	private:
+		std::shared_mutex _mutex;
+		std::unordered_map<Key, Value> _values;
+		std::unordered_map<Key, std::shared_future<Value>> _compiling;
+
+	public:
+		/**
+		 * Returns the value for the given key, compiling it with `compile` if nobody has compiled it (or started compiling it) yet.
+		 *
+		 * @note The lock isn't held while compiling, so `compile` can look up other values in the same cache.
+		 *       If compilation throws, the exception is also rethrown to anyone waiting for it, and the next request tries again.
+		 */
+		template<typename Compiler>
+		Value get(const Key& key, Compiler&& compile) {
+			{
+				std::shared_lock lock(_mutex);
+				auto it = _values.find(key);
+				if (it != _values.end()) {
+					return it->second;
+				}
+			}
+
+			std::unique_lock lock(_mutex);
+
+			auto it = _values.find(key);
+			if (it != _values.end()) {
+				return it->second;
+			}
+
+			auto compiling = _compiling.find(key);
+			if (compiling != _compiling.end()) {
+				auto future = compiling->second;
+				lock.unlock();
+				return future.get();
+			}
+
+			std::promise<Value> promise;
+			_compiling.try_emplace(key, promise.get_future().share());
+			lock.unlock();
+
+			Value value;
+			try {
+				value = compile();
+			} catch (...) {
+				lock.lock();
+				_compiling.erase(key);
+				lock.unlock();
+
+				promise.set_exception(std::current_exception());
+				throw;
+			}
+
+			lock.lock();
+			_values.try_emplace(key, value);
+			_compiling.erase(key);
+			lock.unlock();
+
+			promise.set_value(value);
+			return value;
+		};
+
+		/**
+		 * Calls `function` with each compiled key and value.
+		 *
+		 * @note This doesn't lock the cache; it's meant for cleaning up once nothing else can be using it (e.g. in destructors).
+		 */
+		template<typename Function>
+		void forEach(Function&& function) {
+			for (auto& [key, value]: _values) {
+				function(key, value);
+			}
+		};
+	};
+};
@@ -46,7 +46,7 @@ namespace Iridium {
 		public:
 			Function(Type type, const std::string& name, const void* bitcode, size_t bitcodeSize);
 
-			void analyze(SPIRV::Builder& builder, OutputInfo& outputInfo);
+			void analyze(SPIRV::Builder& builder, OutputInfo& outputInfo, const TranslationOptions& options);
 		};
 
 		class Library {
@@ -61,7 +61,7 @@ namespace Iridium {
 
 			const Function* getFunction(const std::string& name) const;
 
-			void buildModule(SPIRV::Builder& builder, OutputInfo& outputInfo);
+			void buildModule(SPIRV::Builder& builder, OutputInfo& outputInfo, const TranslationOptions& options);
 		};
 	};
 };
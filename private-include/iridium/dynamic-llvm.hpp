@@ -106,12 +106,15 @@ namespace Iridium {
 			_macro(LLVMGetParamTypes) \
 			_macro(LLVMGetPointerAddressSpace) \
 			_macro(LLVMGetReturnType) \
+			_macro(LLVMGetStructName) \
 			_macro(LLVMGetSuccessor) \
 			_macro(LLVMGetTypeKind) \
 			_macro(LLVMGetUndefMaskElem) \
 			_macro(LLVMGetValueKind) \
 			_macro(LLVMGetValueName2) \
 			_macro(LLVMGetVectorSize) \
+			_macro(LLVMIsAConstantInt) \
+			_macro(LLVMIsAMDNode) \
 			_macro(LLVMIsAMDString) \
 			_macro(LLVMIsConditional) \
 			_macro(LLVMIsPackedStruct) \
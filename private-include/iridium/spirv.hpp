@@ -41,6 +41,7 @@ namespace Iridium {
 			Binding = 33,
 			DescriptorSet = 34,
 			Offset = 35,
+			NonUniform = 5300,
 		};
 
 		enum class BuiltinID: uint32_t {
@@ -69,6 +70,7 @@ namespace Iridium {
 			Uniform = 2,
 			Output = 3,
 			Function = 7,
+			PushConstant = 9,
 			StorageBuffer = 12,
 			PhysicalStorageBuffer = 5349,
 		};
@@ -81,7 +83,14 @@ namespace Iridium {
 			Float64 = 10,
 			Int64 = 11,
 			Int16 = 22,
+			ImageCubeArray = 34,
 			Int8 = 39,
+			Sampled1D = 43,
+			Image1D = 44,
+			SampledCubeArray = 45,
+			ShaderNonUniform = 5301,
+			RuntimeDescriptorArray = 5302,
+			SampledImageArrayNonUniformIndexing = 5307,
 			PhysicalStorageBufferAddresses = 5347,
 		};
 
@@ -493,6 +502,7 @@ namespace Iridium {
 			FRem = 140,
 			FMod = 141,
 			Dot = 148,
+			IEqual = 170,
 			FOrdLessThan = 184,
 			FOrdGreaterThan = 186,
 			Phi = 245,
@@ -674,6 +684,7 @@ namespace Iridium {
 
 			void addEntryPoint(const EntryPoint& entryPoint);
 			ResultID addGlobalVariable(ResultID typeID, StorageClass storageClass);
+			ResultID addFunctionVariable(ResultID typeID, ResultID initializer = ResultIDInvalid);
 			void addDecoration(ResultID resultID, const Decoration& decoration);
 			FunctionInfo declareFunction(ResultID functionType);
 
@@ -715,6 +726,7 @@ namespace Iridium {
 			ResultID encodeVectorInsertDynamic(ResultID resultTypeID, ResultID vector, ResultID component, ResultID index);
 			ResultID encodeFOrdLessThan(ResultID operand1, ResultID operand2);
 			ResultID encodeFOrdGreaterThan(ResultID operand1, ResultID operand2);
+			ResultID encodeIEqual(ResultID operand1, ResultID operand2);
 			void encodeBranch(ResultID targetLabel);
 			void encodeBranchConditional(ResultID condition, ResultID trueLabel, ResultID falseLabel);
 			ResultID encodePhi(ResultID resultTypeID, std::vector<std::pair<ResultID, ResultID>> variablesAndBlocks);
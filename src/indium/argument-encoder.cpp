@@ -0,0 +1,241 @@
+#include <indium/argument-encoder.private.hpp>
+#include <indium/device.private.hpp>
+#include <indium/buffer.private.hpp>
+#include <indium/texture.hpp>
+#include <indium/sampler.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <tuple>
+
+Indium::ArgumentEncoder::~ArgumentEncoder() {};
+
+static size_t alignUp(size_t value, size_t alignment) {
+	return (value + alignment - 1) & ~(alignment - 1);
+};
+
+// returns the size and alignment of a (non-aggregate) constant of the given type.
+// 3-component vectors take up as much space as 4-component ones, like in Metal.
+static std::pair<size_t, size_t> constantSizeAndAlignment(Indium::DataType dataType) {
+	using DT = Indium::DataType;
+
+	auto vector = [](size_t scalarSize, size_t components) {
+		auto size = scalarSize * ((components == 3) ? 4 : components);
+		return std::make_pair(size, size);
+	};
+
+	auto matrix = [](size_t columns, size_t rows) {
+		auto columnSize = 4 * ((rows == 3) ? 4 : rows);
+		return std::make_pair(columnSize * columns, columnSize);
+	};
+
+	switch (dataType) {
+		case DT::Float:   return vector(4, 1);
+		case DT::Float2:  return vector(4, 2);
+		case DT::Float3:  return vector(4, 3);
+		case DT::Float4:  return vector(4, 4);
+		case DT::Float2x2: return matrix(2, 2);
+		case DT::Float2x3: return matrix(2, 3);
+		case DT::Float2x4: return matrix(2, 4);
+		case DT::Float3x2: return matrix(3, 2);
+		case DT::Float3x3: return matrix(3, 3);
+		case DT::Float3x4: return matrix(3, 4);
+		case DT::Float4x2: return matrix(4, 2);
+		case DT::Float4x3: return matrix(4, 3);
+		case DT::Float4x4: return matrix(4, 4);
+		case DT::Half:    return vector(2, 1);
+		case DT::Half2:   return vector(2, 2);
+		case DT::Half3:   return vector(2, 3);
+		case DT::Half4:   return vector(2, 4);
+		case DT::Int:     return vector(4, 1);
+		case DT::Int2:    return vector(4, 2);
+		case DT::Int3:    return vector(4, 3);
+		case DT::Int4:    return vector(4, 4);
+		case DT::UInt:    return vector(4, 1);
+		case DT::UInt2:   return vector(4, 2);
+		case DT::UInt3:   return vector(4, 3);
+		case DT::UInt4:   return vector(4, 4);
+		case DT::Short:   return vector(2, 1);
+		case DT::Short2:  return vector(2, 2);
+		case DT::Short3:  return vector(2, 3);
+		case DT::Short4:  return vector(2, 4);
+		case DT::UShort:  return vector(2, 1);
+		case DT::UShort2: return vector(2, 2);
+		case DT::UShort3: return vector(2, 3);
+		case DT::UShort4: return vector(2, 4);
+		case DT::Char:    return vector(1, 1);
+		case DT::Char2:   return vector(1, 2);
+		case DT::Char3:   return vector(1, 3);
+		case DT::Char4:   return vector(1, 4);
+		case DT::UChar:   return vector(1, 1);
+		case DT::UChar2:  return vector(1, 2);
+		case DT::UChar3:  return vector(1, 3);
+		case DT::UChar4:  return vector(1, 4);
+		case DT::Bool:    return vector(1, 1);
+		case DT::Bool2:   return vector(1, 2);
+		case DT::Bool3:   return vector(1, 3);
+		case DT::Bool4:   return vector(1, 4);
+		case DT::Long:    return vector(8, 1);
+		case DT::Long2:   return vector(8, 2);
+		case DT::Long3:   return vector(8, 3);
+		case DT::Long4:   return vector(8, 4);
+		case DT::ULong:   return vector(8, 1);
+		case DT::ULong2:  return vector(8, 2);
+		case DT::ULong3:  return vector(8, 3);
+		case DT::ULong4:  return vector(8, 4);
+		default:
+			throw std::runtime_error("Unsupported argument data type");
+	}
+};
+
+Iridium::ArgumentBufferInfo Indium::argumentBufferInfoForDescriptors(const std::vector<ArgumentDescriptor>& arguments) {
+	Iridium::ArgumentBufferInfo info {};
+	info.bufferIndex = 0;
+	info.alignment = 1;
+
+	size_t offset = 0;
+
+	for (const auto& descriptor: arguments) {
+		Iridium::ArgumentInfo argument {};
+		size_t alignment;
+
+		switch (descriptor.dataType) {
+			case DataType::Pointer:
+				argument.type = Iridium::ArgumentType::Buffer;
+				argument.size = alignment = sizeof(uint64_t);
+				break;
+			case DataType::Texture:
+				// see ArgumentEncoder for why these are the only kinds of textures we support
+				if (descriptor.access != BindingAccess::ReadOnly) {
+					throw std::runtime_error("Writable textures aren't supported in argument buffers");
+				}
+				if (descriptor.textureType == TextureType::e2DMultisample || descriptor.textureType == TextureType::e2DMultisampleArray || descriptor.textureType == TextureType::eTextureBuffer) {
+					throw std::runtime_error("Multisampled textures and texture buffers aren't supported in argument buffers");
+				}
+				argument.type = Iridium::ArgumentType::Texture;
+				argument.size = alignment = sizeof(uint64_t);
+				break;
+			case DataType::Sampler:
+				argument.type = Iridium::ArgumentType::Sampler;
+				argument.size = alignment = sizeof(uint64_t);
+				break;
+			default:
+				argument.type = Iridium::ArgumentType::Constant;
+				std::tie(argument.size, alignment) = constantSizeAndAlignment(descriptor.dataType);
+				if (descriptor.constantBlockAlignment > alignment) {
+					alignment = descriptor.constantBlockAlignment;
+				}
+				break;
+		}
+
+		offset = alignUp(offset, alignment);
+
+		argument.index = descriptor.index;
+		argument.offset = offset;
+		argument.arrayLength = descriptor.arrayLength;
+
+		offset += argument.size * std::max<size_t>(argument.arrayLength, 1);
+		info.alignment = std::max(info.alignment, alignment);
+
+		info.arguments.push_back(argument);
+	}
+
+	info.encodedLength = alignUp(offset, info.alignment);
+
+	return info;
+};
+
+Indium::PrivateArgumentEncoder::PrivateArgumentEncoder(std::shared_ptr<PrivateDevice> device, const Iridium::ArgumentBufferInfo& info):
+	_privateDevice(device),
+	_info(info)
+{};
+
+std::shared_ptr<Indium::Device> Indium::PrivateArgumentEncoder::device() {
+	return _privateDevice;
+};
+
+size_t Indium::PrivateArgumentEncoder::encodedLength() const {
+	return _info.encodedLength;
+};
+
+size_t Indium::PrivateArgumentEncoder::alignment() const {
+	return _info.alignment;
+};
+
+void Indium::PrivateArgumentEncoder::setArgumentBuffer(std::shared_ptr<Buffer> argumentBuffer, size_t offset) {
+	_argumentBuffer = std::dynamic_pointer_cast<PrivateBuffer>(argumentBuffer);
+	_argumentData = nullptr;
+
+	if (!_argumentBuffer) {
+		return;
+	}
+
+	auto contents = static_cast<char*>(_argumentBuffer->contents());
+	if (!contents) {
+		throw std::runtime_error("Argument buffers must be CPU-accessible (private argument buffers aren't supported)");
+	}
+
+	_argumentData = contents + offset;
+};
+
+void Indium::PrivateArgumentEncoder::setArgumentBuffer(std::shared_ptr<Buffer> argumentBuffer, size_t startOffset, size_t arrayElement) {
+	setArgumentBuffer(argumentBuffer, startOffset + alignUp(_info.encodedLength, _info.alignment) * arrayElement);
+};
+
+void* Indium::PrivateArgumentEncoder::argumentPointer(Iridium::ArgumentType type, size_t index) {
+	if (!_argumentData) {
+		throw std::runtime_error("No argument buffer set on argument encoder");
+	}
+
+	for (const auto& argument: _info.arguments) {
+		auto elementCount = std::max<size_t>(argument.arrayLength, 1);
+		if (argument.type == type && index >= argument.index && index < argument.index + elementCount) {
+			return _argumentData + argument.offset + (index - argument.index) * argument.size;
+		}
+	}
+
+	throw std::runtime_error("No argument of the requested type at the given index");
+};
+
+void Indium::PrivateArgumentEncoder::setBuffer(std::shared_ptr<Buffer> buffer, size_t offset, size_t index) {
+	uint64_t address = buffer ? (std::dynamic_pointer_cast<PrivateBuffer>(buffer)->gpuAddress() + offset) : 0;
+	memcpy(argumentPointer(Iridium::ArgumentType::Buffer, index), &address, sizeof(address));
+};
+
+void Indium::PrivateArgumentEncoder::setBuffers(const std::vector<std::shared_ptr<Buffer>>& buffers, const std::vector<size_t>& offsets, Range<size_t> range) {
+	for (size_t i = 0; i < range.length; ++i) {
+		setBuffer(buffers[i], offsets[i], range.start + i);
+	}
+};
+
+void Indium::PrivateArgumentEncoder::setTexture(std::shared_ptr<Texture> texture, size_t index) {
+	uint64_t resourceID = texture ? texture->gpuResourceID().impl : 0;
+	memcpy(argumentPointer(Iridium::ArgumentType::Texture, index), &resourceID, sizeof(resourceID));
+};
+
+void Indium::PrivateArgumentEncoder::setTextures(const std::vector<std::shared_ptr<Texture>>& textures, Range<size_t> range) {
+	for (size_t i = 0; i < range.length; ++i) {
+		setTexture(textures[i], range.start + i);
+	}
+};
+
+void Indium::PrivateArgumentEncoder::setSamplerState(std::shared_ptr<SamplerState> sampler, size_t index) {
+	uint64_t resourceID = sampler ? sampler->gpuResourceID().impl : 0;
+	memcpy(argumentPointer(Iridium::ArgumentType::Sampler, index), &resourceID, sizeof(resourceID));
+};
+
+void Indium::PrivateArgumentEncoder::setSamplerStates(const std::vector<std::shared_ptr<SamplerState>>& samplers, Range<size_t> range) {
+	for (size_t i = 0; i < range.length; ++i) {
+		setSamplerState(samplers[i], range.start + i);
+	}
+};
+
+void* Indium::PrivateArgumentEncoder::constantData(size_t index) {
+	return argumentPointer(Iridium::ArgumentType::Constant, index);
+};
+
+std::shared_ptr<Indium::ArgumentEncoder> Indium::PrivateArgumentEncoder::newArgumentEncoder(size_t index) {
+	// we don't know the layout of nested argument buffers (Iridium only describes the top-level one)
+	throw std::runtime_error("Nested argument encoders aren't supported (encode nested argument buffers with Device::newArgumentEncoder() instead)");
+};
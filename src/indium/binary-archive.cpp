@@ -0,0 +1,289 @@
+#include <indium/binary-archive.private.hpp>
+#include <indium/device.private.hpp>
+#include <indium/library.private.hpp>
+#include <indium/render-pipeline.private.hpp>
+#include <indium/compute-pipeline.private.hpp>
+#include <indium/serialization.private.hpp>
+
+#include <fstream>
+#include <stdexcept>
+
+// archive layout (see serialization.private.hpp for the encoding):
+//   uint32_t magic
+//   uint32_t version
+//   uint64_t pipeline cache data length, followed by the pipeline cache data
+//   uint64_t library count, followed by each library:
+//     library key (see LibraryKey)
+//     uint64_t SPIR-V length, followed by the SPIR-V
+//     uint64_t function count, followed by each function:
+//       uint64_t name length, followed by the name
+//       uint32_t function type
+//       uint64_t binding count, followed by the bindings (see writeBindingInfo())
+//       uint64_t embedded sampler count, followed by the embedded samplers (see writeEmbeddedSampler())
+//       uint64_t argument buffer count, followed by each argument buffer:
+//         uint64_t buffer index, encoded length, and alignment
+//         uint64_t argument count, followed by the arguments (see writeArgumentInfo())
+//       uint8_t whether the function uses the resource table
+//
+// structures are written field by field (rather than as raw memory) so that padding never ends up in the archive.
+
+static constexpr uint32_t archiveMagic = 0x41424e49; // "INBA"
+static constexpr uint32_t archiveVersion = 7;
+
+static void writeBindingInfo(Indium::BinaryWriter& writer, const Iridium::BindingInfo& binding) {
+	writer.write<uint32_t>(static_cast<uint32_t>(binding.type));
+	writer.write<uint64_t>(binding.index);
+	writer.write<uint64_t>(binding.internalIndex);
+	writer.write<uint32_t>(static_cast<uint32_t>(binding.textureAccessType));
+	writer.write<uint64_t>(binding.embeddedSamplerIndex);
+	writer.write<uint64_t>(binding.pushConstantOffset);
+	writer.write<uint64_t>(binding.pushConstantSize);
+};
+
+static Iridium::BindingInfo readBindingInfo(Indium::BinaryReader& reader) {
+	Iridium::BindingInfo binding {};
+	binding.type = static_cast<Iridium::BindingType>(reader.read<uint32_t>());
+	binding.index = reader.read<uint64_t>();
+	binding.internalIndex = reader.read<uint64_t>();
+	binding.textureAccessType = static_cast<Iridium::TextureAccessType>(reader.read<uint32_t>());
+	binding.embeddedSamplerIndex = reader.read<uint64_t>();
+	binding.pushConstantOffset = reader.read<uint64_t>();
+	binding.pushConstantSize = reader.read<uint64_t>();
+	return binding;
+};
+
+static void writeEmbeddedSampler(Indium::BinaryWriter& writer, const Iridium::EmbeddedSampler& sampler) {
+	writer.write<uint8_t>(static_cast<uint8_t>(sampler.widthAddressMode));
+	writer.write<uint8_t>(static_cast<uint8_t>(sampler.heightAddressMode));
+	writer.write<uint8_t>(static_cast<uint8_t>(sampler.depthAddressMode));
+	writer.write<uint8_t>(static_cast<uint8_t>(sampler.magnificationFilter));
+	writer.write<uint8_t>(static_cast<uint8_t>(sampler.minificationFilter));
+	writer.write<uint8_t>(static_cast<uint8_t>(sampler.mipmapFilter));
+	writer.write<uint8_t>(sampler.usesNormalizedCoordinates);
+	writer.write<uint8_t>(static_cast<uint8_t>(sampler.compareFunction));
+	writer.write<uint8_t>(sampler.anisotropyLevel);
+	writer.write<uint8_t>(static_cast<uint8_t>(sampler.borderColor));
+	writer.write<float>(sampler.lodMin);
+	writer.write<float>(sampler.lodMax);
+};
+
+static Iridium::EmbeddedSampler readEmbeddedSampler(Indium::BinaryReader& reader) {
+	using ES = Iridium::EmbeddedSampler;
+
+	ES sampler {};
+	sampler.widthAddressMode = static_cast<ES::AddressMode>(reader.read<uint8_t>());
+	sampler.heightAddressMode = static_cast<ES::AddressMode>(reader.read<uint8_t>());
+	sampler.depthAddressMode = static_cast<ES::AddressMode>(reader.read<uint8_t>());
+	sampler.magnificationFilter = static_cast<ES::Filter>(reader.read<uint8_t>());
+	sampler.minificationFilter = static_cast<ES::Filter>(reader.read<uint8_t>());
+	sampler.mipmapFilter = static_cast<ES::MipFilter>(reader.read<uint8_t>());
+	sampler.usesNormalizedCoordinates = reader.read<uint8_t>();
+	sampler.compareFunction = static_cast<ES::CompareFunction>(reader.read<uint8_t>());
+	sampler.anisotropyLevel = reader.read<uint8_t>();
+	sampler.borderColor = static_cast<ES::BorderColor>(reader.read<uint8_t>());
+	sampler.lodMin = reader.read<float>();
+	sampler.lodMax = reader.read<float>();
+	return sampler;
+};
+
+static void writeArgumentInfo(Indium::BinaryWriter& writer, const Iridium::ArgumentInfo& argument) {
+	writer.write<uint32_t>(static_cast<uint32_t>(argument.type));
+	writer.write<uint64_t>(argument.index);
+	writer.write<uint64_t>(argument.offset);
+	writer.write<uint64_t>(argument.size);
+	writer.write<uint64_t>(argument.arrayLength);
+};
+
+static Iridium::ArgumentInfo readArgumentInfo(Indium::BinaryReader& reader) {
+	Iridium::ArgumentInfo argument {};
+	argument.type = static_cast<Iridium::ArgumentType>(reader.read<uint32_t>());
+	argument.index = reader.read<uint64_t>();
+	argument.offset = reader.read<uint64_t>();
+	argument.size = reader.read<uint64_t>();
+	argument.arrayLength = reader.read<uint64_t>();
+	return argument;
+};
+
+Indium::BinaryArchive::~BinaryArchive() {};
+
+Indium::PrivateBinaryArchive::PrivateBinaryArchive(std::shared_ptr<PrivateDevice> device, const BinaryArchiveDescriptor& descriptor):
+	_privateDevice(device)
+{
+	if (!descriptor.url.empty()) {
+		load(urlToPath(descriptor.url));
+	}
+};
+
+Indium::PrivateBinaryArchive::~PrivateBinaryArchive() {};
+
+std::shared_ptr<Indium::Device> Indium::PrivateBinaryArchive::device() {
+	return _privateDevice;
+};
+
+void Indium::PrivateBinaryArchive::load(const std::string& path) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Failed to open binary archive: " + path);
+	}
+
+	std::vector<char> contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	BinaryReader reader { contents.data(), contents.size() };
+
+	if (reader.read<uint32_t>() != archiveMagic) {
+		throw std::runtime_error("Invalid binary archive: " + path);
+	}
+
+	if (reader.read<uint32_t>() != archiveVersion) {
+		// the translated libraries (and possibly the pipeline cache) in an archive written by a different version of Indium can't be used,
+		// and silently ignoring it would just make pipeline creation slow without any indication of why
+		throw std::runtime_error("Binary archive was written by an incompatible version of Indium: " + path);
+	}
+
+	auto cacheData = reader.readBlob();
+	if (!cacheData.empty()) {
+		_privateDevice->mergePipelineCacheData(cacheData.data(), cacheData.size());
+	}
+
+	auto libraryCount = reader.read<uint64_t>();
+	for (uint64_t i = 0; i < libraryCount; ++i) {
+		auto key = reader.read<LibraryKey>();
+		auto library = std::make_shared<TranslatedLibrary>();
+
+		auto spirv = reader.readBlob();
+		library->spirv.assign(spirv.begin(), spirv.end());
+
+		auto functionCount = reader.read<uint64_t>();
+		for (uint64_t j = 0; j < functionCount; ++j) {
+			auto name = reader.readBlob();
+			auto& functionInfo = library->outputInfo.functionInfos[std::string(name)];
+
+			functionInfo.type = static_cast<Iridium::FunctionType>(reader.read<uint32_t>());
+
+			auto bindingCount = reader.read<uint64_t>();
+			for (uint64_t k = 0; k < bindingCount; ++k) {
+				functionInfo.bindings.push_back(readBindingInfo(reader));
+			}
+
+			auto embeddedSamplerCount = reader.read<uint64_t>();
+			for (uint64_t k = 0; k < embeddedSamplerCount; ++k) {
+				functionInfo.embeddedSamplers.push_back(readEmbeddedSampler(reader));
+			}
+
+			auto argumentBufferCount = reader.read<uint64_t>();
+			for (uint64_t k = 0; k < argumentBufferCount; ++k) {
+				auto& argumentBuffer = functionInfo.argumentBuffers.emplace_back();
+				argumentBuffer.bufferIndex = reader.read<uint64_t>();
+				argumentBuffer.encodedLength = reader.read<uint64_t>();
+				argumentBuffer.alignment = reader.read<uint64_t>();
+
+				auto argumentCount = reader.read<uint64_t>();
+				for (uint64_t l = 0; l < argumentCount; ++l) {
+					argumentBuffer.arguments.push_back(readArgumentInfo(reader));
+				}
+			}
+
+			functionInfo.usesResourceTable = reader.read<uint8_t>();
+		}
+
+		// this lets newLibrary() skip translation for this library
+		_privateDevice->addTranslatedLibrary(key, library);
+		_libraries.try_emplace(key, library);
+	}
+};
+
+void Indium::PrivateBinaryArchive::addFunction(std::shared_ptr<PrivateFunction> function) {
+	if (!function) {
+		return;
+	}
+
+	auto key = function->library()->key();
+	auto library = _privateDevice->translatedLibrary(key);
+
+	if (!library) {
+		return;
+	}
+
+	std::unique_lock lock(_librariesMutex);
+	_libraries.try_emplace(key, library);
+};
+
+void Indium::PrivateBinaryArchive::addRenderPipelineFunctions(const RenderPipelineDescriptor& descriptor) {
+	addFunction(std::dynamic_pointer_cast<PrivateFunction>(descriptor.vertexFunction));
+	addFunction(std::dynamic_pointer_cast<PrivateFunction>(descriptor.fragmentFunction));
+
+	// creating the pipeline state compiles its default pipeline variant, which adds it to the device's pipeline cache
+	_privateDevice->newRenderPipelineState(descriptor);
+};
+
+void Indium::PrivateBinaryArchive::addComputePipelineFunctions(const ComputePipelineDescriptor& descriptor) {
+	addFunction(std::dynamic_pointer_cast<PrivateFunction>(descriptor.computeFunction));
+
+	// compute pipelines are specialized for the threadgroup size they're dispatched with, so we compile the sizes we know about:
+	// the maximum threadgroup size (what most 1D dispatches use) plus any sizes the device has recorded for this pipeline so far
+	// (if it's recording a pipeline manifest). like with render pipelines, that adds them to the device's pipeline cache.
+	auto pipelineState = std::dynamic_pointer_cast<PrivateComputePipelineState>(_privateDevice->newComputePipelineState(descriptor, PipelineOption::None, nullptr));
+
+	auto sizes = _privateDevice->recordedComputePipelineVariants(pipelineState->manifestKey());
+	auto maxThreads = (descriptor.maxTotalThreadsPerThreadgroup > 0) ? descriptor.maxTotalThreadsPerThreadgroup : pipelineState->maxTotalThreadsPerThreadgroup();
+	sizes.push_back(Size { maxThreads, 1, 1 });
+
+	for (const auto& size: sizes) {
+		pipelineState->pipeline(size);
+	}
+};
+
+void Indium::PrivateBinaryArchive::serializeToURL(const std::string& url) {
+	BinaryWriter writer;
+
+	writer.write(archiveMagic);
+	writer.write(archiveVersion);
+
+	auto cacheData = _privateDevice->pipelineCacheData();
+	writer.writeBlob(cacheData.data(), cacheData.size());
+
+	{
+		std::unique_lock lock(_librariesMutex);
+
+		writer.write<uint64_t>(_libraries.size());
+		for (const auto& [key, library]: _libraries) {
+			writer.write(key);
+			writer.writeBlob(library->spirv.data(), library->spirv.size());
+
+			writer.write<uint64_t>(library->outputInfo.functionInfos.size());
+			for (const auto& [name, functionInfo]: library->outputInfo.functionInfos) {
+				writer.writeBlob(name.data(), name.size());
+				writer.write<uint32_t>(static_cast<uint32_t>(functionInfo.type));
+
+				writer.write<uint64_t>(functionInfo.bindings.size());
+				for (const auto& binding: functionInfo.bindings) {
+					writeBindingInfo(writer, binding);
+				}
+
+				writer.write<uint64_t>(functionInfo.embeddedSamplers.size());
+				for (const auto& embeddedSampler: functionInfo.embeddedSamplers) {
+					writeEmbeddedSampler(writer, embeddedSampler);
+				}
+
+				writer.write<uint64_t>(functionInfo.argumentBuffers.size());
+				for (const auto& argumentBuffer: functionInfo.argumentBuffers) {
+					writer.write<uint64_t>(argumentBuffer.bufferIndex);
+					writer.write<uint64_t>(argumentBuffer.encodedLength);
+					writer.write<uint64_t>(argumentBuffer.alignment);
+
+					writer.write<uint64_t>(argumentBuffer.arguments.size());
+					for (const auto& argument: argumentBuffer.arguments) {
+						writeArgumentInfo(writer, argument);
+					}
+				}
+
+				writer.write<uint8_t>(functionInfo.usesResourceTable);
+			}
+		}
+	}
+
+	auto path = urlToPath(url);
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file || !file.write(writer.data.data(), writer.data.size())) {
+		throw std::runtime_error("Failed to write binary archive: " + path);
+	}
+};
@@ -2,6 +2,7 @@
 #include <indium/command-buffer.private.hpp>
 #include <indium/texture.private.hpp>
 #include <indium/buffer.private.hpp>
+#include <indium/fence.private.hpp>
 #include <indium/dynamic-vk.hpp>
 
 Indium::BlitCommandEncoder::~BlitCommandEncoder() {};
@@ -438,6 +439,15 @@ void Indium::PrivateBlitCommandEncoder::generateMipmapsForTexture(std::shared_pt
 	DynamicVK::vkCmdPipelineBarrier(cmdbuf->commandBuffer(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
 };
 
+void Indium::PrivateBlitCommandEncoder::updateFence(std::shared_ptr<Fence> fence) {
+	_fenceUpdateStages |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+};
+
+void Indium::PrivateBlitCommandEncoder::waitForFence(std::shared_ptr<Fence> fence) {
+	// nothing to do here; see PrivateFence for details
+};
+
 void Indium::PrivateBlitCommandEncoder::endEncoding() {
-	// nothing for now
+	auto cmdbuf = _privateCommandBuffer.lock();
+	PrivateFence::encodeUpdates(cmdbuf->commandBuffer(), _fenceUpdateStages);
 };
@@ -13,6 +13,7 @@ Indium::PrivateBuffer::PrivateBuffer(std::shared_ptr<PrivateDevice> device, size
 	_length(length)
 {
 	_storageMode = static_cast<StorageMode>((static_cast<size_t>(options) >> 4) & 0xf);
+	_hazardTrackingMode = static_cast<HazardTrackingMode>((static_cast<size_t>(options) >> 8) & 0xf);
 
 	VkBufferCreateInfo info {};
 	info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -126,6 +127,10 @@ std::shared_ptr<Indium::Device> Indium::PrivateBuffer::device() {
 	return _privateDevice;
 };
 
+Indium::HazardTrackingMode Indium::PrivateBuffer::hazardTrackingMode() const {
+	return _hazardTrackingMode;
+};
+
 size_t Indium::PrivateBuffer::length() const {
 	return _length;
 };
@@ -6,6 +6,7 @@
 #include <indium/drawable.hpp>
 #include <indium/blit-command-encoder.private.hpp>
 #include <indium/compute-command-encoder.private.hpp>
+#include <indium/event.private.hpp>
 #include <indium/dynamic-vk.hpp>
 
 #include <condition_variable>
@@ -19,10 +20,37 @@ std::shared_ptr<Indium::Device> Indium::PrivateCommandBuffer::device() {
 	return _privateDevice;
 };
 
-Indium::PrivateCommandBuffer::PrivateCommandBuffer(std::shared_ptr<PrivateCommandQueue> commandQueue):
-	_privateCommandQueue(commandQueue)
+bool Indium::PrivateCommandBuffer::retainedReferences() const {
+	return _retainedReferences;
+};
+
+Indium::PrivateCommandBuffer::PrivateCommandBuffer(std::shared_ptr<PrivateCommandQueue> commandQueue, bool retainedReferences):
+	_privateCommandQueue(commandQueue),
+	_retainedReferences(retainedReferences)
 {
 	_privateDevice = _privateCommandQueue->privateDevice();
+	_arena = _privateCommandQueue->takeArena();
+	_uploadHeap = _privateCommandQueue->takeUploadHeap();
+
+	beginBatch();
+};
+
+Indium::PrivateCommandBuffer::~PrivateCommandBuffer() {
+	for (const auto& batch: _batches) {
+		DynamicVK::vkFreeCommandBuffers(_privateDevice->device(), _privateCommandQueue->commandPool(), 1, &batch.commandBuffer);
+	}
+
+	_privateCommandQueue->recycleArena(std::move(_arena));
+	_privateCommandQueue->recycleUploadHeap(std::move(_uploadHeap));
+};
+
+void Indium::PrivateCommandBuffer::beginBatch() {
+	if (!_batches.empty()) {
+		if (DynamicVK::vkEndCommandBuffer(_commandBuffer) != VK_SUCCESS) {
+			// TODO
+			abort();
+		}
+	}
 
 	VkCommandBufferAllocateInfo allocInfo {};
 	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -41,10 +69,11 @@ Indium::PrivateCommandBuffer::PrivateCommandBuffer(std::shared_ptr<PrivateComman
 		// TODO: same
 		abort();
 	}
-};
 
-Indium::PrivateCommandBuffer::~PrivateCommandBuffer() {
-	DynamicVK::vkFreeCommandBuffers(_privateDevice->device(), _privateCommandQueue->commandPool(), 1, &_commandBuffer);
+	Batch batch {};
+	batch.commandBuffer = _commandBuffer;
+	batch.firstEncoderIndex = _commandEncoders.size();
+	_batches.push_back(std::move(batch));
 };
 
 std::shared_ptr<Indium::RenderCommandEncoder> Indium::PrivateCommandBuffer::renderCommandEncoder(const RenderPassDescriptor& descriptor) {
@@ -96,21 +125,37 @@ void Indium::PrivateCommandBuffer::commit() {
 
 	_committed = true;
 
+	// the temporary lists we build here (except the ones that outlive this call) come from our arena
+	TransientArena::Scope arenaScope(*_arena);
+
+	std::pmr::vector<std::shared_ptr<PrivateTexture>> readOnlyTextures(_arena.get());
+	std::pmr::vector<std::shared_ptr<PrivateTexture>> readWriteTextures(_arena.get());
+
+	// untracked resources are synchronized manually by the user (e.g. with fences), so we skip them entirely here
+	const auto collectTrackedTextures = [](const std::vector<std::shared_ptr<Texture>>& textures, std::pmr::vector<std::shared_ptr<PrivateTexture>>& output) {
+		for (const auto& texture: textures) {
+			auto privateTexture = std::dynamic_pointer_cast<PrivateTexture>(texture);
+			if (!privateTexture || privateTexture->hazardTrackingMode() == HazardTrackingMode::HazardTrackingModeUntracked) {
+				continue;
+			}
+			output.push_back(privateTexture);
+		}
+	};
+
 	for (const auto& encoder: _commandEncoders) {
 		if (auto renderEncoder = std::dynamic_pointer_cast<PrivateRenderCommandEncoder>(encoder)) {
-			for (const auto& texture: renderEncoder->readOnlyTextures()) {
-				if (auto privateTexture = std::dynamic_pointer_cast<PrivateTexture>(texture)) {
-					privateTexture->precommit(shared_from_this());
-				}
-			}
-			for (const auto& texture: renderEncoder->readWriteTextures()) {
-				if (auto privateTexture = std::dynamic_pointer_cast<PrivateTexture>(texture)) {
-					privateTexture->precommit(shared_from_this());
-				}
-			}
+			collectTrackedTextures(renderEncoder->readOnlyTextures(), readOnlyTextures);
+			collectTrackedTextures(renderEncoder->readWriteTextures(), readWriteTextures);
 		}
 
-		// TODO: same for other encoders
+		// TODO: implement this for other encoders (we need to synchronize those texture accesses as well)
+	}
+
+	for (const auto& texture: readOnlyTextures) {
+		texture->precommit(shared_from_this());
+	}
+	for (const auto& texture: readWriteTextures) {
+		texture->precommit(shared_from_this());
 	}
 
 	if (DynamicVK::vkEndCommandBuffer(_commandBuffer) != VK_SUCCESS) {
@@ -126,31 +171,16 @@ void Indium::PrivateCommandBuffer::commit() {
 
 	++timelineSemaphore->count;
 
-	std::vector<std::shared_ptr<Texture>> readOnlyTextures;
-	std::vector<std::shared_ptr<Texture>> readWriteTextures;
 	std::vector<std::shared_ptr<BinarySemaphore>> presentationSemaphores;
 
-	for (const auto& encoder: _commandEncoders) {
-		if (auto renderEncoder = std::dynamic_pointer_cast<PrivateRenderCommandEncoder>(encoder)) {
-			auto& readOnly = renderEncoder->readOnlyTextures();
-			auto& readWrite = renderEncoder->readWriteTextures();
-			readOnlyTextures.insert(readOnlyTextures.end(), readOnly.begin(), readOnly.end());
-			readWriteTextures.insert(readWriteTextures.end(), readWrite.begin(), readWrite.end());
-		}
-
-		// TODO: implement this for other encoders (we need to synchronize those texture accesses as well)
-	}
-
 	for (const auto& texture: readWriteTextures) {
-		auto privateTexture = std::dynamic_pointer_cast<PrivateTexture>(texture);
-		auto sema = _privateDevice->getWrappedBinarySemaphore(privateTexture->needsExportablePresentationSemaphore());
+		auto sema = _privateDevice->getWrappedBinarySemaphore(texture->needsExportablePresentationSemaphore());
 		presentationSemaphores.push_back(sema);
-		privateTexture->beginUpdatingPresentationSemaphore(sema);
+		texture->beginUpdatingPresentationSemaphore(sema);
 	}
 
-	std::vector<VkSemaphoreSubmitInfo> signalInfos;
-	std::vector<VkSemaphoreSubmitInfo> waitInfos;
-	VkCommandBufferSubmitInfo commandBufferInfo {};
+	std::pmr::vector<VkSemaphoreSubmitInfo> signalInfos(_arena.get());
+	std::pmr::vector<VkSemaphoreSubmitInfo> waitInfos(_arena.get());
 
 	VkSemaphoreSubmitInfo signalEventLoopInfo {};
 	signalEventLoopInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
@@ -194,12 +224,11 @@ void Indium::PrivateCommandBuffer::commit() {
 	};
 
 	for (const auto& texture: readOnlyTextures) {
-		handleTextureSemaphores(std::dynamic_pointer_cast<PrivateTexture>(texture));
+		handleTextureSemaphores(texture);
 	}
 
 	for (size_t i = 0; i < readWriteTextures.size(); ++i) {
-		const auto& texture = readWriteTextures[i];
-		auto privateTexture = std::dynamic_pointer_cast<PrivateTexture>(texture);
+		const auto& privateTexture = readWriteTextures[i];
 		const auto& presentSema = presentationSemaphores[i];
 
 		VkSemaphoreSubmitInfo signalInfo {};
@@ -236,23 +265,36 @@ void Indium::PrivateCommandBuffer::commit() {
 		self->_completedHandlers.clear();
 	});
 
-	commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
-	commandBufferInfo.commandBuffer = _commandBuffer;
-
-	VkSubmitInfo2 info {};
-	info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
-	info.commandBufferInfoCount = 1;
-	info.pCommandBufferInfos = &commandBufferInfo;
-	info.signalSemaphoreInfoCount = signalInfos.size();
-	info.pSignalSemaphoreInfos = signalInfos.data();
-	info.waitSemaphoreInfoCount = waitInfos.size();
-	info.pWaitSemaphoreInfos = waitInfos.data();
+	// texture waits go on the first batch and all of our own signals go on the last one.
+	// batches are executed in submission order, so this covers all the batches.
+	_batches.front().waitInfos.insert(_batches.front().waitInfos.end(), waitInfos.begin(), waitInfos.end());
+	_batches.back().signalInfos.insert(_batches.back().signalInfos.end(), signalInfos.begin(), signalInfos.end());
+
+	std::pmr::vector<VkCommandBufferSubmitInfo> commandBufferInfos(_batches.size(), _arena.get());
+	std::pmr::vector<VkSubmitInfo2> infos(_batches.size(), _arena.get());
+
+	for (size_t i = 0; i < _batches.size(); ++i) {
+		auto& batch = _batches[i];
+		auto& commandBufferInfo = commandBufferInfos[i];
+		auto& info = infos[i];
+
+		commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+		commandBufferInfo.commandBuffer = batch.commandBuffer;
+
+		info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+		info.commandBufferInfoCount = 1;
+		info.pCommandBufferInfos = &commandBufferInfo;
+		info.signalSemaphoreInfoCount = batch.signalInfos.size();
+		info.pSignalSemaphoreInfos = batch.signalInfos.data();
+		info.waitSemaphoreInfoCount = batch.waitInfos.size();
+		info.pWaitSemaphoreInfos = batch.waitInfos.data();
+	}
 
 	// FIXME: we need to check if the queue we're submitting on supports the operations encoded in the command buffer.
 	//        the Device constructor tries to choose command queues that support as many operations as possible, but it's possible
 	//        that a particular device only supports certain operations on certain queues (e.g. maybe it only supports transfer operations
 	//        on an exclusive queue that doesn't support graphics or compute).
-	if (DynamicVK::vkQueueSubmit2(_privateDevice->graphicsQueue(), 1, &info, VK_NULL_HANDLE) != VK_SUCCESS) {
+	if (DynamicVK::vkQueueSubmit2(_privateDevice->graphicsQueue(), infos.size(), infos.data(), VK_NULL_HANDLE) != VK_SUCCESS) {
 		// TODO
 		abort();
 	}
@@ -261,8 +303,7 @@ void Indium::PrivateCommandBuffer::commit() {
 
 	// now that the binary semaphore signals are pending, we can allow them to be used
 	for (const auto& texture: readWriteTextures) {
-		auto privateTexture = std::dynamic_pointer_cast<PrivateTexture>(texture);
-		privateTexture->endUpdatingPresentationSemaphore();
+		texture->endUpdatingPresentationSemaphore();
 	}
 
 	// we can now queue drawables for presentation and they'll be synchronized properly
@@ -280,6 +321,51 @@ void Indium::PrivateCommandBuffer::presentDrawable(std::shared_ptr<Drawable> dra
 	_drawablesToPresent.push_back(drawable);
 };
 
+void Indium::PrivateCommandBuffer::encodeSignalEvent(std::shared_ptr<Event> event, uint64_t value) {
+	std::scoped_lock lock(_mutex);
+	if (_committed) {
+		// TODO
+		abort();
+	}
+
+	auto privateEvent = std::dynamic_pointer_cast<PrivateSharedEvent>(event);
+
+	VkSemaphoreSubmitInfo signalInfo {};
+	signalInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+	signalInfo.semaphore = privateEvent->semaphore();
+	signalInfo.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+	signalInfo.value = value;
+	_batches.back().signalInfos.push_back(signalInfo);
+	_events.push_back(event);
+
+	// the signal happens once the current batch is done, so anything encoded after this has to go into a new batch
+	beginBatch();
+};
+
+void Indium::PrivateCommandBuffer::encodeWaitForEvent(std::shared_ptr<Event> event, uint64_t value) {
+	std::scoped_lock lock(_mutex);
+	if (_committed) {
+		// TODO
+		abort();
+	}
+
+	auto privateEvent = std::dynamic_pointer_cast<PrivateSharedEvent>(event);
+
+	// the wait happens before the current batch starts, so if anything has already been encoded into it,
+	// we need to start a new batch
+	if (_batches.back().firstEncoderIndex != _commandEncoders.size()) {
+		beginBatch();
+	}
+
+	VkSemaphoreSubmitInfo waitInfo {};
+	waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+	waitInfo.semaphore = privateEvent->semaphore();
+	waitInfo.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+	waitInfo.value = value;
+	_batches.back().waitInfos.push_back(waitInfo);
+	_events.push_back(event);
+};
+
 void Indium::PrivateCommandBuffer::addScheduledHandlerLocked(std::function<void(std::shared_ptr<CommandBuffer>)> handler) {
 	_scheduledHandlers.push_back(handler);
 };
@@ -37,3 +37,52 @@ Indium::PrivateCommandQueue::~PrivateCommandQueue() {
 std::shared_ptr<Indium::CommandBuffer> Indium::PrivateCommandQueue::commandBuffer() {
 	return std::make_shared<PrivateCommandBuffer>(shared_from_this());
 };
+
+std::shared_ptr<Indium::CommandBuffer> Indium::PrivateCommandQueue::commandBufferWithUnretainedReferences() {
+	return std::make_shared<PrivateCommandBuffer>(shared_from_this(), false);
+};
+
+std::unique_ptr<Indium::TransientArena> Indium::PrivateCommandQueue::takeArena() {
+	std::unique_lock lock(_arenaMutex);
+
+	if (_arenas.empty()) {
+		return std::make_unique<TransientArena>();
+	}
+
+	auto arena = std::move(_arenas.back());
+	_arenas.pop_back();
+	return arena;
+};
+
+// we don't need to keep more arenas (or upload heaps) around than there are command buffers in flight at any one time; this is just a sanity limit
+static constexpr size_t maxPooledArenas = 16;
+
+void Indium::PrivateCommandQueue::recycleArena(std::unique_ptr<TransientArena> arena) {
+	arena->reset();
+
+	std::unique_lock lock(_arenaMutex);
+	if (_arenas.size() < maxPooledArenas) {
+		_arenas.push_back(std::move(arena));
+	}
+};
+
+std::unique_ptr<Indium::UploadHeap> Indium::PrivateCommandQueue::takeUploadHeap() {
+	std::unique_lock lock(_arenaMutex);
+
+	if (_uploadHeaps.empty()) {
+		return std::make_unique<UploadHeap>(_privateDevice);
+	}
+
+	auto heap = std::move(_uploadHeaps.back());
+	_uploadHeaps.pop_back();
+	return heap;
+};
+
+void Indium::PrivateCommandQueue::recycleUploadHeap(std::unique_ptr<UploadHeap> heap) {
+	heap->reset();
+
+	std::unique_lock lock(_arenaMutex);
+	if (_uploadHeaps.size() < maxPooledArenas) {
+		_uploadHeaps.push_back(std::move(heap));
+	}
+};
@@ -0,0 +1,96 @@
+#include <indium/compile-queue.private.hpp>
+
+Indium::CompileTask::~CompileTask() {};
+
+Indium::PrivateCompileTask::PrivateCompileTask(CompilePriority _priority, uint64_t _sequence, std::function<void()> work):
+	_work(std::move(work)),
+	priority(_priority),
+	sequence(_sequence)
+	{};
+
+Indium::PrivateCompileTask::~PrivateCompileTask() {};
+
+bool Indium::PrivateCompileTask::cancel() {
+	auto expected = State::Pending;
+	if (!_state.compare_exchange_strong(expected, State::Cancelled)) {
+		return false;
+	}
+
+	// the task is never going to run now, so we can release everything it captured right away
+	_work = nullptr;
+	return true;
+};
+
+void Indium::PrivateCompileTask::run() {
+	auto expected = State::Pending;
+	if (!_state.compare_exchange_strong(expected, State::Running)) {
+		// cancelled
+		return;
+	}
+
+	_work();
+	_work = nullptr;
+	_state = State::Done;
+};
+
+Indium::PrivateCompileQueue::PrivateCompileQueue(size_t threadCount):
+	_sharedState(std::make_shared<SharedState>()),
+	_threadCount(threadCount)
+	{};
+
+Indium::PrivateCompileQueue::~PrivateCompileQueue() {
+	{
+		std::unique_lock lock(_sharedState->mutex);
+		_sharedState->stopping = true;
+	}
+	_sharedState->condition.notify_all();
+
+	for (auto& thread: _threads) {
+		if (thread.get_id() == std::this_thread::get_id()) {
+			// we're being destroyed by one of our own tasks; we can't join ourselves
+			thread.detach();
+		} else {
+			thread.join();
+		}
+	}
+};
+
+std::shared_ptr<Indium::CompileTask> Indium::PrivateCompileQueue::submit(CompilePriority priority, std::function<void()> work) {
+	std::unique_lock lock(_sharedState->mutex);
+
+	if (_threads.empty()) {
+		for (size_t i = 0; i < _threadCount; ++i) {
+			_threads.emplace_back(runWorker, _sharedState);
+		}
+	}
+
+	auto task = std::make_shared<PrivateCompileTask>(priority, _sharedState->nextSequence++, std::move(work));
+	_sharedState->tasks.push(task);
+
+	lock.unlock();
+	_sharedState->condition.notify_one();
+
+	return task;
+};
+
+void Indium::PrivateCompileQueue::runWorker(std::shared_ptr<SharedState> sharedState) {
+	while (true) {
+		std::shared_ptr<PrivateCompileTask> task;
+
+		{
+			std::unique_lock lock(sharedState->mutex);
+			sharedState->condition.wait(lock, [&]() {
+				return sharedState->stopping || !sharedState->tasks.empty();
+			});
+
+			if (sharedState->stopping) {
+				return;
+			}
+
+			task = sharedState->tasks.top();
+			sharedState->tasks.pop();
+		}
+
+		task->run();
+	}
+};
@@ -1,5 +1,6 @@
 #include <indium/compute-command-encoder.private.hpp>
 #include <indium/device.private.hpp>
+#include <indium/fence.private.hpp>
 #include <indium/dynamic-vk.hpp>
 
 Indium::ComputeCommandEncoder::~ComputeCommandEncoder() {};
@@ -9,6 +10,9 @@ Indium::PrivateComputeCommandEncoder::PrivateComputeCommandEncoder(std::shared_p
 	_privateDevice(std::dynamic_pointer_cast<PrivateDevice>(commandBuffer->device())),
 	_descriptor(descriptor)
 {
+	_functionResources.retainReferences = commandBuffer->retainedReferences();
+	_indirectFunctionResources.retainReferences = false;
+
 	VkDescriptorPoolCreateInfo poolCreateInfo {};
 	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 	poolCreateInfo.poolSizeCount = poolSizes.size();
@@ -22,18 +26,96 @@ Indium::PrivateComputeCommandEncoder::PrivateComputeCommandEncoder(std::shared_p
 };
 
 Indium::PrivateComputeCommandEncoder::~PrivateComputeCommandEncoder() {
-	for (auto& pipeline: _savedPipelines) {
-		DynamicVK::vkDestroyPipeline(_privateDevice->device(), pipeline, nullptr);
-	}
 	DynamicVK::vkDestroyDescriptorPool(_privateDevice->device(), _pool, 0);
 };
 
 void Indium::PrivateComputeCommandEncoder::endEncoding() {
-	// nothing for now
+	auto cmdbuf = _privateCommandBuffer.lock();
+	PrivateFence::encodeUpdates(cmdbuf->commandBuffer(), _fenceUpdateStages);
+};
+
+void Indium::PrivateComputeCommandEncoder::useResource(std::shared_ptr<Resource> resource, ResourceUsage usage) {
+	useResources({ resource }, usage);
+};
+
+void Indium::PrivateComputeCommandEncoder::useResources(const std::vector<std::shared_ptr<Resource>>& resources, ResourceUsage usage) {
+	// resources used through argument buffers aren't bound directly, so this is our only chance to make previous writes to them visible.
+	// see PrivateRenderCommandEncoder::useResources() for the same thing in render passes.
+	auto buf = _privateCommandBuffer.lock();
+
+	TransientArena::Scope arenaScope(buf->arena());
+	std::pmr::vector<VkBufferMemoryBarrier> bufferBarriers(&buf->arena());
+	std::pmr::vector<VkImageMemoryBarrier> imageBarriers(&buf->arena());
+
+	VkAccessFlags source = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+	VkAccessFlags dest = VK_ACCESS_NONE;
+
+	if (!!(usage & (ResourceUsage::Read | ResourceUsage::Sample))) {
+		dest |= VK_ACCESS_SHADER_READ_BIT;
+	}
+
+	if (!!(usage & ResourceUsage::Write)) {
+		dest |= VK_ACCESS_SHADER_WRITE_BIT;
+	}
+
+	for (const auto& resource: resources) {
+		if (auto buffer = std::dynamic_pointer_cast<PrivateBuffer>(resource)) {
+			VkBufferMemoryBarrier barrier {};
+
+			barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			barrier.srcAccessMask = source;
+			barrier.dstAccessMask = dest;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.buffer = buffer->buffer();
+			barrier.offset = 0;
+			barrier.size = VK_WHOLE_SIZE;
+
+			bufferBarriers.push_back(barrier);
+		} else if (auto texture = std::dynamic_pointer_cast<PrivateTexture>(resource)) {
+			VkImageMemoryBarrier barrier {};
+
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.srcAccessMask = source;
+			barrier.dstAccessMask = dest;
+			barrier.oldLayout = texture->imageLayout();
+			barrier.newLayout = barrier.oldLayout;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = texture->image();
+			barrier.subresourceRange.aspectMask = pixelFormatToVkImageAspectFlags(texture->pixelFormat());
+			barrier.subresourceRange.baseMipLevel = 0;
+			barrier.subresourceRange.levelCount = texture->mipmapLevelCount();
+			barrier.subresourceRange.baseArrayLayer = 0;
+			barrier.subresourceRange.layerCount = texture->vulkanArrayLength();
+
+			imageBarriers.push_back(barrier);
+		} else {
+			throw std::runtime_error("Unsupported resource");
+		}
+	}
+
+	DynamicVK::vkCmdPipelineBarrier(buf->commandBuffer(), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, bufferBarriers.size(), bufferBarriers.data(), imageBarriers.size(), imageBarriers.data());
+};
+
+void Indium::PrivateComputeCommandEncoder::updateFence(std::shared_ptr<Fence> fence) {
+	_fenceUpdateStages |= VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+};
+
+void Indium::PrivateComputeCommandEncoder::waitForFence(std::shared_ptr<Fence> fence) {
+	// nothing to do here; see PrivateFence for details
 };
 
 void Indium::PrivateComputeCommandEncoder::setComputePipelineState(std::shared_ptr<ComputePipelineState> state) {
 	_pso = std::dynamic_pointer_cast<PrivateComputePipelineState>(state);
+
+	// descriptor sets and push constants aren't preserved across pipelines with different layouts
+	_functionResources.dirty = true;
+	_functionResources.pushConstantsDirty = true;
+
+	if (_pso && (_keepAlivePipelineStates.empty() || _keepAlivePipelineStates.back() != _pso)) {
+		_keepAlivePipelineStates.push_back(_pso);
+	}
 };
 
 void Indium::PrivateComputeCommandEncoder::setBuffer(std::shared_ptr<Buffer> buffer, size_t offset, size_t index) {
@@ -51,7 +133,7 @@ void Indium::PrivateComputeCommandEncoder::setBufferOffset(size_t offset, size_t
 };
 
 void Indium::PrivateComputeCommandEncoder::setBytes(const void* bytes, size_t length, size_t index) {
-	_functionResources.setBytes(_privateDevice, bytes, length, index);
+	_functionResources.setBytes(bytes, length, index);
 };
 
 void Indium::PrivateComputeCommandEncoder::setSamplerState(std::shared_ptr<SamplerState> state, size_t index) {
@@ -91,18 +173,222 @@ void Indium::PrivateComputeCommandEncoder::setThreadgroupMemoryLength(size_t len
 void Indium::PrivateComputeCommandEncoder::dispatchThreadgroups(Size threadgroupsPerGrid, Size threadsPerThreadgroup) {
 	auto buf = _privateCommandBuffer.lock();
 
-	auto pipeline = _pso->createPipeline(threadsPerThreadgroup);
-	_savedPipelines.push_back(pipeline);
+	auto pipeline = _pso->pipeline(threadsPerThreadgroup);
 
 	DynamicVK::vkCmdBindPipeline(buf->commandBuffer(), VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
 
 	// TODO: avoid re-binding descriptors on every dispatch
-	updateBindings();
+	updateBindings(_functionResources);
 
 	DynamicVK::vkCmdDispatch(buf->commandBuffer(), threadgroupsPerGrid.width, threadgroupsPerGrid.height, threadgroupsPerGrid.depth);
 
 	// see PrivateRenderCommandEncoder::drawPrimitives() for why we do this
-	_savedFunctionResources.push_back(_functionResources);
+	_functionResources.markUsed();
+};
+
+// Metal's indirect argument structure has the same layout as Vulkan's, so the buffer can be passed straight through
+static_assert(sizeof(VkDispatchIndirectCommand) == 3 * sizeof(uint32_t));
+
+void Indium::PrivateComputeCommandEncoder::dispatchThreadgroups(std::shared_ptr<Buffer> indirectBuffer, size_t indirectBufferOffset, Size threadsPerThreadgroup) {
+	auto buf = _privateCommandBuffer.lock();
+
+	auto privateIndirectBuffer = std::dynamic_pointer_cast<PrivateBuffer>(indirectBuffer);
+
+	// the arguments are usually written by an earlier dispatch (e.g. one that compacts the work for this one),
+	// so we have to make those writes visible to the indirect command read
+	VkBufferMemoryBarrier barrier {};
+	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.buffer = privateIndirectBuffer->buffer();
+	barrier.offset = indirectBufferOffset;
+	barrier.size = sizeof(VkDispatchIndirectCommand);
+
+	DynamicVK::vkCmdPipelineBarrier(buf->commandBuffer(), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+	auto pipeline = _pso->pipeline(threadsPerThreadgroup);
+
+	DynamicVK::vkCmdBindPipeline(buf->commandBuffer(), VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+
+	updateBindings(_functionResources);
+
+	DynamicVK::vkCmdDispatchIndirect(buf->commandBuffer(), privateIndirectBuffer->buffer(), indirectBufferOffset);
+
+	// we need to keep the argument buffer alive until the dispatch completes
+	// (unless the user promised to do that for us)
+	if (buf->retainedReferences()) {
+		_keepAliveBuffers.push_back(std::move(indirectBuffer));
+	}
+
+	// see PrivateRenderCommandEncoder::drawPrimitives() for why we do this
+	_functionResources.markUsed();
+};
+
+void Indium::PrivateComputeCommandEncoder::executeCommandsInBuffer(std::shared_ptr<IndirectCommandBuffer> indirectCommandBuffer, Range<size_t> executionRange) {
+	auto buf = _privateCommandBuffer.lock();
+	auto privateICB = std::dynamic_pointer_cast<PrivateIndirectCommandBuffer>(indirectCommandBuffer);
+	const auto& icbDescriptor = privateICB->descriptor();
+
+	if (!privateICB->containsComputeCommands()) {
+		throw std::runtime_error("Indirect command buffer doesn't contain compute commands");
+	}
+
+	privateICB->checkRange(executionRange);
+
+	// commands that set their own pipeline states and buffers don't depend on any of our state, so they can be recorded once and then executed as-is
+	if (!icbDescriptor.inheritPipelineState && !icbDescriptor.inheritBuffers) {
+		executeRecordedCommands(*privateICB, executionRange);
+
+		if (buf->retainedReferences() && (_keepAliveIndirectCommandBuffers.empty() || _keepAliveIndirectCommandBuffers.back() != indirectCommandBuffer)) {
+			_keepAliveIndirectCommandBuffers.push_back(std::move(indirectCommandBuffer));
+		}
+		return;
+	}
+
+	// otherwise, we fall back to replaying the commands ourselves, since secondary command buffers can't inherit our pipeline state or buffers
+
+	auto savedPSO = _pso;
+
+	// see PrivateRenderCommandEncoder::executeCommandsInBuffer()
+	auto& functionResources = icbDescriptor.inheritBuffers ? _functionResources : _indirectFunctionResources;
+	if (!icbDescriptor.inheritBuffers) {
+		_indirectFunctionResources.dirty = true;
+		_indirectFunctionResources.pushConstantsDirty = true;
+	}
+
+	auto restoreEncoderState = [&]() {
+		if (!icbDescriptor.inheritPipelineState && savedPSO != _pso) {
+			setComputePipelineState(savedPSO);
+		}
+
+		if (!icbDescriptor.inheritBuffers) {
+			_functionResources.needsRebind = true;
+			_functionResources.pushConstantsDirty = true;
+		}
+	};
+
+	try {
+		for (size_t i = executionRange.start; i < executionRange.start + executionRange.length; ++i) {
+			const auto& command = privateICB->computeCommand(i);
+
+			if (!command.dispatch) {
+				continue;
+			}
+
+			if (!icbDescriptor.inheritPipelineState && command.pipelineState != _pso) {
+				setComputePipelineState(command.pipelineState);
+				_indirectFunctionResources.dirty = true;
+				_indirectFunctionResources.pushConstantsDirty = true;
+			}
+
+			if (!_pso) {
+				throw std::runtime_error("No compute pipeline state set for indirect command");
+			}
+
+			if (!icbDescriptor.inheritBuffers) {
+				for (size_t index = 0; index < command.buffers.size(); ++index) {
+					functionResources.setBuffer(command.buffers[index].buffer, command.buffers[index].offset, index);
+				}
+			}
+
+			auto pipeline = _pso->pipeline(command.dispatch->threadsPerThreadgroup);
+
+			DynamicVK::vkCmdBindPipeline(buf->commandBuffer(), VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+
+			updateBindings(functionResources);
+
+			DynamicVK::vkCmdDispatch(buf->commandBuffer(), command.dispatch->threadgroupsPerGrid.width, command.dispatch->threadgroupsPerGrid.height, command.dispatch->threadgroupsPerGrid.depth);
+
+			functionResources.markUsed();
+		}
+	} catch (...) {
+		restoreEncoderState();
+		throw;
+	}
+
+	restoreEncoderState();
+
+	if (buf->retainedReferences() && (_keepAliveIndirectCommandBuffers.empty() || _keepAliveIndirectCommandBuffers.back() != indirectCommandBuffer)) {
+		_keepAliveIndirectCommandBuffers.push_back(std::move(indirectCommandBuffer));
+	}
+};
+
+void Indium::PrivateComputeCommandEncoder::executeRecordedCommands(PrivateIndirectCommandBuffer& indirectCommandBuffer, Range<size_t> executionRange) {
+	auto buf = _privateCommandBuffer.lock();
+
+	// compute recordings don't inherit anything from us, so they don't need a key
+	static const std::vector<char> key;
+
+	auto recording = indirectCommandBuffer.findRecording(executionRange, key);
+	if (!recording) {
+		recording = recordIndirectCommands(indirectCommandBuffer, executionRange);
+		indirectCommandBuffer.addRecording(recording);
+	}
+
+	auto recordedCommandBuffer = recording->commandBuffer();
+	DynamicVK::vkCmdExecuteCommands(buf->commandBuffer(), 1, &recordedCommandBuffer);
+
+	// our descriptor sets and push constants are undefined after executing another command buffer
+	// (every dispatch binds its own pipeline anyways)
+	_functionResources.needsRebind = true;
+	_functionResources.pushConstantsDirty = true;
+
+	_keepAliveIndirectRecordings.push_back(std::move(recording));
+};
+
+std::shared_ptr<Indium::PrivateIndirectCommandRecording> Indium::PrivateComputeCommandEncoder::recordIndirectCommands(PrivateIndirectCommandBuffer& indirectCommandBuffer, Range<size_t> executionRange) {
+	// each command needs at most one descriptor set
+	auto recording = std::make_shared<PrivateIndirectCommandRecording>(_privateDevice, executionRange, std::vector<char>(), executionRange.length);
+	auto commandBuffer = recording->commandBuffer();
+
+	recording->begin(0, nullptr);
+
+	// nothing is bound at the start of the recording; see PrivateRenderCommandEncoder::recordIndirectCommands()
+	auto& functionResources = _indirectFunctionResources;
+	functionResources.dirty = true;
+	functionResources.pushConstantsDirty = true;
+
+	std::shared_ptr<PrivateComputePipelineState> pso;
+
+	for (size_t i = executionRange.start; i < executionRange.start + executionRange.length; ++i) {
+		const auto& command = indirectCommandBuffer.computeCommand(i);
+
+		if (!command.dispatch) {
+			continue;
+		}
+
+		if (!command.pipelineState) {
+			throw std::runtime_error("No compute pipeline state set for indirect command");
+		}
+
+		if (command.pipelineState != pso) {
+			pso = command.pipelineState;
+			recording->retain(pso);
+			functionResources.dirty = true;
+			functionResources.pushConstantsDirty = true;
+		}
+
+		for (size_t index = 0; index < command.buffers.size(); ++index) {
+			functionResources.setBuffer(command.buffers[index].buffer, command.buffers[index].offset, index);
+			if (command.buffers[index].buffer) {
+				recording->retain(command.buffers[index].buffer);
+			}
+		}
+
+		DynamicVK::vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pso->pipeline(command.dispatch->threadsPerThreadgroup));
+
+		updateBindings(functionResources, *pso, commandBuffer, recording->descriptorPool(), recording->uploadHeap());
+
+		DynamicVK::vkCmdDispatch(commandBuffer, command.dispatch->threadgroupsPerGrid.width, command.dispatch->threadgroupsPerGrid.height, command.dispatch->threadgroupsPerGrid.depth);
+
+		functionResources.markUsed();
+	}
+
+	recording->end();
+
+	return recording;
 };
 
 void Indium::PrivateComputeCommandEncoder::dispatchThreads(Size threadsPerGrid, Size threadsPerThreadgroup) {
@@ -135,10 +421,24 @@ Indium::DispatchType Indium::PrivateComputeCommandEncoder::dispatchType() {
 	return _descriptor.dispatchType;
 };
 
-void Indium::PrivateComputeCommandEncoder::updateBindings() {
+void Indium::PrivateComputeCommandEncoder::updateBindings(FunctionResources& functionResources) {
+	auto buf = _privateCommandBuffer.lock();
+	updateBindings(functionResources, *_pso, buf->commandBuffer(), _pool, buf->uploadHeap());
+};
+
+void Indium::PrivateComputeCommandEncoder::updateBindings(FunctionResources& functionResources, PrivateComputePipelineState& pso, VkCommandBuffer commandBuffer, VkDescriptorPool pool, UploadHeap& uploadHeap) {
 	auto buf = _privateCommandBuffer.lock();
 
-	std::array<VkDescriptorSet, 1> descriptorSets = createDescriptorSets(_pso->descriptorSetLayouts().layouts, _pool, _privateDevice, { _functionResources }, { _pso->functionInfo() }, _keepAliveBuffers);
+	const auto& functionInfo = pso.functionInfo();
+
+	functionResources.resolveDirtyBindings(functionInfo);
 
-	DynamicVK::vkCmdBindDescriptorSets(buf->commandBuffer(), VK_PIPELINE_BIND_POINT_COMPUTE, _pso->layout(), 0, descriptorSets.size(), descriptorSets.data(), 0, nullptr);
+	// with bindless resources, dispatches that only change textures and samplers don't need new descriptor sets
+	if (functionResources.dirty || functionResources.needsRebind) {
+		bindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pso.layout(), pso.descriptorSetLayouts(), pool, _privateDevice, { functionResources }, { functionInfo }, uploadHeap, buf->arena());
+	}
+
+	if (functionInfo.pushConstantRange.size > 0 && functionResources.pushConstantsDirty) {
+		functionResources.pushConstants(_privateDevice, commandBuffer, pso.layout(), functionInfo, uploadHeap);
+	}
 };
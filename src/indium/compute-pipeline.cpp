@@ -1,5 +1,6 @@
 #include <indium/compute-pipeline.private.hpp>
 #include <indium/device.private.hpp>
+#include <indium/pipeline-manifest.private.hpp>
 #include <stdexcept>
 #include <indium/dynamic-vk.hpp>
 
@@ -19,18 +20,18 @@ Indium::PrivateComputePipelineState::PrivateComputePipelineState(std::shared_ptr
 		throw std::runtime_error("TODO: support stage-in parameters in compute shaders");
 	}
 
-	_descriptorSetLayouts.processFunction(std::dynamic_pointer_cast<PrivateFunction>(_descriptor.computeFunction), 0);
+	_descriptorSetLayouts.processFunction(std::dynamic_pointer_cast<PrivateFunction>(_descriptor.computeFunction), 0, true);
+	_manifestKey = computePipelineManifestKey(_descriptor);
 
-	VkPipelineLayoutCreateInfo layoutInfo {};
-	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	layoutInfo.setLayoutCount = _descriptorSetLayouts.layouts.size();
-	layoutInfo.pSetLayouts = _descriptorSetLayouts.layouts.data();
-
-	if (DynamicVK::vkCreatePipelineLayout(_privateDevice->device(), &layoutInfo, nullptr, &_layout) != VK_SUCCESS) {
-		// TODO
-		abort();
+	std::vector<VkPushConstantRange> pushConstantRanges;
+	if (functionInfo().pushConstantRange.size > 0) {
+		pushConstantRanges.push_back(functionInfo().pushConstantRange);
 	}
 
+	_sharedLayout = _descriptorSetLayouts.pipelineLayout(pushConstantRanges);
+	_layout = _sharedLayout->layout;
+	_descriptorSetLayouts.createUpdateTemplates(_layout, VK_PIPELINE_BIND_POINT_COMPUTE);
+
 	// determine device properties
 	VkPhysicalDeviceVulkan13Properties vk13Props {};
 	vk13Props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_PROPERTIES;
@@ -45,16 +46,21 @@ Indium::PrivateComputePipelineState::PrivateComputePipelineState(std::shared_ptr
 };
 
 Indium::PrivateComputePipelineState::~PrivateComputePipelineState() {
-	if (_layout) {
-		DynamicVK::vkDestroyPipelineLayout(_privateDevice->device(), _layout, nullptr);
-	}
+	_pipelines.forEach([this](const Size& threadsPerThreadgroup, VkPipeline pipeline) {
+		DynamicVK::vkDestroyPipeline(_privateDevice->device(), pipeline, nullptr);
+	});
 };
 
-VkPipeline Indium::PrivateComputePipelineState::createPipeline(Size threadsPerThreadgroup) {
-	// TODO: optimize this by using pipeline caches.
-	//       also, we can store the most recent pipeline and, if the number of threads per threadgroup stays the same,
-	//       we can just return that instead (wrapped in a reference counting object).
+VkPipeline Indium::PrivateComputePipelineState::pipeline(Size threadsPerThreadgroup) {
+	_privateDevice->recordComputePipelineVariant(_manifestKey, threadsPerThreadgroup);
+
+	// like with render pipelines, each variant is only compiled once, and only requests for the same variant wait for each other
+	return _pipelines.get(threadsPerThreadgroup, [&]() {
+		return compilePipeline(threadsPerThreadgroup);
+	});
+};
 
+VkPipeline Indium::PrivateComputePipelineState::compilePipeline(Size threadsPerThreadgroup) {
 	VkPipeline pipeline = VK_NULL_HANDLE;
 
 	auto func = std::dynamic_pointer_cast<PrivateFunction>(_descriptor.computeFunction);
@@ -85,7 +91,8 @@ VkPipeline Indium::PrivateComputePipelineState::createPipeline(Size threadsPerTh
 	info.stage.pSpecializationInfo = &specInfo;
 	info.layout = _layout;
 
-	if (DynamicVK::vkCreateComputePipelines(_privateDevice->device(), VK_NULL_HANDLE, 1, &info, nullptr, &pipeline) != VK_SUCCESS) {
+	auto pipelineCacheLock = _privateDevice->lockPipelineCache();
+	if (DynamicVK::vkCreateComputePipelines(_privateDevice->device(), _privateDevice->pipelineCache(), 1, &info, nullptr, &pipeline) != VK_SUCCESS) {
 		// TODO
 		abort();
 	}
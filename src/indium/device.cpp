@@ -8,12 +8,23 @@
 #include <indium/texture.private.hpp>
 #include <indium/depth-stencil.private.hpp>
 #include <indium/compute-pipeline.private.hpp>
+#include <indium/fence.private.hpp>
+#include <indium/event.private.hpp>
+#include <indium/binary-archive.private.hpp>
+#include <indium/pipeline-manifest.private.hpp>
+#include <indium/resource-table.private.hpp>
+#include <indium/argument-encoder.private.hpp>
+#include <indium/indirect-command-buffer.private.hpp>
+#include <indium/serialization.private.hpp>
 #include <indium/dynamic-vk.hpp>
 
 #include <iridium/iridium.hpp>
 
+#include <algorithm>
+#include <fstream>
 #include <set>
 #include <stdexcept>
+#include <string_view>
 #include <thread>
 #include <unordered_set>
 
@@ -66,7 +77,7 @@ void Indium::initGlobalDeviceList() {
 
 		DynamicVK::vkGetPhysicalDeviceFeatures2(device, &features);
 
-		if (!features12.timelineSemaphore) {
+		if (!features12.timelineSemaphore || !features13.dynamicRendering) {
 			// unsupported device
 			continue;
 		}
@@ -76,6 +87,9 @@ void Indium::initGlobalDeviceList() {
 };
 
 void Indium::finitGlobalDeviceList() {
+	for (auto& device: globalDeviceList) {
+		device->discardPrewarmedPipelineStates();
+	}
 	globalDeviceList.clear();
 };
 
@@ -222,6 +236,11 @@ Indium::PrivateDevice::PrivateDevice(VkPhysicalDevice physicalDevice):
 		{ VK_KHR_EXTERNAL_MEMORY_FD_EXTENSION_NAME, Feature::ExternalMemoryFD },
 		{ VK_KHR_EXTERNAL_SEMAPHORE_FD_EXTENSION_NAME, Feature::ExternalSemaphoreFD },
 		{ VK_KHR_SHADER_NON_SEMANTIC_INFO_EXTENSION_NAME, Feature::NonSemanticInfo },
+		{ VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME, Feature::PipelineLibrary },
+		{ VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME, Feature::GraphicsPipelineLibrary },
+		{ VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME, Feature::ExtendedDynamicState3 },
+		{ VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME, Feature::PushDescriptor },
+		{ VK_EXT_NESTED_COMMAND_BUFFER_EXTENSION_NAME, Feature::NestedCommandBuffer },
 	};
 
 	for (const auto& prop: extProps) {
@@ -233,6 +252,161 @@ Indium::PrivateDevice::PrivateDevice(VkPhysicalDevice physicalDevice):
 		}
 	}
 
+	auto disableOptionalExtension = [&](const char* name, Feature feature) {
+		extensions.erase(std::remove_if(extensions.begin(), extensions.end(), [&](const char* extension) {
+			return strcmp(extension, name) == 0;
+		}), extensions.end());
+		indiumFeatures = static_cast<Feature>(static_cast<std::underlying_type_t<Feature>>(indiumFeatures) & ~static_cast<std::underlying_type_t<Feature>>(feature));
+	};
+
+	// some optional extensions have features of their own that the device also needs to support before we can use them.
+	// these are chained onto the core features to query them; once we know which extensions we're keeping, the chain is rebuilt below.
+	void** nextFeatures = &features13.pNext;
+
+	VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT graphicsPipelineLibraryFeatures {};
+	graphicsPipelineLibraryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+
+	if (!!(indiumFeatures & Feature::GraphicsPipelineLibrary)) {
+		*nextFeatures = &graphicsPipelineLibraryFeatures;
+		nextFeatures = &graphicsPipelineLibraryFeatures.pNext;
+	}
+
+	VkPhysicalDeviceExtendedDynamicState3FeaturesEXT extendedDynamicState3Features {};
+	extendedDynamicState3Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+
+	if (!!(indiumFeatures & Feature::ExtendedDynamicState3)) {
+		*nextFeatures = &extendedDynamicState3Features;
+		nextFeatures = &extendedDynamicState3Features.pNext;
+	}
+
+	VkPhysicalDeviceNestedCommandBufferFeaturesEXT nestedCommandBufferFeatures {};
+	nestedCommandBufferFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_NESTED_COMMAND_BUFFER_FEATURES_EXT;
+
+	if (!!(indiumFeatures & Feature::NestedCommandBuffer)) {
+		*nextFeatures = &nestedCommandBufferFeatures;
+		nextFeatures = &nestedCommandBufferFeatures.pNext;
+	}
+
+	DynamicVK::vkGetPhysicalDeviceFeatures2(_physicalDevice, &features);
+
+	if (!graphicsPipelineLibraryFeatures.graphicsPipelineLibrary || !(indiumFeatures & Feature::PipelineLibrary)) {
+		disableOptionalExtension(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME, Feature::GraphicsPipelineLibrary);
+	}
+
+	// we only use extended dynamic state 3 for the fill mode and depth clip mode, so we need both of those to be supported
+	// (along with the core features needed to actually use non-default values for them)
+	if (
+		!extendedDynamicState3Features.extendedDynamicState3PolygonMode ||
+		!extendedDynamicState3Features.extendedDynamicState3DepthClampEnable ||
+		!features.features.fillModeNonSolid ||
+		!features.features.depthClamp
+	) {
+		disableOptionalExtension(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME, Feature::ExtendedDynamicState3);
+	}
+
+	// we only use nested command buffers to execute indirect command buffers in the middle of a render pass,
+	// so the only thing we need is for a rendering instance to be able to contain both inline commands and secondary command buffers
+	if (!nestedCommandBufferFeatures.nestedCommandBuffer) {
+		disableOptionalExtension(VK_EXT_NESTED_COMMAND_BUFFER_EXTENSION_NAME, Feature::NestedCommandBuffer);
+	}
+
+	// the features of extensions we don't enable can't be in the chain we create the device with. for the ones we do enable, we only enable what we use:
+	// all of graphics pipeline library's features, but just the fill mode and depth clip mode parts of extended dynamic state 3
+	// and just the basic nested command buffer feature.
+	// (unlike the core features, enabling every extended dynamic state 3 feature would make the driver track state we never set.)
+	nextFeatures = &features13.pNext;
+	*nextFeatures = nullptr;
+
+	if (!!(indiumFeatures & Feature::GraphicsPipelineLibrary)) {
+		graphicsPipelineLibraryFeatures.pNext = nullptr;
+		*nextFeatures = &graphicsPipelineLibraryFeatures;
+		nextFeatures = &graphicsPipelineLibraryFeatures.pNext;
+	}
+
+	VkPhysicalDeviceExtendedDynamicState3FeaturesEXT usedExtendedDynamicState3Features {};
+	usedExtendedDynamicState3Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+	usedExtendedDynamicState3Features.extendedDynamicState3PolygonMode = VK_TRUE;
+	usedExtendedDynamicState3Features.extendedDynamicState3DepthClampEnable = VK_TRUE;
+
+	if (!!(indiumFeatures & Feature::ExtendedDynamicState3)) {
+		*nextFeatures = &usedExtendedDynamicState3Features;
+		nextFeatures = &usedExtendedDynamicState3Features.pNext;
+	}
+
+	VkPhysicalDeviceNestedCommandBufferFeaturesEXT usedNestedCommandBufferFeatures {};
+	usedNestedCommandBufferFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_NESTED_COMMAND_BUFFER_FEATURES_EXT;
+	usedNestedCommandBufferFeatures.nestedCommandBuffer = VK_TRUE;
+
+	if (!!(indiumFeatures & Feature::NestedCommandBuffer)) {
+		*nextFeatures = &usedNestedCommandBufferFeatures;
+		nextFeatures = &usedNestedCommandBufferFeatures.pNext;
+	}
+
+	if (!!(indiumFeatures & Feature::ExtendedDynamicState3)) {
+		VkPhysicalDeviceExtendedDynamicState3PropertiesEXT extendedDynamicState3Props {};
+		extendedDynamicState3Props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_PROPERTIES_EXT;
+		VkPhysicalDeviceProperties2 props {};
+		props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		props.pNext = &extendedDynamicState3Props;
+		DynamicVK::vkGetPhysicalDeviceProperties2(_physicalDevice, &props);
+
+		if (extendedDynamicState3Props.dynamicPrimitiveTopologyUnrestricted) {
+			indiumFeatures = indiumFeatures | Feature::UnrestrictedPrimitiveTopology;
+		}
+	}
+
+	if (
+		features12.runtimeDescriptorArray &&
+		features12.descriptorBindingPartiallyBound &&
+		features12.descriptorBindingSampledImageUpdateAfterBind &&
+		features12.descriptorBindingUpdateUnusedWhilePending &&
+		features12.shaderSampledImageArrayNonUniformIndexing
+	) {
+		indiumFeatures = indiumFeatures | Feature::DescriptorIndexing;
+	}
+
+	if (features12.drawIndirectCount && features.features.multiDrawIndirect) {
+		indiumFeatures = indiumFeatures | Feature::DrawIndirectCount;
+	}
+
+	if (features.features.occlusionQueryPrecise) {
+		indiumFeatures = indiumFeatures | Feature::PreciseOcclusionQuery;
+	}
+
+	if (features12.hostQueryReset) {
+		indiumFeatures = indiumFeatures | Feature::HostQueryReset;
+	}
+
+	if (features.features.fillModeNonSolid) {
+		indiumFeatures = indiumFeatures | Feature::FillModeNonSolid;
+	}
+
+	if (features.features.depthClamp) {
+		indiumFeatures = indiumFeatures | Feature::DepthClamp;
+	}
+
+	if (!!(indiumFeatures & Feature::PushDescriptor)) {
+		VkPhysicalDevicePushDescriptorPropertiesKHR pushDescriptorProps {};
+		pushDescriptorProps.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PUSH_DESCRIPTOR_PROPERTIES_KHR;
+		VkPhysicalDeviceProperties2 props {};
+		props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		props.pNext = &pushDescriptorProps;
+		DynamicVK::vkGetPhysicalDeviceProperties2(_physicalDevice, &props);
+
+		_maxPushDescriptors = pushDescriptorProps.maxPushDescriptors;
+	}
+
+	{
+		VkPhysicalDeviceDepthStencilResolveProperties depthStencilResolveProps {};
+		depthStencilResolveProps.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DEPTH_STENCIL_RESOLVE_PROPERTIES;
+		VkPhysicalDeviceProperties2 props {};
+		props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		props.pNext = &depthStencilResolveProps;
+		DynamicVK::vkGetPhysicalDeviceProperties2(_physicalDevice, &props);
+
+		_supportedDepthResolveModes = depthStencilResolveProps.supportedDepthResolveModes;
+	}
+
 	VkDeviceCreateInfo deviceCreateInfo {};
 	deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 	deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();
@@ -294,9 +468,44 @@ Indium::PrivateDevice::PrivateDevice(VkPhysicalDevice physicalDevice):
 			abort();
 		}
 	}
+
+	// leave one core for the thread that's waiting on the results
+	auto hardwareThreads = std::thread::hardware_concurrency();
+	_compileQueue = std::make_unique<PrivateCompileQueue>((hardwareThreads > 1) ? hardwareThreads - 1 : 1);
+
+	VkPipelineCacheCreateInfo pipelineCacheCreateInfo {};
+	pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+	if (DynamicVK::vkCreatePipelineCache(_device, &pipelineCacheCreateInfo, nullptr, &_pipelineCache) != VK_SUCCESS) {
+		// TODO
+		abort();
+	}
 };
 
 Indium::PrivateDevice::~PrivateDevice() {
+	// nothing else can be using the device now, so none of the compilation threads are using it either
+	_compileQueue.reset();
+
+	_resourceTable.reset();
+
+	for (auto pool: _occlusionQueryPools) {
+		DynamicVK::vkDestroyQueryPool(_device, pool, nullptr);
+	}
+
+	if (_accumulatePipeline) {
+		DynamicVK::vkDestroyPipeline(_device, _accumulatePipeline, nullptr);
+	}
+	if (_accumulatePipelineLayout) {
+		DynamicVK::vkDestroyPipelineLayout(_device, _accumulatePipelineLayout, nullptr);
+	}
+
+	for (const auto& allocation: _memorylessAllocations) {
+		DynamicVK::vkFreeMemory(_device, allocation.memory, nullptr);
+	}
+
+	if (_pipelineCache) {
+		DynamicVK::vkDestroyPipelineCache(_device, _pipelineCache, nullptr);
+	}
 	if (_oneshotCommandPool) {
 		DynamicVK::vkDestroyCommandPool(_device, _oneshotCommandPool, nullptr);
 	}
@@ -313,20 +522,59 @@ std::shared_ptr<Indium::CommandQueue> Indium::PrivateDevice::newCommandQueue() {
 };
 
 std::shared_ptr<Indium::RenderPipelineState> Indium::PrivateDevice::newRenderPipelineState(const RenderPipelineDescriptor& descriptor) {
-	return std::make_shared<PrivateRenderPipelineState>(shared_from_this(), descriptor);
+	return _renderPipelineStates.intern(renderPipelineManifestKey(descriptor), [&]() {
+		return std::make_shared<PrivateRenderPipelineState>(shared_from_this(), descriptor);
+	});
 };
 
 std::shared_ptr<Indium::ComputePipelineState> Indium::PrivateDevice::newComputePipelineState(const ComputePipelineDescriptor& descriptor, PipelineOption options, std::shared_ptr<ComputePipelineReflection> reflection) {
 	if (options != PipelineOption::None) {
 		throw std::runtime_error("TODO: support compute pipeline options");
 	}
-	return std::make_shared<PrivateComputePipelineState>(shared_from_this(), descriptor);
+
+	return _computePipelineStates.intern(computePipelineManifestKey(descriptor), [&]() {
+		return std::make_shared<PrivateComputePipelineState>(shared_from_this(), descriptor);
+	});
 };
 
 std::shared_ptr<Indium::ComputePipelineState> Indium::PrivateDevice::newComputePipelineState(std::shared_ptr<Function> computeFunction, PipelineOption options, std::shared_ptr<ComputePipelineReflection> reflection) {
 	return newComputePipelineState(ComputePipelineDescriptor { computeFunction }, options, reflection);
 };
 
+std::shared_ptr<Indium::CompileTask> Indium::PrivateDevice::newRenderPipelineState(const RenderPipelineDescriptor& descriptor, NewRenderPipelineStateCompletionHandler completionHandler, CompilePriority priority) {
+	return _compileQueue->submit(priority, [self = shared_from_this(), descriptor, completionHandler]() {
+		std::shared_ptr<RenderPipelineState> state = nullptr;
+		std::exception_ptr error = nullptr;
+
+		try {
+			state = self->newRenderPipelineState(descriptor);
+		} catch (...) {
+			error = std::current_exception();
+		}
+
+		completionHandler(state, error);
+	});
+};
+
+std::shared_ptr<Indium::CompileTask> Indium::PrivateDevice::newComputePipelineState(const ComputePipelineDescriptor& descriptor, PipelineOption options, NewComputePipelineStateCompletionHandler completionHandler, CompilePriority priority) {
+	return _compileQueue->submit(priority, [self = shared_from_this(), descriptor, options, completionHandler]() {
+		std::shared_ptr<ComputePipelineState> state = nullptr;
+		std::exception_ptr error = nullptr;
+
+		try {
+			state = self->newComputePipelineState(descriptor, options, std::shared_ptr<ComputePipelineReflection>());
+		} catch (...) {
+			error = std::current_exception();
+		}
+
+		completionHandler(state, error);
+	});
+};
+
+std::shared_ptr<Indium::CompileTask> Indium::PrivateDevice::newComputePipelineState(std::shared_ptr<Function> computeFunction, NewComputePipelineStateCompletionHandler completionHandler, CompilePriority priority) {
+	return newComputePipelineState(ComputePipelineDescriptor { computeFunction }, PipelineOption::None, completionHandler, priority);
+};
+
 std::shared_ptr<Indium::Buffer> Indium::PrivateDevice::newBuffer(size_t length, ResourceOptions options) {
 	return std::make_shared<PrivateBuffer>(shared_from_this(), length, options);
 };
@@ -336,13 +584,43 @@ std::shared_ptr<Indium::Buffer> Indium::PrivateDevice::newBuffer(const void* poi
 };
 
 std::shared_ptr<Indium::Library> Indium::PrivateDevice::newLibrary(const void* data, size_t length) {
-	// TODO: cache translated libraries
-	size_t translatedSize = 0;
-	Iridium::OutputInfo outputInfo;
-	auto translatedData = Iridium::translate(data, length, translatedSize, outputInfo);
+	Iridium::TranslationOptions options {};
+	options.bindlessResources = !!(_features & Feature::DescriptorIndexing);
+	options.pushConstantBlockSize = Iridium::pushConstantBlockSize(_properties.limits.maxPushConstantsSize);
+
+	LibraryKey key(data, length, options);
+
+	auto translated = translatedLibrary(key);
+
+	if (!translated) {
+		size_t translatedSize = 0;
+		auto newTranslated = std::make_shared<TranslatedLibrary>();
+		auto translatedData = Iridium::translate(data, length, translatedSize, newTranslated->outputInfo, options);
+		newTranslated->spirv.assign(static_cast<const char*>(translatedData), static_cast<const char*>(translatedData) + translatedSize);
+		free(translatedData);
+		addTranslatedLibrary(key, newTranslated);
+		translated = newTranslated;
+	}
+
+	return newLibrary(key, translated);
+};
+
+std::shared_ptr<Indium::PrivateLibrary> Indium::PrivateDevice::newLibrary(const LibraryKey& key, std::shared_ptr<const TranslatedLibrary> translated) {
+	return _libraries.intern(key, [&]() {
+		return createLibrary(key, translated);
+	});
+};
+
+std::shared_ptr<Indium::PrivateLibrary> Indium::PrivateDevice::createLibrary(const LibraryKey& key, std::shared_ptr<const TranslatedLibrary> translated) {
 	PrivateLibrary::FunctionInfoMap funcInfoMap;
 
-	for (const auto& [name, info]: outputInfo.functionInfos) {
+	for (const auto& [name, info]: translated->outputInfo.functionInfos) {
+		// the resource table needs descriptor indexing, and without it there's nothing the function could fall back to,
+		// so reject the library now rather than when the function is first used
+		if (info.usesResourceTable && !(_features & Feature::DescriptorIndexing)) {
+			throw std::runtime_error("Function \"" + name + "\" uses textures or samplers in argument buffers, which requires a device that supports descriptor indexing");
+		}
+
 		auto& funcInfo = funcInfoMap[name];
 
 		switch (info.type) {
@@ -359,11 +637,162 @@ std::shared_ptr<Indium::Library> Indium::PrivateDevice::newLibrary(const void* d
 
 		funcInfo.bindings.insert(funcInfo.bindings.end(), info.bindings.begin(), info.bindings.end());
 		funcInfo.embeddedSamplers.insert(funcInfo.embeddedSamplers.end(), info.embeddedSamplers.begin(), info.embeddedSamplers.end());
+		funcInfo.argumentBuffers = info.argumentBuffers;
+		funcInfo.usesResourceTable = info.usesResourceTable;
+		funcInfo.bindingMap = BindingMap(funcInfo.bindings);
+
+		// Iridium keeps each function type within its own part of the push constant block (which is sized to fit within `maxPushConstantsSize`),
+		// so all we need to do is figure out how much of it this function actually uses
+		size_t pushConstantStart = SIZE_MAX;
+		size_t pushConstantEnd = 0;
+		for (const auto& bindingInfo: info.bindings) {
+			if (bindingInfo.pushConstantSize > 0) {
+				pushConstantStart = std::min(pushConstantStart, bindingInfo.pushConstantOffset);
+				pushConstantEnd = std::max(pushConstantEnd, bindingInfo.pushConstantOffset + bindingInfo.pushConstantSize);
+			}
+		}
+		if (pushConstantEnd > 0) {
+			funcInfo.pushConstantRange.stageFlags = functionTypeToVkShaderStageFlags(funcInfo.functionType);
+			funcInfo.pushConstantRange.offset = pushConstantStart;
+			funcInfo.pushConstantRange.size = pushConstantEnd - pushConstantStart;
+		}
+	}
+
+	return std::make_shared<PrivateLibrary>(shared_from_this(), key, translated->spirv.data(), translated->spirv.size(), funcInfoMap);
+};
+
+std::shared_ptr<Indium::SharedDescriptorSetLayout> Indium::PrivateDevice::internDescriptorSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings, bool pushDescriptor) {
+	// binding order doesn't matter to Vulkan, so sort them to get a stable key
+	auto sortedBindings = bindings;
+	std::sort(sortedBindings.begin(), sortedBindings.end(), [](const auto& lhs, const auto& rhs) {
+		return lhs.binding < rhs.binding;
+	});
+
+	BinaryWriter writer;
+	writer.write<uint8_t>(pushDescriptor);
+	for (const auto& binding: sortedBindings) {
+		writer.write<uint32_t>(binding.binding);
+		writer.write<uint32_t>(binding.descriptorType);
+		writer.write<uint32_t>(binding.descriptorCount);
+		writer.write<uint32_t>(binding.stageFlags);
+	}
+
+	return _descriptorSetLayouts.intern(std::string(writer.data.begin(), writer.data.end()), [&]() {
+		return std::make_shared<SharedDescriptorSetLayout>(shared_from_this(), sortedBindings, pushDescriptor);
+	});
+};
+
+std::shared_ptr<Indium::SharedPipelineLayout> Indium::PrivateDevice::internPipelineLayout(const std::vector<std::shared_ptr<SharedDescriptorSetLayout>>& setLayouts, const std::vector<VkPushConstantRange>& pushConstantRanges, bool useResourceTable) {
+	// the set layouts are interned too, so identical set layouts are the same objects and we can just use their handles in the key.
+	// the pipeline layout keeps its set layouts alive, so the handles can't be reused by other set layouts while the entry is alive.
+	BinaryWriter writer;
+	writer.write<uint8_t>(useResourceTable);
+	writer.write<uint64_t>(setLayouts.size());
+	for (const auto& setLayout: setLayouts) {
+		writer.write(setLayout->layout);
+	}
+	for (const auto& range: pushConstantRanges) {
+		writer.write<uint32_t>(range.stageFlags);
+		writer.write<uint32_t>(range.offset);
+		writer.write<uint32_t>(range.size);
+	}
+
+	return _pipelineLayouts.intern(std::string(writer.data.begin(), writer.data.end()), [&]() {
+		return std::make_shared<SharedPipelineLayout>(shared_from_this(), setLayouts, pushConstantRanges, useResourceTable ? resourceTable().setLayout() : VK_NULL_HANDLE);
+	});
+};
+
+Indium::ResourceTable& Indium::PrivateDevice::resourceTable() {
+	std::unique_lock lock(_resourceTableMutex);
+
+	if (!_resourceTable) {
+		if (!(_features & Feature::DescriptorIndexing)) {
+			// libraries and argument encoders that would need the table are already rejected when they're created,
+			// so this only happens when resource IDs are requested directly
+			throw std::runtime_error("Resource IDs require a device that supports descriptor indexing");
+		}
+
+		VkPhysicalDeviceVulkan12Properties props12 {};
+		props12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+		VkPhysicalDeviceProperties2 props {};
+		props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		props.pNext = &props12;
+		DynamicVK::vkGetPhysicalDeviceProperties2(_physicalDevice, &props);
+
+		// the table is visible to every stage, so it counts against the per-stage limits too.
+		// we also cap it ourselves; some drivers report (effectively) unlimited counts, and the whole table gets allocated up front.
+		// leave some room for the normal (per-pipeline) bindings that share the per-stage limits with the table.
+		// the transient slots come on top of the capacity we pass in.
+		auto textureCapacity = std::min({ props12.maxDescriptorSetUpdateAfterBindSampledImages, props12.maxPerStageDescriptorUpdateAfterBindSampledImages, uint32_t(1u << 16) + 64 }) - 64 - ResourceTable::transientTextureSlots;
+		auto samplerCapacity = std::min({ props12.maxDescriptorSetUpdateAfterBindSamplers, props12.maxPerStageDescriptorUpdateAfterBindSamplers, props.properties.limits.maxSamplerAllocationCount, uint32_t(2048) + 16 }) - 16 - ResourceTable::transientSamplerSlots;
+
+		_resourceTable = std::make_unique<ResourceTable>(_device, textureCapacity, samplerCapacity);
+	}
+
+	return *_resourceTable;
+};
+
+std::shared_ptr<const Indium::TranslatedLibrary> Indium::PrivateDevice::translatedLibrary(const LibraryKey& key) {
+	std::unique_lock lock(_translatedLibrariesMutex);
+	auto it = _translatedLibraries.find(key);
+	return (it == _translatedLibraries.end()) ? nullptr : it->second;
+};
+
+void Indium::PrivateDevice::addTranslatedLibrary(const LibraryKey& key, std::shared_ptr<const TranslatedLibrary> library) {
+	std::unique_lock lock(_translatedLibrariesMutex);
+	_translatedLibraries.try_emplace(key, library);
+};
+
+std::shared_lock<std::shared_mutex> Indium::PrivateDevice::lockPipelineCache() {
+	return std::shared_lock(_pipelineCacheMutex);
+};
+
+std::vector<char> Indium::PrivateDevice::pipelineCacheData() {
+	std::vector<char> data;
+	size_t size = 0;
+
+	// the cache can't change size between the two calls if nobody can merge into it
+	std::shared_lock lock(_pipelineCacheMutex);
+
+	if (DynamicVK::vkGetPipelineCacheData(_device, _pipelineCache, &size, nullptr) != VK_SUCCESS) {
+		// TODO
+		abort();
+	}
+
+	data.resize(size);
+
+	if (DynamicVK::vkGetPipelineCacheData(_device, _pipelineCache, &size, data.data()) != VK_SUCCESS) {
+		// TODO
+		abort();
+	}
+
+	data.resize(size);
+	return data;
+};
+
+void Indium::PrivateDevice::mergePipelineCacheData(const void* data, size_t length) {
+	// the implementation checks the header of the initial data and ignores it if it's not compatible,
+	// so we don't need to validate it ourselves
+	VkPipelineCacheCreateInfo createInfo {};
+	createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	createInfo.initialDataSize = length;
+	createInfo.pInitialData = data;
+
+	VkPipelineCache cache = VK_NULL_HANDLE;
+	if (DynamicVK::vkCreatePipelineCache(_device, &createInfo, nullptr, &cache) != VK_SUCCESS) {
+		// TODO
+		abort();
+	}
+
+	{
+		std::unique_lock lock(_pipelineCacheMutex);
+		if (DynamicVK::vkMergePipelineCaches(_device, _pipelineCache, 1, &cache) != VK_SUCCESS) {
+			// TODO
+			abort();
+		}
 	}
 
-	auto lib = std::make_shared<PrivateLibrary>(shared_from_this(), static_cast<const char*>(translatedData), translatedSize, funcInfoMap);
-	free(translatedData);
-	return lib;
+	DynamicVK::vkDestroyPipelineCache(_device, cache, nullptr);
 };
 
 std::shared_ptr<Indium::Texture> Indium::PrivateDevice::newTexture(const TextureDescriptor& descriptor) {
@@ -378,6 +807,180 @@ std::shared_ptr<Indium::DepthStencilState> Indium::PrivateDevice::newDepthStenci
 	return std::make_shared<PrivateDepthStencilState>(shared_from_this(), descriptor);
 };
 
+std::shared_ptr<Indium::Fence> Indium::PrivateDevice::newFence() {
+	return std::make_shared<PrivateFence>(shared_from_this());
+};
+
+std::shared_ptr<Indium::Event> Indium::PrivateDevice::newEvent() {
+	return std::make_shared<PrivateSharedEvent>(shared_from_this(), false);
+};
+
+std::shared_ptr<Indium::SharedEvent> Indium::PrivateDevice::newSharedEvent() {
+	return std::make_shared<PrivateSharedEvent>(shared_from_this(), !!(_features & Feature::ExternalSemaphoreFD));
+};
+
+std::shared_ptr<Indium::SharedEvent> Indium::PrivateDevice::newSharedEvent(const SharedEventHandle& handle) {
+	return std::make_shared<PrivateSharedEvent>(shared_from_this(), handle);
+};
+
+std::shared_ptr<Indium::BinaryArchive> Indium::PrivateDevice::newBinaryArchive(const BinaryArchiveDescriptor& descriptor) {
+	return std::make_shared<PrivateBinaryArchive>(shared_from_this(), descriptor);
+};
+
+std::shared_ptr<Indium::ArgumentEncoder> Indium::PrivateDevice::newArgumentEncoder(const std::vector<ArgumentDescriptor>& arguments) {
+	auto info = argumentBufferInfoForDescriptors(arguments);
+
+	if (!(_features & Feature::DescriptorIndexing)) {
+		for (const auto& argument: info.arguments) {
+			if (argument.type == Iridium::ArgumentType::Texture || argument.type == Iridium::ArgumentType::Sampler) {
+				throw std::runtime_error("Textures and samplers in argument buffers require a device that supports descriptor indexing");
+			}
+		}
+	}
+
+	return std::make_shared<PrivateArgumentEncoder>(shared_from_this(), info);
+};
+
+std::shared_ptr<Indium::IndirectCommandBuffer> Indium::PrivateDevice::newIndirectCommandBuffer(const IndirectCommandBufferDescriptor& descriptor, size_t maxCommandCount, ResourceOptions options) {
+	return std::make_shared<PrivateIndirectCommandBuffer>(shared_from_this(), descriptor, maxCommandCount, options);
+};
+
+void Indium::PrivateDevice::startPipelineRecording() {
+	std::unique_lock lock(_recordedPipelinesMutex);
+	if (!_recordedPipelines) {
+		_recordedPipelines = std::make_unique<PipelineManifest>();
+	}
+	_recordingPipelines = true;
+};
+
+void Indium::PrivateDevice::stopPipelineRecording(const std::string& manifestURL) {
+	std::unique_ptr<PipelineManifest> manifest;
+
+	{
+		std::unique_lock lock(_recordedPipelinesMutex);
+		_recordingPipelines = false;
+		manifest = std::move(_recordedPipelines);
+	}
+
+	if (!manifest) {
+		manifest = std::make_unique<PipelineManifest>();
+	}
+
+	auto data = manifest->serialize();
+	auto path = urlToPath(manifestURL);
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file || !file.write(data.data(), data.size())) {
+		throw std::runtime_error("Failed to write pipeline manifest: " + path);
+	}
+};
+
+void Indium::PrivateDevice::recordRenderPipelineVariant(const std::string& manifestKey, PrimitiveTopologyClass topologyClass, const RenderAttachmentKey& attachmentKey, const RasterizationKey& rasterizationKey) {
+	// this is called for every pipeline lookup, so avoid building the variant key (which copies the attachment formats) or taking the lock
+	// unless we're actually recording
+	if (!_recordingPipelines) {
+		return;
+	}
+
+	std::unique_lock lock(_recordedPipelinesMutex);
+	if (_recordedPipelines) {
+		_recordedPipelines->renderPipelines[manifestKey].insert(RenderPipelineVariantKey { topologyClass, attachmentKey, rasterizationKey });
+	}
+};
+
+void Indium::PrivateDevice::recordComputePipelineVariant(const std::string& manifestKey, Size threadsPerThreadgroup) {
+	if (!_recordingPipelines) {
+		return;
+	}
+
+	std::unique_lock lock(_recordedPipelinesMutex);
+	if (_recordedPipelines) {
+		_recordedPipelines->computePipelines[manifestKey].insert(threadsPerThreadgroup);
+	}
+};
+
+std::vector<Indium::Size> Indium::PrivateDevice::recordedComputePipelineVariants(const std::string& manifestKey) {
+	std::unique_lock lock(_recordedPipelinesMutex);
+
+	if (!_recordedPipelines) {
+		return {};
+	}
+
+	auto it = _recordedPipelines->computePipelines.find(manifestKey);
+	if (it == _recordedPipelines->computePipelines.end()) {
+		return {};
+	}
+
+	return std::vector<Size>(it->second.begin(), it->second.end());
+};
+
+void Indium::PrivateDevice::prewarm(const std::string& manifestURL) {
+	auto path = urlToPath(manifestURL);
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Failed to open pipeline manifest: " + path);
+	}
+
+	std::vector<char> contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	auto manifest = PipelineManifest::deserialize(contents.data(), contents.size());
+
+	// the descriptors are reconstructed up-front (this is cheap); the actual compilation happens on the compile queue,
+	// one task per pipeline state so they can be compiled in parallel.
+	for (auto& [key, variants]: manifest.renderPipelines) {
+		auto descriptor = renderPipelineDescriptorFromManifestKey(shared_from_this(), key);
+		if (!descriptor) {
+			continue;
+		}
+
+		_compileQueue->submit(CompilePriority::Low, [self = shared_from_this(), descriptor = std::move(*descriptor), variants = std::move(variants)]() {
+			std::shared_ptr<PrivateRenderPipelineState> state;
+
+			try {
+				state = std::dynamic_pointer_cast<PrivateRenderPipelineState>(self->newRenderPipelineState(descriptor));
+
+				for (const auto& variant: variants) {
+					state->pipeline(variant.topologyClass, variant.attachmentKey, variant.rasterizationKey);
+				}
+			} catch (...) {
+				// prewarming is only an optimization; the pipeline state will be created again (and report the error) if it's actually used
+				return;
+			}
+
+			std::unique_lock lock(self->_prewarmedPipelineStatesMutex);
+			self->_prewarmedRenderPipelineStates.push_back(state);
+		});
+	}
+
+	for (auto& [key, threadgroupSizes]: manifest.computePipelines) {
+		auto descriptor = computePipelineDescriptorFromManifestKey(shared_from_this(), key);
+		if (!descriptor) {
+			continue;
+		}
+
+		_compileQueue->submit(CompilePriority::Low, [self = shared_from_this(), descriptor = std::move(*descriptor), threadgroupSizes = std::move(threadgroupSizes)]() {
+			std::shared_ptr<PrivateComputePipelineState> state;
+
+			try {
+				state = std::dynamic_pointer_cast<PrivateComputePipelineState>(self->newComputePipelineState(descriptor, PipelineOption::None, std::shared_ptr<ComputePipelineReflection>()));
+
+				for (const auto& threadsPerThreadgroup: threadgroupSizes) {
+					state->pipeline(threadsPerThreadgroup);
+				}
+			} catch (...) {
+				return;
+			}
+
+			std::unique_lock lock(self->_prewarmedPipelineStatesMutex);
+			self->_prewarmedComputePipelineStates.push_back(state);
+		});
+	}
+};
+
+void Indium::PrivateDevice::discardPrewarmedPipelineStates() {
+	std::unique_lock lock(_prewarmedPipelineStatesMutex);
+	_prewarmedRenderPipelineStates.clear();
+	_prewarmedComputePipelineStates.clear();
+};
+
 std::shared_ptr<Indium::Device> Indium::createSystemDefaultDevice() {
 	return globalDeviceList.empty() ? nullptr : globalDeviceList.front();
 };
@@ -551,3 +1154,162 @@ std::shared_ptr<Indium::BinarySemaphore> Indium::PrivateDevice::getWrappedBinary
 		delete ptr;
 	});
 };
+
+VkQueryPool Indium::PrivateDevice::takeOcclusionQueryPool() {
+	{
+		std::unique_lock lock(_occlusionQueryPoolsMutex);
+		if (!_occlusionQueryPools.empty()) {
+			auto pool = _occlusionQueryPools.back();
+			_occlusionQueryPools.pop_back();
+			return pool;
+		}
+	}
+
+	VkQueryPoolCreateInfo createInfo {};
+	createInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	createInfo.queryType = VK_QUERY_TYPE_OCCLUSION;
+	createInfo.queryCount = occlusionQueryPoolSize;
+
+	VkQueryPool pool = VK_NULL_HANDLE;
+	if (DynamicVK::vkCreateQueryPool(_device, &createInfo, nullptr, &pool) != VK_SUCCESS) {
+		// TODO
+		abort();
+	}
+
+	// queries start out in an undefined state, so they have to be reset before their first use
+	DynamicVK::vkResetQueryPool(_device, pool, 0, occlusionQueryPoolSize);
+
+	return pool;
+};
+
+void Indium::PrivateDevice::recycleOcclusionQueryPool(VkQueryPool pool) {
+	// this is just a sanity limit; we only need as many pools as there are render encoders using visibility results in flight
+	static constexpr size_t maxPooledOcclusionQueryPools = 32;
+
+	// resetting on the host means encoders never have to record resets (which aren't allowed inside render passes)
+	DynamicVK::vkResetQueryPool(_device, pool, 0, occlusionQueryPoolSize);
+
+	std::unique_lock lock(_occlusionQueryPoolsMutex);
+	if (_occlusionQueryPools.size() < maxPooledOcclusionQueryPools) {
+		_occlusionQueryPools.push_back(pool);
+		return;
+	}
+	lock.unlock();
+
+	DynamicVK::vkDestroyQueryPool(_device, pool, nullptr);
+};
+
+std::pair<VkPipeline, VkPipelineLayout> Indium::PrivateDevice::accumulatePipeline() {
+	std::unique_lock lock(_accumulatePipelineMutex);
+
+	if (_accumulatePipeline) {
+		return std::make_pair(_accumulatePipeline, _accumulatePipelineLayout);
+	}
+
+	VkPushConstantRange pushConstantRange {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = 2 * sizeof(uint64_t);
+
+	VkPipelineLayoutCreateInfo layoutCreateInfo {};
+	layoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layoutCreateInfo.pushConstantRangeCount = 1;
+	layoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+
+	if (DynamicVK::vkCreatePipelineLayout(_device, &layoutCreateInfo, nullptr, &_accumulatePipelineLayout) != VK_SUCCESS) {
+		// TODO
+		abort();
+	}
+
+	size_t spirvSize = 0;
+	auto spirv = Iridium::buildAccumulateShader(spirvSize);
+
+	VkShaderModuleCreateInfo moduleCreateInfo {};
+	moduleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	moduleCreateInfo.codeSize = spirvSize;
+	moduleCreateInfo.pCode = reinterpret_cast<const uint32_t*>(spirv);
+
+	VkShaderModule shaderModule = VK_NULL_HANDLE;
+	auto result = DynamicVK::vkCreateShaderModule(_device, &moduleCreateInfo, nullptr, &shaderModule);
+	free(spirv);
+	if (result != VK_SUCCESS) {
+		// TODO
+		abort();
+	}
+
+	VkComputePipelineCreateInfo info {};
+	info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	info.stage.module = shaderModule;
+	info.stage.pName = "main";
+	info.layout = _accumulatePipelineLayout;
+
+	{
+		auto pipelineCacheLock = lockPipelineCache();
+		result = DynamicVK::vkCreateComputePipelines(_device, _pipelineCache, 1, &info, nullptr, &_accumulatePipeline);
+	}
+
+	// the pipeline doesn't need the module once it's been created
+	DynamicVK::vkDestroyShaderModule(_device, shaderModule, nullptr);
+
+	if (result != VK_SUCCESS) {
+		// TODO
+		abort();
+	}
+
+	return std::make_pair(_accumulatePipeline, _accumulatePipelineLayout);
+};
+
+Indium::MemorylessAllocation Indium::PrivateDevice::takeMemorylessAllocation(uint32_t memoryTypeIndex, VkDeviceSize size) {
+	{
+		std::unique_lock lock(_memorylessAllocationsMutex);
+
+		// use the smallest allocation that fits, but don't waste more than half of it
+		auto best = _memorylessAllocations.end();
+		for (auto it = _memorylessAllocations.begin(); it != _memorylessAllocations.end(); ++it) {
+			if (it->memoryTypeIndex != memoryTypeIndex || it->size < size || it->size > size * 2) {
+				continue;
+			}
+			if (best == _memorylessAllocations.end() || it->size < best->size) {
+				best = it;
+			}
+		}
+
+		if (best != _memorylessAllocations.end()) {
+			auto allocation = *best;
+			_memorylessAllocations.erase(best);
+			return allocation;
+		}
+	}
+
+	MemorylessAllocation allocation;
+	allocation.memoryTypeIndex = memoryTypeIndex;
+	allocation.size = size;
+
+	VkMemoryAllocateInfo allocateInfo {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocateInfo.allocationSize = size;
+	allocateInfo.memoryTypeIndex = memoryTypeIndex;
+
+	if (DynamicVK::vkAllocateMemory(_device, &allocateInfo, nullptr, &allocation.memory) != VK_SUCCESS) {
+		// TODO
+		abort();
+	}
+
+	return allocation;
+};
+
+void Indium::PrivateDevice::recycleMemorylessAllocation(const MemorylessAllocation& allocation) {
+	// a sanity limit, like the one for query pools
+	static constexpr size_t maxPooledMemorylessAllocations = 16;
+
+	std::unique_lock lock(_memorylessAllocationsMutex);
+	if (_memorylessAllocations.size() < maxPooledMemorylessAllocations) {
+		_memorylessAllocations.push_back(allocation);
+		return;
+	}
+	lock.unlock();
+
+	DynamicVK::vkFreeMemory(_device, allocation.memory, nullptr);
+};
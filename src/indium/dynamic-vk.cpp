@@ -21,6 +21,7 @@ static Indium::DynamicVK::DynamicFunctionBase* const eagerlyResolvedFunctions[]
 	&Indium::DynamicVK::vkDestroyCommandPool,
 	&Indium::DynamicVK::vkDestroySemaphore,
 	&Indium::DynamicVK::vkDestroyDevice,
+	&Indium::DynamicVK::vkDestroyQueryPool,
 };
 
 #ifdef DARLING
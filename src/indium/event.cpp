@@ -0,0 +1,115 @@
+#include <indium/event.private.hpp>
+#include <indium/device.private.hpp>
+#include <indium/dynamic-vk.hpp>
+
+#include <stdexcept>
+
+Indium::Event::~Event() {};
+Indium::SharedEvent::~SharedEvent() {};
+
+Indium::PrivateSharedEvent::PrivateSharedEvent(std::shared_ptr<PrivateDevice> device, bool exportable):
+	_privateDevice(device),
+	_exportable(exportable)
+{
+	if (_exportable && !(_privateDevice->features() & PrivateDevice::Feature::ExternalSemaphoreFD)) {
+		throw std::runtime_error("Device does not support exportable semaphores");
+	}
+
+	// we create the semaphore ourselves rather than using `getTimelineSemaphore()` because that can't create exportable semaphores.
+	// the initial value is also part of the event's API (events start at 0), so we set it explicitly instead of relying on a default.
+	VkSemaphoreTypeCreateInfo typeInfo {};
+	typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	typeInfo.initialValue = 0;
+
+	VkSemaphoreCreateInfo createInfo {};
+	createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	createInfo.pNext = &typeInfo;
+
+	VkExportSemaphoreCreateInfo exportInfo {};
+
+	if (_exportable) {
+		exportInfo.sType = VK_STRUCTURE_TYPE_EXPORT_SEMAPHORE_CREATE_INFO;
+		exportInfo.handleTypes = VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_OPAQUE_FD_BIT;
+
+		typeInfo.pNext = &exportInfo;
+	}
+
+	if (DynamicVK::vkCreateSemaphore(_privateDevice->device(), &createInfo, nullptr, &_semaphore) != VK_SUCCESS) {
+		// TODO
+		abort();
+	}
+};
+
+Indium::PrivateSharedEvent::PrivateSharedEvent(std::shared_ptr<PrivateDevice> device, const SharedEventHandle& handle):
+	PrivateSharedEvent(device, true)
+{
+	VkImportSemaphoreFdInfoKHR importInfo {};
+	importInfo.sType = VK_STRUCTURE_TYPE_IMPORT_SEMAPHORE_FD_INFO_KHR;
+	importInfo.semaphore = _semaphore;
+	importInfo.handleType = VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_OPAQUE_FD_BIT;
+	importInfo.fd = handle.fd;
+
+	if (DynamicVK::vkImportSemaphoreFdKHR(_privateDevice->device(), &importInfo) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to import shared event handle");
+	}
+};
+
+Indium::PrivateSharedEvent::~PrivateSharedEvent() {
+	DynamicVK::vkDestroySemaphore(_privateDevice->device(), _semaphore, nullptr);
+};
+
+std::shared_ptr<Indium::Device> Indium::PrivateSharedEvent::device() {
+	return _privateDevice;
+};
+
+uint64_t Indium::PrivateSharedEvent::signaledValue() {
+	uint64_t value = 0;
+	if (DynamicVK::vkGetSemaphoreCounterValue(_privateDevice->device(), _semaphore, &value) != VK_SUCCESS) {
+		// TODO
+		abort();
+	}
+	return value;
+};
+
+void Indium::PrivateSharedEvent::setSignaledValue(uint64_t value) {
+	// timeline semaphores can only move forward
+	if (value <= signaledValue()) {
+		return;
+	}
+
+	VkSemaphoreSignalInfo info {};
+	info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO;
+	info.semaphore = _semaphore;
+	info.value = value;
+
+	if (DynamicVK::vkSignalSemaphore(_privateDevice->device(), &info) != VK_SUCCESS) {
+		// TODO
+		abort();
+	}
+};
+
+void Indium::PrivateSharedEvent::notifyListener(uint64_t value, NotificationHandler handler) {
+	auto self = shared_from_this();
+	_privateDevice->waitForSemaphore(_semaphore, value, [self, value, handler]() {
+		handler(self, value);
+	});
+};
+
+Indium::SharedEventHandle Indium::PrivateSharedEvent::newSharedEventHandle() {
+	if (!_exportable) {
+		throw std::runtime_error("Event is not shareable");
+	}
+
+	VkSemaphoreGetFdInfoKHR info {};
+	info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_GET_FD_INFO_KHR;
+	info.semaphore = _semaphore;
+	info.handleType = VK_EXTERNAL_SEMAPHORE_HANDLE_TYPE_OPAQUE_FD_BIT;
+
+	SharedEventHandle handle {};
+	if (DynamicVK::vkGetSemaphoreFdKHR(_privateDevice->device(), &info, &handle.fd) != VK_SUCCESS) {
+		throw std::runtime_error("Failed to export shared event handle");
+	}
+
+	return handle;
+};
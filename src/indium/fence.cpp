@@ -0,0 +1,29 @@
+#include <indium/fence.private.hpp>
+#include <indium/device.private.hpp>
+#include <indium/dynamic-vk.hpp>
+
+Indium::Fence::~Fence() {};
+
+Indium::PrivateFence::PrivateFence(std::shared_ptr<PrivateDevice> device):
+	_privateDevice(device)
+	{};
+
+Indium::PrivateFence::~PrivateFence() {};
+
+std::shared_ptr<Indium::Device> Indium::PrivateFence::device() {
+	return _privateDevice;
+};
+
+void Indium::PrivateFence::encodeUpdates(VkCommandBuffer commandBuffer, VkPipelineStageFlags sourceStages) {
+	if (sourceStages == VK_PIPELINE_STAGE_NONE) {
+		return;
+	}
+
+	VkMemoryBarrier barrier {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+	// TODO: we don't know which stages are going to wait on the fence, so we have to block all of them
+	DynamicVK::vkCmdPipelineBarrier(commandBuffer, sourceStages, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+};
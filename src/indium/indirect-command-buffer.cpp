@@ -0,0 +1,324 @@
+#include <indium/indirect-command-buffer.private.hpp>
+#include <indium/device.private.hpp>
+#include <indium/buffer.private.hpp>
+#include <indium/render-pipeline.private.hpp>
+#include <indium/compute-pipeline.private.hpp>
+#include <indium/command-encoder.private.hpp>
+#include <indium/dynamic-vk.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+Indium::IndirectRenderCommand::~IndirectRenderCommand() {};
+Indium::IndirectComputeCommand::~IndirectComputeCommand() {};
+Indium::IndirectCommandBuffer::~IndirectCommandBuffer() {};
+
+// recordings are usually executed with the same few states over and over again (e.g. once per frame), so a handful is enough
+static constexpr size_t maxCachedRecordings = 8;
+
+static constexpr Indium::IndirectCommandType renderCommandTypes = Indium::IndirectCommandType::Draw | Indium::IndirectCommandType::DrawIndexed | Indium::IndirectCommandType::DrawPatches | Indium::IndirectCommandType::DrawIndexedPatches;
+static constexpr Indium::IndirectCommandType computeCommandTypes = Indium::IndirectCommandType::ConcurrentDispatch | Indium::IndirectCommandType::ConcurrentDispatchThreads;
+
+Indium::PrivateIndirectCommandBuffer::PrivateIndirectCommandBuffer(std::shared_ptr<PrivateDevice> device, const IndirectCommandBufferDescriptor& descriptor, size_t maxCommandCount, ResourceOptions options):
+	_privateDevice(device),
+	_descriptor(descriptor),
+	_size(maxCommandCount)
+{
+	_hazardTrackingMode = static_cast<HazardTrackingMode>((static_cast<size_t>(options) >> 8) & 0xf);
+
+	if (!!(_descriptor.commandTypes & (IndirectCommandType::DrawPatches | IndirectCommandType::DrawIndexedPatches))) {
+		throw std::runtime_error("TODO: support tessellation in indirect command buffers");
+	}
+
+	if (!!(_descriptor.commandTypes & renderCommandTypes) && !!(_descriptor.commandTypes & computeCommandTypes)) {
+		throw std::runtime_error("Indirect command buffers can't mix render and compute commands");
+	}
+
+	_containsRenderCommands = !!(_descriptor.commandTypes & renderCommandTypes);
+
+	if (_containsRenderCommands) {
+		_renderCommands.resize(_size);
+	} else {
+		_computeCommands.resize(_size);
+	}
+};
+
+Indium::PrivateIndirectCommandRecording::PrivateIndirectCommandRecording(std::shared_ptr<PrivateDevice> device, Range<size_t> range, std::vector<char> key, size_t descriptorSetCount):
+	_privateDevice(device),
+	_uploadHeap(device),
+	_range(range),
+	_key(std::move(key))
+{
+	// this has to be for the same queue family as the command pools of the command queues that execute this (see PrivateCommandQueue)
+	VkCommandPoolCreateInfo commandPoolCreateInfo {};
+	commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	commandPoolCreateInfo.queueFamilyIndex = _privateDevice->graphicsQueueFamilyIndex() ? *_privateDevice->graphicsQueueFamilyIndex() : *_privateDevice->computeQueueFamilyIndex();
+
+	if (DynamicVK::vkCreateCommandPool(_privateDevice->device(), &commandPoolCreateInfo, nullptr, &_commandPool) != VK_SUCCESS) {
+		// TODO
+		abort();
+	}
+
+	VkCommandBufferAllocateInfo allocInfo {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.commandPool = _commandPool;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+	allocInfo.commandBufferCount = 1;
+
+	if (DynamicVK::vkAllocateCommandBuffers(_privateDevice->device(), &allocInfo, &_commandBuffer) != VK_SUCCESS) {
+		// TODO
+		abort();
+	}
+
+	// the encoders' pools are sized for 64 sets, so we scale that up for however many sets the commands might need
+	descriptorSetCount = std::max<size_t>(descriptorSetCount, 1);
+	auto sizes = poolSizes;
+	for (auto& size: sizes) {
+		size.descriptorCount *= (descriptorSetCount + 63) / 64;
+	}
+
+	VkDescriptorPoolCreateInfo descriptorPoolCreateInfo {};
+	descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	descriptorPoolCreateInfo.poolSizeCount = sizes.size();
+	descriptorPoolCreateInfo.pPoolSizes = sizes.data();
+	descriptorPoolCreateInfo.maxSets = descriptorSetCount;
+
+	if (DynamicVK::vkCreateDescriptorPool(_privateDevice->device(), &descriptorPoolCreateInfo, nullptr, &_descriptorPool) != VK_SUCCESS) {
+		// TODO
+		abort();
+	}
+};
+
+Indium::PrivateIndirectCommandRecording::~PrivateIndirectCommandRecording() {
+	// every command buffer that executed us kept us alive until it completed, so the GPU is done with all of this by now
+	DynamicVK::vkDestroyDescriptorPool(_privateDevice->device(), _descriptorPool, nullptr);
+	DynamicVK::vkDestroyCommandPool(_privateDevice->device(), _commandPool, nullptr);
+};
+
+void Indium::PrivateIndirectCommandRecording::begin(VkCommandBufferUsageFlags flags, const void* inheritanceInfo) {
+	VkCommandBufferInheritanceInfo inheritance {};
+	inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritance.pNext = inheritanceInfo;
+
+	// the same recording can be executed by several command buffers that are pending at the same time
+	VkCommandBufferBeginInfo beginInfo {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = flags | VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+	beginInfo.pInheritanceInfo = &inheritance;
+
+	if (DynamicVK::vkBeginCommandBuffer(_commandBuffer, &beginInfo) != VK_SUCCESS) {
+		// TODO
+		abort();
+	}
+};
+
+void Indium::PrivateIndirectCommandRecording::end() {
+	if (DynamicVK::vkEndCommandBuffer(_commandBuffer) != VK_SUCCESS) {
+		// TODO
+		abort();
+	}
+};
+
+std::shared_ptr<Indium::Device> Indium::PrivateIndirectCommandBuffer::device() {
+	return _privateDevice;
+};
+
+Indium::HazardTrackingMode Indium::PrivateIndirectCommandBuffer::hazardTrackingMode() const {
+	return _hazardTrackingMode;
+};
+
+size_t Indium::PrivateIndirectCommandBuffer::size() const {
+	return _size;
+};
+
+void Indium::PrivateIndirectCommandBuffer::checkIndex(size_t commandIndex) const {
+	if (commandIndex >= _size) {
+		throw std::runtime_error("Indirect command index out of range");
+	}
+};
+
+void Indium::PrivateIndirectCommandBuffer::checkRange(Range<size_t> range) const {
+	if (range.start > _size || range.length > _size - range.start) {
+		throw std::runtime_error("Indirect command range out of bounds");
+	}
+};
+
+std::shared_ptr<Indium::IndirectRenderCommand> Indium::PrivateIndirectCommandBuffer::indirectRenderCommandAtIndex(size_t commandIndex) {
+	if (!_containsRenderCommands) {
+		throw std::runtime_error("Indirect command buffer doesn't support render commands");
+	}
+	checkIndex(commandIndex);
+	return std::make_shared<PrivateIndirectRenderCommand>(shared_from_this(), commandIndex);
+};
+
+std::shared_ptr<Indium::IndirectComputeCommand> Indium::PrivateIndirectCommandBuffer::indirectComputeCommandAtIndex(size_t commandIndex) {
+	if (_containsRenderCommands) {
+		throw std::runtime_error("Indirect command buffer doesn't support compute commands");
+	}
+	checkIndex(commandIndex);
+	return std::make_shared<PrivateIndirectComputeCommand>(shared_from_this(), commandIndex);
+};
+
+std::shared_ptr<Indium::PrivateIndirectCommandRecording> Indium::PrivateIndirectCommandBuffer::findRecording(Range<size_t> range, const std::vector<char>& key) {
+	std::scoped_lock lock(_recordingsMutex);
+
+	for (const auto& recording: _recordings) {
+		if (recording->matches(range, key)) {
+			return recording;
+		}
+	}
+
+	return nullptr;
+};
+
+void Indium::PrivateIndirectCommandBuffer::addRecording(std::shared_ptr<PrivateIndirectCommandRecording> recording) {
+	std::scoped_lock lock(_recordingsMutex);
+
+	if (_recordings.size() >= maxCachedRecordings) {
+		_recordings.erase(_recordings.begin());
+	}
+
+	_recordings.push_back(std::move(recording));
+};
+
+void Indium::PrivateIndirectCommandBuffer::invalidateRecordings() {
+	std::scoped_lock lock(_recordingsMutex);
+	_recordings.clear();
+};
+
+void Indium::PrivateIndirectCommandBuffer::reset(Range<size_t> range) {
+	checkRange(range);
+	invalidateRecordings();
+
+	for (size_t i = range.start; i < range.start + range.length; ++i) {
+		if (_containsRenderCommands) {
+			_renderCommands[i] = RenderCommand {};
+		} else {
+			_computeCommands[i] = ComputeCommand {};
+		}
+	}
+};
+
+Indium::PrivateIndirectRenderCommand::PrivateIndirectRenderCommand(std::shared_ptr<PrivateIndirectCommandBuffer> commandBuffer, size_t commandIndex):
+	_commandBuffer(commandBuffer),
+	_command(commandBuffer->renderCommand(commandIndex))
+	{};
+
+void Indium::PrivateIndirectRenderCommand::setRenderPipelineState(std::shared_ptr<RenderPipelineState> pipelineState) {
+	if (_commandBuffer->descriptor().inheritPipelineState) {
+		throw std::runtime_error("Can't set the pipeline state of a command in an indirect command buffer that inherits it");
+	}
+	_command.pipelineState = std::dynamic_pointer_cast<PrivateRenderPipelineState>(pipelineState);
+	_commandBuffer->invalidateRecordings();
+};
+
+void Indium::PrivateIndirectRenderCommand::setBuffer(size_t stage, size_t maxBindCount, std::shared_ptr<Buffer> buffer, size_t offset, size_t index) {
+	if (_commandBuffer->descriptor().inheritBuffers) {
+		throw std::runtime_error("Can't set buffers on a command in an indirect command buffer that inherits them");
+	}
+
+	if (index >= maxBindCount) {
+		throw std::runtime_error("Buffer index exceeds the indirect command buffer's maximum bind count");
+	}
+
+	auto& buffers = _command.buffers[stage];
+	if (buffers.size() <= index) {
+		buffers.resize(index + 1);
+	}
+	buffers[index] = PrivateIndirectCommandBuffer::BufferBinding { std::move(buffer), offset };
+	_commandBuffer->invalidateRecordings();
+};
+
+void Indium::PrivateIndirectRenderCommand::setVertexBuffer(std::shared_ptr<Buffer> buffer, size_t offset, size_t index) {
+	setBuffer(0, _commandBuffer->descriptor().maxVertexBufferBindCount, std::move(buffer), offset, index);
+};
+
+void Indium::PrivateIndirectRenderCommand::setFragmentBuffer(std::shared_ptr<Buffer> buffer, size_t offset, size_t index) {
+	setBuffer(1, _commandBuffer->descriptor().maxFragmentBufferBindCount, std::move(buffer), offset, index);
+};
+
+void Indium::PrivateIndirectRenderCommand::drawPrimitives(PrimitiveType primitiveType, size_t vertexStart, size_t vertexCount, size_t instanceCount, size_t baseInstance) {
+	if (!(_commandBuffer->descriptor().commandTypes & IndirectCommandType::Draw)) {
+		throw std::runtime_error("Indirect command buffer doesn't support non-indexed draws");
+	}
+	_command.draw = PrivateIndirectCommandBuffer::Draw { primitiveType, vertexStart, vertexCount, instanceCount, baseInstance };
+	_commandBuffer->invalidateRecordings();
+};
+
+void Indium::PrivateIndirectRenderCommand::drawIndexedPrimitives(PrimitiveType primitiveType, size_t indexCount, IndexType indexType, std::shared_ptr<Buffer> indexBuffer, size_t indexBufferOffset, size_t instanceCount, int64_t baseVertex, size_t baseInstance) {
+	if (!(_commandBuffer->descriptor().commandTypes & IndirectCommandType::DrawIndexed)) {
+		throw std::runtime_error("Indirect command buffer doesn't support indexed draws");
+	}
+	_command.draw = PrivateIndirectCommandBuffer::DrawIndexed { primitiveType, indexCount, indexType, std::dynamic_pointer_cast<PrivateBuffer>(indexBuffer), indexBufferOffset, instanceCount, baseVertex, baseInstance };
+	_commandBuffer->invalidateRecordings();
+};
+
+void Indium::PrivateIndirectRenderCommand::reset() {
+	_command = PrivateIndirectCommandBuffer::RenderCommand {};
+	_commandBuffer->invalidateRecordings();
+};
+
+Indium::PrivateIndirectComputeCommand::PrivateIndirectComputeCommand(std::shared_ptr<PrivateIndirectCommandBuffer> commandBuffer, size_t commandIndex):
+	_commandBuffer(commandBuffer),
+	_command(commandBuffer->computeCommand(commandIndex))
+	{};
+
+void Indium::PrivateIndirectComputeCommand::setComputePipelineState(std::shared_ptr<ComputePipelineState> pipelineState) {
+	if (_commandBuffer->descriptor().inheritPipelineState) {
+		throw std::runtime_error("Can't set the pipeline state of a command in an indirect command buffer that inherits it");
+	}
+	_command.pipelineState = std::dynamic_pointer_cast<PrivateComputePipelineState>(pipelineState);
+	_commandBuffer->invalidateRecordings();
+};
+
+void Indium::PrivateIndirectComputeCommand::setKernelBuffer(std::shared_ptr<Buffer> buffer, size_t offset, size_t index) {
+	if (_commandBuffer->descriptor().inheritBuffers) {
+		throw std::runtime_error("Can't set buffers on a command in an indirect command buffer that inherits them");
+	}
+
+	if (index >= _commandBuffer->descriptor().maxKernelBufferBindCount) {
+		throw std::runtime_error("Buffer index exceeds the indirect command buffer's maximum bind count");
+	}
+
+	if (_command.buffers.size() <= index) {
+		_command.buffers.resize(index + 1);
+	}
+	_command.buffers[index] = PrivateIndirectCommandBuffer::BufferBinding { std::move(buffer), offset };
+	_commandBuffer->invalidateRecordings();
+};
+
+void Indium::PrivateIndirectComputeCommand::concurrentDispatchThreadgroups(Size threadgroupsPerGrid, Size threadsPerThreadgroup) {
+	if (!(_commandBuffer->descriptor().commandTypes & IndirectCommandType::ConcurrentDispatch)) {
+		throw std::runtime_error("Indirect command buffer doesn't support threadgroup dispatches");
+	}
+	_command.dispatch = PrivateIndirectCommandBuffer::Dispatch { threadgroupsPerGrid, threadsPerThreadgroup };
+	_commandBuffer->invalidateRecordings();
+};
+
+void Indium::PrivateIndirectComputeCommand::concurrentDispatchThreads(Size threadsPerGrid, Size threadsPerThreadgroup) {
+	if (!(_commandBuffer->descriptor().commandTypes & IndirectCommandType::ConcurrentDispatchThreads)) {
+		throw std::runtime_error("Indirect command buffer doesn't support thread dispatches");
+	}
+
+	Size threadgroupsPerGrid {
+		threadsPerGrid.width / threadsPerThreadgroup.width,
+		threadsPerGrid.height / threadsPerThreadgroup.height,
+		threadsPerGrid.depth / threadsPerThreadgroup.depth,
+	};
+
+	if (
+		(threadgroupsPerGrid.width * threadsPerThreadgroup.width != threadsPerGrid.width) ||
+		(threadgroupsPerGrid.height * threadsPerThreadgroup.height != threadsPerGrid.height) ||
+		(threadgroupsPerGrid.depth * threadsPerThreadgroup.depth != threadsPerGrid.depth)
+	) {
+		throw std::runtime_error("TODO: support partial threadgroups");
+	}
+
+	_command.dispatch = PrivateIndirectCommandBuffer::Dispatch { threadgroupsPerGrid, threadsPerThreadgroup };
+	_commandBuffer->invalidateRecordings();
+};
+
+void Indium::PrivateIndirectComputeCommand::reset() {
+	_command = PrivateIndirectCommandBuffer::ComputeCommand {};
+	_commandBuffer->invalidateRecordings();
+};
@@ -1,8 +1,12 @@
 #include <indium/library.private.hpp>
 #include <indium/device.private.hpp>
-#include <indium/sampler.hpp>
+#include <indium/argument-encoder.private.hpp>
+#include <indium/sampler.private.hpp>
+#include <indium/sha256.private.hpp>
 #include <indium/dynamic-vk.hpp>
 
+#include <stdexcept>
+
 Indium::Function::~Function() {};
 Indium::Library::~Library() {};
 
@@ -10,10 +14,67 @@ std::shared_ptr<Indium::Device> Indium::PrivateFunction::device() {
 	return _privateDevice;
 };
 
+std::shared_ptr<Indium::ArgumentEncoder> Indium::PrivateFunction::newArgumentEncoder(size_t bufferIndex) {
+	for (const auto& argumentBuffer: _functionInfo.argumentBuffers) {
+		if (argumentBuffer.bufferIndex == bufferIndex) {
+			return std::make_shared<PrivateArgumentEncoder>(_privateDevice, argumentBuffer);
+		}
+	}
+
+	throw std::runtime_error("Function does not use an argument buffer at the given index");
+};
+
 std::shared_ptr<Indium::Device> Indium::PrivateLibrary::device() {
 	return _privateDevice;
 };
 
+Indium::BindingMap::BindingMap(const std::vector<Iridium::BindingInfo>& bindings) {
+	for (const auto& bindingInfo: bindings) {
+		bool pushConstant = bindingInfo.pushConstantSize > 0;
+
+		switch (bindingInfo.type) {
+			case Iridium::BindingType::Buffer:
+			case Iridium::BindingType::PushConstantBuffer:
+				if (bindingInfo.index >= maxBufferBindings) {
+					throw std::runtime_error("Buffer binding index out of range");
+				}
+				(pushConstant ? pushConstantBuffers : descriptorBuffers).set(bindingInfo.index);
+				if (bindingInfo.type == Iridium::BindingType::PushConstantBuffer) {
+					pushConstantContentBuffers.set(bindingInfo.index);
+				}
+				if (pushConstant) {
+					pushConstantBindings.push_back(bindingInfo);
+				} else {
+					addressBindings.push_back(bindingInfo);
+				}
+				break;
+
+			case Iridium::BindingType::Texture:
+				if (bindingInfo.index >= maxTextureBindings) {
+					throw std::runtime_error("Texture binding index out of range");
+				}
+				(pushConstant ? pushConstantTextures : descriptorTextures).set(bindingInfo.index);
+				(pushConstant ? pushConstantBindings : descriptorBindings).push_back(bindingInfo);
+				break;
+
+			case Iridium::BindingType::Sampler:
+				// embedded samplers don't have a Metal binding index
+				if (bindingInfo.index != SIZE_MAX) {
+					if (bindingInfo.index >= maxSamplerBindings) {
+						throw std::runtime_error("Sampler binding index out of range");
+					}
+					(pushConstant ? pushConstantSamplers : descriptorSamplers).set(bindingInfo.index);
+				}
+				(pushConstant ? pushConstantBindings : descriptorBindings).push_back(bindingInfo);
+				break;
+
+			default:
+				// vertex inputs are bound as vertex buffers, not through the function's bindings
+				break;
+		}
+	}
+};
+
 Indium::PrivateFunction::PrivateFunction(std::shared_ptr<PrivateLibrary> library, const std::string& name, const FunctionInfo& functionInfo):
 	_library(library),
 	_privateDevice(library->privateDevice()),
@@ -22,9 +83,20 @@ Indium::PrivateFunction::PrivateFunction(std::shared_ptr<PrivateLibrary> library
 	_name = name;
 };
 
-Indium::PrivateLibrary::PrivateLibrary(std::shared_ptr<PrivateDevice> device, const char* data, size_t dataLength, std::unordered_map<std::string, FunctionInfo> functionInfos):
+Indium::LibraryKey::LibraryKey(const void* data, size_t length, const Iridium::TranslationOptions& options):
+	sourceDigest(sha256(data, length)),
+	sourceLength(length)
+{
+	if (options.bindlessResources) {
+		translationFlags |= TranslationFlagBindlessResources;
+	}
+	translationFlags |= uint64_t(options.pushConstantBlockSize) << TranslationFlagsPushConstantBlockSizeShift;
+};
+
+Indium::PrivateLibrary::PrivateLibrary(std::shared_ptr<PrivateDevice> device, const LibraryKey& key, const char* data, size_t dataLength, std::unordered_map<std::string, FunctionInfo> functionInfos):
 	_privateDevice(device),
-	_functionInfos(functionInfos)
+	_functionInfos(functionInfos),
+	_key(key)
 {
 	VkShaderModuleCreateInfo createInfo {};
 	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
@@ -134,7 +206,7 @@ Indium::PrivateLibrary::PrivateLibrary(std::shared_ptr<PrivateDevice> device, co
 			descriptor.supportArgumentBuffers = false;
 			descriptor.compareFunction = translateCompareFunction(embeddedSampler.compareFunction);
 
-			funcInfo.embeddedSamplerStates.push_back(_privateDevice->newSamplerState(descriptor));
+			funcInfo.embeddedSamplerStates.push_back(std::dynamic_pointer_cast<PrivateSamplerState>(_privateDevice->newSamplerState(descriptor)));
 		}
 	}
 };
@@ -0,0 +1,363 @@
+#include <indium/pipeline-manifest.private.hpp>
+#include <indium/device.private.hpp>
+#include <indium/library.private.hpp>
+#include <indium/serialization.private.hpp>
+
+#include <algorithm>
+
+// manifest layout (see serialization.private.hpp for the encoding):
+//   uint32_t magic
+//   uint32_t version
+//   uint64_t render pipeline count, followed by each render pipeline:
+//     uint64_t manifest key length, followed by the manifest key
+//     uint64_t variant count, followed by each variant:
+//       uint64_t topology class
+//       uint64_t sample count
+//       uint32_t depth format
+//       uint32_t stencil format
+//       uint64_t color attachment count, followed by the uint32_t color formats
+//       uint32_t polygon mode
+//       uint8_t whether depth clamping is enabled
+//   uint64_t compute pipeline count, followed by each compute pipeline:
+//     uint64_t manifest key length, followed by the manifest key
+//     uint64_t threadgroup size count, followed by each threadgroup size (as 3 uint64_t's)
+//
+// manifest keys use the same encoding and are only ever compared against keys generated by the same version of Indium,
+// so their layout can change freely as long as the manifest version is bumped.
+
+static constexpr uint32_t manifestMagic = 0x4d504e49; // "INPM"
+static constexpr uint32_t manifestVersion = 6;
+
+static void writeFunction(Indium::BinaryWriter& writer, std::shared_ptr<Indium::Function> function) {
+	auto privateFunction = std::dynamic_pointer_cast<Indium::PrivateFunction>(function);
+
+	writer.write<uint8_t>(privateFunction ? 1 : 0);
+	if (!privateFunction) {
+		return;
+	}
+
+	writer.write(privateFunction->library()->key());
+	writer.writeString(privateFunction->name());
+};
+
+// returns `std::nullopt` if the function's library isn't loaded on the device.
+// note that this returns `nullptr` (which is *not* the same as `std::nullopt`) if there was no function recorded.
+static std::optional<std::shared_ptr<Indium::Function>> readFunction(Indium::BinaryReader& reader, std::shared_ptr<Indium::PrivateDevice> device) {
+	if (reader.read<uint8_t>() == 0) {
+		return nullptr;
+	}
+
+	auto key = reader.read<Indium::LibraryKey>();
+	auto name = std::string(reader.readBlob());
+
+	auto translated = device->translatedLibrary(key);
+	if (!translated) {
+		return std::nullopt;
+	}
+
+	// libraries are interned by the device, so this shares the library with the application (and with other pipelines in the manifest)
+	return device->newLibrary(key, translated)->newFunction(name);
+};
+
+// unordered maps don't have a stable iteration order, so we have to sort their entries to get stable keys
+template<typename T>
+static std::vector<std::pair<size_t, T>> sortedEntries(const std::unordered_map<size_t, T>& map) {
+	std::vector<std::pair<size_t, T>> entries(map.begin(), map.end());
+	std::sort(entries.begin(), entries.end(), [](const auto& lhs, const auto& rhs) {
+		return lhs.first < rhs.first;
+	});
+	return entries;
+};
+
+std::string Indium::renderPipelineManifestKey(const RenderPipelineDescriptor& descriptor) {
+	BinaryWriter writer;
+
+	writeFunction(writer, descriptor.vertexFunction);
+	writeFunction(writer, descriptor.fragmentFunction);
+
+	writer.write<uint64_t>(static_cast<uint64_t>(descriptor.inputPrimitiveTopology));
+	writer.write<uint64_t>(static_cast<uint64_t>(descriptor.depthAttachmentPixelFormat));
+	writer.write<uint64_t>(static_cast<uint64_t>(descriptor.stencilAttachmentPixelFormat));
+	writer.write<uint64_t>(descriptor.rasterSampleCount);
+	writer.write<uint8_t>(descriptor.alphaToCoverageEnabled ? 1 : 0);
+
+	writer.write<uint64_t>(descriptor.colorAttachments.size());
+	for (const auto& colorAttachment: descriptor.colorAttachments) {
+		writer.write<uint64_t>(static_cast<uint64_t>(colorAttachment.writeMask));
+		writer.write<uint64_t>(static_cast<uint64_t>(colorAttachment.pixelFormat));
+		writer.write<uint8_t>(colorAttachment.blendingEnabled ? 1 : 0);
+		writer.write<uint64_t>(static_cast<uint64_t>(colorAttachment.sourceRGBBlendFactor));
+		writer.write<uint64_t>(static_cast<uint64_t>(colorAttachment.destinationRGBBlendFactor));
+		writer.write<uint64_t>(static_cast<uint64_t>(colorAttachment.rgbBlendOperation));
+		writer.write<uint64_t>(static_cast<uint64_t>(colorAttachment.sourceAlphaBlendFactor));
+		writer.write<uint64_t>(static_cast<uint64_t>(colorAttachment.destinationAlphaBlendFactor));
+		writer.write<uint64_t>(static_cast<uint64_t>(colorAttachment.alphaBlendOperation));
+	}
+
+	writer.write<uint8_t>(descriptor.vertexDescriptor ? 1 : 0);
+	if (descriptor.vertexDescriptor) {
+		auto layouts = sortedEntries(descriptor.vertexDescriptor->layouts);
+		writer.write<uint64_t>(layouts.size());
+		for (const auto& [index, layout]: layouts) {
+			writer.write<uint64_t>(index);
+			writer.write<uint64_t>(layout.stride);
+			writer.write<uint64_t>(static_cast<uint64_t>(layout.stepFunction));
+			writer.write<uint64_t>(layout.stepRate);
+		}
+
+		auto attributes = sortedEntries(descriptor.vertexDescriptor->attributes);
+		writer.write<uint64_t>(attributes.size());
+		for (const auto& [index, attribute]: attributes) {
+			writer.write<uint64_t>(index);
+			writer.write<uint64_t>(static_cast<uint64_t>(attribute.format));
+			writer.write<uint64_t>(attribute.offset);
+			writer.write<uint64_t>(attribute.bufferIndex);
+		}
+	}
+
+	return std::string(writer.data.begin(), writer.data.end());
+};
+
+std::string Indium::computePipelineManifestKey(const ComputePipelineDescriptor& descriptor) {
+	BinaryWriter writer;
+
+	writeFunction(writer, descriptor.computeFunction);
+
+	writer.write<uint8_t>(descriptor.threadGroupSizeIsMultipleOfThreadExecutionWidth ? 1 : 0);
+	writer.write<uint64_t>(descriptor.maxTotalThreadsPerThreadgroup);
+	writer.write<uint8_t>(descriptor.supportIndirectCommandBuffers ? 1 : 0);
+
+	auto buffers = sortedEntries(descriptor.buffers);
+	writer.write<uint64_t>(buffers.size());
+	for (const auto& [index, buffer]: buffers) {
+		writer.write<uint64_t>(index);
+		writer.write<uint64_t>(static_cast<uint64_t>(buffer.mutability));
+	}
+
+	// stage-in isn't supported yet (creating the pipeline state throws), but it still has to be part of the key;
+	// otherwise, a descriptor with stage-in would be handed an interned pipeline state that was created without it.
+	writer.write<uint8_t>(descriptor.stageInputDescriptor ? 1 : 0);
+	if (descriptor.stageInputDescriptor) {
+		auto layouts = sortedEntries(descriptor.stageInputDescriptor->layouts);
+		writer.write<uint64_t>(layouts.size());
+		for (const auto& [index, layout]: layouts) {
+			writer.write<uint64_t>(index);
+			writer.write<uint64_t>(layout.stride);
+			writer.write<uint64_t>(static_cast<uint64_t>(layout.stepFunction));
+			writer.write<uint64_t>(layout.stepRate);
+		}
+
+		auto attributes = sortedEntries(descriptor.stageInputDescriptor->attributes);
+		writer.write<uint64_t>(attributes.size());
+		for (const auto& [index, attribute]: attributes) {
+			writer.write<uint64_t>(index);
+			writer.write<uint64_t>(static_cast<uint64_t>(attribute.format));
+			writer.write<uint64_t>(attribute.offset);
+			writer.write<uint64_t>(attribute.bufferIndex);
+		}
+
+		writer.write<uint64_t>(descriptor.stageInputDescriptor->indexBufferIndex);
+		writer.write<uint64_t>(static_cast<uint64_t>(descriptor.stageInputDescriptor->indexType));
+	}
+
+	return std::string(writer.data.begin(), writer.data.end());
+};
+
+std::optional<Indium::RenderPipelineDescriptor> Indium::renderPipelineDescriptorFromManifestKey(std::shared_ptr<PrivateDevice> device, const std::string& key) {
+	BinaryReader reader { key.data(), key.size() };
+	RenderPipelineDescriptor descriptor;
+
+	auto vertexFunction = readFunction(reader, device);
+	if (!vertexFunction) {
+		return std::nullopt;
+	}
+	descriptor.vertexFunction = *vertexFunction;
+
+	auto fragmentFunction = readFunction(reader, device);
+	if (!fragmentFunction) {
+		return std::nullopt;
+	}
+	descriptor.fragmentFunction = *fragmentFunction;
+
+	descriptor.inputPrimitiveTopology = static_cast<PrimitiveTopologyClass>(reader.read<uint64_t>());
+	descriptor.depthAttachmentPixelFormat = static_cast<PixelFormat>(reader.read<uint64_t>());
+	descriptor.stencilAttachmentPixelFormat = static_cast<PixelFormat>(reader.read<uint64_t>());
+	descriptor.rasterSampleCount = reader.read<uint64_t>();
+	descriptor.alphaToCoverageEnabled = reader.read<uint8_t>() != 0;
+
+	descriptor.colorAttachments.resize(reader.read<uint64_t>());
+	for (auto& colorAttachment: descriptor.colorAttachments) {
+		colorAttachment.writeMask = static_cast<ColorWriteMask>(reader.read<uint64_t>());
+		colorAttachment.pixelFormat = static_cast<PixelFormat>(reader.read<uint64_t>());
+		colorAttachment.blendingEnabled = reader.read<uint8_t>() != 0;
+		colorAttachment.sourceRGBBlendFactor = static_cast<BlendFactor>(reader.read<uint64_t>());
+		colorAttachment.destinationRGBBlendFactor = static_cast<BlendFactor>(reader.read<uint64_t>());
+		colorAttachment.rgbBlendOperation = static_cast<BlendOperation>(reader.read<uint64_t>());
+		colorAttachment.sourceAlphaBlendFactor = static_cast<BlendFactor>(reader.read<uint64_t>());
+		colorAttachment.destinationAlphaBlendFactor = static_cast<BlendFactor>(reader.read<uint64_t>());
+		colorAttachment.alphaBlendOperation = static_cast<BlendOperation>(reader.read<uint64_t>());
+	}
+
+	if (reader.read<uint8_t>() != 0) {
+		auto& vertexDescriptor = descriptor.vertexDescriptor.emplace();
+
+		auto layoutCount = reader.read<uint64_t>();
+		for (uint64_t i = 0; i < layoutCount; ++i) {
+			auto& layout = vertexDescriptor.layouts[reader.read<uint64_t>()];
+			layout.stride = reader.read<uint64_t>();
+			layout.stepFunction = static_cast<VertexStepFunction>(reader.read<uint64_t>());
+			layout.stepRate = reader.read<uint64_t>();
+		}
+
+		auto attributeCount = reader.read<uint64_t>();
+		for (uint64_t i = 0; i < attributeCount; ++i) {
+			auto& attribute = vertexDescriptor.attributes[reader.read<uint64_t>()];
+			attribute.format = static_cast<VertexFormat>(reader.read<uint64_t>());
+			attribute.offset = reader.read<uint64_t>();
+			attribute.bufferIndex = reader.read<uint64_t>();
+		}
+	}
+
+	return descriptor;
+};
+
+std::optional<Indium::ComputePipelineDescriptor> Indium::computePipelineDescriptorFromManifestKey(std::shared_ptr<PrivateDevice> device, const std::string& key) {
+	BinaryReader reader { key.data(), key.size() };
+	ComputePipelineDescriptor descriptor;
+
+	auto computeFunction = readFunction(reader, device);
+	if (!computeFunction || !*computeFunction) {
+		return std::nullopt;
+	}
+	descriptor.computeFunction = *computeFunction;
+
+	descriptor.threadGroupSizeIsMultipleOfThreadExecutionWidth = reader.read<uint8_t>() != 0;
+	descriptor.maxTotalThreadsPerThreadgroup = reader.read<uint64_t>();
+	descriptor.supportIndirectCommandBuffers = reader.read<uint8_t>() != 0;
+
+	auto bufferCount = reader.read<uint64_t>();
+	for (uint64_t i = 0; i < bufferCount; ++i) {
+		auto& buffer = descriptor.buffers[reader.read<uint64_t>()];
+		buffer.mutability = static_cast<Mutability>(reader.read<uint64_t>());
+	}
+
+	if (reader.read<uint8_t>() != 0) {
+		auto& stageInputDescriptor = descriptor.stageInputDescriptor.emplace();
+
+		auto layoutCount = reader.read<uint64_t>();
+		for (uint64_t i = 0; i < layoutCount; ++i) {
+			auto& layout = stageInputDescriptor.layouts[reader.read<uint64_t>()];
+			layout.stride = reader.read<uint64_t>();
+			layout.stepFunction = static_cast<StepFunction>(reader.read<uint64_t>());
+			layout.stepRate = reader.read<uint64_t>();
+		}
+
+		auto attributeCount = reader.read<uint64_t>();
+		for (uint64_t i = 0; i < attributeCount; ++i) {
+			auto& attribute = stageInputDescriptor.attributes[reader.read<uint64_t>()];
+			attribute.format = static_cast<AttributeFormat>(reader.read<uint64_t>());
+			attribute.offset = reader.read<uint64_t>();
+			attribute.bufferIndex = reader.read<uint64_t>();
+		}
+
+		stageInputDescriptor.indexBufferIndex = reader.read<uint64_t>();
+		stageInputDescriptor.indexType = static_cast<IndexType>(reader.read<uint64_t>());
+	}
+
+	return descriptor;
+};
+
+std::vector<char> Indium::PipelineManifest::serialize() const {
+	BinaryWriter writer;
+
+	writer.write(manifestMagic);
+	writer.write(manifestVersion);
+
+	writer.write<uint64_t>(renderPipelines.size());
+	for (const auto& [key, variants]: renderPipelines) {
+		writer.writeString(key);
+
+		writer.write<uint64_t>(variants.size());
+		for (const auto& variant: variants) {
+			writer.write<uint64_t>(static_cast<uint64_t>(variant.topologyClass));
+			writer.write<uint64_t>(variant.attachmentKey.sampleCount);
+			writer.write<uint32_t>(variant.attachmentKey.depthFormat);
+			writer.write<uint32_t>(variant.attachmentKey.stencilFormat);
+
+			writer.write<uint64_t>(variant.attachmentKey.colorFormats.size());
+			for (const auto& format: variant.attachmentKey.colorFormats) {
+				writer.write<uint32_t>(format);
+			}
+
+			writer.write<uint32_t>(variant.rasterizationKey.polygonMode);
+			writer.write<uint8_t>(variant.rasterizationKey.depthClampEnable);
+		}
+	}
+
+	writer.write<uint64_t>(computePipelines.size());
+	for (const auto& [key, threadgroupSizes]: computePipelines) {
+		writer.writeString(key);
+
+		writer.write<uint64_t>(threadgroupSizes.size());
+		for (const auto& size: threadgroupSizes) {
+			writer.write<uint64_t>(size.width);
+			writer.write<uint64_t>(size.height);
+			writer.write<uint64_t>(size.depth);
+		}
+	}
+
+	return std::move(writer.data);
+};
+
+Indium::PipelineManifest Indium::PipelineManifest::deserialize(const char* data, size_t length) {
+	BinaryReader reader { data, length };
+	PipelineManifest manifest;
+
+	if (reader.read<uint32_t>() != manifestMagic) {
+		throw std::runtime_error("Invalid pipeline manifest");
+	}
+
+	if (reader.read<uint32_t>() != manifestVersion) {
+		return manifest;
+	}
+
+	auto renderPipelineCount = reader.read<uint64_t>();
+	for (uint64_t i = 0; i < renderPipelineCount; ++i) {
+		auto& variants = manifest.renderPipelines[std::string(reader.readBlob())];
+
+		auto variantCount = reader.read<uint64_t>();
+		for (uint64_t j = 0; j < variantCount; ++j) {
+			RenderPipelineVariantKey variant;
+			variant.topologyClass = static_cast<PrimitiveTopologyClass>(reader.read<uint64_t>());
+			variant.attachmentKey.sampleCount = reader.read<uint64_t>();
+			variant.attachmentKey.depthFormat = static_cast<VkFormat>(reader.read<uint32_t>());
+			variant.attachmentKey.stencilFormat = static_cast<VkFormat>(reader.read<uint32_t>());
+
+			variant.attachmentKey.colorFormats.resize(reader.read<uint64_t>());
+			for (auto& format: variant.attachmentKey.colorFormats) {
+				format = static_cast<VkFormat>(reader.read<uint32_t>());
+			}
+
+			variant.rasterizationKey.polygonMode = static_cast<VkPolygonMode>(reader.read<uint32_t>());
+			variant.rasterizationKey.depthClampEnable = reader.read<uint8_t>();
+
+			variants.insert(std::move(variant));
+		}
+	}
+
+	auto computePipelineCount = reader.read<uint64_t>();
+	for (uint64_t i = 0; i < computePipelineCount; ++i) {
+		auto& threadgroupSizes = manifest.computePipelines[std::string(reader.readBlob())];
+
+		auto sizeCount = reader.read<uint64_t>();
+		for (uint64_t j = 0; j < sizeCount; ++j) {
+			Size size;
+			size.width = reader.read<uint64_t>();
+			size.height = reader.read<uint64_t>();
+			size.depth = reader.read<uint64_t>();
+			threadgroupSizes.insert(size);
+		}
+	}
+
+	return manifest;
+};
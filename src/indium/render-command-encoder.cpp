@@ -11,11 +11,135 @@
 #include <indium/sampler.private.hpp>
 #include <indium/depth-stencil.private.hpp>
 #include <indium/command-encoder.private.hpp>
+#include <indium/fence.private.hpp>
 #include <indium/dynamic-vk.hpp>
 #include <vulkan/vulkan_core.h>
 
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
 Indium::RenderCommandEncoder::~RenderCommandEncoder() {};
 
+// Vulkan structs don't have comparison operators, but the ones we use this for are plain data without any padding.
+// this takes any two contiguous containers so that we can compare temporary (arena-allocated) lists against the shadow state.
+template<typename A, typename B>
+static bool vulkanStructsEqual(const A& a, const B& b) {
+	static_assert(std::is_same_v<typename A::value_type, typename B::value_type>);
+	return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(typename A::value_type)) == 0);
+};
+
+static Indium::PrimitiveTopologyClass primitiveTypeToTopologyClass(Indium::PrimitiveType primitiveType) {
+	switch (primitiveType) {
+		case Indium::PrimitiveType::Point:
+			return Indium::PrimitiveTopologyClass::Point;
+		case Indium::PrimitiveType::Line:
+		case Indium::PrimitiveType::LineStrip:
+			return Indium::PrimitiveTopologyClass::Line;
+		case Indium::PrimitiveType::Triangle:
+		case Indium::PrimitiveType::TriangleStrip:
+			return Indium::PrimitiveTopologyClass::Triangle;
+		default:
+			throw Indium::BadEnumValue();
+	}
+};
+
+// the shadow state is written into recording keys as-is; an empty value is distinct from every actual value
+template<typename T>
+static void writeShadowValue(Indium::BinaryWriter& writer, const std::optional<T>& value) {
+	writer.write<bool>(!!value);
+	if (value) {
+		writer.write(*value);
+	}
+};
+
+// memoryless attachments have no memory to load from or store to; their contents only ever exist for the duration of the pass
+static void validateMemorylessAttachment(const Indium::PrivateTexture& texture, const VkRenderingAttachmentInfo& info) {
+	if (texture.memoryless() && (info.loadOp == VK_ATTACHMENT_LOAD_OP_LOAD || info.storeOp == VK_ATTACHMENT_STORE_OP_STORE)) {
+		throw std::runtime_error("Memoryless attachments can't be loaded or stored");
+	}
+};
+
+static constexpr VkPipelineStageFlags attachmentStages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+static constexpr VkAccessFlags attachmentAccess = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+static VkImageMemoryBarrier attachmentBarrier(Indium::PrivateTexture& texture, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccess, VkAccessFlags dstAccess) {
+	VkImageMemoryBarrier barrier {};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcAccessMask = srcAccess;
+	barrier.dstAccessMask = dstAccess;
+	barrier.oldLayout = oldLayout;
+	barrier.newLayout = newLayout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = texture.image();
+	barrier.subresourceRange = texture.subresourceRange();
+	return barrier;
+};
+
+// resolves happen at the end of the rendering instance itself (rather than as a separate copy afterwards),
+// so a multisampled attachment that's only resolved never has to be written out to memory at all
+static std::shared_ptr<Indium::PrivateTexture> setUpResolveAttachment(const Indium::RenderPassAttachmentDescriptor& attachment, VkResolveModeFlagBits resolveMode, VkRenderingAttachmentInfo& info) {
+	if (!Indium::storeActionResolves(attachment.storeAction)) {
+		return nullptr;
+	}
+
+	if (attachment.texture->sampleCount() < 2) {
+		throw std::runtime_error("Only multisampled attachments can be resolved");
+	}
+
+	auto resolveTexture = std::dynamic_pointer_cast<Indium::PrivateTexture>(attachment.resolveTexture);
+	if (!resolveTexture) {
+		throw std::runtime_error("Multisample resolve requested without a resolve texture");
+	}
+
+	if (resolveTexture->sampleCount() != 1 || resolveTexture->pixelFormat() != attachment.texture->pixelFormat()) {
+		throw std::runtime_error("Resolve textures must be single-sampled and have the same format as the attachment");
+	}
+
+	// the whole point of resolving is to keep the result, which memoryless textures can't do
+	if (resolveTexture->memoryless()) {
+		throw std::runtime_error("Resolve textures can't be memoryless");
+	}
+
+	if (attachment.resolveLevel != 0 || attachment.resolveSlice != 0) {
+		auto textureType = resolveTexture->textureType();
+
+		if (textureType == Indium::TextureType::eCube || textureType == Indium::TextureType::eCubeArray) {
+			if (attachment.resolveSlice != 0) {
+				throw std::runtime_error("Resolving into a face of a cube texture other than the first isn't supported");
+			}
+		} else if (textureType != Indium::TextureType::e2D && textureType != Indium::TextureType::e2DArray) {
+			throw std::runtime_error("Only 2D and 2D array textures can be resolved into levels or slices other than the first");
+		}
+
+		if (attachment.resolveLevel >= resolveTexture->mipmapLevelCount() || attachment.resolveSlice >= resolveTexture->arrayLength()) {
+			throw std::runtime_error("Resolve level or slice is out of range for the resolve texture");
+		}
+
+		// resolve into a view of just the target level and slice; the view is what gets transitioned and kept alive, too
+		resolveTexture = std::dynamic_pointer_cast<Indium::PrivateTexture>(resolveTexture->newTextureView(
+			resolveTexture->pixelFormat(),
+			Indium::TextureType::e2D,
+			Indium::Range<size_t> { attachment.resolveLevel, 1 },
+			Indium::Range<size_t> { attachment.resolveSlice, 1 }
+		));
+	}
+
+	if (attachment.resolveDepthPlane != 0) {
+		// Vulkan can only render into (or resolve into) a depth plane of a 3D image through a 2D view of it,
+		// which needs the image to have been created as 2D array compatible
+		throw std::runtime_error("Resolving into a depth plane of a 3D texture isn't supported");
+	}
+
+	info.resolveMode = resolveMode;
+	info.resolveImageView = resolveTexture->imageView();
+	// resolve targets are written in the same layout as the attachment they're resolved from
+	info.resolveImageLayout = info.imageLayout;
+
+	return resolveTexture;
+};
+
 Indium::PrivateRenderCommandEncoder::PrivateRenderCommandEncoder(std::shared_ptr<PrivateCommandBuffer> commandBuffer, const RenderPassDescriptor& descriptor):
 	_privateCommandBuffer(commandBuffer),
 	_descriptor(descriptor),
@@ -26,6 +150,14 @@ Indium::PrivateRenderCommandEncoder::PrivateRenderCommandEncoder(std::shared_ptr
 	auto vkDevice = _privateDevice->device();
 	auto vkCmdBuf = buf->commandBuffer();
 
+	for (auto& functionResources: _functionResources) {
+		functionResources.retainReferences = buf->retainedReferences();
+	}
+
+	for (auto& functionResources: _indirectFunctionResources) {
+		functionResources.retainReferences = false;
+	}
+
 	VkDescriptorPoolCreateInfo poolCreateInfo {};
 	poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 	poolCreateInfo.poolSizeCount = poolSizes.size();
@@ -38,134 +170,110 @@ Indium::PrivateRenderCommandEncoder::PrivateRenderCommandEncoder(std::shared_ptr
 	}
 
 	auto firstTexture = descriptor.colorAttachments.front().texture;
-	std::vector<VkClearValue> clearValues;
 
+	// pipelines have to be created for the render pass's sample count, so every attachment has to agree on it
+	_attachmentKey.sampleCount = firstTexture->sampleCount();
 	for (const auto& color: descriptor.colorAttachments) {
-		auto clearColor = color.clearColor;
-		VkClearValue clearValue {};
-		clearValue.color.float32[0] = clearColor.red;
-		clearValue.color.float32[1] = clearColor.green;
-		clearValue.color.float32[2] = clearColor.blue;
-		clearValue.color.float32[3] = clearColor.alpha;
-		clearValues.push_back(clearValue);
-
-		// TODO: distinguish between read-only and read-write textures
-		_readWriteTextures.push_back(color.texture);
+		if (color.texture->sampleCount() != _attachmentKey.sampleCount) {
+			throw std::runtime_error("All render pass attachments must have the same sample count");
+		}
 	}
-
-	if (descriptor.depthAttachment || descriptor.stencilAttachment) {
-		VkClearValue clearValue {};
-		clearValue.depthStencil.depth = descriptor.depthAttachment ? descriptor.depthAttachment->clearDepth : 1.0;
-		clearValue.depthStencil.stencil = descriptor.stencilAttachment ? descriptor.stencilAttachment->clearStencil : 0;
-		clearValues.push_back(clearValue);
+	if (descriptor.depthAttachment && descriptor.depthAttachment->texture->sampleCount() != _attachmentKey.sampleCount) {
+		throw std::runtime_error("All render pass attachments must have the same sample count");
 	}
 
-	std::vector<VkAttachmentDescription> renderPassAttachments;
-	std::vector<VkSubpassDescription> subpasses;
-	std::vector<VkSubpassDependency> dependencies;
+	std::vector<VkRenderingAttachmentInfo> colorAttachments;
+	VkRenderingAttachmentInfo depthAttachment {};
+
+	// attachments that aren't loaded don't need their old contents, so they can be transitioned from the undefined layout.
+	// this is also what makes drawables usable, since swapchain images start out in the undefined layout.
+	std::vector<VkImageMemoryBarrier> beginBarriers;
+	auto transitionAttachment = [&](PrivateTexture& texture, VkImageLayout attachmentLayout, bool preserveContents) {
+		beginBarriers.push_back(attachmentBarrier(texture, preserveContents ? texture.imageLayout() : VK_IMAGE_LAYOUT_UNDEFINED, attachmentLayout, VK_ACCESS_MEMORY_WRITE_BIT, attachmentAccess));
+		_attachmentEndBarriers.push_back(attachmentBarrier(texture, attachmentLayout, texture.imageLayout(), attachmentAccess, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT));
+	};
 
 	for (const auto& color: descriptor.colorAttachments) {
 		auto privateTexture = std::dynamic_pointer_cast<PrivateTexture>(color.texture);
-		VkAttachmentDescription desc {};
-		desc.format = pixelFormatToVkFormat(color.texture->pixelFormat());
-		desc.samples = VK_SAMPLE_COUNT_1_BIT; // TODO: support multisampling
-		desc.loadOp = loadActionToVkAttachmentLoadOp(color.loadAction, true);
-		desc.storeOp = storeActionToVkAttachmentStoreOp(color.storeAction, true);
-		desc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		desc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		desc.initialLayout = (color.loadAction == LoadAction::Load) ? privateTexture->imageLayout() : VK_IMAGE_LAYOUT_UNDEFINED;
-		desc.finalLayout = privateTexture->imageLayout();
-		renderPassAttachments.push_back(desc);
-	}
-
-	if (descriptor.depthAttachment) {
-		auto privateTexture = std::dynamic_pointer_cast<PrivateTexture>(descriptor.depthAttachment->texture);
-		VkAttachmentDescription desc {};
-		desc.format = pixelFormatToVkFormat(privateTexture->pixelFormat());
-		desc.samples = VK_SAMPLE_COUNT_1_BIT;
-		desc.loadOp = loadActionToVkAttachmentLoadOp(descriptor.depthAttachment->loadAction, false);
-		desc.storeOp = storeActionToVkAttachmentStoreOp(descriptor.depthAttachment->storeAction, false);
-		desc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		desc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		desc.initialLayout = (descriptor.depthAttachment->loadAction == LoadAction::Load) ? privateTexture->imageLayout() : VK_IMAGE_LAYOUT_UNDEFINED;
-		desc.finalLayout = privateTexture->imageLayout();
-		renderPassAttachments.push_back(desc);
-	}
+		auto clearColor = color.clearColor;
 
-	if (descriptor.stencilAttachment) {
-		throw std::runtime_error("TODO: support stencil attachments");
-	}
+		_attachmentKey.colorFormats.push_back(pixelFormatToVkFormat(color.texture->pixelFormat()));
+
+		auto& info = colorAttachments.emplace_back();
+		info.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+		info.imageView = privateTexture->imageView();
+		info.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		info.resolveMode = VK_RESOLVE_MODE_NONE;
+		info.loadOp = loadActionToVkAttachmentLoadOp(color.loadAction, true);
+		info.storeOp = storeActionToVkAttachmentStoreOp(color.storeAction, true);
+		info.clearValue.color.float32[0] = clearColor.red;
+		info.clearValue.color.float32[1] = clearColor.green;
+		info.clearValue.color.float32[2] = clearColor.blue;
+		info.clearValue.color.float32[3] = clearColor.alpha;
+		validateMemorylessAttachment(*privateTexture, info);
+
+		// integer formats can't be averaged
+		auto colorResolveMode = pixelFormatIsInteger(color.texture->pixelFormat()) ? VK_RESOLVE_MODE_SAMPLE_ZERO_BIT : VK_RESOLVE_MODE_AVERAGE_BIT;
+		if (auto resolveTexture = setUpResolveAttachment(color, colorResolveMode, info)) {
+			// resolves overwrite the entire resolve texture
+			transitionAttachment(*resolveTexture, info.resolveImageLayout, false);
+			_readWriteTextures.push_back(resolveTexture);
+		}
 
-	std::vector<VkAttachmentReference> colorAttachments;
-	VkAttachmentReference depthStencilAttachment {};
+		transitionAttachment(*privateTexture, info.imageLayout, info.loadOp == VK_ATTACHMENT_LOAD_OP_LOAD);
 
-	size_t index = 0;
-	for (const auto& color: descriptor.colorAttachments) {
-		VkAttachmentReference ref {};
-		ref.attachment = index;
-		ref.layout = VK_IMAGE_LAYOUT_GENERAL;
-		colorAttachments.push_back(ref);
-		++index;
+		// TODO: distinguish between read-only and read-write textures
+		_readWriteTextures.push_back(color.texture);
 	}
 
 	if (descriptor.depthAttachment) {
-		depthStencilAttachment.attachment = index;
-		depthStencilAttachment.layout = VK_IMAGE_LAYOUT_GENERAL;
-		++index;
-	}
-
-	auto& subpassDesc = subpasses.emplace_back();
-	subpassDesc.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-	subpassDesc.colorAttachmentCount = colorAttachments.size();
-	subpassDesc.pColorAttachments = colorAttachments.data();
-	subpassDesc.pDepthStencilAttachment = (descriptor.depthAttachment || descriptor.stencilAttachment) ? &depthStencilAttachment : nullptr;
-
-	VkRenderPassCreateInfo renderPassInfo {};
-	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-	renderPassInfo.attachmentCount = renderPassAttachments.size();
-	renderPassInfo.pAttachments = renderPassAttachments.data();
-	renderPassInfo.subpassCount = subpasses.size();
-	renderPassInfo.pSubpasses = subpasses.data();
-	renderPassInfo.dependencyCount = dependencies.size();
-	renderPassInfo.pDependencies = dependencies.data();
-
-	if (DynamicVK::vkCreateRenderPass(vkDevice, &renderPassInfo, nullptr, &_renderPass) != VK_SUCCESS) {
-		// TODO
-		abort();
-	}
+		auto privateTexture = std::dynamic_pointer_cast<PrivateTexture>(descriptor.depthAttachment->texture);
 
-	std::vector<VkImageView> framebufferAttachments;
+		_attachmentKey.depthFormat = pixelFormatToVkFormat(privateTexture->pixelFormat());
+
+		depthAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+		depthAttachment.imageView = privateTexture->imageView();
+		depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		depthAttachment.resolveMode = VK_RESOLVE_MODE_NONE;
+		depthAttachment.loadOp = loadActionToVkAttachmentLoadOp(descriptor.depthAttachment->loadAction, false);
+		depthAttachment.storeOp = storeActionToVkAttachmentStoreOp(descriptor.depthAttachment->storeAction, false);
+		depthAttachment.clearValue.depthStencil.depth = descriptor.depthAttachment->clearDepth;
+		depthAttachment.clearValue.depthStencil.stencil = 0;
+		validateMemorylessAttachment(*privateTexture, depthAttachment);
+
+		auto depthResolveMode = multisampleDepthResolveFilterToVkResolveMode(descriptor.depthAttachment->depthResolveFilter);
+		if (storeActionResolves(descriptor.depthAttachment->storeAction) && (_privateDevice->supportedDepthResolveModes() & depthResolveMode) == 0) {
+			// every device that can resolve depth at all supports `Sample0`, but `Min` and `Max` are optional
+			throw std::runtime_error("Depth resolve filter isn't supported by this device (only MultisampleDepthResolveFilter::Sample0 is guaranteed)");
+		}
+		if (auto resolveTexture = setUpResolveAttachment(*descriptor.depthAttachment, depthResolveMode, depthAttachment)) {
+			transitionAttachment(*resolveTexture, depthAttachment.resolveImageLayout, false);
+			_readWriteTextures.push_back(resolveTexture);
+		}
 
-	for (const auto& colorAttachment: descriptor.colorAttachments) {
-		framebufferAttachments.push_back(std::dynamic_pointer_cast<PrivateTexture>(colorAttachment.texture)->imageView());
+		transitionAttachment(*privateTexture, depthAttachment.imageLayout, depthAttachment.loadOp == VK_ATTACHMENT_LOAD_OP_LOAD);
 	}
 
-	if (descriptor.depthAttachment) {
-		framebufferAttachments.push_back(std::dynamic_pointer_cast<PrivateTexture>(descriptor.depthAttachment->texture)->imageView());
-	}
-
-	VkFramebufferCreateInfo framebufferInfo {};
-	framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-	framebufferInfo.renderPass = _renderPass;
-	framebufferInfo.attachmentCount = framebufferAttachments.size();
-	framebufferInfo.pAttachments = framebufferAttachments.data();
-	framebufferInfo.width = firstTexture->width();
-	framebufferInfo.height = firstTexture->height();
-	framebufferInfo.layers = std::dynamic_pointer_cast<PrivateTexture>(firstTexture)->vulkanArrayLength();
-	if (DynamicVK::vkCreateFramebuffer(vkDevice, &framebufferInfo, nullptr, &_framebuffer) != VK_SUCCESS) {
-		// TODO
-		abort();
+	if (descriptor.stencilAttachment) {
+		throw std::runtime_error("TODO: support stencil attachments");
 	}
 
-	VkRenderPassBeginInfo renderPassBeginInfo {};
-	renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-	renderPassBeginInfo.renderPass = _renderPass;
-	renderPassBeginInfo.framebuffer = _framebuffer;
-	renderPassBeginInfo.renderArea.extent.width = firstTexture->width();
-	renderPassBeginInfo.renderArea.extent.height = firstTexture->height();
-	renderPassBeginInfo.clearValueCount = clearValues.size();
-	renderPassBeginInfo.pClearValues = clearValues.data();
-	DynamicVK::vkCmdBeginRenderPass(vkCmdBuf, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	VkRenderingInfo renderingInfo {};
+	renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+	renderingInfo.renderArea.extent.width = firstTexture->width();
+	renderingInfo.renderArea.extent.height = firstTexture->height();
+	renderingInfo.layerCount = std::dynamic_pointer_cast<PrivateTexture>(firstTexture)->vulkanArrayLength();
+	renderingInfo.colorAttachmentCount = colorAttachments.size();
+	renderingInfo.pColorAttachments = colorAttachments.data();
+	renderingInfo.pDepthAttachment = descriptor.depthAttachment ? &depthAttachment : nullptr;
+
+	// with nested command buffers, we can execute recorded indirect commands in between our own (see executeRecordedCommands())
+	if (!!(_privateDevice->features() & PrivateDevice::Feature::NestedCommandBuffer)) {
+		renderingInfo.flags = VK_RENDERING_CONTENTS_INLINE_BIT_EXT | VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT;
+	}
+
+	DynamicVK::vkCmdPipelineBarrier(vkCmdBuf, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, attachmentStages, 0, 0, nullptr, 0, nullptr, beginBarriers.size(), beginBarriers.data());
+	DynamicVK::vkCmdBeginRendering(vkCmdBuf, &renderingInfo);
 
 	// set default values
 
@@ -174,54 +282,116 @@ Indium::PrivateRenderCommandEncoder::PrivateRenderCommandEncoder(std::shared_ptr
 	setCullMode(CullMode::None);
 	setFrontFacingWinding(Winding::Clockwise);
 
-	DynamicVK::vkCmdSetDepthCompareOp(vkCmdBuf, VK_COMPARE_OP_ALWAYS);
-	DynamicVK::vkCmdSetDepthBiasEnable(vkCmdBuf, false);
-	DynamicVK::vkCmdSetDepthTestEnable(vkCmdBuf, false);
-	DynamicVK::vkCmdSetDepthWriteEnable(vkCmdBuf, false);
-	DynamicVK::vkCmdSetDepthBoundsTestEnable(vkCmdBuf, false);
+	if (!!(_privateDevice->features() & PrivateDevice::Feature::ExtendedDynamicState3)) {
+		setTriangleFillMode(TriangleFillMode::Fill);
+		setDepthClipMode(DepthClipMode::Clip);
+	}
+
+	if (updateShadowState(_shadowState.depthCompareOp, VK_COMPARE_OP_ALWAYS)) {
+		DynamicVK::vkCmdSetDepthCompareOp(vkCmdBuf, VK_COMPARE_OP_ALWAYS);
+	}
+	if (updateShadowState(_shadowState.depthBiasEnable, false)) {
+		DynamicVK::vkCmdSetDepthBiasEnable(vkCmdBuf, false);
+	}
+	if (updateShadowState(_shadowState.depthTestEnable, false)) {
+		DynamicVK::vkCmdSetDepthTestEnable(vkCmdBuf, false);
+	}
+	if (updateShadowState(_shadowState.depthWriteEnable, false)) {
+		DynamicVK::vkCmdSetDepthWriteEnable(vkCmdBuf, false);
+	}
+	if (updateShadowState(_shadowState.depthBoundsTestEnable, false)) {
+		DynamicVK::vkCmdSetDepthBoundsTestEnable(vkCmdBuf, false);
+	}
 
-	DynamicVK::vkCmdSetStencilTestEnable(vkCmdBuf, false);
+	if (updateShadowState(_shadowState.stencilTestEnable, false)) {
+		DynamicVK::vkCmdSetStencilTestEnable(vkCmdBuf, false);
+	}
 
 	setBlendColor(0, 0, 0, 0);
-	DynamicVK::vkCmdSetRasterizerDiscardEnable(vkCmdBuf, false);
+	if (updateShadowState(_shadowState.rasterizerDiscardEnable, false)) {
+		DynamicVK::vkCmdSetRasterizerDiscardEnable(vkCmdBuf, false);
+	}
 };
 
 Indium::PrivateRenderCommandEncoder::~PrivateRenderCommandEncoder() {
-	if (_framebuffer) {
-		DynamicVK::vkDestroyFramebuffer(_privateDevice->device(), _framebuffer, nullptr);
-	}
-	if (_renderPass) {
-		DynamicVK::vkDestroyRenderPass(_privateDevice->device(), _renderPass, nullptr);
-	}
 	DynamicVK::vkDestroyDescriptorPool(_privateDevice->device(), _pool, 0);
+
+	// the command buffer keeps us alive until it's done executing, so the GPU is done with these by now
+	for (auto pool: _visibilityQueryPools) {
+		_privateDevice->recycleOcclusionQueryPool(pool);
+	}
 };
 
 void Indium::PrivateRenderCommandEncoder::setRenderPipelineState(std::shared_ptr<RenderPipelineState> renderPipelineState) {
 	auto buf = _privateCommandBuffer.lock();
-	_privatePSO = std::dynamic_pointer_cast<PrivateRenderPipelineState>(renderPipelineState);
-	_privatePSO->recreatePipeline(_renderPass, false);
+	auto privatePSO = std::dynamic_pointer_cast<PrivateRenderPipelineState>(renderPipelineState);
+
+	if (privatePSO == _privatePSO) {
+		return;
+	}
+
+	if (privatePSO && privatePSO->defaultAttachmentKey().sampleCount != _attachmentKey.sampleCount) {
+		throw std::runtime_error("Render pipeline state's raster sample count doesn't match the render pass's sample count");
+	}
+
+	_privatePSO = privatePSO;
+	_pipelinesByTopologyClass.fill(VK_NULL_HANDLE);
+
+	// the new pipeline may have a different layout and different functions,
+	// so we need new descriptor sets (and push constants) for it even if the bindings themselves didn't change
+	for (auto& functionResources: _functionResources) {
+		functionResources.dirty = true;
+		functionResources.pushConstantsDirty = true;
+	}
 };
 
 void Indium::PrivateRenderCommandEncoder::setFrontFacingWinding(Winding frontFaceWinding) {
 	auto buf = _privateCommandBuffer.lock();
-	DynamicVK::vkCmdSetFrontFace(buf->commandBuffer(), windingToVkFrontFace(frontFaceWinding));
+	auto frontFace = windingToVkFrontFace(frontFaceWinding);
+	if (updateShadowState(_shadowState.frontFace, frontFace)) {
+		DynamicVK::vkCmdSetFrontFace(buf->commandBuffer(), frontFace);
+	}
 };
 
 void Indium::PrivateRenderCommandEncoder::setCullMode(CullMode cullMode) {
 	auto buf = _privateCommandBuffer.lock();
-	DynamicVK::vkCmdSetCullMode(buf->commandBuffer(), cullModeToVkCullMode(cullMode));
+	VkCullModeFlags vkCullMode = cullModeToVkCullMode(cullMode);
+	if (updateShadowState(_shadowState.cullMode, vkCullMode)) {
+		DynamicVK::vkCmdSetCullMode(buf->commandBuffer(), vkCullMode);
+	}
 };
 
 void Indium::PrivateRenderCommandEncoder::setDepthBias(float depthBias, float slopeScale, float clamp) {
 	auto buf = _privateCommandBuffer.lock();
 	auto vkCmdBuf = buf->commandBuffer();
-	DynamicVK::vkCmdSetDepthBiasEnable(vkCmdBuf, true);
-	DynamicVK::vkCmdSetDepthBias(vkCmdBuf, depthBias, clamp, slopeScale);
+	if (updateShadowState(_shadowState.depthBiasEnable, true)) {
+		DynamicVK::vkCmdSetDepthBiasEnable(vkCmdBuf, true);
+	}
+	if (updateShadowState(_shadowState.depthBias, std::array<float, 3> { depthBias, clamp, slopeScale })) {
+		DynamicVK::vkCmdSetDepthBias(vkCmdBuf, depthBias, clamp, slopeScale);
+	}
 };
 
 void Indium::PrivateRenderCommandEncoder::setDepthClipMode(DepthClipMode depthClipMode) {
-	if (depthClipMode != DepthClipMode::Clip) {
-		throw std::runtime_error("TODO: support setting depth clip mode");
+	bool depthClampEnable = depthClipMode == DepthClipMode::Clamp;
+
+	if (!(_privateDevice->features() & PrivateDevice::Feature::ExtendedDynamicState3)) {
+		if (depthClampEnable && !(_privateDevice->features() & PrivateDevice::Feature::DepthClamp)) {
+			throw std::runtime_error("Depth clamping isn't supported by this device");
+		}
+
+		// the next draw has to use a pipeline with the new depth clip mode baked in
+		if (_rasterizationKey.depthClampEnable != depthClampEnable) {
+			_rasterizationKey.depthClampEnable = depthClampEnable;
+			_pipelinesByTopologyClass.fill(VK_NULL_HANDLE);
+		}
+		return;
+	}
+
+	auto buf = _privateCommandBuffer.lock();
+
+	if (updateShadowState(_shadowState.depthClampEnable, depthClampEnable)) {
+		DynamicVK::vkCmdSetDepthClampEnableEXT(buf->commandBuffer(), depthClampEnable);
 	}
 };
 
@@ -231,7 +401,9 @@ void Indium::PrivateRenderCommandEncoder::setViewport(const Viewport& viewport)
 
 void Indium::PrivateRenderCommandEncoder::setViewports(const Viewport* viewports, size_t count) {
 	auto buf = _privateCommandBuffer.lock();
-	std::vector<VkViewport> tmp;
+	TransientArena::Scope arenaScope(buf->arena());
+	std::pmr::vector<VkViewport> tmp(&buf->arena());
+	tmp.reserve(count);
 	for (size_t i = 0; i < count; ++i) {
 		const auto& viewport = viewports[i];
 		VkViewport vkViewport {};
@@ -251,7 +423,13 @@ void Indium::PrivateRenderCommandEncoder::setViewports(const Viewport* viewports
 		vkViewport.maxDepth = std::clamp(viewport.zfar, 0., 1.);
 		tmp.push_back(vkViewport);
 	}
+
+	if (!filterCommand(!vulkanStructsEqual(tmp, _shadowState.viewports))) {
+		return;
+	}
+
 	DynamicVK::vkCmdSetViewportWithCount(buf->commandBuffer(), tmp.size(), tmp.data());
+	_shadowState.viewports.assign(tmp.begin(), tmp.end());
 };
 
 void Indium::PrivateRenderCommandEncoder::setViewports(const std::vector<Viewport>& viewports) {
@@ -264,7 +442,9 @@ void Indium::PrivateRenderCommandEncoder::setScissorRect(const ScissorRect& scis
 
 void Indium::PrivateRenderCommandEncoder::setScissorRects(const ScissorRect* scissorRects, size_t count) {
 	auto buf = _privateCommandBuffer.lock();
-	std::vector<VkRect2D> tmp;
+	TransientArena::Scope arenaScope(buf->arena());
+	std::pmr::vector<VkRect2D> tmp(&buf->arena());
+	tmp.reserve(count);
 	for (size_t i = 0; i < count; ++i) {
 		const auto& scissorRect = scissorRects[i];
 		VkRect2D vkRect {};
@@ -274,7 +454,13 @@ void Indium::PrivateRenderCommandEncoder::setScissorRects(const ScissorRect* sci
 		vkRect.extent.height = scissorRect.height;
 		tmp.push_back(vkRect);
 	}
+
+	if (!filterCommand(!vulkanStructsEqual(tmp, _shadowState.scissors))) {
+		return;
+	}
+
 	DynamicVK::vkCmdSetScissorWithCount(buf->commandBuffer(), tmp.size(), tmp.data());
+	_shadowState.scissors.assign(tmp.begin(), tmp.end());
 };
 
 void Indium::PrivateRenderCommandEncoder::setScissorRects(const std::vector<ScissorRect>& scissorRects) {
@@ -283,80 +469,107 @@ void Indium::PrivateRenderCommandEncoder::setScissorRects(const std::vector<Scis
 
 void Indium::PrivateRenderCommandEncoder::setBlendColor(float red, float green, float blue, float alpha) {
 	auto buf = _privateCommandBuffer.lock();
-	const float tmp[4] = { red, green, blue, alpha };
-	DynamicVK::vkCmdSetBlendConstants(buf->commandBuffer(), tmp);
+	const std::array<float, 4> tmp { red, green, blue, alpha };
+	if (updateShadowState(_shadowState.blendConstants, tmp)) {
+		DynamicVK::vkCmdSetBlendConstants(buf->commandBuffer(), tmp.data());
+	}
 };
 
-void Indium::PrivateRenderCommandEncoder::updateBindings() {
+void Indium::PrivateRenderCommandEncoder::updateBindings(std::array<FunctionResources, 2>& functionResources) {
 	// TODO: better descriptor set resource management
 
 	auto buf = _privateCommandBuffer.lock();
 
-	std::array<VkDescriptorSet, 2> descriptorSets = createDescriptorSets(_privatePSO->descriptorSetLayouts().layouts, _pool, _privateDevice, { _functionResources[0], _functionResources[1] }, { _privatePSO->vertexFunctionInfo(), _privatePSO->fragmentFunctionInfo() }, _keepAliveBuffers);
+	const std::array<std::reference_wrapper<const FunctionInfo>, 2> functionInfos { _privatePSO->vertexFunctionInfo(), _privatePSO->fragmentFunctionInfo() };
+
+	functionResources[0].resolveDirtyBindings(functionInfos[0]);
+	functionResources[1].resolveDirtyBindings(functionInfos[1]);
+
+	// if nothing changed since the last draw, the descriptor sets we bound for it are still valid.
+	// otherwise, only the sets for the stages whose bindings changed are replaced.
+	if (filterCommand(functionResources[0].dirty || functionResources[1].dirty || functionResources[0].needsRebind || functionResources[1].needsRebind)) {
+		// per-draw texture and sampler changes in the fragment set are usually pushed straight into the command buffer (if the device supports push descriptors)
+		bindDescriptorSets(buf->commandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, _privatePSO->pipelineLayout(), _privatePSO->descriptorSetLayouts(), _pool, _privateDevice, { functionResources[0], functionResources[1] }, functionInfos, buf->uploadHeap(), buf->arena());
+	}
 
-	DynamicVK::vkCmdBindDescriptorSets(buf->commandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, _privatePSO->pipelineLayout(), 0, descriptorSets.size(), descriptorSets.data(), 0, nullptr);
+	// small constant buffers (e.g. from setVertexBytes()) and (usually) buffer addresses are passed in push constants,
+	// which don't need any descriptor updates
+	for (size_t i = 0; i < functionInfos.size(); ++i) {
+		const FunctionInfo& functionInfo = functionInfos[i];
+		if (functionInfo.pushConstantRange.size > 0 && filterCommand(functionResources[i].pushConstantsDirty)) {
+			functionResources[i].pushConstants(_privateDevice, buf->commandBuffer(), _privatePSO->pipelineLayout(), functionInfo, buf->uploadHeap());
+		}
+	}
 
 	const auto& vertexInputBindings = _privatePSO->vertexInputBindings();
 	if (vertexInputBindings.size() > 0) {
-		std::vector<VkBuffer> buffers;
-		std::vector<VkDeviceSize> offsets;
-
-		buffers.resize(vertexInputBindings.size());
-		offsets.resize(vertexInputBindings.size());
+		TransientArena::Scope arenaScope(buf->arena());
+		std::pmr::vector<VkBuffer> buffers(vertexInputBindings.size(), &buf->arena());
+		std::pmr::vector<VkDeviceSize> offsets(vertexInputBindings.size(), &buf->arena());
 
 		for (size_t vulkanIndex = 0; vulkanIndex < vertexInputBindings.size(); ++vulkanIndex) {
 			const auto& metalIndex = vertexInputBindings[vulkanIndex];
 
-			if (metalIndex >= _functionResources[0].buffers.size()) {
+			auto [buffer, offset] = functionResources[0].buffer(metalIndex, buf->uploadHeap());
+
+			if (!buffer) {
 				// technically, this requires the `nullDescriptor` feature, but we should never run into this case anyways.
 				buffers[vulkanIndex] = VK_NULL_HANDLE;
 				offsets[vulkanIndex] = 0;
 			} else {
-				auto [buffer, offset] = _functionResources[0].buffers[metalIndex];
-				auto privateBuffer = std::dynamic_pointer_cast<PrivateBuffer>(buffer);
-				buffers[vulkanIndex] = privateBuffer->buffer();
+				buffers[vulkanIndex] = buffer->buffer();
 				offsets[vulkanIndex] = offset;
 			}
 		}
 
-		DynamicVK::vkCmdBindVertexBuffers(buf->commandBuffer(), 0, vertexInputBindings.size(), buffers.data(), offsets.data());
+		if (filterCommand(!vulkanStructsEqual(buffers, _shadowState.vertexBuffers) || !vulkanStructsEqual(offsets, _shadowState.vertexBufferOffsets))) {
+			DynamicVK::vkCmdBindVertexBuffers(buf->commandBuffer(), 0, vertexInputBindings.size(), buffers.data(), offsets.data());
+			// the shadow state keeps its capacity, so this doesn't allocate once it's big enough
+			_shadowState.vertexBuffers.assign(buffers.begin(), buffers.end());
+			_shadowState.vertexBufferOffsets.assign(offsets.begin(), offsets.end());
+		}
 	}
 };
 
-void Indium::PrivateRenderCommandEncoder::drawPrimitives(PrimitiveType primitiveType, size_t vertexStart, size_t vertexCount, size_t instanceCount, size_t baseInstance) {
+void Indium::PrivateRenderCommandEncoder::bindPipelineForPrimitive(PrimitiveType primitiveType) {
 	auto buf = _privateCommandBuffer.lock();
 
 	// bind the pipeline with the right topology class for this primitive
-	VkPipeline pipeline = VK_NULL_HANDLE;
-	switch (primitiveType) {
-		case PrimitiveType::Point:
-			pipeline = _privatePSO->pipelines()[0];
-			break;
-		case PrimitiveType::Line:
-		case PrimitiveType::LineStrip:
-			pipeline = _privatePSO->pipelines()[1];
-			break;
-		case PrimitiveType::Triangle:
-		case PrimitiveType::TriangleStrip:
-			pipeline = _privatePSO->pipelines()[2];
-			break;
-		default:
-			throw BadEnumValue();
+	auto topologyClass = primitiveTypeToTopologyClass(primitiveType);
+
+	auto& pipeline = _pipelinesByTopologyClass[static_cast<size_t>(topologyClass)];
+	if (!pipeline) {
+		pipeline = _privatePSO->pipeline(topologyClass, _attachmentKey, _rasterizationKey);
 	}
-	DynamicVK::vkCmdBindPipeline(buf->commandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
 
-	DynamicVK::vkCmdSetPrimitiveTopology(buf->commandBuffer(), primitiveTypeToVkPrimitiveTopology(primitiveType));
+	if (filterCommand(pipeline != _shadowState.pipeline)) {
+		DynamicVK::vkCmdBindPipeline(buf->commandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+		_shadowState.pipeline = pipeline;
+	}
 
-	// TODO: avoid re-binding descriptors on every draw.
-	updateBindings();
+	auto topology = primitiveTypeToVkPrimitiveTopology(primitiveType);
+	if (updateShadowState(_shadowState.primitiveTopology, topology)) {
+		DynamicVK::vkCmdSetPrimitiveTopology(buf->commandBuffer(), topology);
+	}
+};
+
+void Indium::PrivateRenderCommandEncoder::drawPrimitives(PrimitiveType primitiveType, size_t vertexStart, size_t vertexCount, size_t instanceCount, size_t baseInstance) {
+	auto buf = _privateCommandBuffer.lock();
+
+	bindPipelineForPrimitive(primitiveType);
+	updateBindings(_functionResources);
 
 	DynamicVK::vkCmdDraw(buf->commandBuffer(), vertexCount, instanceCount, vertexStart, baseInstance);
+	finishDraw(_functionResources);
+};
+
+void Indium::PrivateRenderCommandEncoder::finishDraw(std::array<FunctionResources, 2>& functionResources) {
+	++_commandCounters.recordedCommands;
 
-	// when we emit a draw call, we save the current function resources so that they stay alive until the command buffer is done.
-	// TODO: do this more efficiently by essentially doing COW: after a draw call, we only save additional references to resources
-	//       if someone tries to overwrite them.
-	_savedFunctionResources.push_back(_functionResources[0]);
-	_savedFunctionResources.push_back(_functionResources[1]);
+	// the current bindings are now referenced by a draw call, so they need to stay alive until the command buffer is done.
+	// the bindings themselves keep them alive until they're overwritten; see FunctionResources for details.
+	functionResources[0].markUsed();
+	functionResources[1].markUsed();
 };
 
 void Indium::PrivateRenderCommandEncoder::drawPrimitives(PrimitiveType primitiveType, size_t vertexStart, size_t vertexCount, size_t instanceCount) {
@@ -368,13 +581,23 @@ void Indium::PrivateRenderCommandEncoder::drawPrimitives(PrimitiveType primitive
 };
 
 void Indium::PrivateRenderCommandEncoder::setVertexBytes(const void* bytes, size_t length, size_t index) {
-	auto cmdBuf = _privateCommandBuffer.lock();
-	_functionResources[0].setBytes(cmdBuf->device(), bytes, length, index);
+	_functionResources[0].setBytes(bytes, length, index);
 };
 
 void Indium::PrivateRenderCommandEncoder::endEncoding() {
 	auto buf = _privateCommandBuffer.lock();
-	DynamicVK::vkCmdEndRenderPass(buf->commandBuffer());
+
+	// queries have to end within the same rendering instance they began in
+	endVisibilityQuery();
+
+	DynamicVK::vkCmdEndRendering(buf->commandBuffer());
+
+	DynamicVK::vkCmdPipelineBarrier(buf->commandBuffer(), attachmentStages, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, _attachmentEndBarriers.size(), _attachmentEndBarriers.data());
+
+	// copying query results isn't allowed inside a render pass
+	copyVisibilityResults();
+
+	PrivateFence::encodeUpdates(buf->commandBuffer(), _fenceUpdateStages);
 };
 
 void Indium::PrivateRenderCommandEncoder::setVertexBuffer(std::shared_ptr<Buffer> buffer, size_t offset, size_t index) {
@@ -422,8 +645,7 @@ void Indium::PrivateRenderCommandEncoder::setVertexTextures(const std::vector<st
 };
 
 void Indium::PrivateRenderCommandEncoder::setFragmentBytes(const void* bytes, size_t length, size_t index) {
-	auto cmdBuf = _privateCommandBuffer.lock();
-	_functionResources[1].setBytes(cmdBuf->device(), bytes, length, index);
+	_functionResources[1].setBytes(bytes, length, index);
 };
 
 void Indium::PrivateRenderCommandEncoder::setFragmentBuffer(std::shared_ptr<Buffer> buffer, size_t offset, size_t index) {
@@ -473,41 +695,36 @@ void Indium::PrivateRenderCommandEncoder::setFragmentTextures(std::vector<std::s
 void Indium::PrivateRenderCommandEncoder::drawIndexedPrimitives(PrimitiveType primitiveType, size_t indexCount, IndexType indexType, std::shared_ptr<Buffer> indexBuffer, size_t indexBufferOffset, size_t instanceCount, int64_t baseVertex, size_t baseInstance) {
 	auto buf = _privateCommandBuffer.lock();
 
-	// bind the pipeline with the right topology class for this primitive
-	VkPipeline pipeline = VK_NULL_HANDLE;
-	switch (primitiveType) {
-		case PrimitiveType::Point:
-			pipeline = _privatePSO->pipelines()[0];
-			break;
-		case PrimitiveType::Line:
-		case PrimitiveType::LineStrip:
-			pipeline = _privatePSO->pipelines()[1];
-			break;
-		case PrimitiveType::Triangle:
-		case PrimitiveType::TriangleStrip:
-			pipeline = _privatePSO->pipelines()[2];
-			break;
-		default:
-			throw BadEnumValue();
-	}
-	DynamicVK::vkCmdBindPipeline(buf->commandBuffer(), VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
-
-	DynamicVK::vkCmdSetPrimitiveTopology(buf->commandBuffer(), primitiveTypeToVkPrimitiveTopology(primitiveType));
+	bindPipelineForPrimitive(primitiveType);
+	updateBindings(_functionResources);
+	bindIndexBuffer(indexType, *std::dynamic_pointer_cast<PrivateBuffer>(indexBuffer), indexBufferOffset);
+	keepBufferAlive(std::move(indexBuffer));
 
-	// TODO: avoid re-binding descriptors on every draw.
-	updateBindings();
+	DynamicVK::vkCmdDrawIndexed(buf->commandBuffer(), indexCount, instanceCount, 0, baseVertex, baseInstance);
+	finishDraw(_functionResources);
+};
 
-	// we need to keep this buffer alive until we complete the render
-	_keepAliveBuffers.push_back(indexBuffer);
+void Indium::PrivateRenderCommandEncoder::keepBufferAlive(std::shared_ptr<Buffer> buffer) {
+	// we need to keep buffers used by draws alive until we complete the render
+	// (unless the user promised to do that for us)
+	auto buf = _privateCommandBuffer.lock();
+	if (buf->retainedReferences() && (_keepAliveBuffers.empty() || _keepAliveBuffers.back() != buffer)) {
+		_keepAliveBuffers.push_back(std::move(buffer));
+	}
+};
 
-	auto privateIndexBuffer = std::dynamic_pointer_cast<PrivateBuffer>(indexBuffer);
+void Indium::PrivateRenderCommandEncoder::bindIndexBuffer(IndexType indexType, PrivateBuffer& indexBuffer, size_t indexBufferOffset) {
+	auto buf = _privateCommandBuffer.lock();
 
-	DynamicVK::vkCmdBindIndexBuffer(buf->commandBuffer(), privateIndexBuffer->buffer(), indexBufferOffset, indexTypeToVkIndexType(indexType));
-	DynamicVK::vkCmdDrawIndexed(buf->commandBuffer(), indexCount, instanceCount, 0, baseVertex, baseInstance);
+	auto vkIndexBuffer = indexBuffer.buffer();
+	auto vkIndexType = indexTypeToVkIndexType(indexType);
 
-	// see drawPrimitives() to know why we do this
-	_savedFunctionResources.push_back(_functionResources[0]);
-	_savedFunctionResources.push_back(_functionResources[1]);
+	if (filterCommand(vkIndexBuffer != _shadowState.indexBuffer || indexBufferOffset != _shadowState.indexBufferOffset || vkIndexType != _shadowState.indexType)) {
+		DynamicVK::vkCmdBindIndexBuffer(buf->commandBuffer(), vkIndexBuffer, indexBufferOffset, vkIndexType);
+		_shadowState.indexBuffer = vkIndexBuffer;
+		_shadowState.indexBufferOffset = indexBufferOffset;
+		_shadowState.indexType = vkIndexType;
+	}
 };
 
 void Indium::PrivateRenderCommandEncoder::drawIndexedPrimitives(PrimitiveType primitiveType, size_t indexCount, IndexType indexType, std::shared_ptr<Buffer> indexBuffer, size_t indexBufferOffset, size_t instanceCount) {
@@ -518,77 +735,741 @@ void Indium::PrivateRenderCommandEncoder::drawIndexedPrimitives(PrimitiveType pr
 	drawIndexedPrimitives(primitiveType, indexCount, indexType, indexBuffer, indexBufferOffset, 1);
 };
 
+// Metal's indirect argument structures have the same layout as Vulkan's, so the buffers can be passed straight through
+static_assert(sizeof(VkDrawIndirectCommand) == 4 * sizeof(uint32_t));
+static_assert(sizeof(VkDrawIndexedIndirectCommand) == 5 * sizeof(uint32_t));
+
+void Indium::PrivateRenderCommandEncoder::drawPrimitives(PrimitiveType primitiveType, std::shared_ptr<Buffer> indirectBuffer, size_t indirectBufferOffset) {
+	auto buf = _privateCommandBuffer.lock();
+
+	bindPipelineForPrimitive(primitiveType);
+	updateBindings(_functionResources);
+
+	auto vkIndirectBuffer = std::dynamic_pointer_cast<PrivateBuffer>(indirectBuffer)->buffer();
+	keepBufferAlive(std::move(indirectBuffer));
+
+	DynamicVK::vkCmdDrawIndirect(buf->commandBuffer(), vkIndirectBuffer, indirectBufferOffset, 1, sizeof(VkDrawIndirectCommand));
+	finishDraw(_functionResources);
+};
+
+void Indium::PrivateRenderCommandEncoder::drawIndexedPrimitives(PrimitiveType primitiveType, IndexType indexType, std::shared_ptr<Buffer> indexBuffer, size_t indexBufferOffset, std::shared_ptr<Buffer> indirectBuffer, size_t indirectBufferOffset) {
+	auto buf = _privateCommandBuffer.lock();
+
+	bindPipelineForPrimitive(primitiveType);
+	updateBindings(_functionResources);
+	bindIndexBuffer(indexType, *std::dynamic_pointer_cast<PrivateBuffer>(indexBuffer), indexBufferOffset);
+	keepBufferAlive(std::move(indexBuffer));
+
+	auto vkIndirectBuffer = std::dynamic_pointer_cast<PrivateBuffer>(indirectBuffer)->buffer();
+	keepBufferAlive(std::move(indirectBuffer));
+
+	DynamicVK::vkCmdDrawIndexedIndirect(buf->commandBuffer(), vkIndirectBuffer, indirectBufferOffset, 1, sizeof(VkDrawIndexedIndirectCommand));
+	finishDraw(_functionResources);
+};
+
+void Indium::PrivateRenderCommandEncoder::drawPrimitives(PrimitiveType primitiveType, std::shared_ptr<Buffer> indirectBuffer, size_t indirectBufferOffset, std::shared_ptr<Buffer> countBuffer, size_t countBufferOffset, size_t maxDrawCount) {
+	if (!(_privateDevice->features() & PrivateDevice::Feature::DrawIndirectCount)) {
+		throw std::runtime_error("Device does not support indirect draw counts");
+	}
+
+	auto buf = _privateCommandBuffer.lock();
+
+	bindPipelineForPrimitive(primitiveType);
+	updateBindings(_functionResources);
+
+	auto vkIndirectBuffer = std::dynamic_pointer_cast<PrivateBuffer>(indirectBuffer)->buffer();
+	auto vkCountBuffer = std::dynamic_pointer_cast<PrivateBuffer>(countBuffer)->buffer();
+	keepBufferAlive(std::move(indirectBuffer));
+	keepBufferAlive(std::move(countBuffer));
+
+	DynamicVK::vkCmdDrawIndirectCount(buf->commandBuffer(), vkIndirectBuffer, indirectBufferOffset, vkCountBuffer, countBufferOffset, maxDrawCount, sizeof(VkDrawIndirectCommand));
+	finishDraw(_functionResources);
+};
+
+void Indium::PrivateRenderCommandEncoder::drawIndexedPrimitives(PrimitiveType primitiveType, IndexType indexType, std::shared_ptr<Buffer> indexBuffer, size_t indexBufferOffset, std::shared_ptr<Buffer> indirectBuffer, size_t indirectBufferOffset, std::shared_ptr<Buffer> countBuffer, size_t countBufferOffset, size_t maxDrawCount) {
+	if (!(_privateDevice->features() & PrivateDevice::Feature::DrawIndirectCount)) {
+		throw std::runtime_error("Device does not support indirect draw counts");
+	}
+
+	auto buf = _privateCommandBuffer.lock();
+
+	bindPipelineForPrimitive(primitiveType);
+	updateBindings(_functionResources);
+	bindIndexBuffer(indexType, *std::dynamic_pointer_cast<PrivateBuffer>(indexBuffer), indexBufferOffset);
+	keepBufferAlive(std::move(indexBuffer));
+
+	auto vkIndirectBuffer = std::dynamic_pointer_cast<PrivateBuffer>(indirectBuffer)->buffer();
+	auto vkCountBuffer = std::dynamic_pointer_cast<PrivateBuffer>(countBuffer)->buffer();
+	keepBufferAlive(std::move(indirectBuffer));
+	keepBufferAlive(std::move(countBuffer));
+
+	DynamicVK::vkCmdDrawIndexedIndirectCount(buf->commandBuffer(), vkIndirectBuffer, indirectBufferOffset, vkCountBuffer, countBufferOffset, maxDrawCount, sizeof(VkDrawIndexedIndirectCommand));
+	finishDraw(_functionResources);
+};
+
+void Indium::PrivateRenderCommandEncoder::executeCommandsInBuffer(std::shared_ptr<IndirectCommandBuffer> indirectCommandBuffer, Range<size_t> executionRange) {
+	auto buf = _privateCommandBuffer.lock();
+	auto privateICB = std::dynamic_pointer_cast<PrivateIndirectCommandBuffer>(indirectCommandBuffer);
+	const auto& icbDescriptor = privateICB->descriptor();
+
+	if (!privateICB->containsRenderCommands()) {
+		throw std::runtime_error("Indirect command buffer doesn't contain render commands");
+	}
+
+	privateICB->checkRange(executionRange);
+
+	// commands that set their own pipeline states and buffers only depend on our attachments and dynamic state, so they can be recorded once
+	// and then executed as-is for as long as those stay the same. executing them in the middle of our rendering instance needs nested command buffers, though,
+	// and a secondary command buffer can't take part in our visibility queries without the `inheritedQueries` feature.
+	// (suspending our rendering instance around the commands instead isn't an option either, since that has to be decided when it begins.)
+	if (
+		!icbDescriptor.inheritPipelineState &&
+		!icbDescriptor.inheritBuffers &&
+		!!(_privateDevice->features() & PrivateDevice::Feature::NestedCommandBuffer) &&
+		_visibilityResultMode == VisibilityResultMode::Disabled
+	) {
+		executeRecordedCommands(*privateICB, executionRange);
+
+		if (buf->retainedReferences() && (_keepAliveIndirectCommandBuffers.empty() || _keepAliveIndirectCommandBuffers.back() != indirectCommandBuffer)) {
+			_keepAliveIndirectCommandBuffers.push_back(std::move(indirectCommandBuffer));
+		}
+		return;
+	}
+
+	// otherwise, we fall back to replaying the commands ourselves, which records them into our command buffer again every time they're executed.
+	// this is the only way to execute commands that inherit our pipeline state or buffers, since secondary command buffers can't inherit those.
+
+	auto savedPSO = _privatePSO;
+
+	// commands that set their own buffers are bound separately so that the encoder's own bindings survive this
+	auto& functionResources = icbDescriptor.inheritBuffers ? _functionResources : _indirectFunctionResources;
+	if (!icbDescriptor.inheritBuffers) {
+		for (auto& resources: _indirectFunctionResources) {
+			resources.dirty = true;
+			resources.pushConstantsDirty = true;
+		}
+	}
+
+	// this also has to happen if one of the commands throws, so that the encoder is left the way it was
+	auto restoreEncoderState = [&]() {
+		if (!icbDescriptor.inheritPipelineState) {
+			setRenderPipelineState(savedPSO);
+		}
+
+		if (!icbDescriptor.inheritBuffers) {
+			// the descriptor sets and push constants we last bound belong to the indirect commands.
+			// our own bindings haven't changed, though, so our sets just need to be bound again.
+			for (auto& resources: _functionResources) {
+				resources.needsRebind = true;
+				resources.pushConstantsDirty = true;
+			}
+		}
+	};
+
+	try {
+		for (size_t i = executionRange.start; i < executionRange.start + executionRange.length; ++i) {
+			const auto& command = privateICB->renderCommand(i);
+
+			if (std::holds_alternative<std::monostate>(command.draw)) {
+				continue;
+			}
+
+			if (!icbDescriptor.inheritPipelineState && command.pipelineState != _privatePSO) {
+				setRenderPipelineState(command.pipelineState);
+
+				// setRenderPipelineState() only invalidates the encoder's own bindings
+				for (auto& resources: _indirectFunctionResources) {
+					resources.dirty = true;
+					resources.pushConstantsDirty = true;
+				}
+			}
+
+			if (!_privatePSO) {
+				throw std::runtime_error("No render pipeline state set for indirect command");
+			}
+
+			if (!icbDescriptor.inheritBuffers) {
+				// unchanged bindings are filtered out by FunctionResources, so consecutive commands that share buffers don't need new descriptor sets
+				for (size_t stage = 0; stage < command.buffers.size(); ++stage) {
+					const auto& buffers = command.buffers[stage];
+					for (size_t index = 0; index < buffers.size(); ++index) {
+						functionResources[stage].setBuffer(buffers[index].buffer, buffers[index].offset, index);
+					}
+				}
+			}
+
+			if (auto draw = std::get_if<PrivateIndirectCommandBuffer::Draw>(&command.draw)) {
+				bindPipelineForPrimitive(draw->primitiveType);
+				updateBindings(functionResources);
+				DynamicVK::vkCmdDraw(buf->commandBuffer(), draw->vertexCount, draw->instanceCount, draw->vertexStart, draw->baseInstance);
+			} else if (auto draw = std::get_if<PrivateIndirectCommandBuffer::DrawIndexed>(&command.draw)) {
+				bindPipelineForPrimitive(draw->primitiveType);
+				updateBindings(functionResources);
+				bindIndexBuffer(draw->indexType, *draw->indexBuffer, draw->indexBufferOffset);
+				DynamicVK::vkCmdDrawIndexed(buf->commandBuffer(), draw->indexCount, draw->instanceCount, 0, draw->baseVertex, draw->baseInstance);
+			}
+
+			finishDraw(functionResources);
+		}
+	} catch (...) {
+		restoreEncoderState();
+		throw;
+	}
+
+	restoreEncoderState();
+
+	// the commands keep their resources alive, so we only need to keep the indirect command buffer itself alive
+	if (buf->retainedReferences() && (_keepAliveIndirectCommandBuffers.empty() || _keepAliveIndirectCommandBuffers.back() != indirectCommandBuffer)) {
+		_keepAliveIndirectCommandBuffers.push_back(std::move(indirectCommandBuffer));
+	}
+};
+
+void Indium::PrivateRenderCommandEncoder::recordDynamicState(VkCommandBuffer commandBuffer) {
+	// this records the shadow state as-is (into a command buffer whose state is undefined), so it's never filtered
+	if (_shadowState.primitiveTopology) {
+		DynamicVK::vkCmdSetPrimitiveTopology(commandBuffer, *_shadowState.primitiveTopology);
+	}
+	if (_shadowState.frontFace) {
+		DynamicVK::vkCmdSetFrontFace(commandBuffer, *_shadowState.frontFace);
+	}
+	if (_shadowState.cullMode) {
+		DynamicVK::vkCmdSetCullMode(commandBuffer, *_shadowState.cullMode);
+	}
+	if (_shadowState.depthBiasEnable) {
+		DynamicVK::vkCmdSetDepthBiasEnable(commandBuffer, *_shadowState.depthBiasEnable);
+	}
+	if (_shadowState.depthBias) {
+		DynamicVK::vkCmdSetDepthBias(commandBuffer, (*_shadowState.depthBias)[0], (*_shadowState.depthBias)[1], (*_shadowState.depthBias)[2]);
+	}
+	if (!_shadowState.viewports.empty()) {
+		DynamicVK::vkCmdSetViewportWithCount(commandBuffer, _shadowState.viewports.size(), _shadowState.viewports.data());
+	}
+	if (!_shadowState.scissors.empty()) {
+		DynamicVK::vkCmdSetScissorWithCount(commandBuffer, _shadowState.scissors.size(), _shadowState.scissors.data());
+	}
+	if (_shadowState.blendConstants) {
+		DynamicVK::vkCmdSetBlendConstants(commandBuffer, _shadowState.blendConstants->data());
+	}
+	if (_shadowState.depthTestEnable) {
+		DynamicVK::vkCmdSetDepthTestEnable(commandBuffer, *_shadowState.depthTestEnable);
+	}
+	if (_shadowState.depthWriteEnable) {
+		DynamicVK::vkCmdSetDepthWriteEnable(commandBuffer, *_shadowState.depthWriteEnable);
+	}
+	if (_shadowState.depthCompareOp) {
+		DynamicVK::vkCmdSetDepthCompareOp(commandBuffer, *_shadowState.depthCompareOp);
+	}
+	if (_shadowState.depthBoundsTestEnable) {
+		DynamicVK::vkCmdSetDepthBoundsTestEnable(commandBuffer, *_shadowState.depthBoundsTestEnable);
+	}
+	if (_shadowState.stencilTestEnable) {
+		DynamicVK::vkCmdSetStencilTestEnable(commandBuffer, *_shadowState.stencilTestEnable);
+	}
+	if (_shadowState.rasterizerDiscardEnable) {
+		DynamicVK::vkCmdSetRasterizerDiscardEnable(commandBuffer, *_shadowState.rasterizerDiscardEnable);
+	}
+	if (_shadowState.polygonMode) {
+		DynamicVK::vkCmdSetPolygonModeEXT(commandBuffer, *_shadowState.polygonMode);
+	}
+	if (_shadowState.depthClampEnable) {
+		DynamicVK::vkCmdSetDepthClampEnableEXT(commandBuffer, *_shadowState.depthClampEnable);
+	}
+
+	for (size_t faceIndex = 0; faceIndex < 2; ++faceIndex) {
+		VkStencilFaceFlags face = (faceIndex == 0) ? VK_STENCIL_FACE_FRONT_BIT : VK_STENCIL_FACE_BACK_BIT;
+
+		if (_shadowState.stencilCompareMask[faceIndex]) {
+			DynamicVK::vkCmdSetStencilCompareMask(commandBuffer, face, *_shadowState.stencilCompareMask[faceIndex]);
+		}
+		if (_shadowState.stencilWriteMask[faceIndex]) {
+			DynamicVK::vkCmdSetStencilWriteMask(commandBuffer, face, *_shadowState.stencilWriteMask[faceIndex]);
+		}
+		if (_shadowState.stencilReference[faceIndex]) {
+			DynamicVK::vkCmdSetStencilReference(commandBuffer, face, *_shadowState.stencilReference[faceIndex]);
+		}
+		if (const auto& opState = _shadowState.stencilOp[faceIndex]) {
+			DynamicVK::vkCmdSetStencilOp(commandBuffer, face, opState->failOp, opState->passOp, opState->depthFailOp, opState->compareOp);
+		}
+	}
+};
+
+void Indium::PrivateRenderCommandEncoder::writeIndirectRecordingKey() {
+	// everything a recording inherits from us: the attachments and rasterization state its pipelines were created for, along with our dynamic state.
+	// the primitive topology is left out, since every recorded draw sets its own.
+	auto& writer = _indirectRecordingKey;
+	writer.data.clear();
+
+	writer.writeBlob(_attachmentKey.colorFormats.data(), _attachmentKey.colorFormats.size() * sizeof(VkFormat));
+	writer.write(_attachmentKey.depthFormat);
+	writer.write(_attachmentKey.stencilFormat);
+	writer.write(_attachmentKey.sampleCount);
+	writer.write(_rasterizationKey.polygonMode);
+	writer.write(_rasterizationKey.depthClampEnable);
+
+	writeShadowValue(writer, _shadowState.frontFace);
+	writeShadowValue(writer, _shadowState.cullMode);
+	writeShadowValue(writer, _shadowState.depthBiasEnable);
+	writeShadowValue(writer, _shadowState.depthBias);
+	writer.writeBlob(_shadowState.viewports.data(), _shadowState.viewports.size() * sizeof(VkViewport));
+	writer.writeBlob(_shadowState.scissors.data(), _shadowState.scissors.size() * sizeof(VkRect2D));
+	writeShadowValue(writer, _shadowState.blendConstants);
+	writeShadowValue(writer, _shadowState.depthTestEnable);
+	writeShadowValue(writer, _shadowState.depthWriteEnable);
+	writeShadowValue(writer, _shadowState.depthCompareOp);
+	writeShadowValue(writer, _shadowState.depthBoundsTestEnable);
+	writeShadowValue(writer, _shadowState.stencilTestEnable);
+	writeShadowValue(writer, _shadowState.rasterizerDiscardEnable);
+	writeShadowValue(writer, _shadowState.polygonMode);
+	writeShadowValue(writer, _shadowState.depthClampEnable);
+
+	for (size_t faceIndex = 0; faceIndex < 2; ++faceIndex) {
+		writeShadowValue(writer, _shadowState.stencilCompareMask[faceIndex]);
+		writeShadowValue(writer, _shadowState.stencilWriteMask[faceIndex]);
+		writeShadowValue(writer, _shadowState.stencilReference[faceIndex]);
+		writeShadowValue(writer, _shadowState.stencilOp[faceIndex]);
+	}
+};
+
+void Indium::PrivateRenderCommandEncoder::executeRecordedCommands(PrivateIndirectCommandBuffer& indirectCommandBuffer, Range<size_t> executionRange) {
+	auto buf = _privateCommandBuffer.lock();
+
+	writeIndirectRecordingKey();
+
+	auto recording = indirectCommandBuffer.findRecording(executionRange, _indirectRecordingKey.data);
+	if (!recording) {
+		recording = recordIndirectCommands(indirectCommandBuffer, executionRange);
+		indirectCommandBuffer.addRecording(recording);
+	}
+
+	auto recordedCommandBuffer = recording->commandBuffer();
+	DynamicVK::vkCmdExecuteCommands(buf->commandBuffer(), 1, &recordedCommandBuffer);
+	++_commandCounters.recordedCommands;
+
+	// all of our command buffer's state is undefined after executing another command buffer. our dynamic state has to be recorded again right away,
+	// but everything else is bound again by the next draw once we forget what we last bound.
+	recordDynamicState(buf->commandBuffer());
+
+	_shadowState.pipeline = VK_NULL_HANDLE;
+	_shadowState.vertexBuffers.clear();
+	_shadowState.vertexBufferOffsets.clear();
+	_shadowState.indexBuffer = VK_NULL_HANDLE;
+
+	for (auto& resources: _functionResources) {
+		resources.needsRebind = true;
+		resources.pushConstantsDirty = true;
+	}
+
+	_keepAliveIndirectRecordings.push_back(std::move(recording));
+};
+
+std::shared_ptr<Indium::PrivateIndirectCommandRecording> Indium::PrivateRenderCommandEncoder::recordIndirectCommands(PrivateIndirectCommandBuffer& indirectCommandBuffer, Range<size_t> executionRange) {
+	auto buf = _privateCommandBuffer.lock();
+
+	// each command needs at most one descriptor set per stage
+	auto recording = std::make_shared<PrivateIndirectCommandRecording>(_privateDevice, executionRange, _indirectRecordingKey.data, executionRange.length * 2);
+	auto commandBuffer = recording->commandBuffer();
+
+	VkCommandBufferInheritanceRenderingInfo renderingInfo {};
+	renderingInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+	renderingInfo.colorAttachmentCount = _attachmentKey.colorFormats.size();
+	renderingInfo.pColorAttachmentFormats = _attachmentKey.colorFormats.data();
+	renderingInfo.depthAttachmentFormat = _attachmentKey.depthFormat;
+	renderingInfo.stencilAttachmentFormat = _attachmentKey.stencilFormat;
+	renderingInfo.rasterizationSamples = static_cast<VkSampleCountFlagBits>(_attachmentKey.sampleCount);
+
+	recording->begin(VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT, &renderingInfo);
+
+	// secondary command buffers don't inherit any state, so our dynamic state is baked into the recording (which is why it's part of the key)
+	recordDynamicState(commandBuffer);
+
+	// nothing is bound at the start of the recording either. these bindings are only used for the recording,
+	// so whatever we leave in them here is thrown away by the next execution (see executeCommandsInBuffer()).
+	auto& functionResources = _indirectFunctionResources;
+	for (auto& resources: functionResources) {
+		resources.dirty = true;
+		resources.pushConstantsDirty = true;
+	}
+
+	std::shared_ptr<PrivateRenderPipelineState> pso;
+	VkPipeline boundPipeline = VK_NULL_HANDLE;
+	std::optional<VkPrimitiveTopology> boundTopology;
+
+	for (size_t i = executionRange.start; i < executionRange.start + executionRange.length; ++i) {
+		const auto& command = indirectCommandBuffer.renderCommand(i);
+
+		if (std::holds_alternative<std::monostate>(command.draw)) {
+			continue;
+		}
+
+		if (!command.pipelineState) {
+			throw std::runtime_error("No render pipeline state set for indirect command");
+		}
+
+		if (command.pipelineState != pso) {
+			if (command.pipelineState->defaultAttachmentKey().sampleCount != _attachmentKey.sampleCount) {
+				throw std::runtime_error("Render pipeline state's raster sample count doesn't match the render pass's sample count");
+			}
+
+			pso = command.pipelineState;
+			recording->retain(pso);
+
+			for (auto& resources: functionResources) {
+				resources.dirty = true;
+				resources.pushConstantsDirty = true;
+			}
+		}
+
+		for (size_t stage = 0; stage < command.buffers.size(); ++stage) {
+			const auto& buffers = command.buffers[stage];
+			for (size_t index = 0; index < buffers.size(); ++index) {
+				functionResources[stage].setBuffer(buffers[index].buffer, buffers[index].offset, index);
+				if (buffers[index].buffer) {
+					recording->retain(buffers[index].buffer);
+				}
+			}
+		}
+
+		auto draw = std::get_if<PrivateIndirectCommandBuffer::Draw>(&command.draw);
+		auto indexedDraw = std::get_if<PrivateIndirectCommandBuffer::DrawIndexed>(&command.draw);
+		auto primitiveType = draw ? draw->primitiveType : indexedDraw->primitiveType;
+
+		auto pipeline = pso->pipeline(primitiveTypeToTopologyClass(primitiveType), _attachmentKey, _rasterizationKey);
+		if (pipeline != boundPipeline) {
+			DynamicVK::vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+			boundPipeline = pipeline;
+		}
+
+		auto topology = primitiveTypeToVkPrimitiveTopology(primitiveType);
+		if (boundTopology != topology) {
+			DynamicVK::vkCmdSetPrimitiveTopology(commandBuffer, topology);
+			boundTopology = topology;
+		}
+
+		// this is what updateBindings() does, except that everything comes from the recording instead of our command buffer
+		const std::array<std::reference_wrapper<const FunctionInfo>, 2> functionInfos { pso->vertexFunctionInfo(), pso->fragmentFunctionInfo() };
+
+		functionResources[0].resolveDirtyBindings(functionInfos[0]);
+		functionResources[1].resolveDirtyBindings(functionInfos[1]);
+
+		if (functionResources[0].dirty || functionResources[1].dirty || functionResources[0].needsRebind || functionResources[1].needsRebind) {
+			bindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pso->pipelineLayout(), pso->descriptorSetLayouts(), recording->descriptorPool(), _privateDevice, { functionResources[0], functionResources[1] }, functionInfos, recording->uploadHeap(), buf->arena());
+		}
+
+		for (size_t stage = 0; stage < functionInfos.size(); ++stage) {
+			const FunctionInfo& functionInfo = functionInfos[stage];
+			if (functionInfo.pushConstantRange.size > 0 && functionResources[stage].pushConstantsDirty) {
+				functionResources[stage].pushConstants(_privateDevice, commandBuffer, pso->pipelineLayout(), functionInfo, recording->uploadHeap());
+			}
+		}
+
+		const auto& vertexInputBindings = pso->vertexInputBindings();
+		if (vertexInputBindings.size() > 0) {
+			TransientArena::Scope arenaScope(buf->arena());
+			std::pmr::vector<VkBuffer> vertexBuffers(vertexInputBindings.size(), &buf->arena());
+			std::pmr::vector<VkDeviceSize> vertexBufferOffsets(vertexInputBindings.size(), &buf->arena());
+
+			for (size_t vulkanIndex = 0; vulkanIndex < vertexInputBindings.size(); ++vulkanIndex) {
+				auto [buffer, offset] = functionResources[0].buffer(vertexInputBindings[vulkanIndex], recording->uploadHeap());
+				vertexBuffers[vulkanIndex] = buffer ? buffer->buffer() : VK_NULL_HANDLE;
+				vertexBufferOffsets[vulkanIndex] = buffer ? offset : 0;
+			}
+
+			DynamicVK::vkCmdBindVertexBuffers(commandBuffer, 0, vertexInputBindings.size(), vertexBuffers.data(), vertexBufferOffsets.data());
+		}
+
+		if (draw) {
+			DynamicVK::vkCmdDraw(commandBuffer, draw->vertexCount, draw->instanceCount, draw->vertexStart, draw->baseInstance);
+		} else {
+			recording->retain(indexedDraw->indexBuffer);
+			DynamicVK::vkCmdBindIndexBuffer(commandBuffer, indexedDraw->indexBuffer->buffer(), indexedDraw->indexBufferOffset, indexTypeToVkIndexType(indexedDraw->indexType));
+			DynamicVK::vkCmdDrawIndexed(commandBuffer, indexedDraw->indexCount, indexedDraw->instanceCount, 0, indexedDraw->baseVertex, indexedDraw->baseInstance);
+		}
+
+		functionResources[0].markUsed();
+		functionResources[1].markUsed();
+	}
+
+	recording->end();
+
+	return recording;
+};
+
 void Indium::PrivateRenderCommandEncoder::setDepthStencilState(std::shared_ptr<DepthStencilState> state) {
 	auto buf = _privateCommandBuffer.lock();
 	auto privateState = std::dynamic_pointer_cast<PrivateDepthStencilState>(state);
 	auto& desc = privateState->descriptor();
 
-	DynamicVK::vkCmdSetDepthWriteEnable(buf->commandBuffer(), desc.depthWriteEnabled ? VK_TRUE : VK_FALSE);
-	DynamicVK::vkCmdSetDepthCompareOp(buf->commandBuffer(), compareFunctionToVkCompareOp(desc.depthCompareFunction));
-	DynamicVK::vkCmdSetDepthTestEnable(buf->commandBuffer(), VK_TRUE);
-
-	DynamicVK::vkCmdSetStencilTestEnable(buf->commandBuffer(), (desc.frontFaceStencil || desc.backFaceStencil) ? VK_TRUE : VK_FALSE);
-
-	if (desc.frontFaceStencil || desc.backFaceStencil) {
-		if (desc.frontFaceStencil) {
-			DynamicVK::vkCmdSetStencilCompareMask(buf->commandBuffer(), VK_STENCIL_FACE_FRONT_BIT, desc.frontFaceStencil->readMask);
-			DynamicVK::vkCmdSetStencilWriteMask(buf->commandBuffer(), VK_STENCIL_FACE_FRONT_BIT, desc.frontFaceStencil->writeMask);
-
-			DynamicVK::vkCmdSetStencilOp(
-				buf->commandBuffer(),
-				VK_STENCIL_FACE_FRONT_BIT,
-				stencilOperationToVkStencilOp(desc.frontFaceStencil->stencilFailureOperation),
-				stencilOperationToVkStencilOp(desc.frontFaceStencil->depthStencilPassOperation),
-				stencilOperationToVkStencilOp(desc.frontFaceStencil->depthFailureOperation),
-				compareFunctionToVkCompareOp(desc.frontFaceStencil->stencilCompareFunction)
-			);
-		} else {
-			DynamicVK::vkCmdSetStencilOp(buf->commandBuffer(), VK_STENCIL_FACE_FRONT_BIT, VK_STENCIL_OP_KEEP, VK_STENCIL_OP_KEEP, VK_STENCIL_OP_KEEP, VK_COMPARE_OP_ALWAYS);
-		}
-		if (desc.backFaceStencil) {
-			DynamicVK::vkCmdSetStencilCompareMask(buf->commandBuffer(), VK_STENCIL_FACE_BACK_BIT, desc.backFaceStencil->readMask);
-			DynamicVK::vkCmdSetStencilWriteMask(buf->commandBuffer(), VK_STENCIL_FACE_BACK_BIT, desc.backFaceStencil->writeMask);
-
-			DynamicVK::vkCmdSetStencilOp(
-				buf->commandBuffer(),
-				VK_STENCIL_FACE_BACK_BIT,
-				stencilOperationToVkStencilOp(desc.backFaceStencil->stencilFailureOperation),
-				stencilOperationToVkStencilOp(desc.backFaceStencil->depthStencilPassOperation),
-				stencilOperationToVkStencilOp(desc.backFaceStencil->depthFailureOperation),
-				compareFunctionToVkCompareOp(desc.backFaceStencil->stencilCompareFunction)
-			);
-		} else {
-			DynamicVK::vkCmdSetStencilOp(buf->commandBuffer(), VK_STENCIL_FACE_BACK_BIT, VK_STENCIL_OP_KEEP, VK_STENCIL_OP_KEEP, VK_STENCIL_OP_KEEP, VK_COMPARE_OP_ALWAYS);
+	bool depthWriteEnable = desc.depthWriteEnabled;
+	auto depthCompareOp = compareFunctionToVkCompareOp(desc.depthCompareFunction);
+	bool stencilTestEnable = desc.frontFaceStencil || desc.backFaceStencil;
+
+	if (updateShadowState(_shadowState.depthWriteEnable, depthWriteEnable)) {
+		DynamicVK::vkCmdSetDepthWriteEnable(buf->commandBuffer(), depthWriteEnable ? VK_TRUE : VK_FALSE);
+	}
+	if (updateShadowState(_shadowState.depthCompareOp, depthCompareOp)) {
+		DynamicVK::vkCmdSetDepthCompareOp(buf->commandBuffer(), depthCompareOp);
+	}
+	if (updateShadowState(_shadowState.depthTestEnable, true)) {
+		DynamicVK::vkCmdSetDepthTestEnable(buf->commandBuffer(), VK_TRUE);
+	}
+
+	if (updateShadowState(_shadowState.stencilTestEnable, stencilTestEnable)) {
+		DynamicVK::vkCmdSetStencilTestEnable(buf->commandBuffer(), stencilTestEnable ? VK_TRUE : VK_FALSE);
+	}
+
+	if (stencilTestEnable) {
+		setStencilFace(VK_STENCIL_FACE_FRONT_BIT, 0, desc.frontFaceStencil);
+		setStencilFace(VK_STENCIL_FACE_BACK_BIT, 1, desc.backFaceStencil);
+	}
+};
+
+void Indium::PrivateRenderCommandEncoder::setStencilFace(VkStencilFaceFlags face, size_t faceIndex, const std::optional<StencilDescriptor>& stencil) {
+	auto buf = _privateCommandBuffer.lock();
+
+	StencilOpState opState { VK_STENCIL_OP_KEEP, VK_STENCIL_OP_KEEP, VK_STENCIL_OP_KEEP, VK_COMPARE_OP_ALWAYS };
+
+	if (stencil) {
+		if (updateShadowState(_shadowState.stencilCompareMask[faceIndex], stencil->readMask)) {
+			DynamicVK::vkCmdSetStencilCompareMask(buf->commandBuffer(), face, stencil->readMask);
+		}
+		if (updateShadowState(_shadowState.stencilWriteMask[faceIndex], stencil->writeMask)) {
+			DynamicVK::vkCmdSetStencilWriteMask(buf->commandBuffer(), face, stencil->writeMask);
 		}
+
+		opState.failOp = stencilOperationToVkStencilOp(stencil->stencilFailureOperation);
+		opState.passOp = stencilOperationToVkStencilOp(stencil->depthStencilPassOperation);
+		opState.depthFailOp = stencilOperationToVkStencilOp(stencil->depthFailureOperation);
+		opState.compareOp = compareFunctionToVkCompareOp(stencil->stencilCompareFunction);
+	}
+
+	if (updateShadowState(_shadowState.stencilOp[faceIndex], opState)) {
+		DynamicVK::vkCmdSetStencilOp(buf->commandBuffer(), face, opState.failOp, opState.passOp, opState.depthFailOp, opState.compareOp);
 	}
 };
 
 void Indium::PrivateRenderCommandEncoder::setTriangleFillMode(TriangleFillMode triangleFillMode) {
-	if (triangleFillMode != TriangleFillMode::Fill) {
-		// we might have to just create duplicate pipelines for each possible fill mode;
-		// there's only 2 at the moment, but this has to multiplied by the number of pipelines required
-		// for other combinations. for example, we currently have to create a pipeline for each topology class
-		// and there's 3 of those, so we would need 6 pipelines total. yikes.
-		throw std::runtime_error("TODO: support changing fill mode");
+	auto polygonMode = (triangleFillMode == TriangleFillMode::Lines) ? VK_POLYGON_MODE_LINE : VK_POLYGON_MODE_FILL;
+
+	if (!(_privateDevice->features() & PrivateDevice::Feature::ExtendedDynamicState3)) {
+		if (polygonMode != VK_POLYGON_MODE_FILL && !(_privateDevice->features() & PrivateDevice::Feature::FillModeNonSolid)) {
+			throw std::runtime_error("Line fill mode isn't supported by this device");
+		}
+
+		// without VK_EXT_extended_dynamic_state3, each fill mode needs its own pipelines (for each topology class and set of attachments),
+		// so they're only compiled for the fill modes that are actually used. the next draw has to look up one with the new fill mode.
+		if (_rasterizationKey.polygonMode != polygonMode) {
+			_rasterizationKey.polygonMode = polygonMode;
+			_pipelinesByTopologyClass.fill(VK_NULL_HANDLE);
+		}
+		return;
+	}
+
+	auto buf = _privateCommandBuffer.lock();
+
+	if (updateShadowState(_shadowState.polygonMode, polygonMode)) {
+		DynamicVK::vkCmdSetPolygonModeEXT(buf->commandBuffer(), polygonMode);
 	}
 };
 
 void Indium::PrivateRenderCommandEncoder::setStencilReferenceValue(uint32_t value) {
 	auto buf = _privateCommandBuffer.lock();
-	DynamicVK::vkCmdSetStencilReference(buf->commandBuffer(), VK_STENCIL_FACE_FRONT_AND_BACK, value);
+
+	if (filterCommand(_shadowState.stencilReference[0] != value || _shadowState.stencilReference[1] != value)) {
+		DynamicVK::vkCmdSetStencilReference(buf->commandBuffer(), VK_STENCIL_FACE_FRONT_AND_BACK, value);
+		_shadowState.stencilReference[0] = value;
+		_shadowState.stencilReference[1] = value;
+	}
 };
 
 void Indium::PrivateRenderCommandEncoder::setStencilReferenceValue(uint32_t front, uint32_t back) {
+	setStencilReference(VK_STENCIL_FACE_FRONT_BIT, 0, front);
+	setStencilReference(VK_STENCIL_FACE_BACK_BIT, 1, back);
+};
+
+void Indium::PrivateRenderCommandEncoder::setStencilReference(VkStencilFaceFlags face, size_t faceIndex, uint32_t value) {
 	auto buf = _privateCommandBuffer.lock();
-	DynamicVK::vkCmdSetStencilReference(buf->commandBuffer(), VK_STENCIL_FACE_FRONT_BIT, front);
-	DynamicVK::vkCmdSetStencilReference(buf->commandBuffer(), VK_STENCIL_FACE_BACK_BIT, back);
+	if (updateShadowState(_shadowState.stencilReference[faceIndex], value)) {
+		DynamicVK::vkCmdSetStencilReference(buf->commandBuffer(), face, value);
+	}
+};
+
+Indium::RenderCommandCounters Indium::PrivateRenderCommandEncoder::commandCounters() const {
+	return _commandCounters;
 };
 
 void Indium::PrivateRenderCommandEncoder::setVisibilityResultMode(VisibilityResultMode mode, size_t offset) {
 	auto buf = _privateCommandBuffer.lock();
 
-	// TODO: this can be implemented using Vulkan's occlusion queries
-	throw std::runtime_error("TODO: support visibility results");
+	// the query that's already running can just keep counting
+	if (mode == _visibilityResultMode && (mode == VisibilityResultMode::Disabled || offset == _visibilityResultOffset)) {
+		return;
+	}
+
+	endVisibilityQuery();
+
+	if (mode == VisibilityResultMode::Disabled) {
+		return;
+	}
+
+	if (!_descriptor.visibilityResultBuffer) {
+		throw std::runtime_error("Render pass has no visibility result buffer");
+	}
+
+	if (offset % 8 != 0 || offset + 8 > _descriptor.visibilityResultBuffer->length()) {
+		throw std::runtime_error("Invalid visibility result offset");
+	}
+
+	// we reset query pools on the host; see PrivateDevice::recycleOcclusionQueryPool()
+	if (!(_privateDevice->features() & PrivateDevice::Feature::HostQueryReset)) {
+		throw std::runtime_error("Device does not support visibility results");
+	}
+
+	if (mode == VisibilityResultMode::Counting && !(_privateDevice->features() & PrivateDevice::Feature::PreciseOcclusionQuery)) {
+		throw std::runtime_error("Device does not support counting visibility results");
+	}
+
+	size_t queryNumber = _visibilityQueryOffsets.size();
+	if (queryNumber % PrivateDevice::occlusionQueryPoolSize == 0) {
+		_visibilityQueryPools.push_back(_privateDevice->takeOcclusionQueryPool());
+	}
+	_visibilityQueryOffsets.push_back(offset);
+
+	// each query can only be used once per render pass (they can't be reset inside one), so reusing an offset takes another query
+	_visibilityQueryReuseIndices.push_back(_visibilityResultOffsetQueryCounts[offset]++);
+
+	// without the precise flag, the query only needs to tell us whether any samples passed
+	VkQueryControlFlags flags = (mode == VisibilityResultMode::Counting) ? VK_QUERY_CONTROL_PRECISE_BIT : 0;
+	DynamicVK::vkCmdBeginQuery(buf->commandBuffer(), _visibilityQueryPools.back(), queryNumber % PrivateDevice::occlusionQueryPoolSize, flags);
+
+	_visibilityResultMode = mode;
+	_visibilityResultOffset = offset;
+};
+
+void Indium::PrivateRenderCommandEncoder::endVisibilityQuery() {
+	if (_visibilityResultMode == VisibilityResultMode::Disabled) {
+		return;
+	}
+
+	auto buf = _privateCommandBuffer.lock();
+	size_t queryNumber = _visibilityQueryOffsets.size() - 1;
+	DynamicVK::vkCmdEndQuery(buf->commandBuffer(), _visibilityQueryPools.back(), queryNumber % PrivateDevice::occlusionQueryPoolSize);
+
+	_visibilityResultMode = VisibilityResultMode::Disabled;
+};
+
+void Indium::PrivateRenderCommandEncoder::copyVisibilityResults() {
+	if (_visibilityQueryOffsets.empty()) {
+		return;
+	}
+
+	auto buf = _privateCommandBuffer.lock();
+	auto visibilityResultBuffer = std::dynamic_pointer_cast<PrivateBuffer>(_descriptor.visibilityResultBuffer);
+
+	// the first query for each offset is copied straight into the visibility result buffer.
+	// the results of any later queries for the same offset are copied into scratch memory (in query order) and added to it afterwards.
+	size_t reusedQueryCount = 0;
+	size_t maxReuseIndex = 0;
+	for (auto reuseIndex: _visibilityQueryReuseIndices) {
+		if (reuseIndex > 0) {
+			++reusedQueryCount;
+		}
+		maxReuseIndex = std::max(maxReuseIndex, reuseIndex);
+	}
+
+	std::pair<PrivateBuffer*, size_t> scratch {};
+	if (reusedQueryCount > 0) {
+		scratch = buf->uploadHeap().allocate(reusedQueryCount * sizeof(uint64_t));
+	}
+
+	// queries that are next to each other in the same pool and were written to consecutive offsets (the usual case: one offset per object)
+	// are copied together
+	size_t scratchIndex = 0;
+	for (size_t first = 0; first < _visibilityQueryOffsets.size();) {
+		auto pool = _visibilityQueryPools[first / PrivateDevice::occlusionQueryPoolSize];
+
+		// Metal's visibility results are 64-bit values
+		if (_visibilityQueryReuseIndices[first] > 0) {
+			DynamicVK::vkCmdCopyQueryPoolResults(buf->commandBuffer(), pool, first % PrivateDevice::occlusionQueryPoolSize, 1, scratch.first->buffer(), scratch.second + scratchIndex * sizeof(uint64_t), 8, VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+			++scratchIndex;
+			++first;
+			continue;
+		}
+
+		size_t count = 1;
+		while (
+			first + count < _visibilityQueryOffsets.size() &&
+			(first + count) % PrivateDevice::occlusionQueryPoolSize != 0 &&
+			_visibilityQueryOffsets[first + count] == _visibilityQueryOffsets[first] + (count * 8) &&
+			_visibilityQueryReuseIndices[first + count] == 0
+		) {
+			++count;
+		}
+
+		DynamicVK::vkCmdCopyQueryPoolResults(buf->commandBuffer(), pool, first % PrivateDevice::occlusionQueryPoolSize, count, visibilityResultBuffer->buffer(), _visibilityQueryOffsets[first], 8, VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+
+		first += count;
+	}
+
+	VkPipelineStageFlags writeStages = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	VkAccessFlags writeAccess = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+	if (reusedQueryCount > 0) {
+		// the scratch results are added to the buffer with a tiny compute shader (one threadgroup per addition). Boolean results are only guaranteed to be
+		// non-zero when any samples passed, and the sum of those is still non-zero in that case, so summing works for both modes (even when they're mixed).
+		//
+		// additions for the same offset can't run concurrently, so they're done in rounds: round N adds the Nth reused query for every offset,
+		// and each round waits for the previous one.
+		auto [pipeline, layout] = _privateDevice->accumulatePipeline();
+
+		VkMemoryBarrier barrier {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		DynamicVK::vkCmdPipelineBarrier(buf->commandBuffer(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		DynamicVK::vkCmdBindPipeline(buf->commandBuffer(), VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+
+		auto scratchAddress = scratch.first->gpuAddress() + scratch.second;
+		auto resultAddress = visibilityResultBuffer->gpuAddress();
+
+		for (size_t round = 1; round <= maxReuseIndex; ++round) {
+			if (round > 1) {
+				barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+				DynamicVK::vkCmdPipelineBarrier(buf->commandBuffer(), VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+			}
+
+			scratchIndex = 0;
+			for (size_t query = 0; query < _visibilityQueryOffsets.size(); ++query) {
+				if (_visibilityQueryReuseIndices[query] == 0) {
+					continue;
+				}
+
+				if (_visibilityQueryReuseIndices[query] == round) {
+					std::array<uint64_t, 2> addresses { scratchAddress + scratchIndex * sizeof(uint64_t), resultAddress + _visibilityQueryOffsets[query] };
+					DynamicVK::vkCmdPushConstants(buf->commandBuffer(), layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(addresses), addresses.data());
+					DynamicVK::vkCmdDispatch(buf->commandBuffer(), 1, 1, 1);
+				}
+
+				++scratchIndex;
+			}
+		}
+
+		writeStages |= VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		writeAccess |= VK_ACCESS_SHADER_WRITE_BIT;
+	}
+
+	// make the results visible to whatever reads them next (on the GPU or on the CPU once the command buffer completes)
+	VkBufferMemoryBarrier barrier {};
+	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier.srcAccessMask = writeAccess;
+	barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.buffer = visibilityResultBuffer->buffer();
+	barrier.offset = 0;
+	barrier.size = VK_WHOLE_SIZE;
+
+	DynamicVK::vkCmdPipelineBarrier(buf->commandBuffer(), writeStages, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
 };
 
 void Indium::PrivateRenderCommandEncoder::useResource(std::shared_ptr<Resource> resource, ResourceUsage usage, RenderStages stages) {
@@ -604,8 +1485,9 @@ void Indium::PrivateRenderCommandEncoder::useResources(const std::vector<std::sh
 
 	auto buf = _privateCommandBuffer.lock();
 
-	std::vector<VkBufferMemoryBarrier> bufferBarriers;
-	std::vector<VkImageMemoryBarrier> imageBarriers;
+	TransientArena::Scope arenaScope(buf->arena());
+	std::pmr::vector<VkBufferMemoryBarrier> bufferBarriers(&buf->arena());
+	std::pmr::vector<VkImageMemoryBarrier> imageBarriers(&buf->arena());
 
 	// TODO: relax this mask, maybe; it depends on what Metal does here.
 	VkAccessFlags source = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
@@ -694,3 +1576,14 @@ void Indium::PrivateRenderCommandEncoder::useResources(const std::vector<std::sh
 	// TODO: check what Metal does in this case. this is just an educated guess
 	useResources(resources, usage, RenderStages::Vertex | RenderStages::Fragment | RenderStages::Tile | RenderStages::Object | RenderStages::Mesh);
 };
+
+void Indium::PrivateRenderCommandEncoder::updateFence(std::shared_ptr<Fence> fence, RenderStages afterStages) {
+	// the actual update is recorded once the render pass ends (we can't record a barrier like this inside it).
+	// TODO: relax this depending on `afterStages`; for now, we just wait for the whole pass to finish.
+	_fenceUpdateStages |= VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT;
+};
+
+void Indium::PrivateRenderCommandEncoder::waitForFence(std::shared_ptr<Fence> fence, RenderStages beforeStages) {
+	// nothing to do here; the encoder that updated the fence already blocks everything after it on the queue.
+	// see PrivateFence for details.
+};
@@ -1,6 +1,7 @@
 #include <indium/render-pipeline.private.hpp>
 #include <indium/device.private.hpp>
 #include <indium/library.private.hpp>
+#include <indium/pipeline-manifest.private.hpp>
 #include <indium/types.private.hpp>
 #include <indium/dynamic-vk.hpp>
 
@@ -19,68 +20,23 @@ Indium::PrivateRenderPipelineState::PrivateRenderPipelineState(std::shared_ptr<P
 	_colorAttachments = descriptor.colorAttachments;
 	_vertexDescriptor = descriptor.vertexDescriptor;
 	_primitiveTopology = descriptor.inputPrimitiveTopology;
+	_alphaToCoverageEnabled = descriptor.alphaToCoverageEnabled;
 
 	_vertexFunction = std::dynamic_pointer_cast<PrivateFunction>(descriptor.vertexFunction);
 	_fragmentFunction = std::dynamic_pointer_cast<PrivateFunction>(descriptor.fragmentFunction);
 
-	_descriptorSetLayouts.processFunction(_vertexFunction, 0);
-	_descriptorSetLayouts.processFunction(_fragmentFunction, 1);
-};
-
-Indium::PrivateRenderPipelineState::~PrivateRenderPipelineState() {
-	if (_pipelines[0]) {
-		for (auto& pipeline: _pipelines) {
-			DynamicVK::vkDestroyPipeline(_privateDevice->device(), pipeline, nullptr);
-			pipeline = VK_NULL_HANDLE;
-		}
-	}
+	_manifestKey = renderPipelineManifestKey(descriptor);
 
-	if (_pipelineLayout) {
-		DynamicVK::vkDestroyPipelineLayout(_privateDevice->device(), _pipelineLayout, nullptr);
-		_pipelineLayout = VK_NULL_HANDLE;
-	}
-};
-
-void Indium::PrivateRenderPipelineState::recreatePipeline(VkRenderPass compatibleRenderPass, bool force) {
-	if (!force && _pipelines[0]) {
-		// assumes that the current pipeline is compatible with the given render pass
-		return;
-	}
-
-	if (_pipelines[0]) {
-		for (auto& pipeline: _pipelines) {
-			DynamicVK::vkDestroyPipeline(_privateDevice->device(), pipeline, nullptr);
-			pipeline = VK_NULL_HANDLE;
-		}
-	}
+	_descriptorSetLayouts.processFunction(_vertexFunction, 0);
+	// only one set in a pipeline layout can use push descriptors; the fragment set is the one that's most likely to change between draws (textures and samplers)
+	_descriptorSetLayouts.processFunction(_fragmentFunction, 1, true);
 
-	if (_pipelineLayout) {
-		DynamicVK::vkDestroyPipelineLayout(_privateDevice->device(), _pipelineLayout, nullptr);
-		_pipelineLayout = VK_NULL_HANDLE;
+	for (const auto& colorInfo: _colorAttachments) {
+		_defaultAttachmentKey.colorFormats.push_back(pixelFormatToVkFormat(colorInfo.pixelFormat));
 	}
-
-	auto vertexFunctionName = _vertexFunction->name();
-	auto fragmentFunctionName = _fragmentFunction->name();
-	std::vector<VkPipelineShaderStageCreateInfo> stages;
-
-	VkPipelineShaderStageCreateInfo shaderStage {};
-	shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-
-	shaderStage.stage = VK_SHADER_STAGE_VERTEX_BIT;
-	shaderStage.module = _vertexFunction->library()->shaderModule();
-	shaderStage.pName = vertexFunctionName.c_str();
-	stages.push_back(shaderStage);
-
-	shaderStage.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-	shaderStage.module = _fragmentFunction->library()->shaderModule();
-	shaderStage.pName = fragmentFunctionName.c_str();
-	stages.push_back(shaderStage);
-
-	VkPipelineVertexInputStateCreateInfo vertexInputState {};
-	vertexInputState.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-
-	std::vector<VkVertexInputBindingDescription> vertexBindingDescs;
-	std::vector<VkVertexInputAttributeDescription> vertexAttrDescs;
+	_defaultAttachmentKey.depthFormat = (descriptor.depthAttachmentPixelFormat == PixelFormat::Invalid) ? VK_FORMAT_UNDEFINED : pixelFormatToVkFormat(descriptor.depthAttachmentPixelFormat);
+	_defaultAttachmentKey.stencilFormat = (descriptor.stencilAttachmentPixelFormat == PixelFormat::Invalid) ? VK_FORMAT_UNDEFINED : pixelFormatToVkFormat(descriptor.stencilAttachmentPixelFormat);
+	_defaultAttachmentKey.sampleCount = descriptor.rasterSampleCount;
 
 	if (_vertexDescriptor) {
 		const auto& desc = *_vertexDescriptor;
@@ -107,7 +63,7 @@ void Indium::PrivateRenderPipelineState::recreatePipeline(VkRenderPass compatibl
 			bindingDesc.stride = layout.stride;
 			bindingDesc.inputRate = (layout.stepFunction == VertexStepFunction::PerVertex) ? VK_VERTEX_INPUT_RATE_VERTEX : VK_VERTEX_INPUT_RATE_INSTANCE;
 
-			vertexBindingDescs.push_back(bindingDesc);
+			_vertexBindingDescriptions.push_back(bindingDesc);
 		}
 
 		for (const auto& [index, attr]: desc.attributes) {
@@ -118,7 +74,7 @@ void Indium::PrivateRenderPipelineState::recreatePipeline(VkRenderPass compatibl
 			attrDesc.format = vertexFormatToVkFormat(attr.format);
 			attrDesc.offset = attr.offset;
 
-			vertexAttrDescs.push_back(attrDesc);
+			_vertexAttributeDescriptions.push_back(attrDesc);
 		}
 
 		_vertexInputBindings.resize(currIndex);
@@ -128,14 +84,152 @@ void Indium::PrivateRenderPipelineState::recreatePipeline(VkRenderPass compatibl
 		}
 	}
 
-	vertexInputState.vertexBindingDescriptionCount = vertexBindingDescs.size();
-	vertexInputState.pVertexBindingDescriptions = vertexBindingDescs.data();
-	vertexInputState.vertexAttributeDescriptionCount = vertexAttrDescs.size();
-	vertexInputState.pVertexAttributeDescriptions = vertexAttrDescs.data();
+	std::vector<VkPushConstantRange> pushConstantRanges;
+	for (const auto& function: { _vertexFunction, _fragmentFunction }) {
+		if (function->functionInfo().pushConstantRange.size > 0) {
+			pushConstantRanges.push_back(function->functionInfo().pushConstantRange);
+		}
+	}
+
+	_sharedPipelineLayout = _descriptorSetLayouts.pipelineLayout(pushConstantRanges);
+	_pipelineLayout = _sharedPipelineLayout->layout;
+	_descriptorSetLayouts.createUpdateTemplates(_pipelineLayout, VK_PIPELINE_BIND_POINT_GRAPHICS);
+
+	// we use dynamic rendering, so all we need to know about the attachments is their formats (which we're given in the descriptor).
+	// that means we can compile the pipeline we're most likely to need right away rather than waiting for a render pass to use it with.
+	// other variants (e.g. for other topology classes) are compiled the first time they're used.
+	pipeline((_primitiveTopology == PrimitiveTopologyClass::Unspecified) ? PrimitiveTopologyClass::Triangle : _primitiveTopology, _defaultAttachmentKey);
+};
+
+Indium::PrivateRenderPipelineState::~PrivateRenderPipelineState() {
+	auto destroyPipeline = [this](const auto& key, VkPipeline pipeline) {
+		DynamicVK::vkDestroyPipeline(_privateDevice->device(), pipeline, nullptr);
+	};
+
+	_pipelines.forEach(destroyPipeline);
+
+	// linked pipelines don't depend on their libraries once they've been created, so the order doesn't matter here
+	_vertexInputLibraries.forEach(destroyPipeline);
+	_preRasterizationLibraries.forEach(destroyPipeline);
+	_fragmentShaderLibraries.forEach(destroyPipeline);
+	_fragmentOutputLibraries.forEach(destroyPipeline);
+};
+
+VkPipeline Indium::PrivateRenderPipelineState::pipeline(PrimitiveTopologyClass topologyClass, const RenderAttachmentKey& attachmentKey, const RasterizationKey& rasterizationKey) {
+	_privateDevice->recordRenderPipelineVariant(_manifestKey, topologyClass, attachmentKey, rasterizationKey);
+
+	RenderPipelineVariantKey key { topologyClass, attachmentKey, rasterizationKey };
+
+	// if the device lets us dynamically switch to a topology in a different class, a single pipeline can be used for all topology classes
+	if (!!(_privateDevice->features() & PrivateDevice::Feature::UnrestrictedPrimitiveTopology)) {
+		key.topologyClass = PrimitiveTopologyClass::Triangle;
+	}
+
+	// likewise, the rasterization state is dynamic with VK_EXT_extended_dynamic_state3
+	if (!!(_privateDevice->features() & PrivateDevice::Feature::ExtendedDynamicState3)) {
+		key.rasterizationKey = RasterizationKey {};
+	}
+
+	// only requests for the same variant wait for each other; lookups of compiled variants and compiles of other variants don't
+	return _pipelines.get(key, [&]() {
+		return !!(_privateDevice->features() & PrivateDevice::Feature::GraphicsPipelineLibrary) ? linkPipeline(key) : compilePipeline(key);
+	});
+};
+
+VkPipeline Indium::PrivateRenderPipelineState::linkPipeline(const RenderPipelineVariantKey& key) {
+	// each part is only affected by some of the variant's properties, so we only need to compile each part once for each distinct value of those properties.
+	// for the parts that ignore some of the properties we pass in, whatever we pass in is ignored.
+
+	auto vertexInputLibrary = _vertexInputLibraries.get(key.topologyClass, [&]() {
+		return compilePipeline(key, VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT);
+	});
+
+	// the rasterization state belongs to the pre-rasterization part
+	auto preRasterizationLibrary = _preRasterizationLibraries.get(key.rasterizationKey, [&]() {
+		return compilePipeline(key, VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT);
+	});
+
+	auto fragmentShaderLibrary = _fragmentShaderLibraries.get(key.attachmentKey.sampleCount, [&]() {
+		return compilePipeline(key, VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT);
+	});
+
+	auto fragmentOutputLibrary = _fragmentOutputLibraries.get(key.attachmentKey, [&]() {
+		return compilePipeline(key, VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT);
+	});
+
+	std::array<VkPipeline, 4> libraries { vertexInputLibrary, preRasterizationLibrary, fragmentShaderLibrary, fragmentOutputLibrary };
+
+	VkPipelineLibraryCreateInfoKHR libraryInfo {};
+	libraryInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+	libraryInfo.libraryCount = libraries.size();
+	libraryInfo.pLibraries = libraries.data();
+
+	// we don't ask for link-time optimization here; the whole point is to make linking as fast as possible
+	VkGraphicsPipelineCreateInfo pipelineCreateInfo {};
+	pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineCreateInfo.pNext = &libraryInfo;
+	pipelineCreateInfo.layout = _pipelineLayout;
+
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	auto pipelineCacheLock = _privateDevice->lockPipelineCache();
+	if (DynamicVK::vkCreateGraphicsPipelines(_privateDevice->device(), _privateDevice->pipelineCache(), 1, &pipelineCreateInfo, nullptr, &pipeline) != VK_SUCCESS) {
+		// TODO
+		abort();
+	}
+
+	return pipeline;
+};
+
+VkPipeline Indium::PrivateRenderPipelineState::compilePipeline(const RenderPipelineVariantKey& key, VkGraphicsPipelineLibraryFlagsEXT libraryParts) {
+	const auto& attachmentKey = key.attachmentKey;
+	auto vertexFunctionName = _vertexFunction->name();
+	auto fragmentFunctionName = _fragmentFunction->name();
+	std::vector<VkPipelineShaderStageCreateInfo> stages;
+
+	VkPipelineShaderStageCreateInfo shaderStage {};
+	shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+
+	// pipeline library parts must only include the stages that belong to them
+	if (libraryParts == 0 || (libraryParts & VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT)) {
+		shaderStage.stage = VK_SHADER_STAGE_VERTEX_BIT;
+		shaderStage.module = _vertexFunction->library()->shaderModule();
+		shaderStage.pName = vertexFunctionName.c_str();
+		stages.push_back(shaderStage);
+	}
+
+	if (libraryParts == 0 || (libraryParts & VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT)) {
+		shaderStage.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+		shaderStage.module = _fragmentFunction->library()->shaderModule();
+		shaderStage.pName = fragmentFunctionName.c_str();
+		stages.push_back(shaderStage);
+	}
+
+	VkPipelineVertexInputStateCreateInfo vertexInputState {};
+	vertexInputState.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertexInputState.vertexBindingDescriptionCount = _vertexBindingDescriptions.size();
+	vertexInputState.pVertexBindingDescriptions = _vertexBindingDescriptions.data();
+	vertexInputState.vertexAttributeDescriptionCount = _vertexAttributeDescriptions.size();
+	vertexInputState.pVertexAttributeDescriptions = _vertexAttributeDescriptions.data();
 
 	VkPipelineInputAssemblyStateCreateInfo inputAssemblyState {};
 	inputAssemblyState.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
 
+	// we can set the primitive topology dynamically, but unfortunately, we can usually only set it for a different topology
+	// in the same topology class that the pipeline was created for. this means we need a separate pipeline for each topology class
+	// (unless the device supports `dynamicPrimitiveTopologyUnrestricted`; see pipeline()).
+	switch (key.topologyClass) {
+		case PrimitiveTopologyClass::Point:
+			inputAssemblyState.topology = VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+			break;
+		case PrimitiveTopologyClass::Line:
+			inputAssemblyState.topology = VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+			break;
+		case PrimitiveTopologyClass::Triangle:
+			inputAssemblyState.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+			break;
+		default:
+			throw BadEnumValue();
+	}
 	VkPipelineTessellationStateCreateInfo tesselationState {};
 	tesselationState.sType = VK_STRUCTURE_TYPE_PIPELINE_TESSELLATION_STATE_CREATE_INFO;
 
@@ -144,22 +238,31 @@ void Indium::PrivateRenderPipelineState::recreatePipeline(VkRenderPass compatibl
 
 	VkPipelineRasterizationStateCreateInfo rasterizationState {};
 	rasterizationState.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-	// TODO: figure out how to set `depthClampEnable` and `polgygonMode` dynamically;
-	//       might have to just create multiple pipelines
-	rasterizationState.polygonMode = VK_POLYGON_MODE_FILL;
+	// these are dynamic with VK_EXT_extended_dynamic_state3 (in which case the key always has the defaults);
+	// otherwise, each combination the render command encoder uses gets its own pipeline.
+	rasterizationState.polygonMode = key.rasterizationKey.polygonMode;
+	rasterizationState.depthClampEnable = key.rasterizationKey.depthClampEnable;
 	rasterizationState.lineWidth = 1.0f;
 
 	VkPipelineMultisampleStateCreateInfo multisampleState {};
 	multisampleState.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-	multisampleState.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+	multisampleState.rasterizationSamples = static_cast<VkSampleCountFlagBits>(attachmentKey.sampleCount);
 	multisampleState.minSampleShading = 1.0f;
+	multisampleState.alphaToCoverageEnable = _alphaToCoverageEnabled;
 
 	VkPipelineDepthStencilStateCreateInfo depthStencilState {};
 	depthStencilState.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
 
+	// the blend state has to match the attachments we're actually rendering to (from the variant key), not the descriptor;
+	// attachments the descriptor doesn't describe get blending disabled and nothing written to them.
 	std::vector<VkPipelineColorBlendAttachmentState> colorBlendStates;
-	for (const auto& colorInfo: _colorAttachments) {
-		VkPipelineColorBlendAttachmentState tmp;
+	for (size_t i = 0; i < attachmentKey.colorFormats.size(); ++i) {
+		VkPipelineColorBlendAttachmentState tmp {};
+		if (i >= _colorAttachments.size()) {
+			colorBlendStates.push_back(tmp);
+			continue;
+		}
+		const auto& colorInfo = _colorAttachments[i];
 		tmp.blendEnable = colorInfo.blendingEnabled;
 		tmp.srcColorBlendFactor = blendFactorToVkBlendFactor(colorInfo.sourceRGBBlendFactor);
 		tmp.dstColorBlendFactor = blendFactorToVkBlendFactor(colorInfo.destinationRGBBlendFactor);
@@ -199,27 +302,35 @@ void Indium::PrivateRenderPipelineState::recreatePipeline(VkRenderPass compatibl
 		VK_DYNAMIC_STATE_BLEND_CONSTANTS,
 		VK_DYNAMIC_STATE_RASTERIZER_DISCARD_ENABLE,
 	};
+	if (!!(_privateDevice->features() & PrivateDevice::Feature::ExtendedDynamicState3)) {
+		dynamicStates.push_back(VK_DYNAMIC_STATE_POLYGON_MODE_EXT);
+		dynamicStates.push_back(VK_DYNAMIC_STATE_DEPTH_CLAMP_ENABLE_EXT);
+	}
 	VkPipelineDynamicStateCreateInfo dynamicState {};
 	dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
 	dynamicState.dynamicStateCount = dynamicStates.size();
 	dynamicState.pDynamicStates = dynamicStates.data();
 
-	std::vector<VkPushConstantRange> pushConstantRanges;
+	VkPipelineRenderingCreateInfo renderingCreateInfo {};
+	renderingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+	renderingCreateInfo.colorAttachmentCount = attachmentKey.colorFormats.size();
+	renderingCreateInfo.pColorAttachmentFormats = attachmentKey.colorFormats.data();
+	renderingCreateInfo.depthAttachmentFormat = attachmentKey.depthFormat;
+	renderingCreateInfo.stencilAttachmentFormat = attachmentKey.stencilFormat;
 
-	VkPipelineLayoutCreateInfo layoutCreateInfo {};
-	layoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	layoutCreateInfo.setLayoutCount = _descriptorSetLayouts.layouts.size();
-	layoutCreateInfo.pSetLayouts = _descriptorSetLayouts.layouts.data();
-	layoutCreateInfo.pushConstantRangeCount = pushConstantRanges.size();
-	layoutCreateInfo.pPushConstantRanges = pushConstantRanges.data();
+	// state that doesn't belong to the library parts we're compiling is ignored, so we can just fill everything in regardless
+	VkGraphicsPipelineLibraryCreateInfoEXT libraryCreateInfo {};
+	libraryCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+	libraryCreateInfo.flags = libraryParts;
 
-	if (DynamicVK::vkCreatePipelineLayout(_privateDevice->device(), &layoutCreateInfo, nullptr, &_pipelineLayout) != VK_SUCCESS) {
-		// TODO
-		abort();
+	if (libraryParts != 0) {
+		renderingCreateInfo.pNext = &libraryCreateInfo;
 	}
 
 	VkGraphicsPipelineCreateInfo pipelineCreateInfo {};
 	pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineCreateInfo.pNext = &renderingCreateInfo;
+	pipelineCreateInfo.flags = (libraryParts != 0) ? VK_PIPELINE_CREATE_LIBRARY_BIT_KHR : 0;
 	pipelineCreateInfo.stageCount = stages.size();
 	pipelineCreateInfo.pStages = stages.data();
 	pipelineCreateInfo.pVertexInputState = &vertexInputState;
@@ -232,32 +343,16 @@ void Indium::PrivateRenderPipelineState::recreatePipeline(VkRenderPass compatibl
 	pipelineCreateInfo.pColorBlendState = &colorBlendState;
 	pipelineCreateInfo.pDynamicState = &dynamicState;
 	pipelineCreateInfo.layout = _pipelineLayout;
-	pipelineCreateInfo.renderPass = compatibleRenderPass;
+	pipelineCreateInfo.renderPass = VK_NULL_HANDLE;
 
-	// we can set the primitive topology dynamically, but unfortunately, we can only set it for a different topology
-	// in the same topology class that the pipeline was created for. this means we need to create 3 pipelines
-	// (one for each topology class) rather than 5 (one for each primitive topology).
-
-	// first, one for points
-	inputAssemblyState.topology = VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
-	if (DynamicVK::vkCreateGraphicsPipelines(_privateDevice->device(), VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &_pipelines[0]) != VK_SUCCESS) {
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	auto pipelineCacheLock = _privateDevice->lockPipelineCache();
+	if (DynamicVK::vkCreateGraphicsPipelines(_privateDevice->device(), _privateDevice->pipelineCache(), 1, &pipelineCreateInfo, nullptr, &pipeline) != VK_SUCCESS) {
 		// TODO
 		abort();
 	}
 
-	// now, one for lines
-	inputAssemblyState.topology = VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
-	if (DynamicVK::vkCreateGraphicsPipelines(_privateDevice->device(), VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &_pipelines[1]) != VK_SUCCESS) {
-		// TODO
-		abort();
-	}
-
-	// finally, one for triangles
-	inputAssemblyState.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-	if (DynamicVK::vkCreateGraphicsPipelines(_privateDevice->device(), VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &_pipelines[2]) != VK_SUCCESS) {
-		// TODO
-		abort();
-	}
+	return pipeline;
 };
 
 const Indium::FunctionInfo& Indium::PrivateRenderPipelineState::vertexFunctionInfo() {
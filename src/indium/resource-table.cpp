@@ -0,0 +1,198 @@
+#include <indium/resource-table.private.hpp>
+#include <indium/dynamic-vk.hpp>
+
+#include <iridium/iridium.hpp>
+
+#include <array>
+#include <stdexcept>
+
+Indium::ResourceTable::ResourceTable(VkDevice device, uint32_t textureCapacity, uint32_t samplerCapacity):
+	_device(device),
+	_textureCapacity(textureCapacity),
+	_samplerCapacity(samplerCapacity)
+{
+	// the transient slots come from the end of the table
+	for (uint32_t i = 0; i < transientTextureSlots; ++i) {
+		_freeTransientTextureSlots.push_back(_textureCapacity + i);
+	}
+	for (uint32_t i = 0; i < transientSamplerSlots; ++i) {
+		_freeTransientSamplerSlots.push_back(_samplerCapacity + i);
+	}
+
+	std::array<VkDescriptorSetLayoutBinding, 2> bindings {};
+
+	bindings[0].binding = Iridium::resourceTableTextureBinding;
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+	bindings[0].descriptorCount = _textureCapacity + transientTextureSlots;
+	bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+
+	bindings[1].binding = Iridium::resourceTableSamplerBinding;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+	bindings[1].descriptorCount = _samplerCapacity + transientSamplerSlots;
+	bindings[1].stageFlags = VK_SHADER_STAGE_ALL;
+
+	// most of the table is empty most of the time, and we need to be able to fill in new slots while the table is in use
+	const VkDescriptorBindingFlags bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+	const std::array<VkDescriptorBindingFlags, 2> allBindingFlags { bindingFlags, bindingFlags };
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo {};
+	bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+	bindingFlagsInfo.bindingCount = allBindingFlags.size();
+	bindingFlagsInfo.pBindingFlags = allBindingFlags.data();
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.pNext = &bindingFlagsInfo;
+	layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+	layoutInfo.bindingCount = bindings.size();
+	layoutInfo.pBindings = bindings.data();
+
+	if (DynamicVK::vkCreateDescriptorSetLayout(_device, &layoutInfo, nullptr, &_setLayout) != VK_SUCCESS) {
+		// TODO
+		abort();
+	}
+
+	const std::array<VkDescriptorPoolSize, 2> poolSizes {
+		VkDescriptorPoolSize { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, _textureCapacity + transientTextureSlots },
+		VkDescriptorPoolSize { VK_DESCRIPTOR_TYPE_SAMPLER, _samplerCapacity + transientSamplerSlots },
+	};
+
+	VkDescriptorPoolCreateInfo poolInfo {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+	poolInfo.maxSets = 1;
+	poolInfo.poolSizeCount = poolSizes.size();
+	poolInfo.pPoolSizes = poolSizes.data();
+
+	if (DynamicVK::vkCreateDescriptorPool(_device, &poolInfo, nullptr, &_pool) != VK_SUCCESS) {
+		// TODO
+		abort();
+	}
+
+	VkDescriptorSetAllocateInfo allocateInfo {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocateInfo.descriptorPool = _pool;
+	allocateInfo.descriptorSetCount = 1;
+	allocateInfo.pSetLayouts = &_setLayout;
+
+	if (DynamicVK::vkAllocateDescriptorSets(_device, &allocateInfo, &_descriptorSet) != VK_SUCCESS) {
+		// TODO
+		abort();
+	}
+};
+
+Indium::ResourceTable::~ResourceTable() {
+	DynamicVK::vkDestroyDescriptorPool(_device, _pool, nullptr);
+	DynamicVK::vkDestroyDescriptorSetLayout(_device, _setLayout, nullptr);
+};
+
+void Indium::ResourceTable::writeDescriptor(uint32_t binding, uint32_t slot, const VkDescriptorImageInfo& imageInfo) {
+	VkWriteDescriptorSet write {};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = _descriptorSet;
+	write.dstBinding = binding;
+	write.dstArrayElement = slot;
+	write.descriptorCount = 1;
+	write.descriptorType = (binding == Iridium::resourceTableSamplerBinding) ? VK_DESCRIPTOR_TYPE_SAMPLER : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+	write.pImageInfo = &imageInfo;
+
+	DynamicVK::vkUpdateDescriptorSets(_device, 1, &write, 0, nullptr);
+};
+
+std::optional<uint32_t> Indium::ResourceTable::addTexture(VkImageView imageView, VkImageLayout imageLayout) {
+	// updates to the same descriptor set have to be externally synchronized, so we hold the lock while writing the descriptor, too
+	std::unique_lock lock(_mutex);
+
+	uint32_t slot;
+	if (!_freeTextureSlots.empty()) {
+		slot = _freeTextureSlots.back();
+		_freeTextureSlots.pop_back();
+	} else if (_nextTextureSlot < _textureCapacity) {
+		slot = _nextTextureSlot++;
+	} else {
+		return std::nullopt;
+	}
+
+	VkDescriptorImageInfo imageInfo {};
+	imageInfo.imageView = imageView;
+	imageInfo.imageLayout = imageLayout;
+	writeDescriptor(Iridium::resourceTableTextureBinding, slot, imageInfo);
+
+	return slot;
+};
+
+std::optional<uint32_t> Indium::ResourceTable::addSampler(VkSampler sampler) {
+	std::unique_lock lock(_mutex);
+
+	uint32_t slot;
+	if (!_freeSamplerSlots.empty()) {
+		slot = _freeSamplerSlots.back();
+		_freeSamplerSlots.pop_back();
+	} else if (_nextSamplerSlot < _samplerCapacity) {
+		slot = _nextSamplerSlot++;
+	} else {
+		return std::nullopt;
+	}
+
+	VkDescriptorImageInfo imageInfo {};
+	imageInfo.sampler = sampler;
+	writeDescriptor(Iridium::resourceTableSamplerBinding, slot, imageInfo);
+
+	return slot;
+};
+
+// the table is partially bound, so we don't need to clear removed slots; shaders just must not use them anymore
+// (and they can't, since the resource they referred to is gone).
+
+void Indium::ResourceTable::removeTexture(uint32_t slot) {
+	std::unique_lock lock(_mutex);
+	_freeTextureSlots.push_back(slot);
+};
+
+void Indium::ResourceTable::removeSampler(uint32_t slot) {
+	std::unique_lock lock(_mutex);
+	_freeSamplerSlots.push_back(slot);
+};
+
+std::shared_ptr<const uint32_t> Indium::ResourceTable::makeTransientSlot(uint32_t slot, std::vector<uint32_t>& freeList) {
+	return std::shared_ptr<const uint32_t>(new uint32_t(slot), [this, &freeList](const uint32_t* slot) {
+		std::unique_lock lock(_mutex);
+		freeList.push_back(*slot);
+		delete slot;
+	});
+};
+
+std::shared_ptr<const uint32_t> Indium::ResourceTable::addTransientTexture(VkImageView imageView, VkImageLayout imageLayout) {
+	std::unique_lock lock(_mutex);
+
+	if (_freeTransientTextureSlots.empty()) {
+		throw std::runtime_error("Resource table is full (too many textures)");
+	}
+
+	auto slot = _freeTransientTextureSlots.back();
+	_freeTransientTextureSlots.pop_back();
+
+	VkDescriptorImageInfo imageInfo {};
+	imageInfo.imageView = imageView;
+	imageInfo.imageLayout = imageLayout;
+	writeDescriptor(Iridium::resourceTableTextureBinding, slot, imageInfo);
+
+	return makeTransientSlot(slot, _freeTransientTextureSlots);
+};
+
+std::shared_ptr<const uint32_t> Indium::ResourceTable::addTransientSampler(VkSampler sampler) {
+	std::unique_lock lock(_mutex);
+
+	if (_freeTransientSamplerSlots.empty()) {
+		throw std::runtime_error("Resource table is full (too many samplers)");
+	}
+
+	auto slot = _freeTransientSamplerSlots.back();
+	_freeTransientSamplerSlots.pop_back();
+
+	VkDescriptorImageInfo imageInfo {};
+	imageInfo.sampler = sampler;
+	writeDescriptor(Iridium::resourceTableSamplerBinding, slot, imageInfo);
+
+	return makeTransientSlot(slot, _freeTransientSamplerSlots);
+};
@@ -1,7 +1,10 @@
 #include <indium/sampler.private.hpp>
 #include <indium/device.private.hpp>
+#include <indium/resource-table.private.hpp>
 #include <indium/dynamic-vk.hpp>
 
+#include <stdexcept>
+
 Indium::SamplerState::~SamplerState() {};
 
 Indium::PrivateSamplerState::PrivateSamplerState(std::shared_ptr<PrivateDevice> device, const SamplerDescriptor& descriptor):
@@ -33,6 +36,9 @@ Indium::PrivateSamplerState::PrivateSamplerState(std::shared_ptr<PrivateDevice>
 };
 
 Indium::PrivateSamplerState::~PrivateSamplerState() {
+	if (_resourceTableSlot) {
+		_privateDevice->resourceTable().removeSampler(*_resourceTableSlot);
+	}
 	DynamicVK::vkDestroySampler(_privateDevice->device(), _sampler, nullptr);
 };
 
@@ -40,6 +46,22 @@ std::shared_ptr<Indium::Device> Indium::PrivateSamplerState::device() {
 	return _privateDevice;
 };
 
+std::optional<uint32_t> Indium::PrivateSamplerState::resourceTableSlot() {
+	std::unique_lock lock(_resourceIDMutex);
+	if (!_resourceTableSlot) {
+		_resourceTableSlot = _privateDevice->resourceTable().addSampler(_sampler);
+	}
+	return _resourceTableSlot;
+};
+
+Indium::ResourceID Indium::PrivateSamplerState::gpuResourceID() {
+	auto slot = resourceTableSlot();
+	if (!slot) {
+		throw std::runtime_error("Resource table is full (too many samplers)");
+	}
+	return ResourceID { *slot };
+};
+
 std::shared_ptr<Indium::PrivateSamplerState> Indium::PrivateSamplerState::cloneWithClamps(float lodMinClamp, float lodMaxClamp) {
 	SamplerDescriptor desc2 = _descriptor;
 	desc2.lodMinClamp = lodMinClamp;
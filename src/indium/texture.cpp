@@ -2,12 +2,17 @@
 #include <indium/device.private.hpp>
 #include <indium/types.private.hpp>
 #include <indium/buffer.private.hpp>
+#include <indium/resource-table.private.hpp>
 #include <indium/dynamic-vk.hpp>
 
 #include <cstring>
 
 Indium::Texture::~Texture() {};
-Indium::PrivateTexture::~PrivateTexture() {};
+Indium::PrivateTexture::~PrivateTexture() {
+	if (_resourceTableSlot) {
+		_device->resourceTable().removeTexture(*_resourceTableSlot);
+	}
+};
 
 std::shared_ptr<Indium::Texture> Indium::Texture::parentTexture() const {
 	return nullptr;
@@ -68,6 +73,16 @@ size_t Indium::PrivateTexture::vulkanArrayLength() const {
 	return arrayLength();
 };
 
+VkImageSubresourceRange Indium::PrivateTexture::subresourceRange() {
+	VkImageSubresourceRange range {};
+	range.aspectMask = pixelFormatToVkImageAspectFlags(pixelFormat());
+	range.baseMipLevel = 0;
+	range.levelCount = mipmapLevelCount();
+	range.baseArrayLayer = 0;
+	range.layerCount = vulkanArrayLength();
+	return range;
+};
+
 Indium::TextureView::TextureView(std::shared_ptr<PrivateTexture> original, PixelFormat pixelFormat, TextureType textureType, VkImageAspectFlags imageAspect, TextureSwizzleChannels swizzle, const Range<size_t>& levels, const Range<size_t>& layers):
 	PrivateTexture(std::dynamic_pointer_cast<PrivateDevice>(original->device())),
 	_original(original),
@@ -104,6 +119,7 @@ Indium::TextureView::TextureView(std::shared_ptr<PrivateTexture> original, Pixel
 	info.subresourceRange.levelCount = levelEnd - levelStart + 1;
 	info.subresourceRange.baseArrayLayer = layerStart;
 	info.subresourceRange.layerCount = (layerEnd - layerStart + 1) * (isCube ? 6 : 1);
+	_subresourceRange = info.subresourceRange;
 
 	if (DynamicVK::vkCreateImageView(std::dynamic_pointer_cast<PrivateDevice>(_original->device())->device(), &info, nullptr, &_imageView) != VK_SUCCESS) {
 		// TODO
@@ -187,6 +203,18 @@ std::shared_ptr<Indium::Device> Indium::TextureView::device() {
 	return _original->device();
 };
 
+Indium::HazardTrackingMode Indium::TextureView::hazardTrackingMode() const {
+	return _original->hazardTrackingMode();
+};
+
+VkImageSubresourceRange Indium::TextureView::subresourceRange() {
+	return _subresourceRange;
+};
+
+bool Indium::TextureView::memoryless() const {
+	return _original->memoryless();
+};
+
 VkImageLayout Indium::TextureView::imageLayout() {
 	return _original->imageLayout();
 };
@@ -266,10 +294,38 @@ Indium::PrivateTexture::PrivateTexture(std::shared_ptr<PrivateDevice> device):
 	_syncSemaphore = device->getWrappedTimelineSemaphore();
 };
 
+std::optional<uint32_t> Indium::PrivateTexture::resourceTableSlot() {
+	if (memoryless()) {
+		throw std::runtime_error("Memoryless textures don't have resource IDs");
+	}
+
+	std::unique_lock lock(_resourceIDMutex);
+	if (!_resourceTableSlot) {
+		_resourceTableSlot = _device->resourceTable().addTexture(imageView(), imageLayout());
+	}
+	return _resourceTableSlot;
+};
+
+Indium::ResourceID Indium::PrivateTexture::gpuResourceID() {
+	auto slot = resourceTableSlot();
+	if (!slot) {
+		throw std::runtime_error("Resource table is full (too many textures)");
+	}
+	return ResourceID { *slot };
+};
+
 std::shared_ptr<Indium::Device> Indium::PrivateTexture::device() {
 	return _device;
 };
 
+Indium::HazardTrackingMode Indium::PrivateTexture::hazardTrackingMode() const {
+	return HazardTrackingMode::HazardTrackingModeTracked;
+};
+
+bool Indium::PrivateTexture::memoryless() const {
+	return false;
+};
+
 void Indium::PrivateTexture::precommit(std::shared_ptr<Indium::PrivateCommandBuffer> cmdbuf) {
 	// do nothing by default
 };
@@ -288,6 +344,7 @@ Indium::ConcreteTexture::ConcreteTexture(std::shared_ptr<PrivateDevice> device,
 	_descriptor(descriptor)
 {
 	_storageMode = static_cast<StorageMode>((static_cast<size_t>(_descriptor.resourceOptions) >> 4) & 0xf);
+	_hazardTrackingMode = static_cast<HazardTrackingMode>((static_cast<size_t>(_descriptor.resourceOptions) >> 8) & 0xf);
 
 	bool isCube = _descriptor.textureType == TextureType::eCube || _descriptor.textureType == TextureType::eCubeArray;
 
@@ -300,9 +357,8 @@ Indium::ConcreteTexture::ConcreteTexture(std::shared_ptr<PrivateDevice> device,
 	info.extent.depth = _descriptor.depth;
 	info.mipLevels = _descriptor.mipmapLevelCount;
 	info.arrayLayers = _descriptor.arrayLength * (isCube ? 6 : 1);
-	// TODO
-	//info.samples = _descriptor.sampleCount;
-	info.samples = VK_SAMPLE_COUNT_1_BIT;
+	// Vulkan's sample count bits have the same values as the sample counts themselves
+	info.samples = static_cast<VkSampleCountFlagBits>(_descriptor.sampleCount);
 
 	if (_descriptor.textureType == TextureType::eCube || _descriptor.textureType == TextureType::eCubeArray) {
 		info.flags |= VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
@@ -312,26 +368,61 @@ Indium::ConcreteTexture::ConcreteTexture(std::shared_ptr<PrivateDevice> device,
 	bool isColor = (imageAspect & VK_IMAGE_ASPECT_COLOR_BIT) != 0;
 	bool isDepthStencil = (imageAspect & (VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT)) != 0;
 
+	bool memoryless = _storageMode == StorageMode::Memoryless;
+	bool multisampled = _descriptor.sampleCount > 1;
 	bool canBeLinear = true;
 
+	if (multisampled) {
+		const auto& limits = _device->properties().limits;
+		VkSampleCountFlags supportedSampleCounts = isDepthStencil ? limits.framebufferDepthSampleCounts : (isColor ? limits.framebufferColorSampleCounts : 0);
+
+		// multisampled textures are only useful as render targets (and as sources for resolves and multisample reads)
+		if ((_descriptor.sampleCount & (_descriptor.sampleCount - 1)) != 0 || (supportedSampleCounts & _descriptor.sampleCount) == 0) {
+			throw std::runtime_error("Unsupported texture sample count");
+		}
+
+		if (_descriptor.mipmapLevelCount > 1) {
+			throw std::runtime_error("Multisampled textures can't have mipmaps");
+		}
+	}
+
 	if (
 		// depth-stencil formats don't seem to work with VK_IMAGE_TILING_LINEAR, so we force OPTIMAL instead
 		isDepthStencil ||
 
 		// linear textures only support a single mip level
-		_descriptor.mipmapLevelCount > 1
+		_descriptor.mipmapLevelCount > 1 ||
+
+		// transient attachments have to be optimally tiled
+		memoryless ||
+
+		// so do multisampled images
+		multisampled
 	) {
 		canBeLinear = false;
 	}
 
 	info.tiling = (descriptor.allowGPUOptimizedContents || !canBeLinear) ? VK_IMAGE_TILING_OPTIMAL : VK_IMAGE_TILING_LINEAR;
 
-	// we don't know ahead of time how the image is going to be used, so specify everything we support
-	info.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-	if (isColor) {
-		info.usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-	} else if (isDepthStencil) {
-		info.usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+	if (memoryless) {
+		// memoryless textures can only ever be used as attachments that aren't loaded or stored.
+		// transient attachments can live entirely in tile memory on tilers (as long as they're bound to lazily-allocated memory).
+		if (!isColor && !isDepthStencil) {
+			throw std::runtime_error("Memoryless textures must have a color or depth-stencil format");
+		}
+		info.usage = VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | (isColor ? VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT : VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT);
+	} else {
+		// we don't know ahead of time how the image is going to be used, so specify everything we support
+		info.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		// multisampled storage images need an optional feature, and shaders can't write to multisampled textures anyway
+		if (!multisampled) {
+			info.usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+		}
+		if (isColor) {
+			info.usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+		} else if (isDepthStencil) {
+			info.usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+		}
 	}
 	info.sharingMode = VK_SHARING_MODE_EXCLUSIVE; // TODO: check if this should be "concurrent" instead. i think we're good, though.
 	info.queueFamilyIndexCount = 0;
@@ -349,13 +440,27 @@ Indium::ConcreteTexture::ConcreteTexture(std::shared_ptr<PrivateDevice> device,
 
 	size_t targetIndex = SIZE_MAX;
 
-	for (size_t i = 0; i < _device->memoryProperties().memoryTypeCount; ++i) {
+	// memoryless textures prefer lazily-allocated memory, which the driver only actually backs with memory if it has to
+	if (memoryless) {
+		for (size_t i = 0; i < _device->memoryProperties().memoryTypeCount; ++i) {
+			if ((reqs.memoryTypeBits & (1 << i)) != 0 && (_device->memoryProperties().memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) != 0) {
+				targetIndex = i;
+				break;
+			}
+		}
+	}
+
+	for (size_t i = 0; targetIndex == SIZE_MAX && i < _device->memoryProperties().memoryTypeCount; ++i) {
 		const auto& type = _device->memoryProperties().memoryTypes[i];
 
 		if ((reqs.memoryTypeBits & (1 << i)) == 0) {
 			continue;
 		}
 
+		if (memoryless && (type.propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) == 0) {
+			continue;
+		}
+
 		if ((_storageMode == StorageMode::Managed || _storageMode == StorageMode::Shared) && (type.propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) == 0) {
 			continue;
 		}
@@ -373,14 +478,22 @@ Indium::ConcreteTexture::ConcreteTexture(std::shared_ptr<PrivateDevice> device,
 		throw std::runtime_error("No suitable memory region found for image with requested storage mode");
 	}
 
-	VkMemoryAllocateInfo allocateInfo {};
-	allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	allocateInfo.allocationSize = reqs.size;
-	allocateInfo.memoryTypeIndex = targetIndex;
-
-	if (DynamicVK::vkAllocateMemory(_device->device(), &allocateInfo, nullptr, &_memory) != VK_SUCCESS) {
-		// TODO
-		abort();
+	bool lazilyAllocated = (_device->memoryProperties().memoryTypes[targetIndex].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) != 0;
+
+	if (memoryless && !lazilyAllocated) {
+		// without lazily-allocated memory, memoryless textures need real memory, but they can share it with earlier memoryless textures
+		_memorylessAllocation = _device->takeMemorylessAllocation(targetIndex, reqs.size);
+		_memory = _memorylessAllocation->memory;
+	} else {
+		VkMemoryAllocateInfo allocateInfo {};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocateInfo.allocationSize = reqs.size;
+		allocateInfo.memoryTypeIndex = targetIndex;
+
+		if (DynamicVK::vkAllocateMemory(_device->device(), &allocateInfo, nullptr, &_memory) != VK_SUCCESS) {
+			// TODO
+			abort();
+		}
 	}
 
 	DynamicVK::vkBindImageMemory(_device->device(), _image, _memory, 0);
@@ -468,7 +581,12 @@ Indium::ConcreteTexture::ConcreteTexture(std::shared_ptr<PrivateDevice> device,
 Indium::ConcreteTexture::~ConcreteTexture() {
 	DynamicVK::vkDestroyImageView(_device->device(), _imageView, nullptr);
 	DynamicVK::vkDestroyImage(_device->device(), _image, nullptr);
-	DynamicVK::vkFreeMemory(_device->device(), _memory, nullptr);
+
+	if (_memorylessAllocation) {
+		_device->recycleMemorylessAllocation(*_memorylessAllocation);
+	} else {
+		DynamicVK::vkFreeMemory(_device->device(), _memory, nullptr);
+	}
 };
 
 Indium::TextureType Indium::ConcreteTexture::textureType() const {
@@ -529,6 +647,14 @@ Indium::TextureSwizzleChannels Indium::ConcreteTexture::swizzle() const {
 	return _descriptor.swizzle;
 };
 
+Indium::HazardTrackingMode Indium::ConcreteTexture::hazardTrackingMode() const {
+	return _hazardTrackingMode;
+};
+
+bool Indium::ConcreteTexture::memoryless() const {
+	return _storageMode == StorageMode::Memoryless;
+};
+
 VkImageView Indium::ConcreteTexture::imageView() {
 	return _imageView;
 };
@@ -0,0 +1,38 @@
+#include <indium/transient-arena.private.hpp>
+
+#include <algorithm>
+#include <cstdint>
+
+void* Indium::TransientArena::do_allocate(size_t bytes, size_t alignment) {
+	while (true) {
+		if (_current.blockIndex < _blocks.size()) {
+			auto& block = _blocks[_current.blockIndex];
+			auto base = reinterpret_cast<uintptr_t>(block.data.get());
+			size_t alignedOffset = ((base + _current.offset + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+
+			if (alignedOffset + bytes <= block.size) {
+				_current.offset = alignedOffset + bytes;
+				return block.data.get() + alignedOffset;
+			}
+
+			// doesn't fit in this block; move on to the next one
+			++_current.blockIndex;
+			_current.offset = 0;
+			continue;
+		}
+
+		// we've run out of blocks, so add a new one (big enough for this allocation, even if it's unusually large)
+		Block block;
+		block.size = std::max(defaultBlockSize, bytes + alignment);
+		block.data = std::make_unique<char[]>(block.size);
+		_blocks.push_back(std::move(block));
+	}
+};
+
+void Indium::TransientArena::do_deallocate(void* pointer, size_t bytes, size_t alignment) {
+	// nothing to do; memory is only freed by rewinding the arena
+};
+
+bool Indium::TransientArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+	return this == &other;
+};
@@ -0,0 +1,39 @@
+#include <indium/upload-heap.private.hpp>
+#include <indium/device.private.hpp>
+#include <indium/buffer.private.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+Indium::UploadHeap::UploadHeap(std::shared_ptr<PrivateDevice> device):
+	_privateDevice(device)
+	{};
+
+std::pair<Indium::PrivateBuffer*, size_t> Indium::UploadHeap::upload(const void* data, size_t length) {
+	auto result = allocate(length);
+	memcpy(static_cast<char*>(result.first->contents()) + result.second, data, length);
+	return result;
+};
+
+std::pair<Indium::PrivateBuffer*, size_t> Indium::UploadHeap::allocate(size_t length) {
+	while (true) {
+		if (_blockIndex < _blocks.size()) {
+			auto& block = _blocks[_blockIndex];
+			size_t alignedOffset = (_offset + uploadAlignment - 1) & ~(uploadAlignment - 1);
+
+			if (alignedOffset + length <= block->length()) {
+				_offset = alignedOffset + length;
+				return std::make_pair(block.get(), alignedOffset);
+			}
+
+			// doesn't fit in this block; move on to the next one
+			++_blockIndex;
+			_offset = 0;
+			continue;
+		}
+
+		// we've run out of blocks, so add a new one (big enough for this allocation, even if it's unusually large)
+		auto block = std::dynamic_pointer_cast<PrivateBuffer>(_privateDevice->newBuffer(std::max(defaultBlockSize, length), ResourceOptions::StorageModeShared));
+		_blocks.push_back(std::move(block));
+	}
+};
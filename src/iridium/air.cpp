@@ -5,6 +5,11 @@
 
 #include <llvm-c/BitReader.h>
 
+#include <algorithm>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+
 namespace DynamicLLVM = Iridium::DynamicLLVM;
 
 // special thanks to https://github.com/YuAo/MetalLibraryArchive for information on the library format
@@ -43,7 +48,84 @@ Iridium::AIR::Function::Function(Type type, const std::string& name, const void*
 
 class ImpossibleResultID: public std::exception {};
 
-static Iridium::SPIRV::ResultID llvmTypeToSPIRVType(Iridium::SPIRV::Builder& builder, LLVMTypeRef llvmType) {
+// textures and samplers are opaque structures in AIR (e.g. `%struct._texture_2d_t`) that are only ever used through pointers
+static bool isResourceStructType(LLVMTypeRef llvmType) {
+	if (DynamicLLVM::LLVMGetTypeKind(llvmType) != LLVMStructTypeKind) {
+		return false;
+	}
+
+	auto rawName = DynamicLLVM::LLVMGetStructName(llvmType);
+	if (!rawName) {
+		return false;
+	}
+
+	std::string_view name(rawName);
+	return name.compare(0, sizeof("struct._texture_") - 1, "struct._texture_") == 0 || name == "struct._sampler_t";
+};
+
+static bool isResourcePointerType(LLVMTypeRef llvmType) {
+	return DynamicLLVM::LLVMGetTypeKind(llvmType) == LLVMPointerTypeKind && isResourceStructType(DynamicLLVM::LLVMGetElementType(llvmType));
+};
+
+// AIR and Metal name texture types consistently, so `kind` is the part of the name that identifies the type of texture
+// (e.g. "2d_array" for both `struct._texture_2d_array_t` and `texture2d_array<float>`).
+// returns the SPIR-V dimensionality and whether the texture is arrayed, or nothing for textures we don't support (multisampled and depth textures).
+static std::optional<std::pair<Iridium::SPIRV::Dim, bool>> textureDimensionsForKind(std::string_view kind) {
+	using Iridium::SPIRV::Dim;
+
+	if (kind == "1d") {
+		return std::make_pair(Dim::e1D, false);
+	} else if (kind == "1d_array") {
+		return std::make_pair(Dim::e1D, true);
+	} else if (kind == "2d") {
+		return std::make_pair(Dim::e2D, false);
+	} else if (kind == "2d_array") {
+		return std::make_pair(Dim::e2D, true);
+	} else if (kind == "3d") {
+		return std::make_pair(Dim::e3D, false);
+	} else if (kind == "cube") {
+		return std::make_pair(Dim::eCube, false);
+	} else if (kind == "cube_array") {
+		return std::make_pair(Dim::eCube, true);
+	}
+
+	return std::nullopt;
+};
+
+// returns the dimensions of the texture sampled by the given `air.sample_texture_*` function (e.g. `air.sample_texture_2d_array.v4f32`),
+// or nothing if it's not one we can translate.
+static std::optional<std::pair<Iridium::SPIRV::Dim, bool>> sampleTextureDimensions(std::string_view name) {
+	static constexpr std::string_view prefix = "air.sample_texture_";
+
+	if (name.compare(0, prefix.size(), prefix) != 0) {
+		return std::nullopt;
+	}
+
+	auto dot = name.find('.', prefix.size());
+	if (dot == std::string_view::npos || (name.substr(dot) != ".v4f16" && name.substr(dot) != ".v4f32")) {
+		return std::nullopt;
+	}
+
+	return textureDimensionsForKind(name.substr(prefix.size(), dot - prefix.size()));
+};
+
+// the number of coordinate components needed to address a texel in a texture with the given dimensionality (not counting the array layer)
+static size_t coordinateCountForDimensionality(Iridium::SPIRV::Dim dimensionality) {
+	switch (dimensionality) {
+		case Iridium::SPIRV::Dim::e1D:
+			return 1;
+		case Iridium::SPIRV::Dim::e2D:
+			return 2;
+		default:
+			return 3;
+	}
+};
+
+// `inMemory` is set for the types of values stored in memory (i.e. members of structures, elements of arrays, and the targets of pointers).
+// pointers to device or constant memory that are stored in memory (e.g. buffers in argument buffers) are buffer device addresses.
+// pointer values that aren't stored anywhere keep the storage class of the pointer they were derived from (see e.g. the handling of GEPs),
+// so the type returned for those is just a placeholder.
+static Iridium::SPIRV::ResultID llvmTypeToSPIRVType(Iridium::SPIRV::Builder& builder, LLVMTypeRef llvmType, bool inMemory = false) {
 	using namespace Iridium::SPIRV;
 
 	auto kind = DynamicLLVM::LLVMGetTypeKind(llvmType);
@@ -92,7 +174,7 @@ static Iridium::SPIRV::ResultID llvmTypeToSPIRVType(Iridium::SPIRV::Builder& bui
 				// see which member has the greatest alignment
 				for (size_t i = 0; i < len; ++i) {
 					auto typeAtIndex = DynamicLLVM::LLVMStructGetTypeAtIndex(llvmType, i);
-					auto type = llvmTypeToSPIRVType(builder, typeAtIndex);
+					auto type = llvmTypeToSPIRVType(builder, typeAtIndex, true);
 					auto typeInst = *builder.reverseLookupType(type);
 					if (typeInst.alignment > structAlignment) {
 						structAlignment = typeInst.alignment;
@@ -106,7 +188,7 @@ static Iridium::SPIRV::ResultID llvmTypeToSPIRVType(Iridium::SPIRV::Builder& bui
 			size_t offset = 0;
 			for (size_t i = 0; i < len; ++i) {
 				auto typeAtIndex = DynamicLLVM::LLVMStructGetTypeAtIndex(llvmType, i);
-				auto type = llvmTypeToSPIRVType(builder, typeAtIndex);
+				auto type = llvmTypeToSPIRVType(builder, typeAtIndex, true);
 				auto typeInst = *builder.reverseLookupType(type);
 				auto alignmentToUse = (typeInst.alignment < structAlignment) ? typeInst.alignment : structAlignment;
 				// align the offset
@@ -121,21 +203,30 @@ static Iridium::SPIRV::ResultID llvmTypeToSPIRVType(Iridium::SPIRV::Builder& bui
 		} break;
 
 		case LLVMPointerTypeKind: {
+			if (isResourcePointerType(llvmType)) {
+				// textures and samplers stored in memory (i.e. in argument buffers) are resource IDs
+				return builder.declareType(Type(Type::IntegerTag {}, 64, false));
+			}
+
 			StorageClass storageClass = StorageClass::Output;
-			// TODO: somehow determine the appropriate storage class
-			//auto addrSpace = DynamicLLVM::LLVMGetPointerAddressSpace(llvmType);
-			return builder.declareType(Type(Type::PointerTag {}, storageClass, llvmTypeToSPIRVType(builder, DynamicLLVM::LLVMGetElementType(llvmType)), 8));
+			// TODO: somehow determine the appropriate storage class for the other address spaces
+			auto addrSpace = DynamicLLVM::LLVMGetPointerAddressSpace(llvmType);
+			if (inMemory && (addrSpace == 1 || addrSpace == 2)) {
+				// the device and constant address spaces
+				storageClass = StorageClass::PhysicalStorageBuffer;
+			}
+			return builder.declareType(Type(Type::PointerTag {}, storageClass, llvmTypeToSPIRVType(builder, DynamicLLVM::LLVMGetElementType(llvmType), true), 8));
 		} break;
 
 		case LLVMVectorTypeKind: {
-			auto type = llvmTypeToSPIRVType(builder, DynamicLLVM::LLVMGetElementType(llvmType));
+			auto type = llvmTypeToSPIRVType(builder, DynamicLLVM::LLVMGetElementType(llvmType), true);
 			auto typeInst = *builder.reverseLookupType(type);
 			auto elmCount = DynamicLLVM::LLVMGetVectorSize(llvmType);
 			return builder.declareType(Type(Type::VectorTag {}, elmCount, type, typeInst.size * elmCount, ((elmCount == 3 || elmCount == 4) ? 4 : 2) * typeInst.alignment));
 		} break;
 
 		case LLVMArrayTypeKind: {
-			auto type = llvmTypeToSPIRVType(builder, DynamicLLVM::LLVMGetElementType(llvmType));
+			auto type = llvmTypeToSPIRVType(builder, DynamicLLVM::LLVMGetElementType(llvmType), true);
 			auto typeInst = *builder.reverseLookupType(type);
 			auto elmCount = DynamicLLVM::LLVMGetArrayLength(llvmType);
 			return builder.declareType(Type(Type::ArrayTag {}, type, elmCount, typeInst.size * elmCount, typeInst.alignment));
@@ -152,6 +243,115 @@ static std::string_view llvmMDStringToStringView(LLVMValueRef llvmMDString) {
 	return std::string_view(rawStr, length);
 };
 
+// finds the value that follows the given key in a parameter's metadata (e.g. the index that follows "air.location_index")
+static LLVMValueRef findParameterInfoValue(const std::vector<LLVMValueRef>& parameterInfo, std::string_view key) {
+	for (size_t i = 0; i + 1 < parameterInfo.size(); ++i) {
+		if (DynamicLLVM::LLVMIsAMDString(parameterInfo[i]) && llvmMDStringToStringView(parameterInfo[i]) == key) {
+			return parameterInfo[i + 1];
+		}
+	}
+	return nullptr;
+};
+
+// texture parameters are marked with how they're accessed ("air.sample", "air.read", "air.write", or "air.read_write").
+// we read textures through sampled images, so textures that are only read are treated just like sampled ones.
+static Iridium::TextureAccessType textureAccessTypeForParameter(const std::vector<LLVMValueRef>& parameterInfo) {
+	for (const auto& info: parameterInfo) {
+		if (!DynamicLLVM::LLVMIsAMDString(info)) {
+			continue;
+		}
+
+		auto str = llvmMDStringToStringView(info);
+
+		if (str == "air.write") {
+			return Iridium::TextureAccessType::Write;
+		} else if (str == "air.read_write") {
+			return Iridium::TextureAccessType::ReadWrite;
+		}
+	}
+
+	return Iridium::TextureAccessType::Sample;
+};
+
+// argument buffers are described by the "air.struct_type_info" node of their parameter. this is a flat list of members, each of which starts with
+// its offset, size, array length, type name, and name, optionally followed by more info about the member.
+// textures, samplers, and buffers have an "air.indirect_argument" node that describes them like a regular parameter (including their ID as the location index).
+//
+// returns `false` if the structure doesn't contain any indirect arguments (i.e. it's just a regular structure).
+static bool parseArgumentBufferInfo(LLVMValueRef structTypeInfo, Iridium::ArgumentBufferInfo& argumentBufferInfo) {
+	std::vector<LLVMValueRef> operands(DynamicLLVM::LLVMGetMDNodeNumOperands(structTypeInfo));
+	DynamicLLVM::LLVMGetMDNodeOperands(structTypeInfo, operands.data());
+
+	bool hasIndirectArguments = false;
+	// members without an explicit ID get the one after the previous member's
+	size_t nextIndex = 0;
+
+	for (size_t i = 0; i < operands.size(); ++i) {
+		bool isMemberStart = i + 4 < operands.size() &&
+			DynamicLLVM::LLVMIsAConstantInt(operands[i]) &&
+			DynamicLLVM::LLVMIsAConstantInt(operands[i + 1]) &&
+			DynamicLLVM::LLVMIsAConstantInt(operands[i + 2]) &&
+			DynamicLLVM::LLVMIsAMDString(operands[i + 3]) &&
+			DynamicLLVM::LLVMIsAMDString(operands[i + 4]);
+
+		if (isMemberStart) {
+			size_t size = DynamicLLVM::LLVMConstIntGetZExtValue(operands[i + 1]);
+			size_t arrayLength = DynamicLLVM::LLVMConstIntGetZExtValue(operands[i + 2]);
+
+			auto& argument = argumentBufferInfo.arguments.emplace_back();
+			argument.type = Iridium::ArgumentType::Constant;
+			argument.index = nextIndex;
+			argument.offset = DynamicLLVM::LLVMConstIntGetZExtValue(operands[i]);
+			argument.size = (arrayLength > 0) ? (size / arrayLength) : size;
+			argument.arrayLength = arrayLength;
+
+			nextIndex += std::max<size_t>(arrayLength, 1);
+			i += 4;
+			continue;
+		}
+
+		if (argumentBufferInfo.arguments.empty() || !DynamicLLVM::LLVMIsAMDString(operands[i]) || llvmMDStringToStringView(operands[i]) != "air.indirect_argument") {
+			continue;
+		}
+
+		if (i + 1 >= operands.size() || !DynamicLLVM::LLVMIsAMDNode(operands[i + 1])) {
+			continue;
+		}
+
+		std::vector<LLVMValueRef> argumentInfo(DynamicLLVM::LLVMGetMDNodeNumOperands(operands[i + 1]));
+		DynamicLLVM::LLVMGetMDNodeOperands(operands[i + 1], argumentInfo.data());
+		++i;
+
+		auto& argument = argumentBufferInfo.arguments.back();
+
+		// like parameters, info[1] is the kind
+		if (argumentInfo.size() > 1 && DynamicLLVM::LLVMIsAMDString(argumentInfo[1])) {
+			auto kind = llvmMDStringToStringView(argumentInfo[1]);
+
+			if (kind == "air.buffer") {
+				argument.type = Iridium::ArgumentType::Buffer;
+			} else if (kind == "air.texture") {
+				// the resource table only has sampled images (see Iridium::ArgumentType::Texture)
+				if (textureAccessTypeForParameter(argumentInfo) != Iridium::TextureAccessType::Sample) {
+					throw std::runtime_error("Writable textures aren't supported in argument buffers");
+				}
+				argument.type = Iridium::ArgumentType::Texture;
+			} else if (kind == "air.sampler") {
+				argument.type = Iridium::ArgumentType::Sampler;
+			}
+		}
+
+		if (auto locationIndex = findParameterInfoValue(argumentInfo, "air.location_index"); locationIndex && DynamicLLVM::LLVMIsAConstantInt(locationIndex)) {
+			argument.index = DynamicLLVM::LLVMConstIntGetZExtValue(locationIndex);
+			nextIndex = argument.index + std::max<size_t>(argument.arrayLength, 1);
+		}
+
+		hasIndirectArguments = true;
+	}
+
+	return hasIndirectArguments;
+};
+
 static Iridium::SPIRV::ResultID llvmValueToResultID(Iridium::SPIRV::Builder& builder, LLVMValueRef llvmValue) {
 	using namespace Iridium::SPIRV;
 
@@ -263,7 +463,7 @@ static Iridium::SPIRV::ResultID llvmValueToResultID(Iridium::SPIRV::Builder& bui
 	}
 };
 
-void Iridium::AIR::Function::analyze(SPIRV::Builder& builder, OutputInfo& outputInfo) {
+void Iridium::AIR::Function::analyze(SPIRV::Builder& builder, OutputInfo& outputInfo, const TranslationOptions& options) {
 	//auto tmp = DynamicLLVM::LLVMPrintModuleToString(_module.get());
 	//std::cout << "    " << tmp << std::endl;
 	//DynamicLLVM::LLVMDisposeMessage(tmp);
@@ -293,6 +493,8 @@ void Iridium::AIR::Function::analyze(SPIRV::Builder& builder, OutputInfo& output
 	SPIRV::ResultID globalInvocationIdVar = SPIRV::ResultIDInvalid;
 
 	auto firstLabelID = builder.beginFunction(funcID.id);
+	// parameter setup may need to branch, so the function's first block doesn't necessarily start at the first label
+	auto entryLabelID = firstLabelID;
 
 	// within this node, operand 0 refers to the vertex function,
 	// operand 1 contains information about the function's return value,
@@ -480,11 +682,102 @@ void Iridium::AIR::Function::analyze(SPIRV::Builder& builder, OutputInfo& output
 	std::vector<LLVMValueRef> parameterOperands(DynamicLLVM::LLVMGetMDNodeNumOperands(rootInfoOperands[2]));
 	DynamicLLVM::LLVMGetMDNodeOperands(rootInfoOperands[2], parameterOperands.data());
 
+	// textures and samplers loaded from argument buffers (and, with `TranslationOptions::bindlessResources`, texture and sampler parameters)
+	// are looked up in the resource table (see Iridium::resourceTableSetForFunctionType()).
+	// the table has a single array for all textures, but each texture type needs its own variable (they all alias the same binding).
+	std::unordered_map<SPIRV::ResultID, SPIRV::ResultID> resourceTableVars;
+	std::unordered_set<SPIRV::ResultID> nonUniformResources;
+
+	auto resourceTableVariableForType = [&](SPIRV::ResultID resourceType, uint32_t binding) {
+		auto it = resourceTableVars.find(resourceType);
+		if (it != resourceTableVars.end()) {
+			return it->second;
+		}
+
+		auto arrayType = builder.declareType(SPIRV::Type(SPIRV::Type::RuntimeArrayTag {}, resourceType, 8, 8));
+		auto arrayPtrType = builder.declareType(SPIRV::Type(SPIRV::Type::PointerTag {}, SPIRV::StorageClass::UniformConstant, arrayType, 8));
+		auto var = builder.addGlobalVariable(arrayPtrType, SPIRV::StorageClass::UniformConstant);
+
+		builder.addDecoration(var, SPIRV::Decoration { SPIRV::DecorationType::DescriptorSet, { resourceTableSetForFunctionType(funcInfo.type) } });
+		builder.addDecoration(var, SPIRV::Decoration { SPIRV::DecorationType::Binding, { binding } });
+		builder.referenceGlobalVariable(var);
+
+		builder.requireCapability(SPIRV::Capability::RuntimeDescriptorArray);
+
+		funcInfo.usesResourceTable = true;
+		resourceTableVars[resourceType] = var;
+		return var;
+	};
+
+	auto resourceTableVariable = [&](LLVMTypeRef resourceStructType) {
+		auto rawName = DynamicLLVM::LLVMGetStructName(resourceStructType);
+		std::string_view name(rawName);
+		SPIRV::ResultID resourceType = SPIRV::ResultIDInvalid;
+		uint32_t binding = 0;
+
+		if (name == "struct._sampler_t") {
+			resourceType = builder.declareType(SPIRV::Type(SPIRV::Type::SamplerTag {}));
+			binding = resourceTableSamplerBinding;
+		} else {
+			// every kind of texture shares the same binding in the table; a sampled image descriptor can hold any type of image view,
+			// so each texture type just gets its own variable aliasing that binding.
+			// since this is only ever called while translating, unsupported textures are rejected when the library is created.
+			std::optional<std::pair<SPIRV::Dim, bool>> dimensions;
+			if (name.size() > sizeof("struct._texture__t") - 1 && name.compare(0, sizeof("struct._texture_") - 1, "struct._texture_") == 0) {
+				dimensions = textureDimensionsForKind(name.substr(sizeof("struct._texture_") - 1, name.size() - (sizeof("struct._texture_") - 1) - (sizeof("_t") - 1)));
+			}
+			if (!dimensions) {
+				throw std::runtime_error(std::string("Multisampled and depth textures aren't supported in argument buffers (found ") + rawName + ")");
+			}
+
+			// as with texture parameters, we always sample as 32-bit floats
+			resourceType = builder.declareType(SPIRV::Type(SPIRV::Type::ImageTag {}, floatType, floatType, dimensions->first, 2, dimensions->second, false, 1, SPIRV::ImageFormat::Unknown));
+			binding = resourceTableTextureBinding;
+		}
+
+		// resource IDs loaded from argument buffers are 64-bit and can differ between invocations
+		builder.requireCapability(SPIRV::Capability::Int64);
+		builder.requireCapability(SPIRV::Capability::ShaderNonUniform);
+		builder.requireCapability(SPIRV::Capability::SampledImageArrayNonUniformIndexing);
+
+		return std::make_pair(resourceTableVariableForType(resourceType, binding), resourceType);
+	};
+
 	//
 	// analyze parameters and mark special values (like the vertex ID)
 	//
 
-	// first, count how many buffers we have (we'll need this later)
+	// first, figure out where each buffer's going to be passed (we'll need this later).
+	//
+	// small constant buffers with a known size (i.e. `constant T&` parameters) are passed by value in our part of the push constant block,
+	// as long as they fit. these are usually per-draw constants set with setBytes(), so this saves Indium from having to create a buffer for them
+	// (and saves us a pointer chase). however, they can also be bound with setBuffer(), in which case the contents have to be read when the function runs,
+	// so every buffer (including those passed by value) also gets an address; for buffers passed by value, Indium passes a null address when it pushed
+	// the contents instead.
+	//
+	// our part of the push constant block is sized from the device's `maxPushConstantsSize` (see `TranslationOptions::pushConstantBlockSize`),
+	// so on devices that only have the 128 bytes Vulkan guarantees, we get 64 bytes for vertex and fragment functions and 128 for kernels.
+	//
+	// the addresses go into the push constant block as well if there are few enough of them;
+	// otherwise, they go into a UBO (which Indium has to rebuild whenever a buffer binding changes).
+	// we reserve space for the addresses first since the UBO is more expensive than passing a constant buffer by address.
+	//
+	// with bindless resources, the resource IDs of texture and sampler parameters come before all of that (if they all fit);
+	// they're tiny and they save Indium from having to write any descriptors for them at all.
+	auto pushConstantRange = pushConstantRangeForFunctionType(funcInfo.type, options.pushConstantBlockSize);
+	auto pushConstantLimit = pushConstantRange.offset + pushConstantRange.size;
+	size_t pushConstantEnd = pushConstantRange.offset;
+	size_t pushConstantAlignment = 1;
+	std::vector<SPIRV::Type::Member> pushConstantMembers;
+	// maps parameter indices to push constant member indices (only for buffers passed by value)
+	std::unordered_map<size_t, size_t> pushConstantMemberIndices;
+	// maps parameter indices to push constant member indices for the resource IDs of texture and sampler parameters (only with bindless resources)
+	std::unordered_map<size_t, size_t> resourceIDMemberIndices;
+	std::vector<size_t> resourceParameters;
+
+	// parameter indices of buffers that could be passed by value
+	std::vector<size_t> constantBufferParameters;
+
 	uint32_t bufferCount = 0;
 	for (size_t i = 0; i < parameterOperands.size(); ++i) {
 		auto& parameterOperand = parameterOperands[i];
@@ -498,14 +791,57 @@ void Iridium::AIR::Function::analyze(SPIRV::Builder& builder, OutputInfo& output
 		auto kind = llvmMDStringToStringView(parameterInfo[1]);
 
 		if (kind == "air.buffer") {
+			auto bufferSize = findParameterInfoValue(parameterInfo, "air.buffer_size");
+
+			// address space 2 is the constant address space.
+			// older compilers don't include `air.address_space` in the parameter info, so this comes from the parameter's type instead.
+			if (bufferSize && DynamicLLVM::LLVMGetTypeKind(funcParamTypes[i]) == LLVMPointerTypeKind && DynamicLLVM::LLVMGetPointerAddressSpace(funcParamTypes[i]) == 2) {
+				constantBufferParameters.push_back(i);
+			}
+
 			++bufferCount;
+		} else if (options.bindlessResources && (kind == "air.sampler" || (kind == "air.texture" && textureAccessTypeForParameter(parameterInfo) == TextureAccessType::Sample))) {
+			// the resource table only has sampled images, so textures that are written to keep their own descriptors
+			resourceParameters.push_back(i);
 		}
 	}
 
+	if (!resourceParameters.empty() && resourceParameters.size() * sizeof(uint32_t) <= pushConstantRange.size) {
+		for (auto i: resourceParameters) {
+			resourceIDMemberIndices[i] = pushConstantMembers.size();
+			pushConstantMembers.push_back(SPIRV::Type::Member { u32Type, pushConstantEnd, {} });
+			pushConstantEnd += sizeof(uint32_t);
+		}
+		pushConstantAlignment = sizeof(uint32_t);
+	}
+
+	bool addressesInPushConstants = bufferCount * 8 <= pushConstantLimit - pushConstantEnd;
+	size_t reservedForAddresses = addressesInPushConstants ? bufferCount * 8 : 0;
+
+	for (auto i: constantBufferParameters) {
+		auto type = llvmTypeToSPIRVType(builder, DynamicLLVM::LLVMGetElementType(funcParamTypes[i]));
+		auto typeInst = *builder.reverseLookupType(type);
+		auto offset = (pushConstantEnd + (typeInst.alignment - 1)) & ~(typeInst.alignment - 1);
+
+		if (offset + typeInst.size + reservedForAddresses <= pushConstantLimit) {
+			pushConstantMemberIndices[i] = pushConstantMembers.size();
+			pushConstantMembers.push_back(SPIRV::Type::Member { type, offset, {} });
+			pushConstantEnd = offset + typeInst.size;
+			pushConstantAlignment = std::max(pushConstantAlignment, typeInst.alignment);
+		}
+
+		// otherwise, it'll only be passed by address
+	}
+
+	// the addresses go right after the buffers passed by value
+	size_t addressesOffset = (pushConstantEnd + 7) & ~7;
+	if (addressesInPushConstants && (bufferCount == 0 || addressesOffset + bufferCount * 8 > pushConstantLimit)) {
+		addressesInPushConstants = false;
+	}
+
 	std::vector<SPIRV::Type::Member> bufferMembers;
+	size_t addressMemberBase = pushConstantMembers.size();
 	if (bufferCount > 0) {
-		// if we have buffers, add a global variable for the UBO that contains their physical addresses
-
 		uint32_t bufferIndex = 0;
 		for (size_t i = 0; i < parameterOperands.size(); ++i) {
 			auto& parameterOperand = parameterOperands[i];
@@ -519,39 +855,80 @@ void Iridium::AIR::Function::analyze(SPIRV::Builder& builder, OutputInfo& output
 			auto kind = llvmMDStringToStringView(parameterInfo[1]);
 
 			if (kind == "air.buffer") {
-				auto type = llvmTypeToSPIRVType(builder, DynamicLLVM::LLVMGetElementType(funcParamTypes[i]));
-				auto addrPtrTypeInst = SPIRV::Type(SPIRV::Type::PointerTag {}, SPIRV::StorageClass::PhysicalStorageBuffer, type, 8);
-				auto addrPtrType = builder.declareType(addrPtrTypeInst);
-				bufferMembers.push_back(SPIRV::Type::Member { addrPtrType, 8 * bufferIndex, {} });
+				// buffers passed by value only need the address when it's non-null, so we load it as an integer first
+				SPIRV::ResultID addrType = SPIRV::ResultIDInvalid;
+				if (pushConstantMemberIndices.find(i) != pushConstantMemberIndices.end()) {
+					addrType = builder.declareType(SPIRV::Type(SPIRV::Type::IntegerTag {}, 64, false));
+					builder.requireCapability(SPIRV::Capability::Int64);
+				} else {
+					auto type = llvmTypeToSPIRVType(builder, DynamicLLVM::LLVMGetElementType(funcParamTypes[i]));
+					auto addrPtrTypeInst = SPIRV::Type(SPIRV::Type::PointerTag {}, SPIRV::StorageClass::PhysicalStorageBuffer, type, 8);
+					addrType = builder.declareType(addrPtrTypeInst);
+				}
+				bufferMembers.push_back(SPIRV::Type::Member { addrType, (addressesInPushConstants ? addressesOffset : 0) + 8 * bufferIndex, {} });
 				++bufferIndex;
 			}
 		}
 
-		auto structType = builder.declareType(SPIRV::Type(SPIRV::Type::StructureTag {}, bufferMembers, bufferIndex * 8, 8));
-		auto structPtrType = builder.declareType(SPIRV::Type(SPIRV::Type::PointerTag {}, SPIRV::StorageClass::Uniform, structType, 8));
+		if (addressesInPushConstants) {
+			pushConstantMembers.insert(pushConstantMembers.end(), bufferMembers.begin(), bufferMembers.end());
+			pushConstantEnd = addressesOffset + bufferIndex * 8;
+			pushConstantAlignment = std::max<size_t>(pushConstantAlignment, 8);
+		} else {
+			// add a global variable for the UBO that contains their physical addresses
+			auto structType = builder.declareType(SPIRV::Type(SPIRV::Type::StructureTag {}, bufferMembers, bufferIndex * 8, 8));
+			auto structPtrType = builder.declareType(SPIRV::Type(SPIRV::Type::PointerTag {}, SPIRV::StorageClass::Uniform, structType, 8));
 
-		builder.addDecoration(structType, SPIRV::Decoration { SPIRV::DecorationType::Block, {} });
+			builder.addDecoration(structType, SPIRV::Decoration { SPIRV::DecorationType::Block, {} });
 
-		uboPointersVar = builder.addGlobalVariable(structPtrType, SPIRV::StorageClass::Uniform);
-		builder.referenceGlobalVariable(uboPointersVar);
+			uboPointersVar = builder.addGlobalVariable(structPtrType, SPIRV::StorageClass::Uniform);
+			builder.referenceGlobalVariable(uboPointersVar);
 
-		builder.addDecoration(uboPointersVar, SPIRV::Decoration { SPIRV::DecorationType::DescriptorSet, { funcInfo.type == FunctionType::Fragment ? 1u : 0u } });
-		builder.addDecoration(uboPointersVar, SPIRV::Decoration { SPIRV::DecorationType::Binding, { 0 } });
+			builder.addDecoration(uboPointersVar, SPIRV::Decoration { SPIRV::DecorationType::DescriptorSet, { funcInfo.type == FunctionType::Fragment ? 1u : 0u } });
+			builder.addDecoration(uboPointersVar, SPIRV::Decoration { SPIRV::DecorationType::Binding, { 0 } });
+		}
 	}
 
+	SPIRV::ResultID pushConstantsVar = SPIRV::ResultIDInvalid;
+	if (pushConstantMembers.size() > 0) {
+		// note that the members use offsets relative to the start of the entire push constant block, not our part of it
+		auto structType = builder.declareType(SPIRV::Type(SPIRV::Type::StructureTag {}, pushConstantMembers, pushConstantEnd, pushConstantAlignment));
+		auto structPtrType = builder.declareType(SPIRV::Type(SPIRV::Type::PointerTag {}, SPIRV::StorageClass::PushConstant, structType, 8));
+
+		builder.addDecoration(structType, SPIRV::Decoration { SPIRV::DecorationType::Block, {} });
+
+		pushConstantsVar = builder.addGlobalVariable(structPtrType, SPIRV::StorageClass::PushConstant);
+		builder.referenceGlobalVariable(pushConstantsVar);
+	}
+
+	// loads a texture or sampler parameter's resource ID from the push constant block and returns a pointer to its descriptor in the resource table
+	// (so it can be used just like the variable for a regular binding)
+	auto bindlessResourcePointer = [&](size_t memberIndex, SPIRV::ResultID resourceType, uint32_t binding) {
+		auto tableVar = resourceTableVariableForType(resourceType, binding);
+
+		auto idPtrType = builder.declareType(SPIRV::Type(SPIRV::Type::PointerTag {}, SPIRV::StorageClass::PushConstant, u32Type, 8));
+		auto idAccess = builder.encodeAccessChain(idPtrType, pushConstantsVar, { builder.declareConstantScalar<int32_t>(memberIndex) });
+		auto slot = builder.encodeLoad(u32Type, idAccess);
+
+		auto resourcePtrType = builder.declareType(SPIRV::Type(SPIRV::Type::PointerTag {}, SPIRV::StorageClass::UniformConstant, resourceType, 8));
+		auto resourcePtr = builder.encodeAccessChain(resourcePtrType, tableVar, { slot });
+
+		return std::make_pair(resourcePtr, resourcePtrType);
+	};
+
 	uint32_t paramLocation = 0;
 	uint32_t bufferIndex = 0;
 
 	// internal binding indices are the actual bindings we expect Indium to bind resources with.
 	//
 	// as required by Indium, we must assign indices in the following order:
-	//   1. buffers (really only 1 index for all buffers)
+	//   1. buffers (really only 1 index for all buffers, and only if their addresses are in a UBO)
 	//   2. stage-ins
 	//   3. textures
 	//   4. samplers
 	size_t internalBindingIndex = 0;
 
-	if (bufferCount > 0) {
+	if (bufferCount > 0 && !addressesInPushConstants) {
 		// we put all our buffer addresses into a single UBO which occupies a single internal binding
 		++internalBindingIndex;
 	}
@@ -596,19 +973,83 @@ void Iridium::AIR::Function::analyze(SPIRV::Builder& builder, OutputInfo& output
 			uint32_t bindingIndex = DynamicLLVM::LLVMConstIntGetSExtValue(parameterInfo[infoIdx + 1]);
 			auto somethingElseTODO = DynamicLLVM::LLVMConstIntGetSExtValue(parameterInfo[infoIdx + 2]);
 
-			funcInfo.bindings.push_back(BindingInfo { BindingType::Buffer, bindingIndex, 0 });
+			// argument buffers are passed just like any other buffer, but Indium needs to know their layout to create argument encoders for them
+			if (auto structTypeInfo = findParameterInfoValue(parameterInfo, "air.struct_type_info"); structTypeInfo && DynamicLLVM::LLVMIsAMDNode(structTypeInfo)) {
+				auto structTypeInst = *builder.reverseLookupType(llvmTypeToSPIRVType(builder, DynamicLLVM::LLVMGetElementType(funcParamTypes[i])));
+				ArgumentBufferInfo argumentBufferInfo { bindingIndex, structTypeInst.size, structTypeInst.alignment, {} };
+
+				if (parseArgumentBufferInfo(structTypeInfo, argumentBufferInfo)) {
+					funcInfo.argumentBuffers.push_back(std::move(argumentBufferInfo));
+				}
+			}
 
 			auto ptrType = bufferMembers[bufferIndex].id;
-			auto ptrPtrType = builder.declareType(SPIRV::Type(SPIRV::Type::PointerTag {}, SPIRV::StorageClass::Uniform, ptrType, 8));
-			auto access = builder.encodeAccessChain(ptrPtrType, uboPointersVar, { builder.declareConstantScalar<int32_t>(bufferIndex) });
+			SPIRV::ResultID access = SPIRV::ResultIDInvalid;
+
+			if (addressesInPushConstants) {
+				funcInfo.bindings.push_back(BindingInfo { BindingType::Buffer, bindingIndex, /* ignored: */ 0, /* ignored: */ TextureAccessType::Read, /* ignored: */ 0, bufferMembers[bufferIndex].offset, 8 });
+
+				auto ptrPtrType = builder.declareType(SPIRV::Type(SPIRV::Type::PointerTag {}, SPIRV::StorageClass::PushConstant, ptrType, 8));
+				access = builder.encodeAccessChain(ptrPtrType, pushConstantsVar, { builder.declareConstantScalar<int32_t>(addressMemberBase + bufferIndex) });
+			} else {
+				funcInfo.bindings.push_back(BindingInfo { BindingType::Buffer, bindingIndex, 0 });
+
+				auto ptrPtrType = builder.declareType(SPIRV::Type(SPIRV::Type::PointerTag {}, SPIRV::StorageClass::Uniform, ptrType, 8));
+				access = builder.encodeAccessChain(ptrPtrType, uboPointersVar, { builder.declareConstantScalar<int32_t>(bufferIndex) });
+			}
+
 			auto load = builder.encodeLoad(ptrType, access);
 
+			++bufferIndex;
+
+			auto pushConstantMember = pushConstantMemberIndices.find(i);
+			if (pushConstantMember != pushConstantMemberIndices.end()) {
+				const auto& member = pushConstantMembers[pushConstantMember->second];
+				auto memberTypeInst = *builder.reverseLookupType(member.id);
+
+				funcInfo.bindings.push_back(BindingInfo { BindingType::PushConstantBuffer, bindingIndex, /* ignored: */ 0, /* ignored: */ TextureAccessType::Read, /* ignored: */ 0, member.offset, memberTypeInst.size });
+
+				// the contents are either in the push constant block (if the address is null) or in a buffer bound with setBuffer(),
+				// so we copy them into a local variable and let the function use that instead.
+				auto localPtrType = builder.declareType(SPIRV::Type(SPIRV::Type::PointerTag {}, SPIRV::StorageClass::Function, member.id, 8));
+				auto local = builder.addFunctionVariable(localPtrType);
+
+				auto pushConstantLabel = builder.reserveResultID();
+				auto bufferLabel = builder.reserveResultID();
+				auto mergeLabel = builder.reserveResultID();
+
+				auto isNull = builder.encodeIEqual(load, builder.declareConstantScalar<uint64_t>(0));
+				builder.encodeSelectionMerge(mergeLabel);
+				builder.encodeBranchConditional(isNull, pushConstantLabel, bufferLabel);
+
+				builder.insertLabel(pushConstantLabel);
+				auto pushConstantPtrType = builder.declareType(SPIRV::Type(SPIRV::Type::PointerTag {}, SPIRV::StorageClass::PushConstant, member.id, 8));
+				auto pushConstantAccess = builder.encodeAccessChain(pushConstantPtrType, pushConstantsVar, { builder.declareConstantScalar<int32_t>(pushConstantMember->second) });
+				builder.encodeStore(local, builder.encodeLoad(member.id, pushConstantAccess));
+				builder.encodeBranch(mergeLabel);
+
+				builder.insertLabel(bufferLabel);
+				auto bufferPtrType = builder.declareType(SPIRV::Type(SPIRV::Type::PointerTag {}, SPIRV::StorageClass::PhysicalStorageBuffer, member.id, 8));
+				auto bufferPtr = builder.encodeConvertUToPtr(bufferPtrType, load);
+				builder.encodeStore(local, builder.encodeLoad(member.id, bufferPtr, static_cast<uint8_t>(memberTypeInst.alignment)));
+				builder.encodeBranch(mergeLabel);
+
+				// the rest of the entry block (including the function's first block) continues in the merge block
+				builder.insertLabel(mergeLabel);
+				entryLabelID = mergeLabel;
+
+				_parameterIDs.push_back(local);
+
+				builder.associateExistingResultID(local, llparamVal);
+				builder.setResultType(local, localPtrType);
+
+				continue;
+			}
+
 			_parameterIDs.push_back(load);
 
 			builder.associateExistingResultID(load, llparamVal);
 			builder.setResultType(load, ptrType);
-
-			++bufferIndex;
 		} else if (kind == "air.position") {
 			auto load = builder.encodeLoad(vec4Type, fragCoordVar);
 			_parameterIDs.push_back(load);
@@ -707,7 +1148,7 @@ void Iridium::AIR::Function::analyze(SPIRV::Builder& builder, OutputInfo& output
 		if (kind == "air.texture") {
 			// find the location index info, determine the access type, and find the arg type info
 			size_t infoIdx = SIZE_MAX;
-			TextureAccessType accessType = TextureAccessType::Sample;
+			TextureAccessType accessType = textureAccessTypeForParameter(parameterInfo);
 			size_t argTypeIdx = SIZE_MAX;
 			for (size_t idx = 0; idx < parameterInfo.size(); ++idx) {
 				if (DynamicLLVM::LLVMIsAMDString(parameterInfo[idx])) {
@@ -715,8 +1156,6 @@ void Iridium::AIR::Function::analyze(SPIRV::Builder& builder, OutputInfo& output
 
 					if (str == "air.location_index") {
 						infoIdx = idx;
-					} else if (str == "air.sample") {
-						accessType = TextureAccessType::Sample;
 					} else if (str == "air.arg_type_name") {
 						argTypeIdx = idx;
 					}
@@ -744,11 +1183,8 @@ void Iridium::AIR::Function::analyze(SPIRV::Builder& builder, OutputInfo& output
 			std::string_view sampleTypeName(argType.data() + (firstAngle + 1), comma - (firstAngle + 1));
 			std::string_view accessTypeName(argType.data() + notWhitespace, lastAngle - notWhitespace);
 
-			funcInfo.bindings.push_back(BindingInfo { BindingType::Texture, bindingIndex, internalBindingIndex, accessType });
-
 			SPIRV::ResultID fakeSampleType = SPIRV::ResultIDInvalid;
 			SPIRV::ResultID realSampleType = SPIRV::ResultIDInvalid;
-			SPIRV::Dim dimensionality;
 
 			// TODO: find a better way to do this than just matching different strings
 			if (sampleTypeName == "half") {
@@ -761,14 +1197,32 @@ void Iridium::AIR::Function::analyze(SPIRV::Builder& builder, OutputInfo& output
 				realSampleType = fakeSampleType;
 			}
 
-			// TODO: same here (find a better way...)
-			if (textureClassName == "texture2d") {
-				dimensionality = SPIRV::Dim::e2D;
-			} else if (textureClassName == "texturecube") {
-				dimensionality = SPIRV::Dim::eCube;
+			std::optional<std::pair<SPIRV::Dim, bool>> dimensions;
+			if (textureClassName.compare(0, sizeof("texture") - 1, "texture") == 0) {
+				dimensions = textureDimensionsForKind(textureClassName.substr(sizeof("texture") - 1));
+			}
+			if (!dimensions) {
+				throw std::runtime_error(std::string("Unsupported texture type: ") + std::string(argType));
+			}
+
+			auto imageType = builder.declareType(SPIRV::Type(SPIRV::Type::ImageTag {}, fakeSampleType, realSampleType, dimensions->first, 2, dimensions->second, false, accessType == TextureAccessType::Sample ? 1 : 2, SPIRV::ImageFormat::Unknown));
+
+			if (auto resourceIDMember = resourceIDMemberIndices.find(i); resourceIDMember != resourceIDMemberIndices.end()) {
+				const auto& member = pushConstantMembers[resourceIDMember->second];
+				funcInfo.bindings.push_back(BindingInfo { BindingType::Texture, bindingIndex, /* ignored: */ 0, accessType, /* ignored: */ 0, member.offset, sizeof(uint32_t) });
+
+				auto [resourcePtr, resourcePtrType] = bindlessResourcePointer(resourceIDMember->second, imageType, resourceTableTextureBinding);
+
+				_parameterIDs.push_back(resourcePtr);
+
+				builder.associateExistingResultID(resourcePtr, reinterpret_cast<uintptr_t>(DynamicLLVM::LLVMGetParam(_function, i)));
+				builder.setResultType(resourcePtr, resourcePtrType);
+
+				continue;
 			}
 
-			auto imageType = builder.declareType(SPIRV::Type(SPIRV::Type::ImageTag {}, fakeSampleType, realSampleType, dimensionality, 2, false, false, accessType == TextureAccessType::Sample ? 1 : 2, SPIRV::ImageFormat::Unknown));
+			funcInfo.bindings.push_back(BindingInfo { BindingType::Texture, bindingIndex, internalBindingIndex, accessType });
+
 			auto imagePtrType = builder.declareType(SPIRV::Type(SPIRV::Type::PointerTag {}, SPIRV::StorageClass::UniformConstant, imageType, 8));
 			auto var = builder.addGlobalVariable(imagePtrType, SPIRV::StorageClass::UniformConstant);
 			//auto load = builder.encodeLoad(imageType, var);
@@ -820,9 +1274,24 @@ void Iridium::AIR::Function::analyze(SPIRV::Builder& builder, OutputInfo& output
 			uint32_t bindingIndex = DynamicLLVM::LLVMConstIntGetSExtValue(parameterInfo[infoIdx + 1]);
 			auto somethingElseTODO = DynamicLLVM::LLVMConstIntGetSExtValue(parameterInfo[infoIdx + 2]);
 
+			auto samplerType = builder.declareType(SPIRV::Type(SPIRV::Type::SamplerTag {}));
+
+			if (auto resourceIDMember = resourceIDMemberIndices.find(i); resourceIDMember != resourceIDMemberIndices.end()) {
+				const auto& member = pushConstantMembers[resourceIDMember->second];
+				funcInfo.bindings.push_back(BindingInfo { BindingType::Sampler, bindingIndex, /* ignored: */ 0, /* ignored: */ TextureAccessType::Read, /* ignored: */ SIZE_MAX, member.offset, sizeof(uint32_t) });
+
+				auto [resourcePtr, resourcePtrType] = bindlessResourcePointer(resourceIDMember->second, samplerType, resourceTableSamplerBinding);
+
+				_parameterIDs.push_back(resourcePtr);
+
+				builder.associateExistingResultID(resourcePtr, reinterpret_cast<uintptr_t>(DynamicLLVM::LLVMGetParam(_function, i)));
+				builder.setResultType(resourcePtr, resourcePtrType);
+
+				continue;
+			}
+
 			funcInfo.bindings.push_back(BindingInfo { BindingType::Sampler, bindingIndex, internalBindingIndex, /* ignored: */ TextureAccessType::Read, /* ignored: */ SIZE_MAX });
 
-			auto samplerType = builder.declareType(SPIRV::Type(SPIRV::Type::SamplerTag {}));
 			auto samplerPtrType = builder.declareType(SPIRV::Type(SPIRV::Type::PointerTag {}, SPIRV::StorageClass::UniformConstant, samplerType, 8));
 			auto var = builder.addGlobalVariable(samplerPtrType, SPIRV::StorageClass::UniformConstant);
 			//auto load = builder.encodeLoad(samplerType, var);
@@ -942,8 +1411,8 @@ void Iridium::AIR::Function::analyze(SPIRV::Builder& builder, OutputInfo& output
 		if (isFirst) {
 			isFirst = false;
 
-			// assign the existing ID
-			builder.associateExistingResultID(firstLabelID, reinterpret_cast<uintptr_t>(bb));
+			// assign the existing ID (the label of the block we're currently in, which is where the first block's instructions will go)
+			builder.associateExistingResultID(entryLabelID, reinterpret_cast<uintptr_t>(bb));
 		} else {
 			// assign a new ID
 			builder.associateResultID(reinterpret_cast<uintptr_t>(bb));
@@ -1075,11 +1544,22 @@ void Iridium::AIR::Function::analyze(SPIRV::Builder& builder, OutputInfo& output
 					// there's OpPtrAccessChain, which is tantalizingly named, but unfortunately that instruction doesn't work as expected
 					// either. i've tried using the raw index (i.e. in element units) and the multiplied index (i.e. in bytes), but no dice.
 					// so, let's do it ourselves. a little pointer arithmetic never hurt anybody, right? (it most certainly has).
-					auto uint64Type = builder.declareType(SPIRV::Type(SPIRV::Type::IntegerTag {}, 64, false));
-					auto asInteger = builder.encodeConvertPtrToU(uint64Type, tmp2);
-					auto mul = builder.encodeArithBinop(SPIRV::Opcode::IMul, uint64Type, indices[0], builder.declareConstantScalar<uint64_t>(origTypeTarget.size));
-					auto added = builder.encodeArithBinop(SPIRV::Opcode::IAdd, uint64Type, asInteger, mul);
-					auto asPtr = builder.encodeConvertUToPtr(origTypeID, added);
+					SPIRV::ResultID asPtr = tmp2;
+
+					if (origType.pointerStorageClass == SPIRV::StorageClass::PhysicalStorageBuffer) {
+						auto uint64Type = builder.declareType(SPIRV::Type(SPIRV::Type::IntegerTag {}, 64, false));
+						auto asInteger = builder.encodeConvertPtrToU(uint64Type, tmp2);
+						auto mul = builder.encodeArithBinop(SPIRV::Opcode::IMul, uint64Type, indices[0], builder.declareConstantScalar<uint64_t>(origTypeTarget.size));
+						auto added = builder.encodeArithBinop(SPIRV::Opcode::IAdd, uint64Type, asInteger, mul);
+						asPtr = builder.encodeConvertUToPtr(origTypeID, added);
+					} else {
+						// logical pointers (e.g. into the push constant block) can't be converted to integers.
+						// these only ever point to a single object, though, so the initial index should always be zero and we can just skip it.
+						auto llindex = DynamicLLVM::LLVMGetOperand(inst, 1);
+						if (!DynamicLLVM::LLVMIsAConstantInt(llindex) || DynamicLLVM::LLVMConstIntGetZExtValue(llindex) != 0) {
+							throw std::runtime_error("Unsupported pointer offset into logical storage");
+						}
+					}
 
 					indices.erase(indices.begin());
 
@@ -1099,7 +1579,8 @@ void Iridium::AIR::Function::analyze(SPIRV::Builder& builder, OutputInfo& output
 					auto alignment = DynamicLLVM::LLVMGetAlignment(inst);
 					auto ptr = DynamicLLVM::LLVMGetOperand(inst, 0);
 					auto targetType = DynamicLLVM::LLVMTypeOf(inst);
-					auto type = llvmTypeToSPIRVType(builder, targetType);
+					// we're reading the value from memory, so if it's a pointer, it's stored the same way as in the type of the pointer we're loading from
+					auto type = llvmTypeToSPIRVType(builder, targetType, true);
 					auto op = llvmValueToResultID(builder, ptr);
 					auto opType = *builder.reverseLookupType(builder.lookupResultType(op));
 					auto opDerefType = *builder.reverseLookupType(opType.targetType);
@@ -1114,6 +1595,23 @@ void Iridium::AIR::Function::analyze(SPIRV::Builder& builder, OutputInfo& output
 
 					auto resID = builder.encodeLoad(type, op, alignment);
 
+					if (isResourcePointerType(targetType)) {
+						// this is a texture or sampler being loaded from an argument buffer, so what we just loaded is its resource ID.
+						// we look the resource up in the resource table and use a pointer to its descriptor, just like we do for texture and sampler parameters.
+						auto [tableVar, resourceType] = resourceTableVariable(DynamicLLVM::LLVMGetElementType(targetType));
+						auto resourcePtrType = builder.declareType(SPIRV::Type(SPIRV::Type::PointerTag {}, SPIRV::StorageClass::UniformConstant, resourceType, 8));
+						auto slot = builder.encodeUConvert(u32Type, resID);
+						auto resourcePtr = builder.encodeAccessChain(resourcePtrType, tableVar, { slot });
+
+						// nothing guarantees that the index is the same for all invocations
+						builder.addDecoration(slot, SPIRV::Decoration { SPIRV::DecorationType::NonUniform, {} });
+						builder.addDecoration(resourcePtr, SPIRV::Decoration { SPIRV::DecorationType::NonUniform, {} });
+						nonUniformResources.insert(resourcePtr);
+
+						resID = resourcePtr;
+						type = resourcePtrType;
+					}
+
 					builder.associateExistingResultID(resID, reinterpret_cast<uintptr_t>(inst));
 					builder.setResultType(resID, type);
 				} break;
@@ -1149,7 +1647,7 @@ void Iridium::AIR::Function::analyze(SPIRV::Builder& builder, OutputInfo& output
 						auto arg = DynamicLLVM::LLVMGetOperand(inst, 0);
 
 						resID = builder.encodeConvertUToF(type, llvmValueToResultID(builder, arg));
-					} else if (name == "air.sample_texture_2d.v4f16" || name == "air.sample_texture_2d.v4f32" || name == "air.sample_texture_cube.v4f16") {
+					} else if (auto sampleDimensions = sampleTextureDimensions(name)) {
 						auto textureArg = DynamicLLVM::LLVMGetOperand(inst, 0);
 						auto samplerArg = DynamicLLVM::LLVMGetOperand(inst, 1);
 						auto textureCoordArg = DynamicLLVM::LLVMGetOperand(inst, 2);
@@ -1179,12 +1677,43 @@ void Iridium::AIR::Function::analyze(SPIRV::Builder& builder, OutputInfo& output
 						auto sampledImageType = builder.declareType(SPIRV::Type(SPIRV::Type::SampledImageTag {}, textureType));
 						auto sampledImage = builder.encodeSampledImage(sampledImageType, textureLoad, samplerLoad);
 
+						// resources from the resource table can differ between invocations, so everything derived from them has to be marked as such
+						if (nonUniformResources.count(textureArgID) > 0 || nonUniformResources.count(samplerArgID) > 0) {
+							for (auto id: { textureLoad, samplerLoad, sampledImage }) {
+								builder.addDecoration(id, SPIRV::Decoration { SPIRV::DecorationType::NonUniform, {} });
+							}
+						}
+
 						// WORKAROUND: as explained before, we use 32-bit floats in place of 16-bit floats for image sampling.
 						auto textureSampleComponentType = builder.declareType(SPIRV::Type(SPIRV::Type::FloatTag {}, 32));
 						auto textureSampleType = builder.declareType(SPIRV::Type(SPIRV::Type::VectorTag {}, 4, textureSampleComponentType, 16, 8));
-						auto sampled = builder.encodeImageSampleImplicitLod(textureSampleType, sampledImage, llvmValueToResultID(builder, textureCoordArg));
+						auto coordinate = llvmValueToResultID(builder, textureCoordArg);
+
+						// for arrayed textures, AIR passes the array index (as an integer) right after the coordinate,
+						// but SPIR-V expects it as an extra (floating-point) coordinate component
+						if (sampleDimensions->second) {
+							auto layerArg = DynamicLLVM::LLVMGetOperand(inst, 3);
+							auto layer = builder.encodeConvertUToF(floatType, llvmValueToResultID(builder, layerArg));
+							auto count = coordinateCountForDimensionality(sampleDimensions->first);
+							auto coordinateType = builder.declareType(SPIRV::Type(SPIRV::Type::VectorTag {}, count + 1, floatType, floatTypeInst.size * (count + 1), ((count + 1 == 3 || count + 1 == 4) ? 4 : 2) * floatTypeInst.alignment));
+
+							if (count == 1) {
+								coordinate = builder.encodeCompositeInsert(coordinateType, coordinate, builder.declareUndefinedValue(coordinateType), { 0 });
+							} else {
+								std::vector<uint32_t> components;
+								for (uint32_t i = 0; i < count; ++i) {
+									components.push_back(i);
+								}
+								components.push_back(UINT32_MAX);
+								coordinate = builder.encodeVectorShuffle(coordinateType, coordinate, coordinate, components);
+							}
+
+							coordinate = builder.encodeCompositeInsert(coordinateType, layer, coordinate, { static_cast<uint32_t>(count) });
+						}
+
+						auto sampled = builder.encodeImageSampleImplicitLod(textureSampleType, sampledImage, coordinate);
 
-						if (name == "air.sample_texture_2d.v4f16" || name == "air.sample_texture_cube.v4f16") {
+						if (name.compare(name.size() - (sizeof(".v4f16") - 1), std::string_view::npos, ".v4f16") == 0) {
 							auto convertedComponentType = builder.declareType(SPIRV::Type(SPIRV::Type::FloatTag {}, 16));
 							auto convertedType = builder.declareType(SPIRV::Type(SPIRV::Type::VectorTag {}, 4, convertedComponentType, 8, 8));
 							sampled = builder.encodeFConvert(convertedType, sampled);
@@ -1564,7 +2093,7 @@ const Iridium::AIR::Function* Iridium::AIR::Library::getFunction(const std::stri
 	return &it->second;
 };
 
-void Iridium::AIR::Library::buildModule(SPIRV::Builder& builder, OutputInfo& outputInfo) {
+void Iridium::AIR::Library::buildModule(SPIRV::Builder& builder, OutputInfo& outputInfo, const TranslationOptions& options) {
 	builder.requireCapability(SPIRV::Capability::Shader);
 	builder.requireCapability(SPIRV::Capability::PhysicalStorageBufferAddresses);
 	builder.setAddressingModel(SPIRV::AddressingModel::PhysicalStorageBuffer64);
@@ -1572,7 +2101,7 @@ void Iridium::AIR::Library::buildModule(SPIRV::Builder& builder, OutputInfo& out
 	builder.setVersion(1, 5);
 
 	for (auto& [name, func]: _functions) {
-		func.analyze(builder, _outputInfo);
+		func.analyze(builder, _outputInfo, options);
 	}
 
 	outputInfo = _outputInfo;
@@ -15,13 +15,70 @@ void Iridium::finit() {
 	Iridium::DynamicLLVM::finit();
 };
 
-void* Iridium::translate(const void* inputData, size_t inputSize, size_t& outputSize, OutputInfo& outputInfo) {
+void* Iridium::translate(const void* inputData, size_t inputSize, size_t& outputSize, OutputInfo& outputInfo, const TranslationOptions& options) {
 	AIR::Library lib(inputData, inputSize);
 	SPIRV::Builder builder;
 
-	lib.buildModule(builder, outputInfo);
+	lib.buildModule(builder, outputInfo, options);
 
 	auto result = builder.finalize(outputSize);
 
 	return result;
 };
+
+void* Iridium::buildAccumulateShader(size_t& outputSize) {
+	SPIRV::Builder builder;
+
+	builder.requireCapability(SPIRV::Capability::Shader);
+	builder.requireCapability(SPIRV::Capability::Int64);
+	builder.requireCapability(SPIRV::Capability::PhysicalStorageBufferAddresses);
+	builder.setAddressingModel(SPIRV::AddressingModel::PhysicalStorageBuffer64);
+	builder.setMemoryModel(SPIRV::MemoryModel::GLSL450);
+	builder.setVersion(1, 5);
+
+	auto voidType = builder.declareType(SPIRV::Type(SPIRV::Type::VoidTag {}));
+	auto funcType = builder.declareType(SPIRV::Type(SPIRV::Type::FunctionTag {}, voidType, {}, 8));
+	auto u64Type = builder.declareType(SPIRV::Type(SPIRV::Type::IntegerTag {}, 64, false));
+	auto u64PushConstantPtrType = builder.declareType(SPIRV::Type(SPIRV::Type::PointerTag {}, SPIRV::StorageClass::PushConstant, u64Type, 8));
+	auto u64BufferPtrType = builder.declareType(SPIRV::Type(SPIRV::Type::PointerTag {}, SPIRV::StorageClass::PhysicalStorageBuffer, u64Type, 8));
+
+	auto pushConstantsType = builder.declareType(SPIRV::Type(SPIRV::Type::StructureTag {}, {
+		SPIRV::Type::Member { u64Type, 0, {} },
+		SPIRV::Type::Member { u64Type, 8, {} },
+	}, 16, 8));
+	auto pushConstantsPtrType = builder.declareType(SPIRV::Type(SPIRV::Type::PointerTag {}, SPIRV::StorageClass::PushConstant, pushConstantsType, 8));
+	builder.addDecoration(pushConstantsType, SPIRV::Decoration { SPIRV::DecorationType::Block, {} });
+
+	auto pushConstantsVar = builder.addGlobalVariable(pushConstantsPtrType, SPIRV::StorageClass::PushConstant);
+
+	auto localSize = builder.declareConstantScalar<uint32_t>(1);
+
+	auto funcID = builder.declareFunction(funcType);
+
+	builder.addEntryPoint(SPIRV::EntryPoint {
+		SPIRV::ExecutionModel::GLCompute,
+		funcID.id,
+		"main",
+		{},
+		{
+			{ SPIRV::ExecutionMode::LocalSizeId, true, { localSize, localSize, localSize } },
+		},
+	});
+
+	builder.beginFunction(funcID.id);
+	builder.referenceGlobalVariable(pushConstantsVar);
+
+	auto sourceAddress = builder.encodeLoad(u64Type, builder.encodeAccessChain(u64PushConstantPtrType, pushConstantsVar, { builder.declareConstantScalar<int32_t>(0) }));
+	auto destinationAddress = builder.encodeLoad(u64Type, builder.encodeAccessChain(u64PushConstantPtrType, pushConstantsVar, { builder.declareConstantScalar<int32_t>(1) }));
+
+	auto source = builder.encodeConvertUToPtr(u64BufferPtrType, sourceAddress);
+	auto destination = builder.encodeConvertUToPtr(u64BufferPtrType, destinationAddress);
+
+	auto sum = builder.encodeArithBinop(SPIRV::Opcode::IAdd, u64Type, builder.encodeLoad(u64Type, destination, 8), builder.encodeLoad(u64Type, source, 8));
+	builder.encodeStore(destination, sum, 8);
+
+	builder.encodeReturn();
+	builder.endFunction();
+
+	return builder.finalize(outputSize);
+};
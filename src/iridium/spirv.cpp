@@ -133,6 +133,14 @@ Iridium::SPIRV::ResultID Iridium::SPIRV::Builder::declareType(const Type& type)
 		} else if (typeCopy.scalarWidth > 32) {
 			_requiredCapabilities.insert(Capability::Int64);
 		}
+	} else if (typeCopy.backingType == Type::BackingType::Image) {
+		// sampled 1D and cube array images need their own capabilities (and storage ones need different ones)
+		bool isStorage = typeCopy.imageIsSampledIndication == 2;
+		if (typeCopy.imageDimensionality == Dim::e1D) {
+			_requiredCapabilities.insert(isStorage ? Capability::Image1D : Capability::Sampled1D);
+		} else if (typeCopy.imageDimensionality == Dim::eCube && typeCopy.imageIsArrayed) {
+			_requiredCapabilities.insert(isStorage ? Capability::ImageCubeArray : Capability::SampledCubeArray);
+		}
 	}
 
 	return id;
@@ -230,6 +238,12 @@ Iridium::SPIRV::ResultID Iridium::SPIRV::Builder::addGlobalVariable(ResultID typ
 	return resultID;
 };
 
+Iridium::SPIRV::ResultID Iridium::SPIRV::Builder::addFunctionVariable(ResultID typeID, ResultID initializer) {
+	auto resultID = reserveResultID();
+	_currentFunctionInfo->variables[resultID] = FunctionVariable { typeID, initializer };
+	return resultID;
+};
+
 void Iridium::SPIRV::Builder::addDecoration(ResultID resultID, const Decoration& decoration) {
 	if (_decorations.find(resultID) == _decorations.end()) {
 		_decorations[resultID] = std::unordered_set<Decoration> { decoration };
@@ -705,6 +719,18 @@ Iridium::SPIRV::ResultID Iridium::SPIRV::Builder::encodeFOrdGreaterThan(ResultID
 	return result;
 };
 
+Iridium::SPIRV::ResultID Iridium::SPIRV::Builder::encodeIEqual(ResultID operand1, ResultID operand2) {
+	auto result = reserveResultID();
+	auto resultTypeID = declareType(SPIRV::Type(SPIRV::Type::BooleanTag {}));
+	auto tmp = beginInstruction(Opcode::IEqual, *_currentFunctionWriter);
+	_currentFunctionWriter->writeIntegerLE<uint32_t>(resultTypeID);
+	_currentFunctionWriter->writeIntegerLE<uint32_t>(result);
+	_currentFunctionWriter->writeIntegerLE<uint32_t>(operand1);
+	_currentFunctionWriter->writeIntegerLE<uint32_t>(operand2);
+	endInstruction(std::move(tmp));
+	return result;
+};
+
 void Iridium::SPIRV::Builder::encodeBranch(ResultID targetLabel) {
 	auto tmp = beginInstruction(Opcode::Branch, *_currentFunctionWriter);
 	_currentFunctionWriter->writeIntegerLE<uint32_t>(targetLabel);
@@ -936,6 +962,12 @@ void* Iridium::SPIRV::Builder::finalize(size_t& outputSize) {
 	for (const auto& [type, id]: _typeIDs) {
 		if (type.backingType == Type::BackingType::RuntimeArray || type.backingType == Type::BackingType::Array) {
 			auto elmTypeInst = _reverseTypeIDs[type.targetType];
+
+			// arrays of opaque types (e.g. descriptor arrays of images) have no memory layout, so they can't have a stride
+			if (elmTypeInst->backingType == Type::BackingType::Image || elmTypeInst->backingType == Type::BackingType::Sampler || elmTypeInst->backingType == Type::BackingType::SampledImage) {
+				continue;
+			}
+
 			tmp = beginInstruction(Opcode::Decorate, _writer);
 			_writer.writeIntegerLE<uint32_t>(id);
 			_writer.writeIntegerLE<uint32_t>(static_cast<uint32_t>(DecorationType::ArrayStride));
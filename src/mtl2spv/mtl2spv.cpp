@@ -96,6 +96,8 @@ int main(int argc, char** argv) {
 					outFileJSON << "sampler";
 				} else if (binding.type == Iridium::BindingType::VertexInput) {
 					outFileJSON << "vertex-input";
+				} else if (binding.type == Iridium::BindingType::PushConstantBuffer) {
+					outFileJSON << "push-constant-buffer";
 				} else {
 					outFileJSON << "undefined";
 				}
@@ -103,7 +105,14 @@ int main(int argc, char** argv) {
 
 				outFileJSON << "\t\t\t\t\t\"index\": " << (binding.index == SIZE_MAX ? "-1" : std::to_string(binding.index));
 
-				if (binding.type != Iridium::BindingType::VertexInput) {
+				if (binding.type == Iridium::BindingType::Buffer && binding.pushConstantSize > 0) {
+					outFileJSON << "," << std::endl;
+					outFileJSON << "\t\t\t\t\t\"push-constant-offset\": " << std::to_string(binding.pushConstantOffset) << std::endl;
+				} else if (binding.type == Iridium::BindingType::PushConstantBuffer) {
+					outFileJSON << "," << std::endl;
+					outFileJSON << "\t\t\t\t\t\"push-constant-offset\": " << std::to_string(binding.pushConstantOffset) << "," << std::endl;
+					outFileJSON << "\t\t\t\t\t\"push-constant-size\": " << std::to_string(binding.pushConstantSize) << std::endl;
+				} else if (binding.type != Iridium::BindingType::VertexInput) {
 					outFileJSON << "," << std::endl;
 					outFileJSON << "\t\t\t\t\t\"internal-index\": " << std::to_string(binding.internalIndex) << (binding.type == Iridium::BindingType::Buffer ? "" : ",") << std::endl;
 				} else {
@@ -233,7 +242,50 @@ int main(int argc, char** argv) {
 
 				outFileJSON << "\t\t\t\t}" << ((i + 1 == it->second.embeddedSamplers.size()) ? "" : ",") << std::endl;
 			}
-			outFileJSON << "\t\t\t]" << std::endl;
+			outFileJSON << "\t\t\t]," << std::endl;
+
+			outFileJSON << "\t\t\t\"argument-buffers\": [" << std::endl;
+			for (size_t i = 0; i < it->second.argumentBuffers.size(); ++i) {
+				const auto& argumentBuffer = it->second.argumentBuffers[i];
+				outFileJSON << "\t\t\t\t{" << std::endl;
+
+				outFileJSON << "\t\t\t\t\t\"buffer-index\": " << std::to_string(argumentBuffer.bufferIndex) << "," << std::endl;
+				outFileJSON << "\t\t\t\t\t\"encoded-length\": " << std::to_string(argumentBuffer.encodedLength) << "," << std::endl;
+				outFileJSON << "\t\t\t\t\t\"alignment\": " << std::to_string(argumentBuffer.alignment) << "," << std::endl;
+
+				outFileJSON << "\t\t\t\t\t\"arguments\": [" << std::endl;
+				for (size_t j = 0; j < argumentBuffer.arguments.size(); ++j) {
+					const auto& argument = argumentBuffer.arguments[j];
+					outFileJSON << "\t\t\t\t\t\t{" << std::endl;
+
+					outFileJSON << "\t\t\t\t\t\t\t\"type\": \"";
+					if (argument.type == Iridium::ArgumentType::Constant) {
+						outFileJSON << "constant";
+					} else if (argument.type == Iridium::ArgumentType::Buffer) {
+						outFileJSON << "buffer";
+					} else if (argument.type == Iridium::ArgumentType::Texture) {
+						outFileJSON << "texture";
+					} else if (argument.type == Iridium::ArgumentType::Sampler) {
+						outFileJSON << "sampler";
+					} else {
+						outFileJSON << "undefined";
+					}
+					outFileJSON << "\"," << std::endl;
+
+					outFileJSON << "\t\t\t\t\t\t\t\"index\": " << std::to_string(argument.index) << "," << std::endl;
+					outFileJSON << "\t\t\t\t\t\t\t\"offset\": " << std::to_string(argument.offset) << "," << std::endl;
+					outFileJSON << "\t\t\t\t\t\t\t\"size\": " << std::to_string(argument.size) << "," << std::endl;
+					outFileJSON << "\t\t\t\t\t\t\t\"array-length\": " << std::to_string(argument.arrayLength) << std::endl;
+
+					outFileJSON << "\t\t\t\t\t\t}" << ((j + 1 == argumentBuffer.arguments.size()) ? "" : ",") << std::endl;
+				}
+				outFileJSON << "\t\t\t\t\t]" << std::endl;
+
+				outFileJSON << "\t\t\t\t}" << ((i + 1 == it->second.argumentBuffers.size()) ? "" : ",") << std::endl;
+			}
+			outFileJSON << "\t\t\t]," << std::endl;
+
+			outFileJSON << "\t\t\t\"uses-resource-table\": " << (it->second.usesResourceTable ? "true" : "false") << std::endl;
 
 			outFileJSON << "\t\t}" << ((std::next(it) == outputInfo.functionInfos.end()) ? "" : ",") << std::endl;
 		}
@@ -0,0 +1,195 @@
+#include "add.h"
+
+#include <indium/indium.hpp>
+
+#include <thread>
+#include <functional>
+#include <iostream>
+#include <new>
+
+#include <cstdlib>
+
+#ifndef ENABLE_VALIDATION
+	#define ENABLE_VALIDATION (!!getenv("INDIUM_TEST_VALIDATION"))
+#endif
+
+// this checks that encoding commands doesn't allocate once an encoder has warmed up:
+// every dispatch binds new buffer offsets (so it needs new bindings every time), but none of them should touch the heap.
+
+static constexpr unsigned int threadsPerDispatch = 64;
+// 256 bytes is the largest buffer offset alignment a device can require
+static constexpr unsigned int dispatchStride = 256 / sizeof(float);
+static constexpr unsigned int warmupDispatchCount = 16;
+static constexpr unsigned int measuredDispatchCount = 1024;
+static constexpr unsigned int dispatchCount = warmupDispatchCount + measuredDispatchCount;
+static constexpr unsigned int commandBufferCount = 4;
+static constexpr unsigned int arrayLength = dispatchCount * dispatchStride;
+static constexpr unsigned int bufferSize = arrayLength * sizeof(float);
+
+// only allocations made by the encoding thread are counted (the device polling thread is free to do whatever it wants)
+static thread_local bool countAllocations = false;
+static thread_local size_t allocationCount = 0;
+
+static void* countedAllocate(size_t size, size_t alignment) {
+	if (countAllocations) {
+		++allocationCount;
+	}
+
+	void* result = nullptr;
+	if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+		// aligned_alloc() requires the size to be a multiple of the alignment
+		result = aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+	} else {
+		result = malloc(size == 0 ? 1 : size);
+	}
+
+	if (!result) {
+		throw std::bad_alloc();
+	}
+
+	return result;
+};
+
+void* operator new(size_t size) {
+	return countedAllocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+};
+
+void* operator new[](size_t size) {
+	return countedAllocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+};
+
+void* operator new(size_t size, std::align_val_t alignment) {
+	return countedAllocate(size, static_cast<size_t>(alignment));
+};
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+	return countedAllocate(size, static_cast<size_t>(alignment));
+};
+
+void operator delete(void* pointer) noexcept {
+	free(pointer);
+};
+
+void operator delete[](void* pointer) noexcept {
+	free(pointer);
+};
+
+void operator delete(void* pointer, size_t size) noexcept {
+	free(pointer);
+};
+
+void operator delete[](void* pointer, size_t size) noexcept {
+	free(pointer);
+};
+
+void operator delete(void* pointer, std::align_val_t alignment) noexcept {
+	free(pointer);
+};
+
+void operator delete[](void* pointer, std::align_val_t alignment) noexcept {
+	free(pointer);
+};
+
+void operator delete(void* pointer, size_t size, std::align_val_t alignment) noexcept {
+	free(pointer);
+};
+
+void operator delete[](void* pointer, size_t size, std::align_val_t alignment) noexcept {
+	free(pointer);
+};
+
+int main(int argc, char** argv) {
+	Indium::init(nullptr, 0, ENABLE_VALIDATION);
+
+	bool ok = true;
+
+	{
+		auto device = Indium::createSystemDefaultDevice();
+
+		bool keepPollingDevice = true;
+
+		std::thread devicePollingThread([device, &keepPollingDevice]() {
+			while (keepPollingDevice) {
+				device->pollEvents(UINT64_MAX);
+			}
+		});
+
+		auto lib = device->newLibrary(compute_add, compute_add_len);
+		auto func = lib->newFunction("add_arrays");
+
+		auto pso = device->newComputePipelineState(func);
+		auto commandQueue = device->newCommandQueue();
+
+		auto bufA = device->newBuffer(bufferSize, Indium::ResourceOptions::StorageModeShared);
+		auto bufB = device->newBuffer(bufferSize, Indium::ResourceOptions::StorageModeShared);
+		auto bufResult = device->newBuffer(bufferSize, Indium::ResourceOptions::StorageModeShared);
+
+		auto a = static_cast<float*>(bufA->contents());
+		auto b = static_cast<float*>(bufB->contents());
+		auto result = static_cast<float*>(bufResult->contents());
+
+		// later command buffers reuse the arenas and upload heaps of earlier ones, so they should be just as quiet
+		for (size_t commandBufferIndex = 0; commandBufferIndex < commandBufferCount; ++commandBufferIndex) {
+			for (size_t i = 0; i < arrayLength; ++i) {
+				a[i] = (float)rand() / (float)RAND_MAX;
+				b[i] = (float)rand() / (float)RAND_MAX;
+				result[i] = -1;
+			}
+
+			auto cmdbuf = commandQueue->commandBuffer();
+			auto encoder = cmdbuf->computeCommandEncoder();
+
+			encoder->setComputePipelineState(pso);
+
+			size_t measuredAllocations = 0;
+
+			for (size_t dispatchIndex = 0; dispatchIndex < dispatchCount; ++dispatchIndex) {
+				size_t offset = dispatchIndex * dispatchStride * sizeof(float);
+
+				allocationCount = 0;
+				countAllocations = dispatchIndex >= warmupDispatchCount;
+
+				encoder->setBuffer(bufA, offset, 0);
+				encoder->setBuffer(bufB, offset, 1);
+				encoder->setBuffer(bufResult, offset, 2);
+				encoder->dispatchThreadgroups(Indium::Size { 1, 1, 1 }, Indium::Size { threadsPerDispatch, 1, 1 });
+
+				countAllocations = false;
+				measuredAllocations += allocationCount;
+			}
+
+			encoder->endEncoding();
+			cmdbuf->commit();
+			cmdbuf->waitUntilCompleted();
+
+			if (measuredAllocations != 0) {
+				std::cerr << "Allocation ERROR: command buffer " << commandBufferIndex << " made " << measuredAllocations << " allocations over " << measuredDispatchCount << " dispatches" << std::endl;
+				ok = false;
+			}
+
+			for (size_t dispatchIndex = 0; dispatchIndex < dispatchCount; ++dispatchIndex) {
+				for (size_t thread = 0; thread < threadsPerDispatch; ++thread) {
+					size_t i = dispatchIndex * dispatchStride + thread;
+					if (result[i] != (a[i] + b[i])) {
+						std::cerr << "Compute ERROR: index=" << i << " result=" << result[i] << " vs " << (a[i] + b[i]) << "=a+b" << std::endl;
+						ok = false;
+					}
+				}
+			}
+		}
+
+		if (ok) {
+			std::cout << "Steady-state encoding made no allocations, and compute results as expected" << std::endl;
+		}
+
+		keepPollingDevice = false;
+		device->wakeupEventLoop();
+		devicePollingThread.join();
+	}
+
+	Indium::finit();
+
+	std::cout << "Execution finished" << std::endl;
+
+	return ok ? 0 : 1;
+};
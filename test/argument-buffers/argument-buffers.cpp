@@ -0,0 +1,198 @@
+#include "gather.h"
+
+#include <indium/indium.private.hpp>
+
+#include <thread>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef ENABLE_VALIDATION
+	#define ENABLE_VALIDATION (!!getenv("INDIUM_TEST_VALIDATION"))
+#endif
+
+// this encodes a few argument buffers and checks their contents on the host (buffers are encoded as addresses, textures and samplers as resource IDs),
+// then runs a kernel that reads its input buffer and scale through each of them.
+
+static constexpr unsigned int threadsPerDispatch = 64;
+// 256 bytes is the largest buffer offset alignment a device can require
+static constexpr unsigned int dispatchStride = 256 / sizeof(float);
+static constexpr unsigned int dispatchCount = 3;
+static constexpr unsigned int arrayLength = dispatchCount * dispatchStride;
+static constexpr unsigned int bufferSize = arrayLength * sizeof(float);
+
+static const float scales[dispatchCount] = { 2.0f, -1.0f, 0.5f };
+
+static bool ok = true;
+
+static void expect(bool condition, const std::string& message) {
+	if (!condition) {
+		std::cerr << "Encoding ERROR: " << message << std::endl;
+		ok = false;
+	}
+};
+
+template<typename T>
+static T readArgument(const std::shared_ptr<Indium::Buffer>& buffer, size_t offset) {
+	T value;
+	memcpy(&value, static_cast<const char*>(buffer->contents()) + offset, sizeof(value));
+	return value;
+};
+
+// textures and samplers are only supported with descriptor indexing; without it, the encoder should refuse to be created at all
+static void checkResourceIDs(std::shared_ptr<Indium::Device> device) {
+	std::vector<Indium::ArgumentDescriptor> descriptors(2);
+	descriptors[0].dataType = Indium::DataType::Texture;
+	descriptors[0].index = 0;
+	descriptors[1].dataType = Indium::DataType::Sampler;
+	descriptors[1].index = 1;
+
+	bool bindless = !!(std::dynamic_pointer_cast<Indium::PrivateDevice>(device)->features() & Indium::PrivateDevice::Feature::DescriptorIndexing);
+
+	if (!bindless) {
+		bool threw = false;
+		try {
+			device->newArgumentEncoder(descriptors);
+		} catch (const std::runtime_error&) {
+			threw = true;
+		}
+		expect(threw, "textures and samplers were accepted without descriptor indexing");
+		return;
+	}
+
+	auto encoder = device->newArgumentEncoder(descriptors);
+	expect(encoder->encodedLength() == 16 && encoder->alignment() == 8, "unexpected layout for a texture and a sampler");
+
+	Indium::TextureDescriptor textureDescriptor {};
+	textureDescriptor.width = 4;
+	textureDescriptor.height = 4;
+	auto texture = device->newTexture(textureDescriptor);
+	auto sampler = device->newSamplerState(Indium::SamplerDescriptor {});
+
+	auto argumentBuffer = device->newBuffer(encoder->encodedLength(), Indium::ResourceOptions::StorageModeShared);
+	encoder->setArgumentBuffer(argumentBuffer, 0);
+	encoder->setTexture(texture, 0);
+	encoder->setSamplerState(sampler, 1);
+
+	expect(readArgument<uint64_t>(argumentBuffer, 0) == texture->gpuResourceID().impl, "texture wasn't encoded as its resource ID");
+	expect(readArgument<uint64_t>(argumentBuffer, 8) == sampler->gpuResourceID().impl, "sampler wasn't encoded as its resource ID");
+
+	encoder->setTexture(nullptr, 0);
+	expect(readArgument<uint64_t>(argumentBuffer, 0) == 0, "clearing the texture didn't encode a null resource ID");
+};
+
+int main(int argc, char** argv) {
+	Indium::init(nullptr, 0, ENABLE_VALIDATION);
+
+	{
+		auto device = Indium::createSystemDefaultDevice();
+
+		bool keepPollingDevice = true;
+
+		std::thread devicePollingThread([device, &keepPollingDevice]() {
+			while (keepPollingDevice) {
+				device->pollEvents(UINT64_MAX);
+			}
+		});
+
+		auto lib = device->newLibrary(compute_gather, compute_gather_len);
+		auto func = lib->newFunction("scale_indirect");
+
+		auto pso = device->newComputePipelineState(func);
+		auto commandQueue = device->newCommandQueue();
+
+		// the layout the function expects should be the same as the one described by hand
+		auto encoder = func->newArgumentEncoder(0);
+
+		std::vector<Indium::ArgumentDescriptor> descriptors(2);
+		descriptors[0].dataType = Indium::DataType::Pointer;
+		descriptors[0].index = 0;
+		descriptors[1].dataType = Indium::DataType::Float;
+		descriptors[1].index = 1;
+
+		auto describedEncoder = device->newArgumentEncoder(descriptors);
+
+		expect(encoder->encodedLength() == 16 && encoder->alignment() == 8, "unexpected layout for the function's argument buffer");
+		expect(describedEncoder->encodedLength() == encoder->encodedLength() && describedEncoder->alignment() == encoder->alignment(), "described layout doesn't match the function's");
+
+		auto bufInput = device->newBuffer(bufferSize, Indium::ResourceOptions::StorageModeShared);
+		auto bufOutput = device->newBuffer(bufferSize, Indium::ResourceOptions::StorageModeShared);
+
+		auto input = static_cast<float*>(bufInput->contents());
+		auto output = static_cast<float*>(bufOutput->contents());
+
+		for (size_t i = 0; i < arrayLength; ++i) {
+			input[i] = (float)rand() / (float)RAND_MAX;
+			output[i] = -1;
+		}
+
+		// each dispatch gets its own element of the argument buffer array, and each element points to a different part of the input
+		size_t argumentStride = 256;
+		auto argumentBuffer = device->newBuffer(argumentStride * dispatchCount, Indium::ResourceOptions::StorageModeShared);
+
+		for (size_t dispatchIndex = 0; dispatchIndex < dispatchCount; ++dispatchIndex) {
+			size_t inputOffset = dispatchIndex * dispatchStride * sizeof(float);
+			auto& activeEncoder = (dispatchIndex % 2 == 0) ? encoder : describedEncoder;
+
+			activeEncoder->setArgumentBuffer(argumentBuffer, dispatchIndex * argumentStride);
+			activeEncoder->setBuffer(bufInput, inputOffset, 0);
+			*static_cast<float*>(activeEncoder->constantData(1)) = scales[dispatchIndex];
+
+			auto address = readArgument<uint64_t>(argumentBuffer, dispatchIndex * argumentStride);
+			expect(address == bufInput->gpuAddress() + inputOffset, "buffer wasn't encoded as its address plus the offset (element " + std::to_string(dispatchIndex) + ")");
+			expect(readArgument<float>(argumentBuffer, dispatchIndex * argumentStride + 8) == scales[dispatchIndex], "constant wasn't encoded at its offset (element " + std::to_string(dispatchIndex) + ")");
+		}
+
+		checkResourceIDs(device);
+
+		auto cmdbuf = commandQueue->commandBuffer();
+		auto computeEncoder = cmdbuf->computeCommandEncoder();
+
+		computeEncoder->setComputePipelineState(pso);
+		// the input is only referenced through the argument buffers
+		computeEncoder->useResource(bufInput, Indium::ResourceUsage::Read);
+
+		for (size_t dispatchIndex = 0; dispatchIndex < dispatchCount; ++dispatchIndex) {
+			computeEncoder->setBuffer(argumentBuffer, dispatchIndex * argumentStride, 0);
+			computeEncoder->setBuffer(bufOutput, dispatchIndex * dispatchStride * sizeof(float), 1);
+			computeEncoder->dispatchThreadgroups(Indium::Size { 1, 1, 1 }, Indium::Size { threadsPerDispatch, 1, 1 });
+		}
+
+		computeEncoder->endEncoding();
+		cmdbuf->commit();
+		cmdbuf->waitUntilCompleted();
+
+		for (size_t dispatchIndex = 0; dispatchIndex < dispatchCount; ++dispatchIndex) {
+			for (size_t thread = 0; thread < threadsPerDispatch; ++thread) {
+				size_t i = dispatchIndex * dispatchStride + thread;
+				float expected = input[i] * scales[dispatchIndex];
+
+				if (std::abs(output[i] - expected) > 1e-5f) {
+					std::cerr << "Compute ERROR: dispatch=" << dispatchIndex << " index=" << i << " result=" << output[i] << " vs " << expected << "=input*scale" << std::endl;
+					ok = false;
+					break;
+				}
+			}
+		}
+
+		if (ok) {
+			std::cout << "Argument buffers encoded and read as expected" << std::endl;
+		}
+
+		keepPollingDevice = false;
+		device->wakeupEventLoop();
+		devicePollingThread.join();
+	}
+
+	Indium::finit();
+
+	std::cout << "Execution finished" << std::endl;
+
+	return ok ? 0 : 1;
+};
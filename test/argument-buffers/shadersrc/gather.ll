@@ -0,0 +1,58 @@
+; AIR for gather.metal, in the form the Metal compiler emits it.
+; gather.metallib is built from this with `llvm-as` and `build-metallib.py` from the push-constants test,
+; so the test doesn't need the Metal toolchain to be rebuilt.
+
+source_filename = "scale_indirect"
+target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v16:16:16-v24:32:32-v32:32:32-v48:64:64-v64:64:64-v96:128:128-v128:128:128-v192:256:256-v256:256:256-v512:512:512-v1024:1024:1024-n8:16:32"
+target triple = "air64-apple-macosx10.15.0"
+
+%struct.Arguments = type { float addrspace(1)*, float }
+
+; Function Attrs: norecurse nounwind
+define void @scale_indirect(%struct.Arguments addrspace(2)* noalias nocapture readonly dereferenceable(16) %0, float addrspace(1)* noalias nocapture %1, i32 %2) local_unnamed_addr #0 {
+  %4 = getelementptr inbounds %struct.Arguments, %struct.Arguments addrspace(2)* %0, i64 0, i32 0
+  %5 = load float addrspace(1)*, float addrspace(1)* addrspace(2)* %4, align 8, !tbaa !15
+  %6 = zext i32 %2 to i64
+  %7 = getelementptr inbounds float, float addrspace(1)* %5, i64 %6
+  %8 = load float, float addrspace(1)* %7, align 4, !tbaa !19
+  %9 = getelementptr inbounds %struct.Arguments, %struct.Arguments addrspace(2)* %0, i64 0, i32 1
+  %10 = load float, float addrspace(2)* %9, align 8, !tbaa !21
+  %11 = fmul fast float %10, %8
+  %12 = getelementptr inbounds float, float addrspace(1)* %1, i64 %6
+  store float %11, float addrspace(1)* %12, align 4, !tbaa !19
+  ret void
+}
+
+attributes #0 = { norecurse nounwind "correctly-rounded-divide-sqrt-fp-math"="false" "disable-tail-calls"="false" "frame-pointer"="all" "less-precise-fpmad"="false" "no-infs-fp-math"="true" "no-jump-tables"="false" "no-nans-fp-math"="true" "no-signed-zeros-fp-math"="true" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "unsafe-fp-math"="true" "use-soft-float"="false" }
+
+!llvm.module.flags = !{!0, !1}
+!llvm.ident = !{!2}
+!air.version = !{!3}
+!air.language_version = !{!4}
+!air.compile_options = !{!5, !6, !7}
+!air.kernel = !{!8}
+
+!0 = !{i32 2, !"SDK Version", [3 x i32] [i32 10, i32 15, i32 6]}
+!1 = !{i32 1, !"wchar_size", i32 4}
+!2 = !{!"Apple LLVM version 902.14 (metalfe-902.14.12)"}
+!3 = !{i32 2, i32 2, i32 0}
+!4 = !{!"Metal", i32 2, i32 2, i32 0}
+!5 = !{!"air.compile.denorms_disable"}
+!6 = !{!"air.compile.fast_math_enable"}
+!7 = !{!"air.compile.framebuffer_fetch_disable"}
+!8 = !{void (%struct.Arguments addrspace(2)*, float addrspace(1)*, i32)* @scale_indirect, !9, !10}
+!9 = !{}
+!10 = !{!11, !13, !14}
+!11 = !{i32 0, !"air.buffer", !"air.buffer_size", i32 16, !"air.location_index", i32 0, i32 1, !"air.read", !"air.struct_type_info", !12, !"air.arg_type_size", i32 16, !"air.arg_type_align_size", i32 8, !"air.arg_type_name", !"Arguments", !"air.arg_name", !"arguments"}
+!12 = !{i32 0, i32 8, i32 0, !"float", !"input", !"air.indirect_argument", !22, i32 8, i32 4, i32 0, !"float", !"scale"}
+!13 = !{i32 1, !"air.buffer", !"air.location_index", i32 1, i32 1, !"air.read_write", !"air.arg_type_size", i32 4, !"air.arg_type_align_size", i32 4, !"air.arg_type_name", !"float", !"air.arg_name", !"output"}
+!14 = !{i32 2, !"air.thread_position_in_grid", !"air.arg_type_name", !"uint", !"air.arg_name", !"index"}
+!15 = !{!16, !17, i64 0}
+!16 = !{!"_ZTS9Arguments", !17, i64 0, !20, i64 8}
+!17 = !{!"any pointer", !18, i64 0}
+!18 = !{!"omnipotent char", !23, i64 0}
+!19 = !{!20, !20, i64 0}
+!20 = !{!"float", !18, i64 0}
+!21 = !{!16, !20, i64 8}
+!22 = !{i32 0, !"air.buffer", !"air.location_index", i32 0, i32 1, !"air.read", !"air.arg_type_size", i32 4, !"air.arg_type_align_size", i32 4, !"air.arg_type_name", !"float", !"air.arg_name", !"input"}
+!23 = !{!"Simple C++ TBAA"}
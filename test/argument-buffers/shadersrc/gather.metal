@@ -0,0 +1,15 @@
+#include <metal_stdlib>
+using namespace metal;
+
+struct Arguments {
+	device const float* input [[id(0)]];
+	float scale [[id(1)]];
+};
+
+// `arguments` is an argument buffer encoded with an ArgumentEncoder
+kernel void scale_indirect(constant Arguments& arguments [[buffer(0)]],
+                           device float* output [[buffer(1)]],
+                           uint index [[thread_position_in_grid]])
+{
+	output[index] = arguments.input[index] * arguments.scale;
+}
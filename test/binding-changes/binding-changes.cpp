@@ -0,0 +1,242 @@
+#include "ColorShaders.h"
+#include "TextureShaders.h"
+
+#include <indium/indium.hpp>
+
+#include <thread>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef ENABLE_VALIDATION
+	#define ENABLE_VALIDATION (!!getenv("INDIUM_TEST_VALIDATION"))
+#endif
+
+// this draws one quad into each quarter of an offscreen render target, changing bindings in different ways between the draws:
+// switching a binding between setVertexBytes() and setVertexBuffer(), setting bindings the pipeline doesn't use,
+// and switching between pipelines with different bindings (which shouldn't lose bindings that were set before the switch).
+// the encoders only rebind what each function's binding map says it uses, so each of these has to be picked up (or ignored) correctly.
+
+// equivalent to AAPLVertex in the triangle test's shaders (the color is 16-byte aligned)
+struct ColorVertex {
+	float position[2];
+	float padding[2];
+	float color[4];
+};
+
+// equivalent to AAPLVertex in the sampler test's shaders
+struct TextureVertex {
+	float position[2];
+	float textureCoordinate[2];
+};
+
+struct Color {
+	uint8_t red;
+	uint8_t green;
+	uint8_t blue;
+	uint8_t alpha;
+
+	bool operator==(const Color& other) const {
+		return red == other.red && green == other.green && blue == other.blue && alpha == other.alpha;
+	};
+};
+
+static std::ostream& operator<<(std::ostream& stream, const Color& color) {
+	return stream << '(' << (int)color.red << ", " << (int)color.green << ", " << (int)color.blue << ", " << (int)color.alpha << ')';
+};
+
+static constexpr uint32_t renderTargetSize = 64;
+static constexpr size_t quadVertexCount = 6;
+
+static constexpr Color red { 255, 0, 0, 255 };
+static constexpr Color green { 0, 255, 0, 255 };
+static constexpr Color blue { 0, 0, 255, 255 };
+static constexpr Color yellow { 255, 255, 0, 255 };
+
+// positions are in pixels from the center of the render target (with Y pointing up); `left` and `bottom` are the quad's corner
+static std::vector<ColorVertex> colorQuad(float left, float bottom, Color color) {
+	float half = renderTargetSize / 2;
+	float rgba[4] = { color.red / 255.f, color.green / 255.f, color.blue / 255.f, color.alpha / 255.f };
+	float corners[quadVertexCount][2] = {
+		{ left + half, bottom }, { left, bottom }, { left, bottom + half },
+		{ left + half, bottom }, { left, bottom + half }, { left + half, bottom + half },
+	};
+
+	std::vector<ColorVertex> vertices(quadVertexCount);
+	for (size_t i = 0; i < quadVertexCount; ++i) {
+		vertices[i] = ColorVertex { { corners[i][0], corners[i][1] }, { 0, 0 }, { rgba[0], rgba[1], rgba[2], rgba[3] } };
+	}
+	return vertices;
+};
+
+static std::vector<TextureVertex> textureQuad(float left, float bottom) {
+	float half = renderTargetSize / 2;
+	return {
+		{ { left + half, bottom }, { 1.f, 1.f } },
+		{ { left, bottom }, { 0.f, 1.f } },
+		{ { left, bottom + half }, { 0.f, 0.f } },
+
+		{ { left + half, bottom }, { 1.f, 1.f } },
+		{ { left, bottom + half }, { 0.f, 0.f } },
+		{ { left + half, bottom + half }, { 1.f, 0.f } },
+	};
+};
+
+int main(int argc, char** argv) {
+	Indium::init(nullptr, 0, ENABLE_VALIDATION);
+
+	bool ok = true;
+
+	{
+		auto device = Indium::createSystemDefaultDevice();
+
+		bool keepPollingDevice = true;
+
+		std::thread devicePollingThread([device, &keepPollingDevice]() {
+			while (keepPollingDevice) {
+				device->pollEvents(UINT64_MAX);
+			}
+		});
+
+		auto colorLibrary = device->newLibrary(colorShaders, colorShaders_len);
+		auto textureLibrary = device->newLibrary(textureShaders, textureShaders_len);
+
+		Indium::RenderPipelineDescriptor colorDescriptor {};
+		colorDescriptor.vertexFunction = colorLibrary->newFunction("vertexShader");
+		colorDescriptor.fragmentFunction = colorLibrary->newFunction("fragmentShader");
+		colorDescriptor.colorAttachments.emplace_back();
+		colorDescriptor.colorAttachments[0].pixelFormat = Indium::PixelFormat::RGBA8Unorm;
+
+		Indium::RenderPipelineDescriptor textureDescriptor {};
+		textureDescriptor.vertexFunction = textureLibrary->newFunction("vertexShader");
+		textureDescriptor.fragmentFunction = textureLibrary->newFunction("samplingShader");
+		textureDescriptor.colorAttachments.emplace_back();
+		textureDescriptor.colorAttachments[0].pixelFormat = Indium::PixelFormat::RGBA8Unorm;
+
+		auto colorPipeline = device->newRenderPipelineState(colorDescriptor);
+		auto texturePipeline = device->newRenderPipelineState(textureDescriptor);
+		auto commandQueue = device->newCommandQueue();
+
+		// a solid blue texture for the textured quad
+		Indium::TextureDescriptor blueDescriptor {};
+		blueDescriptor.pixelFormat = Indium::PixelFormat::RGBA8Unorm;
+		blueDescriptor.width = 4;
+		blueDescriptor.height = 4;
+
+		auto blueTexture = device->newTexture(blueDescriptor);
+		std::vector<Color> bluePixels(16, blue);
+		blueTexture->replaceRegion(Indium::Region {
+			Indium::Origin { 0, 0, 0 },
+			Indium::Size { 4, 4, 1 },
+		}, 0, bluePixels.data(), sizeof(Color) * 4);
+
+		auto topLeft = colorQuad(-32, 0, red);
+		auto topRight = colorQuad(0, 0, green);
+		auto bottomLeft = textureQuad(-32, -32);
+		auto bottomRight = colorQuad(0, -32, yellow);
+
+		// the green and yellow quads live in the same buffer, 256 bytes apart (the largest buffer offset alignment a device can require)
+		static constexpr size_t quadStride = 256;
+		auto colorBuffer = device->newBuffer(quadStride * 2, Indium::ResourceOptions::StorageModeShared);
+		memcpy(static_cast<char*>(colorBuffer->contents()), topRight.data(), sizeof(ColorVertex) * quadVertexCount);
+		memcpy(static_cast<char*>(colorBuffer->contents()) + quadStride, bottomRight.data(), sizeof(ColorVertex) * quadVertexCount);
+
+		auto textureBuffer = device->newBuffer(bottomLeft.data(), sizeof(TextureVertex) * quadVertexCount, Indium::ResourceOptions::StorageModeShared);
+		auto unusedBuffer = device->newBuffer(quadStride, Indium::ResourceOptions::StorageModeShared);
+
+		Indium::TextureDescriptor renderTargetDescriptor {};
+		renderTargetDescriptor.pixelFormat = Indium::PixelFormat::RGBA8Unorm;
+		renderTargetDescriptor.width = renderTargetSize;
+		renderTargetDescriptor.height = renderTargetSize;
+		renderTargetDescriptor.resourceOptions = Indium::ResourceOptions::StorageModePrivate;
+		renderTargetDescriptor.usage = Indium::TextureUsage::RenderTarget;
+
+		auto renderTarget = device->newTexture(renderTargetDescriptor);
+		auto readback = device->newBuffer(renderTargetSize * renderTargetSize * sizeof(Color), Indium::ResourceOptions::StorageModeShared);
+
+		auto commandBuffer = commandQueue->commandBuffer();
+
+		Indium::RenderPassDescriptor renderPassDescriptor {};
+		renderPassDescriptor.colorAttachments.emplace_back();
+		renderPassDescriptor.colorAttachments[0].texture = renderTarget;
+		renderPassDescriptor.colorAttachments[0].loadAction = Indium::LoadAction::Clear;
+		renderPassDescriptor.colorAttachments[0].storeAction = Indium::StoreAction::Store;
+		renderPassDescriptor.colorAttachments[0].clearColor = Indium::ClearColor(0, 0, 0, 1);
+
+		auto renderEncoder = commandBuffer->renderCommandEncoder(renderPassDescriptor);
+
+		uint32_t viewportSize[2] = { renderTargetSize, renderTargetSize };
+
+		renderEncoder->setViewport(Indium::Viewport { 0, 0, static_cast<double>(renderTargetSize), static_cast<double>(renderTargetSize), 0, 1 });
+
+		// the viewport size is only set once, before any pipeline is set; every draw below relies on it
+		renderEncoder->setVertexBytes(viewportSize, sizeof(viewportSize), 1);
+
+		// top left: vertices set by value
+		renderEncoder->setRenderPipelineState(colorPipeline);
+		renderEncoder->setVertexBytes(topLeft.data(), sizeof(ColorVertex) * quadVertexCount, 0);
+		renderEncoder->drawPrimitives(Indium::PrimitiveType::Triangle, 0, quadVertexCount);
+
+		// top right: the same binding switched to a buffer, plus bindings that neither function uses
+		renderEncoder->setVertexBuffer(colorBuffer, 0, 0);
+		renderEncoder->setVertexBuffer(unusedBuffer, 0, 7);
+		renderEncoder->setFragmentBuffer(unusedBuffer, 0, 3);
+		renderEncoder->setFragmentTexture(blueTexture, 5);
+		renderEncoder->drawPrimitives(Indium::PrimitiveType::Triangle, 0, quadVertexCount);
+
+		// bottom left: a different pipeline with a texture (and a different vertex layout)
+		renderEncoder->setRenderPipelineState(texturePipeline);
+		renderEncoder->setVertexBuffer(textureBuffer, 0, 0);
+		renderEncoder->setFragmentTexture(blueTexture, 0);
+		renderEncoder->drawPrimitives(Indium::PrimitiveType::Triangle, 0, quadVertexCount);
+
+		// bottom right: back to the first pipeline, only changing the offset of a buffer that was bound while the other pipeline was set
+		renderEncoder->setRenderPipelineState(colorPipeline);
+		renderEncoder->setVertexBuffer(colorBuffer, 0, 0);
+		renderEncoder->setVertexBufferOffset(quadStride, 0);
+		renderEncoder->drawPrimitives(Indium::PrimitiveType::Triangle, 0, quadVertexCount);
+
+		renderEncoder->endEncoding();
+
+		auto blitEncoder = commandBuffer->blitCommandEncoder();
+		blitEncoder->copy(renderTarget, 0, 0, Indium::Origin { 0, 0, 0 }, Indium::Size { renderTargetSize, renderTargetSize, 1 }, readback, 0, renderTargetSize * sizeof(Color), renderTargetSize * renderTargetSize * sizeof(Color));
+		blitEncoder->endEncoding();
+
+		commandBuffer->commit();
+		commandBuffer->waitUntilCompleted();
+
+		auto pixels = static_cast<const Color*>(readback->contents());
+
+		auto checkPixel = [&](uint32_t x, uint32_t y, Color expected, const char* description) {
+			auto actual = pixels[y * renderTargetSize + x];
+			if (!(actual == expected)) {
+				std::cerr << "Render ERROR: " << description << " pixel (" << x << ", " << y << ")=" << actual << " vs " << expected << std::endl;
+				ok = false;
+			}
+		};
+
+		// the render target's rows go from top to bottom
+		checkPixel(renderTargetSize / 4, renderTargetSize / 4, red, "top left");
+		checkPixel(renderTargetSize * 3 / 4, renderTargetSize / 4, green, "top right");
+		checkPixel(renderTargetSize / 4, renderTargetSize * 3 / 4, blue, "bottom left");
+		checkPixel(renderTargetSize * 3 / 4, renderTargetSize * 3 / 4, yellow, "bottom right");
+
+		if (ok) {
+			std::cout << "Rendered quads as expected" << std::endl;
+		}
+
+		keepPollingDevice = false;
+		device->wakeupEventLoop();
+		devicePollingThread.join();
+	}
+
+	Indium::finit();
+
+	std::cout << "Execution finished" << std::endl;
+
+	return ok ? 0 : 1;
+};
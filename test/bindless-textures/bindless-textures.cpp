@@ -0,0 +1,198 @@
+#include "AAPLShaders.h"
+
+#include <indium/indium.private.hpp>
+
+#include <thread>
+#include <functional>
+#include <iostream>
+
+#include <cstdint>
+#include <cstdlib>
+
+#ifndef ENABLE_VALIDATION
+	#define ENABLE_VALIDATION (!!getenv("INDIUM_TEST_VALIDATION"))
+#endif
+
+// this draws two quads offscreen, each one sampling a different solid-color texture.
+// on devices with descriptor indexing, the fragment shader looks the texture up in the resource table by the ID it's given in push constants,
+// so this checks that each draw gets its own texture's ID.
+
+struct Vertex {
+	float position[2];
+	float textureCoordinate[2];
+};
+
+struct Color {
+	uint8_t red;
+	uint8_t green;
+	uint8_t blue;
+	uint8_t alpha;
+
+	bool operator==(const Color& other) const {
+		return red == other.red && green == other.green && blue == other.blue && alpha == other.alpha;
+	};
+};
+
+static std::ostream& operator<<(std::ostream& stream, const Color& color) {
+	return stream << '(' << (int)color.red << ", " << (int)color.green << ", " << (int)color.blue << ", " << (int)color.alpha << ')';
+};
+
+static constexpr uint32_t renderTargetWidth = 64;
+static constexpr uint32_t renderTargetHeight = 32;
+static constexpr uint32_t textureSize = 4;
+
+// positions are in pixels from the center of the render target
+static const Vertex leftQuad[] = {
+	{ {   0, -16 }, { 1.f, 1.f } },
+	{ { -32, -16 }, { 0.f, 1.f } },
+	{ { -32,  16 }, { 0.f, 0.f } },
+
+	{ {   0, -16 }, { 1.f, 1.f } },
+	{ { -32,  16 }, { 0.f, 0.f } },
+	{ {   0,  16 }, { 1.f, 0.f } },
+};
+
+static const Vertex rightQuad[] = {
+	{ {  32, -16 }, { 1.f, 1.f } },
+	{ {   0, -16 }, { 0.f, 1.f } },
+	{ {   0,  16 }, { 0.f, 0.f } },
+
+	{ {  32, -16 }, { 1.f, 1.f } },
+	{ {   0,  16 }, { 0.f, 0.f } },
+	{ {  32,  16 }, { 1.f, 0.f } },
+};
+
+static constexpr Color red { 255, 0, 0, 255 };
+static constexpr Color green { 0, 255, 0, 255 };
+
+int main(int argc, char** argv) {
+	Indium::init(nullptr, 0, ENABLE_VALIDATION);
+
+	bool ok = true;
+
+	{
+		auto device = Indium::createSystemDefaultDevice();
+
+		bool keepPollingDevice = true;
+
+		std::thread devicePollingThread([device, &keepPollingDevice]() {
+			while (keepPollingDevice) {
+				device->pollEvents(UINT64_MAX);
+			}
+		});
+
+		bool bindless = !!(std::dynamic_pointer_cast<Indium::PrivateDevice>(device)->features() & Indium::PrivateDevice::Feature::DescriptorIndexing);
+		std::cout << "Textures are " << (bindless ? "looked up in the resource table" : "bound with descriptors") << " on this device" << std::endl;
+
+		auto newSolidTexture = [&](Color color) {
+			Indium::TextureDescriptor textureDescriptor {};
+
+			textureDescriptor.pixelFormat = Indium::PixelFormat::RGBA8Unorm;
+			textureDescriptor.width = textureSize;
+			textureDescriptor.height = textureSize;
+
+			auto texture = device->newTexture(textureDescriptor);
+
+			Color pixels[textureSize * textureSize];
+			for (auto& pixel: pixels) {
+				pixel = color;
+			}
+
+			texture->replaceRegion(Indium::Region {
+				Indium::Origin { 0, 0, 0 },
+				Indium::Size { textureSize, textureSize, 1 },
+			}, 0, pixels, sizeof(Color) * textureSize);
+
+			return texture;
+		};
+
+		auto redTexture = newSolidTexture(red);
+		auto greenTexture = newSolidTexture(green);
+
+		Indium::TextureDescriptor renderTargetDescriptor {};
+		renderTargetDescriptor.pixelFormat = Indium::PixelFormat::RGBA8Unorm;
+		renderTargetDescriptor.width = renderTargetWidth;
+		renderTargetDescriptor.height = renderTargetHeight;
+		renderTargetDescriptor.resourceOptions = Indium::ResourceOptions::StorageModePrivate;
+		renderTargetDescriptor.usage = Indium::TextureUsage::RenderTarget;
+
+		auto renderTarget = device->newTexture(renderTargetDescriptor);
+		auto readback = device->newBuffer(renderTargetWidth * renderTargetHeight * sizeof(Color), Indium::ResourceOptions::StorageModeShared);
+
+		auto library = device->newLibrary(shader, shader_len);
+
+		Indium::RenderPipelineDescriptor psoDescriptor {};
+		psoDescriptor.vertexFunction = library->newFunction("vertexShader");
+		psoDescriptor.fragmentFunction = library->newFunction("samplingShader");
+		psoDescriptor.colorAttachments.emplace_back();
+		psoDescriptor.colorAttachments[0].pixelFormat = Indium::PixelFormat::RGBA8Unorm;
+
+		auto pipelineState = device->newRenderPipelineState(psoDescriptor);
+		auto commandQueue = device->newCommandQueue();
+
+		auto commandBuffer = commandQueue->commandBuffer();
+
+		Indium::RenderPassDescriptor renderPassDescriptor {};
+		renderPassDescriptor.colorAttachments.emplace_back();
+		renderPassDescriptor.colorAttachments[0].texture = renderTarget;
+		renderPassDescriptor.colorAttachments[0].loadAction = Indium::LoadAction::Clear;
+		renderPassDescriptor.colorAttachments[0].storeAction = Indium::StoreAction::Store;
+		renderPassDescriptor.colorAttachments[0].clearColor = Indium::ClearColor(0, 0, 1, 1);
+
+		auto renderEncoder = commandBuffer->renderCommandEncoder(renderPassDescriptor);
+
+		uint32_t viewportSize[2] = { renderTargetWidth, renderTargetHeight };
+
+		renderEncoder->setViewport(Indium::Viewport { 0, 0, static_cast<double>(renderTargetWidth), static_cast<double>(renderTargetHeight), 0, 1 });
+		renderEncoder->setRenderPipelineState(pipelineState);
+		renderEncoder->setVertexBytes(viewportSize, sizeof(viewportSize), 1);
+
+		// only the texture changes between these draws
+		renderEncoder->setVertexBytes(leftQuad, sizeof(leftQuad), 0);
+		renderEncoder->setFragmentTexture(redTexture, 0);
+		renderEncoder->drawPrimitives(Indium::PrimitiveType::Triangle, 0, sizeof(leftQuad) / sizeof(Vertex));
+
+		renderEncoder->setVertexBytes(rightQuad, sizeof(rightQuad), 0);
+		renderEncoder->setFragmentTexture(greenTexture, 0);
+		renderEncoder->drawPrimitives(Indium::PrimitiveType::Triangle, 0, sizeof(rightQuad) / sizeof(Vertex));
+
+		renderEncoder->endEncoding();
+
+		auto blitEncoder = commandBuffer->blitCommandEncoder();
+		blitEncoder->copy(renderTarget, 0, 0, Indium::Origin { 0, 0, 0 }, Indium::Size { renderTargetWidth, renderTargetHeight, 1 }, readback, 0, renderTargetWidth * sizeof(Color), renderTargetWidth * renderTargetHeight * sizeof(Color));
+		blitEncoder->endEncoding();
+
+		commandBuffer->commit();
+		commandBuffer->waitUntilCompleted();
+
+		auto pixels = static_cast<const Color*>(readback->contents());
+
+		auto checkPixel = [&](uint32_t x, uint32_t y, Color expected) {
+			auto actual = pixels[y * renderTargetWidth + x];
+			if (!(actual == expected)) {
+				std::cerr << "Render ERROR: pixel (" << x << ", " << y << ")=" << actual << " vs " << expected << std::endl;
+				ok = false;
+			}
+		};
+
+		// pixel centers well within each quad
+		checkPixel(renderTargetWidth / 4, renderTargetHeight / 2, red);
+		checkPixel(renderTargetWidth * 3 / 4, renderTargetHeight / 2, green);
+		checkPixel(1, 1, red);
+		checkPixel(renderTargetWidth - 2, renderTargetHeight - 2, green);
+
+		if (ok) {
+			std::cout << "Rendered textures as expected" << std::endl;
+		}
+
+		keepPollingDevice = false;
+		device->wakeupEventLoop();
+		devicePollingThread.join();
+	}
+
+	Indium::finit();
+
+	std::cout << "Execution finished" << std::endl;
+
+	return ok ? 0 : 1;
+};
@@ -0,0 +1,187 @@
+#include "add.h"
+
+#include <indium/indium.hpp>
+
+#include <thread>
+#include <functional>
+#include <iostream>
+#include <string>
+
+#include <cstdlib>
+
+#ifndef ENABLE_VALIDATION
+	#define ENABLE_VALIDATION (!!getenv("INDIUM_TEST_VALIDATION"))
+#endif
+
+// this encodes a few dispatches into an indirect command buffer once and executes them from several command buffers:
+// the first execution records them, the second reuses that recording, and changing a command afterwards has to be picked up.
+// it also executes commands that inherit the encoder's pipeline and buffers, which can't be pre-recorded.
+
+static constexpr unsigned int threadsPerDispatch = 64;
+// 256 bytes is the largest buffer offset alignment a device can require
+static constexpr unsigned int dispatchStride = 256 / sizeof(float);
+static constexpr unsigned int commandCount = 4;
+static constexpr unsigned int arrayLength = commandCount * dispatchStride;
+static constexpr unsigned int bufferSize = arrayLength * sizeof(float);
+
+int main(int argc, char** argv) {
+	Indium::init(nullptr, 0, ENABLE_VALIDATION);
+
+	bool ok = true;
+
+	{
+		auto device = Indium::createSystemDefaultDevice();
+
+		bool keepPollingDevice = true;
+
+		std::thread devicePollingThread([device, &keepPollingDevice]() {
+			while (keepPollingDevice) {
+				device->pollEvents(UINT64_MAX);
+			}
+		});
+
+		auto lib = device->newLibrary(compute_add, compute_add_len);
+
+		Indium::ComputePipelineDescriptor psoDescriptor {};
+		psoDescriptor.computeFunction = lib->newFunction("add_arrays");
+		psoDescriptor.supportIndirectCommandBuffers = true;
+
+		auto pso = device->newComputePipelineState(psoDescriptor, Indium::PipelineOption::None, nullptr);
+		auto commandQueue = device->newCommandQueue();
+
+		auto bufA = device->newBuffer(bufferSize, Indium::ResourceOptions::StorageModeShared);
+		auto bufB = device->newBuffer(bufferSize, Indium::ResourceOptions::StorageModeShared);
+		auto bufResult = device->newBuffer(bufferSize, Indium::ResourceOptions::StorageModeShared);
+
+		auto a = static_cast<float*>(bufA->contents());
+		auto b = static_cast<float*>(bufB->contents());
+		auto result = static_cast<float*>(bufResult->contents());
+
+		for (size_t i = 0; i < arrayLength; ++i) {
+			a[i] = (float)rand() / (float)RAND_MAX;
+			b[i] = (float)rand() / (float)RAND_MAX;
+		}
+
+		// commands that set their own pipeline and buffers
+		Indium::IndirectCommandBufferDescriptor icbDescriptor {};
+		icbDescriptor.commandTypes = Indium::IndirectCommandType::ConcurrentDispatch;
+		icbDescriptor.inheritPipelineState = false;
+		icbDescriptor.inheritBuffers = false;
+		icbDescriptor.maxKernelBufferBindCount = 3;
+
+		auto icb = device->newIndirectCommandBuffer(icbDescriptor, commandCount, Indium::ResourceOptions::StorageModeShared);
+
+		// command `i` adds region `inputRegions[i]` of A and B and stores the sum in region `i` of the result
+		size_t inputRegions[commandCount];
+
+		auto encodeCommand = [&](size_t commandIndex, size_t inputRegion) {
+			auto command = icb->indirectComputeCommandAtIndex(commandIndex);
+			size_t inputOffset = inputRegion * dispatchStride * sizeof(float);
+
+			command->setComputePipelineState(pso);
+			command->setKernelBuffer(bufA, inputOffset, 0);
+			command->setKernelBuffer(bufB, inputOffset, 1);
+			command->setKernelBuffer(bufResult, commandIndex * dispatchStride * sizeof(float), 2);
+			command->concurrentDispatchThreadgroups(Indium::Size { 1, 1, 1 }, Indium::Size { threadsPerDispatch, 1, 1 });
+
+			inputRegions[commandIndex] = inputRegion;
+		};
+
+		for (size_t i = 0; i < commandCount; ++i) {
+			encodeCommand(i, i);
+		}
+
+		// runs the given commands in a new command buffer and checks that exactly those commands wrote their results
+		auto execute = [&](const std::string& description, Indium::Range<size_t> range) {
+			for (size_t i = 0; i < arrayLength; ++i) {
+				result[i] = -1;
+			}
+
+			auto cmdbuf = commandQueue->commandBuffer();
+			auto encoder = cmdbuf->computeCommandEncoder();
+
+			// the commands' resources aren't bound on the encoder itself
+			encoder->useResource(bufA, Indium::ResourceUsage::Read);
+			encoder->useResource(bufB, Indium::ResourceUsage::Read);
+			encoder->useResource(bufResult, Indium::ResourceUsage::Write);
+			encoder->executeCommandsInBuffer(icb, range);
+
+			encoder->endEncoding();
+			cmdbuf->commit();
+			cmdbuf->waitUntilCompleted();
+
+			for (size_t commandIndex = 0; commandIndex < commandCount; ++commandIndex) {
+				bool executed = commandIndex >= range.start && commandIndex < range.start + range.length;
+
+				for (size_t thread = 0; thread < threadsPerDispatch; ++thread) {
+					size_t i = commandIndex * dispatchStride + thread;
+					size_t input = inputRegions[commandIndex] * dispatchStride + thread;
+					float expected = executed ? (a[input] + b[input]) : -1;
+
+					if (result[i] != expected) {
+						std::cerr << "Compute ERROR (" << description << "): command=" << commandIndex << " index=" << i << " result=" << result[i] << " vs " << expected << std::endl;
+						ok = false;
+						break;
+					}
+				}
+			}
+		};
+
+		execute("first execution", Indium::Range<size_t> { 0, commandCount });
+		execute("second execution", Indium::Range<size_t> { 0, commandCount });
+		execute("partial execution", Indium::Range<size_t> { 1, 2 });
+
+		// changing a command has to invalidate anything recorded from the old one
+		encodeCommand(2, 0);
+		execute("after changing a command", Indium::Range<size_t> { 0, commandCount });
+
+		icb->reset(Indium::Range<size_t> { 3, 1 });
+		execute("after resetting a command", Indium::Range<size_t> { 0, commandCount - 1 });
+
+		// commands that inherit the encoder's pipeline and buffers
+		Indium::IndirectCommandBufferDescriptor inheritingDescriptor {};
+		inheritingDescriptor.commandTypes = Indium::IndirectCommandType::ConcurrentDispatch;
+
+		auto inheritingICB = device->newIndirectCommandBuffer(inheritingDescriptor, 1, Indium::ResourceOptions::StorageModeShared);
+		inheritingICB->indirectComputeCommandAtIndex(0)->concurrentDispatchThreadgroups(Indium::Size { commandCount * dispatchStride / threadsPerDispatch, 1, 1 }, Indium::Size { threadsPerDispatch, 1, 1 });
+
+		for (size_t i = 0; i < arrayLength; ++i) {
+			result[i] = -1;
+		}
+
+		auto cmdbuf = commandQueue->commandBuffer();
+		auto encoder = cmdbuf->computeCommandEncoder();
+
+		encoder->setComputePipelineState(pso);
+		encoder->setBuffer(bufA, 0, 0);
+		encoder->setBuffer(bufB, 0, 1);
+		encoder->setBuffer(bufResult, 0, 2);
+		encoder->executeCommandsInBuffer(inheritingICB, Indium::Range<size_t> { 0, 1 });
+
+		encoder->endEncoding();
+		cmdbuf->commit();
+		cmdbuf->waitUntilCompleted();
+
+		for (size_t i = 0; i < arrayLength; ++i) {
+			if (result[i] != (a[i] + b[i])) {
+				std::cerr << "Compute ERROR (inherited state): index=" << i << " result=" << result[i] << " vs " << (a[i] + b[i]) << "=a+b" << std::endl;
+				ok = false;
+				break;
+			}
+		}
+
+		if (ok) {
+			std::cout << "Indirect command buffer results as expected" << std::endl;
+		}
+
+		keepPollingDevice = false;
+		device->wakeupEventLoop();
+		devicePollingThread.join();
+	}
+
+	Indium::finit();
+
+	std::cout << "Execution finished" << std::endl;
+
+	return ok ? 0 : 1;
+};
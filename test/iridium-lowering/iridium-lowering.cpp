@@ -0,0 +1,253 @@
+#include "scale.h"
+#include "add.h"
+#include "texturing.h"
+#include "gather.h"
+
+#include <iridium/iridium.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+#include <cstdlib>
+
+// this translates shaders on the host and checks how Iridium lays their parameters out in the push constant block.
+// it doesn't need a GPU; the other tests check that the translated shaders actually behave correctly.
+
+static bool ok = true;
+
+static void expect(bool condition, const std::string& message) {
+	if (!condition) {
+		std::cerr << "Lowering ERROR: " << message << std::endl;
+		ok = false;
+	}
+};
+
+static bool translate(const unsigned char* data, size_t size, const Iridium::TranslationOptions& options, Iridium::OutputInfo& outputInfo) {
+	size_t outputSize = 0;
+	auto output = Iridium::translate(data, size, outputSize, outputInfo, options);
+
+	if (!output) {
+		expect(false, "translation failed");
+		return false;
+	}
+
+	// every SPIR-V module starts with the magic number
+	expect(outputSize >= 20 && *static_cast<uint32_t*>(output) == 0x07230203, "translation didn't produce a SPIR-V module");
+
+	free(output);
+	return true;
+};
+
+static const Iridium::FunctionInfo* findFunction(const Iridium::OutputInfo& outputInfo, const std::string& name) {
+	auto it = outputInfo.functionInfos.find(name);
+	if (it == outputInfo.functionInfos.end()) {
+		expect(false, "missing function info for " + name);
+		return nullptr;
+	}
+	return &it->second;
+};
+
+static const Iridium::BindingInfo* findBinding(const Iridium::FunctionInfo& functionInfo, Iridium::BindingType type, size_t index) {
+	for (auto& binding: functionInfo.bindings) {
+		if (binding.type == type && binding.index == index) {
+			return &binding;
+		}
+	}
+	return nullptr;
+};
+
+// checks that everything a function places in the push constant block is aligned, fits within the function's range, and doesn't overlap anything else
+static void checkPushConstantLayout(const std::string& name, const Iridium::FunctionInfo& functionInfo, size_t blockSize) {
+	auto range = Iridium::pushConstantRangeForFunctionType(functionInfo.type, blockSize);
+	std::vector<const Iridium::BindingInfo*> placed;
+
+	for (auto& binding: functionInfo.bindings) {
+		if (binding.pushConstantSize == 0) {
+			continue;
+		}
+
+		auto start = binding.pushConstantOffset;
+		auto end = start + binding.pushConstantSize;
+		auto description = name + " binding " + std::to_string(binding.index) + " (type " + std::to_string(static_cast<int>(binding.type)) + ")";
+
+		expect(start >= range.offset && end <= range.offset + range.size, description + " is outside of the function's push constant range");
+
+		if (binding.type != Iridium::BindingType::PushConstantBuffer) {
+			expect(start % binding.pushConstantSize == 0, description + " is misaligned");
+		}
+
+		for (auto other: placed) {
+			expect(end <= other->pushConstantOffset || start >= other->pushConstantOffset + other->pushConstantSize, description + " overlaps another binding");
+		}
+
+		placed.push_back(&binding);
+	}
+};
+
+// `constant ScaleParameters& parameters [[buffer(2)]]` is only 8 bytes, so it should be passed by value.
+// its regular buffer binding stays around so that setBuffer() still works.
+static void checkByValueBuffers() {
+	for (size_t blockSize: { 128, 16 }) {
+		Iridium::OutputInfo outputInfo;
+		Iridium::TranslationOptions options;
+		options.pushConstantBlockSize = blockSize;
+
+		if (!translate(compute_scale, compute_scale_len, options, outputInfo)) {
+			continue;
+		}
+
+		auto functionInfo = findFunction(outputInfo, "scale_bias");
+		if (!functionInfo) {
+			continue;
+		}
+
+		auto suffix = " (block size " + std::to_string(blockSize) + ")";
+
+		checkPushConstantLayout("scale_bias", *functionInfo, blockSize);
+
+		auto byValue = findBinding(*functionInfo, Iridium::BindingType::PushConstantBuffer, 2);
+		expect(byValue && byValue->pushConstantSize == sizeof(float) * 2, "parameters aren't passed by value" + suffix);
+		expect(findBinding(*functionInfo, Iridium::BindingType::Buffer, 2), "parameters lost their buffer binding" + suffix);
+		expect(!findBinding(*functionInfo, Iridium::BindingType::PushConstantBuffer, 0) && !findBinding(*functionInfo, Iridium::BindingType::PushConstantBuffer, 1), "device buffers are passed by value" + suffix);
+	}
+};
+
+// buffer addresses go in the push constant block when they all fit, and into a uniform buffer otherwise
+static void checkBufferAddresses() {
+	for (size_t blockSize: { 128, 16 }) {
+		Iridium::OutputInfo outputInfo;
+		Iridium::TranslationOptions options;
+		options.pushConstantBlockSize = blockSize;
+
+		if (!translate(compute_add, compute_add_len, options, outputInfo)) {
+			continue;
+		}
+
+		auto functionInfo = findFunction(outputInfo, "add_arrays");
+		if (!functionInfo) {
+			continue;
+		}
+
+		auto suffix = " (block size " + std::to_string(blockSize) + ")";
+		bool expectPushConstants = blockSize >= 3 * sizeof(uint64_t);
+
+		checkPushConstantLayout("add_arrays", *functionInfo, blockSize);
+
+		for (size_t index = 0; index < 3; ++index) {
+			auto binding = findBinding(*functionInfo, Iridium::BindingType::Buffer, index);
+			expect(binding, "missing binding for buffer " + std::to_string(index) + suffix);
+			if (binding) {
+				expect(binding->pushConstantSize == (expectPushConstants ? sizeof(uint64_t) : 0), "buffer " + std::to_string(index) + (expectPushConstants ? " isn't" : " is") + " passed in push constants" + suffix);
+			}
+		}
+	}
+
+	// vertex and fragment functions have to share the block, so each one's addresses have to stay in its own half
+	Iridium::OutputInfo outputInfo;
+	if (translate(texturing_shaders, texturing_shaders_len, {}, outputInfo)) {
+		for (auto name: { "vertex_project", "fragment_texture" }) {
+			if (auto functionInfo = findFunction(outputInfo, name)) {
+				checkPushConstantLayout(name, *functionInfo, 128);
+
+				auto binding = findBinding(*functionInfo, Iridium::BindingType::Buffer, 0);
+				expect(binding && binding->pushConstantSize == sizeof(uint64_t), std::string("buffer 0 of ") + name + " isn't passed in push constants");
+			}
+		}
+	}
+};
+
+// with bindless resources, sampled textures and samplers are passed as resource IDs in the push constant block instead of being bound individually
+static void checkBindlessResources() {
+	for (bool bindless: { false, true }) {
+		Iridium::OutputInfo outputInfo;
+		Iridium::TranslationOptions options;
+		options.bindlessResources = bindless;
+
+		if (!translate(texturing_shaders, texturing_shaders_len, options, outputInfo)) {
+			continue;
+		}
+
+		auto suffix = std::string(bindless ? " (bindless)" : " (not bindless)");
+
+		if (auto functionInfo = findFunction(outputInfo, "vertex_project")) {
+			expect(!functionInfo->usesResourceTable, "vertex_project uses the resource table" + suffix);
+		}
+
+		auto functionInfo = findFunction(outputInfo, "fragment_texture");
+		if (!functionInfo) {
+			continue;
+		}
+
+		checkPushConstantLayout("fragment_texture", *functionInfo, options.pushConstantBlockSize);
+
+		expect(functionInfo->usesResourceTable == bindless, std::string("fragment_texture ") + (bindless ? "doesn't use" : "uses") + " the resource table" + suffix);
+
+		for (auto type: { Iridium::BindingType::Texture, Iridium::BindingType::Sampler }) {
+			auto description = std::string(type == Iridium::BindingType::Texture ? "texture" : "sampler") + " 0";
+			auto binding = findBinding(*functionInfo, type, 0);
+
+			expect(binding, "missing binding for " + description + suffix);
+			if (binding) {
+				expect(binding->pushConstantSize == (bindless ? sizeof(uint32_t) : 0), description + (bindless ? " isn't" : " is") + " passed as a resource ID" + suffix);
+			}
+		}
+	}
+};
+
+// argument buffers are described so that Indium can create argument encoders for them.
+// buffers in them are encoded as 8-byte addresses, and everything else keeps its place in the structure.
+static void checkArgumentBuffers() {
+	Iridium::OutputInfo outputInfo;
+	if (!translate(compute_gather, compute_gather_len, {}, outputInfo)) {
+		return;
+	}
+
+	auto functionInfo = findFunction(outputInfo, "scale_indirect");
+	if (!functionInfo) {
+		return;
+	}
+
+	checkPushConstantLayout("scale_indirect", *functionInfo, 128);
+
+	expect(functionInfo->argumentBuffers.size() == 1, "expected exactly one argument buffer");
+	if (functionInfo->argumentBuffers.empty()) {
+		return;
+	}
+
+	auto& argumentBuffer = functionInfo->argumentBuffers[0];
+	expect(argumentBuffer.bufferIndex == 0, "argument buffer has the wrong buffer index");
+	expect(argumentBuffer.encodedLength == 16 && argumentBuffer.alignment == 8, "argument buffer has the wrong size or alignment");
+	expect(argumentBuffer.arguments.size() == 2, "argument buffer has the wrong number of arguments");
+
+	if (argumentBuffer.arguments.size() == 2) {
+		auto& input = argumentBuffer.arguments[0];
+		auto& scale = argumentBuffer.arguments[1];
+
+		expect(input.type == Iridium::ArgumentType::Buffer && input.index == 0 && input.offset == 0 && input.size == sizeof(uint64_t), "input isn't described as a buffer address at offset 0");
+		expect(scale.type == Iridium::ArgumentType::Constant && scale.index == 1 && scale.offset == 8 && scale.size == sizeof(float), "scale isn't described as a constant at offset 8");
+	}
+};
+
+int main(int argc, char** argv) {
+	if (!Iridium::init()) {
+		std::cerr << "Failed to initialize Iridium" << std::endl;
+		return 1;
+	}
+
+	checkByValueBuffers();
+	checkBufferAddresses();
+	checkBindlessResources();
+	checkArgumentBuffers();
+
+	Iridium::finit();
+
+	if (ok) {
+		std::cout << "Translated layouts as expected" << std::endl;
+	}
+
+	std::cout << "Execution finished" << std::endl;
+
+	return ok ? 0 : 1;
+};
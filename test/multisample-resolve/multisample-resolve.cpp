@@ -0,0 +1,182 @@
+#include "AAPLShaders.h"
+
+#include <indium/indium.hpp>
+
+#include <thread>
+#include <functional>
+#include <iostream>
+#include <string>
+
+#include <cstdint>
+#include <cstdlib>
+
+#ifndef ENABLE_VALIDATION
+	#define ENABLE_VALIDATION (!!getenv("INDIUM_TEST_VALIDATION"))
+#endif
+
+// this renders a triangle into a memoryless multisampled render target and resolves it within the render pass,
+// once into a regular texture and once into a level and slice of a mipmapped 2D array texture.
+// the multisampled contents never leave the render pass, so the resolved texture is the only thing we can check.
+
+// equivalent to AAPLVertex in the triangle test's shaders (the color is 16-byte aligned)
+struct Vertex {
+	float position[2];
+	float padding[2];
+	float color[4];
+};
+
+struct Color {
+	uint8_t red;
+	uint8_t green;
+	uint8_t blue;
+	uint8_t alpha;
+};
+
+static constexpr size_t sampleCount = 4;
+static constexpr uint32_t baseSize = 64;
+
+int main(int argc, char** argv) {
+	Indium::init(nullptr, 0, ENABLE_VALIDATION);
+
+	bool ok = true;
+
+	{
+		auto device = Indium::createSystemDefaultDevice();
+
+		bool keepPollingDevice = true;
+
+		std::thread devicePollingThread([device, &keepPollingDevice]() {
+			while (keepPollingDevice) {
+				device->pollEvents(UINT64_MAX);
+			}
+		});
+
+		auto library = device->newLibrary(shader, shader_len);
+
+		Indium::RenderPipelineDescriptor psoDescriptor {};
+		psoDescriptor.vertexFunction = library->newFunction("vertexShader");
+		psoDescriptor.fragmentFunction = library->newFunction("fragmentShader");
+		psoDescriptor.colorAttachments.emplace_back();
+		psoDescriptor.colorAttachments[0].pixelFormat = Indium::PixelFormat::RGBA8Unorm;
+		psoDescriptor.rasterSampleCount = sampleCount;
+
+		auto pipelineState = device->newRenderPipelineState(psoDescriptor);
+		auto commandQueue = device->newCommandQueue();
+
+		// renders a red triangle covering the bottom left half of a `size`-by-`size` target, resolves it into the given level and slice, and checks the result
+		auto renderAndCheck = [&](const std::string& description, uint32_t size, std::shared_ptr<Indium::Texture> resolveTexture, size_t resolveLevel, size_t resolveSlice) {
+			Indium::TextureDescriptor multisampleDescriptor {};
+			multisampleDescriptor.textureType = Indium::TextureType::e2DMultisample;
+			multisampleDescriptor.pixelFormat = Indium::PixelFormat::RGBA8Unorm;
+			multisampleDescriptor.width = size;
+			multisampleDescriptor.height = size;
+			multisampleDescriptor.sampleCount = sampleCount;
+			multisampleDescriptor.resourceOptions = Indium::ResourceOptions::StorageModeMemoryless;
+			multisampleDescriptor.usage = Indium::TextureUsage::RenderTarget;
+
+			auto multisampleTarget = device->newTexture(multisampleDescriptor);
+			auto readback = device->newBuffer(size * size * sizeof(Color), Indium::ResourceOptions::StorageModeShared);
+
+			float half = size / 2.f;
+			Vertex vertices[] = {
+				{ { -half, -half }, { 0, 0 }, { 1, 0, 0, 1 } },
+				{ {  half, -half }, { 0, 0 }, { 1, 0, 0, 1 } },
+				{ { -half,  half }, { 0, 0 }, { 1, 0, 0, 1 } },
+			};
+			uint32_t viewportSize[2] = { size, size };
+
+			auto commandBuffer = commandQueue->commandBuffer();
+
+			Indium::RenderPassDescriptor renderPassDescriptor {};
+			renderPassDescriptor.colorAttachments.emplace_back();
+			renderPassDescriptor.colorAttachments[0].texture = multisampleTarget;
+			renderPassDescriptor.colorAttachments[0].resolveTexture = resolveTexture;
+			renderPassDescriptor.colorAttachments[0].resolveLevel = resolveLevel;
+			renderPassDescriptor.colorAttachments[0].resolveSlice = resolveSlice;
+			renderPassDescriptor.colorAttachments[0].loadAction = Indium::LoadAction::Clear;
+			renderPassDescriptor.colorAttachments[0].storeAction = Indium::StoreAction::MultisampleResolve;
+			renderPassDescriptor.colorAttachments[0].clearColor = Indium::ClearColor(0, 0, 0, 1);
+
+			auto renderEncoder = commandBuffer->renderCommandEncoder(renderPassDescriptor);
+
+			renderEncoder->setViewport(Indium::Viewport { 0, 0, static_cast<double>(size), static_cast<double>(size), 0, 1 });
+			renderEncoder->setRenderPipelineState(pipelineState);
+			renderEncoder->setVertexBytes(vertices, sizeof(vertices), 0);
+			renderEncoder->setVertexBytes(viewportSize, sizeof(viewportSize), 1);
+			renderEncoder->drawPrimitives(Indium::PrimitiveType::Triangle, 0, 3);
+			renderEncoder->endEncoding();
+
+			auto blitEncoder = commandBuffer->blitCommandEncoder();
+			blitEncoder->copy(resolveTexture, resolveSlice, resolveLevel, Indium::Origin { 0, 0, 0 }, Indium::Size { size, size, 1 }, readback, 0, size * sizeof(Color), size * size * sizeof(Color));
+			blitEncoder->endEncoding();
+
+			commandBuffer->commit();
+			commandBuffer->waitUntilCompleted();
+
+			auto pixels = static_cast<const Color*>(readback->contents());
+			auto pixel = [&](uint32_t x, uint32_t y) {
+				return pixels[y * size + x];
+			};
+
+			// the render target's rows go from top to bottom
+			auto inside = pixel(size / 8, size - 1 - size / 8);
+			auto outside = pixel(size - 1 - size / 8, size / 8);
+
+			if (inside.red != 255 || inside.alpha != 255) {
+				std::cerr << "Resolve ERROR (" << description << "): pixel inside the triangle has red=" << (int)inside.red << " alpha=" << (int)inside.alpha << std::endl;
+				ok = false;
+			}
+
+			if (outside.red != 0 || outside.alpha != 255) {
+				std::cerr << "Resolve ERROR (" << description << "): pixel outside the triangle has red=" << (int)outside.red << " alpha=" << (int)outside.alpha << std::endl;
+				ok = false;
+			}
+
+			// pixels that the edge passes through are only partially covered, so resolving them has to average their samples
+			bool foundPartialCoverage = false;
+			for (uint32_t i = 0; i < size; ++i) {
+				auto red = pixel(i, i).red;
+				if (red > 0 && red < 255) {
+					foundPartialCoverage = true;
+					break;
+				}
+			}
+
+			if (!foundPartialCoverage) {
+				std::cerr << "Resolve ERROR (" << description << "): no partially covered pixels along the edge of the triangle" << std::endl;
+				ok = false;
+			}
+		};
+
+		Indium::TextureDescriptor resolveDescriptor {};
+		resolveDescriptor.pixelFormat = Indium::PixelFormat::RGBA8Unorm;
+		resolveDescriptor.width = baseSize;
+		resolveDescriptor.height = baseSize;
+		resolveDescriptor.resourceOptions = Indium::ResourceOptions::StorageModePrivate;
+		resolveDescriptor.usage = Indium::TextureUsage::RenderTarget | Indium::TextureUsage::ShaderRead;
+
+		renderAndCheck("2D texture", baseSize, device->newTexture(resolveDescriptor), 0, 0);
+
+		// level 1 of this is half the size of the base level
+		Indium::TextureDescriptor arrayDescriptor = resolveDescriptor;
+		arrayDescriptor.textureType = Indium::TextureType::e2DArray;
+		arrayDescriptor.arrayLength = 2;
+		arrayDescriptor.mipmapLevelCount = 2;
+
+		renderAndCheck("2D array texture, level 1, slice 1", baseSize / 2, device->newTexture(arrayDescriptor), 1, 1);
+
+		if (ok) {
+			std::cout << "Resolved textures as expected" << std::endl;
+		}
+
+		keepPollingDevice = false;
+		device->wakeupEventLoop();
+		devicePollingThread.join();
+	}
+
+	Indium::finit();
+
+	std::cout << "Execution finished" << std::endl;
+
+	return ok ? 0 : 1;
+};
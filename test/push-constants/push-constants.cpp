@@ -0,0 +1,147 @@
+#include "scale.h"
+
+#include <indium/indium.hpp>
+
+#include <thread>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+#include <cmath>
+#include <cstdlib>
+
+#ifndef ENABLE_VALIDATION
+	#define ENABLE_VALIDATION (!!getenv("INDIUM_TEST_VALIDATION"))
+#endif
+
+// this runs a kernel whose `parameters` are passed by value in the push constant block,
+// once with the parameters set with setBytes() (which goes straight into the push constants)
+// and once with them in a buffer (which the kernel has to read through the buffer's address instead).
+
+struct ScaleParameters {
+	float scale;
+	float bias;
+};
+
+static constexpr unsigned int threadsPerDispatch = 64;
+// 256 bytes is the largest buffer offset alignment a device can require
+static constexpr unsigned int dispatchStride = 256 / sizeof(float);
+
+static const ScaleParameters byteParameters[] = {
+	{ 2.0f, 1.0f },
+	{ -0.5f, 3.0f },
+};
+
+static const ScaleParameters bufferParameters[] = {
+	{ 4.0f, -2.0f },
+	{ 0.25f, 0.5f },
+};
+
+static constexpr unsigned int byteParameterCount = sizeof(byteParameters) / sizeof(ScaleParameters);
+static constexpr unsigned int bufferParameterCount = sizeof(bufferParameters) / sizeof(ScaleParameters);
+static constexpr unsigned int dispatchCount = byteParameterCount + bufferParameterCount;
+static constexpr unsigned int arrayLength = dispatchCount * dispatchStride;
+static constexpr unsigned int bufferSize = arrayLength * sizeof(float);
+
+int main(int argc, char** argv) {
+	Indium::init(nullptr, 0, ENABLE_VALIDATION);
+
+	bool ok = true;
+
+	{
+		auto device = Indium::createSystemDefaultDevice();
+
+		bool keepPollingDevice = true;
+
+		std::thread devicePollingThread([device, &keepPollingDevice]() {
+			while (keepPollingDevice) {
+				device->pollEvents(UINT64_MAX);
+			}
+		});
+
+		auto lib = device->newLibrary(compute_scale, compute_scale_len);
+		auto func = lib->newFunction("scale_bias");
+
+		auto pso = device->newComputePipelineState(func);
+		auto commandQueue = device->newCommandQueue();
+
+		auto bufInput = device->newBuffer(bufferSize, Indium::ResourceOptions::StorageModeShared);
+		auto bufOutput = device->newBuffer(bufferSize, Indium::ResourceOptions::StorageModeShared);
+		auto bufParameters = device->newBuffer(bufferParameterCount * 256, Indium::ResourceOptions::StorageModeShared);
+
+		auto input = static_cast<float*>(bufInput->contents());
+		auto output = static_cast<float*>(bufOutput->contents());
+
+		for (size_t i = 0; i < arrayLength; ++i) {
+			input[i] = (float)rand() / (float)RAND_MAX;
+			output[i] = -1;
+		}
+
+		// each set of parameters is placed at a separate 256-byte offset
+		for (size_t i = 0; i < bufferParameterCount; ++i) {
+			*reinterpret_cast<ScaleParameters*>(static_cast<char*>(bufParameters->contents()) + (i * 256)) = bufferParameters[i];
+		}
+
+		auto cmdbuf = commandQueue->commandBuffer();
+		auto encoder = cmdbuf->computeCommandEncoder();
+
+		encoder->setComputePipelineState(pso);
+		encoder->setBuffer(bufInput, 0, 0);
+
+		std::vector<ScaleParameters> expectedParameters;
+		size_t dispatchIndex = 0;
+
+		auto dispatch = [&](const ScaleParameters& parameters) {
+			size_t offset = dispatchIndex * dispatchStride * sizeof(float);
+			encoder->setBufferOffset(offset, 0);
+			encoder->setBuffer(bufOutput, offset, 1);
+			encoder->dispatchThreadgroups(Indium::Size { 1, 1, 1 }, Indium::Size { threadsPerDispatch, 1, 1 });
+			expectedParameters.push_back(parameters);
+			++dispatchIndex;
+		};
+
+		for (auto& parameters: byteParameters) {
+			encoder->setBytes(&parameters, sizeof(parameters), 2);
+			dispatch(parameters);
+		}
+
+		for (size_t i = 0; i < bufferParameterCount; ++i) {
+			encoder->setBuffer(bufParameters, i * 256, 2);
+			dispatch(bufferParameters[i]);
+		}
+
+		encoder->endEncoding();
+		cmdbuf->commit();
+		cmdbuf->waitUntilCompleted();
+
+		for (size_t dispatchIndex = 0; dispatchIndex < dispatchCount; ++dispatchIndex) {
+			auto& parameters = expectedParameters[dispatchIndex];
+
+			for (size_t thread = 0; thread < threadsPerDispatch; ++thread) {
+				size_t i = dispatchIndex * dispatchStride + thread;
+				float expected = input[i] * parameters.scale + parameters.bias;
+
+				// the multiply and add may be fused on the GPU
+				if (std::abs(output[i] - expected) > 1e-5f) {
+					std::cerr << "Compute ERROR: dispatch=" << dispatchIndex << " index=" << i << " result=" << output[i] << " vs " << expected << "=input*scale+bias" << std::endl;
+					ok = false;
+					break;
+				}
+			}
+		}
+
+		if (ok) {
+			std::cout << "Compute results as expected" << std::endl;
+		}
+
+		keepPollingDevice = false;
+		device->wakeupEventLoop();
+		devicePollingThread.join();
+	}
+
+	Indium::finit();
+
+	std::cout << "Execution finished" << std::endl;
+
+	return ok ? 0 : 1;
+};
@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+
+# wraps AIR bitcode (e.g. from `llvm-as scale.ll`) in a single-function metallib, laid out the same way as the ones the Metal toolchain produces.
+#
+# usage: build-metallib.py <bitcode> <function name> <vertex|fragment|kernel> <output>
+
+import hashlib
+import struct
+import sys
+
+def tag(name, data):
+	return name + struct.pack('<H', len(data)) + data
+
+def main():
+	bitcodePath, functionName, functionType, outputPath = sys.argv[1:5]
+
+	with open(bitcodePath, 'rb') as file:
+		bitcode = file.read()
+
+	# the bitcode wrapper header (magic, version, offset, size, CPU type); `llvm-as` already adds this for Apple targets
+	if bitcode[:4] != struct.pack('<I', 0x0b17c0de):
+		bitcode = struct.pack('<5I', 0x0b17c0de, 0, 20, len(bitcode), 0xffffffff) + bitcode
+
+	typeCode = { 'vertex': 0, 'fragment': 1, 'kernel': 2 }[functionType]
+
+	tags = b''.join([
+		tag(b'NAME', functionName.encode() + b'\0'),
+		tag(b'TYPE', struct.pack('<B', typeCode)),
+		tag(b'HASH', hashlib.sha256(bitcode).digest()),
+		tag(b'MDSZ', struct.pack('<Q', len(bitcode))),
+		# public metadata, private metadata, and bitcode offsets (relative to their sections)
+		tag(b'OFFT', struct.pack('<3Q', 0, 0, 0)),
+		tag(b'VERS', struct.pack('<4H', 2, 2, 2, 2)),
+		b'ENDT',
+	])
+
+	# the group size includes itself
+	functionList = struct.pack('<I', 1) + struct.pack('<I', len(tags) + 4) + tags
+	extendedHeader = b'ENDT'
+	metadata = struct.pack('<I', 4) + b'ENDT'
+
+	headerSize = 88
+	functionListOffset = headerSize
+	functionListSize = len(functionList) - 4
+	publicMetadataOffset = functionListOffset + len(functionList) + len(extendedHeader)
+	privateMetadataOffset = publicMetadataOffset + len(metadata)
+	bitcodeOffset = privateMetadataOffset + len(metadata)
+	fileSize = bitcodeOffset + len(bitcode)
+
+	# magic, platform (macOS), file version 1.2, executable, then the target OS and its version (unspecified)
+	header = b'MTLB' + struct.pack('<HHHBBHH', 0x8001, 2, 4, 0, 0, 0, 0)
+	header += struct.pack('<9Q',
+		fileSize,
+		functionListOffset, functionListSize,
+		publicMetadataOffset, len(metadata),
+		privateMetadataOffset, len(metadata),
+		bitcodeOffset, len(bitcode),
+	)
+	assert len(header) == headerSize
+
+	with open(outputPath, 'wb') as file:
+		file.write(header + functionList + extendedHeader + metadata + metadata + bitcode)
+
+if __name__ == '__main__':
+	main()
@@ -0,0 +1,58 @@
+; AIR for scale.metal, in the form the Metal compiler emits it.
+; scale.metallib is built from this with `llvm-as` and `build-metallib.py` (in this directory),
+; so the test doesn't need the Metal toolchain to be rebuilt.
+
+source_filename = "scale_bias"
+target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v16:16:16-v24:32:32-v32:32:32-v48:64:64-v64:64:64-v96:128:128-v128:128:128-v192:256:256-v256:256:256-v512:512:512-v1024:1024:1024-n8:16:32"
+target triple = "air64-apple-macosx10.15.0"
+
+%struct.ScaleParameters = type { float, float }
+
+; Function Attrs: norecurse nounwind
+define void @scale_bias(float addrspace(1)* noalias nocapture readonly %0, float addrspace(1)* noalias nocapture %1, %struct.ScaleParameters addrspace(2)* noalias nocapture readonly dereferenceable(8) %2, i32 %3) local_unnamed_addr #0 {
+  %5 = zext i32 %3 to i64
+  %6 = getelementptr inbounds float, float addrspace(1)* %0, i64 %5
+  %7 = load float, float addrspace(1)* %6, align 4, !tbaa !16
+  %8 = getelementptr inbounds %struct.ScaleParameters, %struct.ScaleParameters addrspace(2)* %2, i64 0, i32 0
+  %9 = load float, float addrspace(2)* %8, align 4, !tbaa !20
+  %10 = getelementptr inbounds %struct.ScaleParameters, %struct.ScaleParameters addrspace(2)* %2, i64 0, i32 1
+  %11 = load float, float addrspace(2)* %10, align 4, !tbaa !22
+  %12 = fmul fast float %9, %7
+  %13 = fadd fast float %12, %11
+  %14 = getelementptr inbounds float, float addrspace(1)* %1, i64 %5
+  store float %13, float addrspace(1)* %14, align 4, !tbaa !16
+  ret void
+}
+
+attributes #0 = { norecurse nounwind "correctly-rounded-divide-sqrt-fp-math"="false" "disable-tail-calls"="false" "frame-pointer"="all" "less-precise-fpmad"="false" "no-infs-fp-math"="true" "no-jump-tables"="false" "no-nans-fp-math"="true" "no-signed-zeros-fp-math"="true" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "unsafe-fp-math"="true" "use-soft-float"="false" }
+
+!llvm.module.flags = !{!0, !1}
+!llvm.ident = !{!2}
+!air.version = !{!3}
+!air.language_version = !{!4}
+!air.compile_options = !{!5, !6, !7}
+!air.kernel = !{!8}
+
+!0 = !{i32 2, !"SDK Version", [3 x i32] [i32 10, i32 15, i32 6]}
+!1 = !{i32 1, !"wchar_size", i32 4}
+!2 = !{!"Apple LLVM version 902.14 (metalfe-902.14.12)"}
+!3 = !{i32 2, i32 2, i32 0}
+!4 = !{!"Metal", i32 2, i32 2, i32 0}
+!5 = !{!"air.compile.denorms_disable"}
+!6 = !{!"air.compile.fast_math_enable"}
+!7 = !{!"air.compile.framebuffer_fetch_disable"}
+!8 = !{void (float addrspace(1)*, float addrspace(1)*, %struct.ScaleParameters addrspace(2)*, i32)* @scale_bias, !9, !10}
+!9 = !{}
+!10 = !{!11, !12, !13, !15}
+!11 = !{i32 0, !"air.buffer", !"air.location_index", i32 0, i32 1, !"air.read", !"air.arg_type_size", i32 4, !"air.arg_type_align_size", i32 4, !"air.arg_type_name", !"float", !"air.arg_name", !"input"}
+!12 = !{i32 1, !"air.buffer", !"air.location_index", i32 1, i32 1, !"air.read_write", !"air.arg_type_size", i32 4, !"air.arg_type_align_size", i32 4, !"air.arg_type_name", !"float", !"air.arg_name", !"output"}
+!13 = !{i32 2, !"air.buffer", !"air.buffer_size", i32 8, !"air.location_index", i32 2, i32 1, !"air.read", !"air.struct_type_info", !14, !"air.arg_type_size", i32 8, !"air.arg_type_align_size", i32 4, !"air.arg_type_name", !"ScaleParameters", !"air.arg_name", !"parameters"}
+!14 = !{i32 0, i32 4, i32 0, !"float", !"scale", i32 4, i32 4, i32 0, !"float", !"bias"}
+!15 = !{i32 3, !"air.thread_position_in_grid", !"air.arg_type_name", !"uint", !"air.arg_name", !"index"}
+!16 = !{!17, !17, i64 0}
+!17 = !{!"float", !18, i64 0}
+!18 = !{!"omnipotent char", !19, i64 0}
+!19 = !{!"Simple C++ TBAA"}
+!20 = !{!21, !17, i64 0}
+!21 = !{!"_ZTS15ScaleParameters", !17, i64 0, !17, i64 4}
+!22 = !{!21, !17, i64 4}
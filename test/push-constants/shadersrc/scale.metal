@@ -0,0 +1,16 @@
+#include <metal_stdlib>
+using namespace metal;
+
+struct ScaleParameters {
+	float scale;
+	float bias;
+};
+
+// `parameters` is small enough to be passed by value in the push constant block
+kernel void scale_bias(device const float* input [[buffer(0)]],
+                       device float* output [[buffer(1)]],
+                       constant ScaleParameters& parameters [[buffer(2)]],
+                       uint index [[thread_position_in_grid]])
+{
+	output[index] = input[index] * parameters.scale + parameters.bias;
+}
@@ -0,0 +1,189 @@
+#include "AAPLShaders.h"
+
+#include <indium/indium.private.hpp>
+
+#include <thread>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+#include <cstdint>
+#include <cstdlib>
+
+#ifndef ENABLE_VALIDATION
+	#define ENABLE_VALIDATION (!!getenv("INDIUM_TEST_VALIDATION"))
+#endif
+
+// this draws quads of known sizes (with nothing to occlude them) while recording visibility results, including an offset that's used twice in the same pass
+// (whose results have to be added together) and one that isn't used at all (which has to be left alone).
+
+// equivalent to AAPLVertex in the triangle test's shaders (the color is 16-byte aligned)
+struct Vertex {
+	float position[2];
+	float padding[2];
+	float color[4];
+};
+
+static constexpr uint32_t renderTargetSize = 64;
+static constexpr size_t quadVertexCount = 6;
+static constexpr uint64_t untouched = 0xdeadbeefcafef00d;
+
+// positions are in pixels from the center of the render target (with Y pointing up)
+static std::vector<Vertex> quad(float left, float bottom, float size) {
+	float corners[quadVertexCount][2] = {
+		{ left + size, bottom }, { left, bottom }, { left, bottom + size },
+		{ left + size, bottom }, { left, bottom + size }, { left + size, bottom + size },
+	};
+
+	std::vector<Vertex> vertices(quadVertexCount);
+	for (size_t i = 0; i < quadVertexCount; ++i) {
+		vertices[i] = Vertex { { corners[i][0], corners[i][1] }, { 0, 0 }, { 1, 1, 1, 1 } };
+	}
+	return vertices;
+};
+
+int main(int argc, char** argv) {
+	Indium::init(nullptr, 0, ENABLE_VALIDATION);
+
+	bool ok = true;
+
+	{
+		auto device = Indium::createSystemDefaultDevice();
+
+		bool keepPollingDevice = true;
+
+		std::thread devicePollingThread([device, &keepPollingDevice]() {
+			while (keepPollingDevice) {
+				device->pollEvents(UINT64_MAX);
+			}
+		});
+
+		auto features = std::dynamic_pointer_cast<Indium::PrivateDevice>(device)->features();
+
+		if (!(features & Indium::PrivateDevice::Feature::HostQueryReset)) {
+			std::cout << "Visibility results aren't supported on this device; skipping" << std::endl;
+		} else {
+			// without precise occlusion queries, we can only check whether anything was visible
+			bool counting = !!(features & Indium::PrivateDevice::Feature::PreciseOcclusionQuery);
+			auto mode = counting ? Indium::VisibilityResultMode::Counting : Indium::VisibilityResultMode::Boolean;
+
+			auto library = device->newLibrary(shader, shader_len);
+
+			Indium::RenderPipelineDescriptor psoDescriptor {};
+			psoDescriptor.vertexFunction = library->newFunction("vertexShader");
+			psoDescriptor.fragmentFunction = library->newFunction("fragmentShader");
+			psoDescriptor.colorAttachments.emplace_back();
+			psoDescriptor.colorAttachments[0].pixelFormat = Indium::PixelFormat::RGBA8Unorm;
+
+			auto pipelineState = device->newRenderPipelineState(psoDescriptor);
+			auto commandQueue = device->newCommandQueue();
+
+			Indium::TextureDescriptor renderTargetDescriptor {};
+			renderTargetDescriptor.pixelFormat = Indium::PixelFormat::RGBA8Unorm;
+			renderTargetDescriptor.width = renderTargetSize;
+			renderTargetDescriptor.height = renderTargetSize;
+			renderTargetDescriptor.resourceOptions = Indium::ResourceOptions::StorageModePrivate;
+			renderTargetDescriptor.usage = Indium::TextureUsage::RenderTarget;
+
+			auto renderTarget = device->newTexture(renderTargetDescriptor);
+
+			static constexpr size_t resultCount = 5;
+			auto visibilityResults = device->newBuffer(resultCount * sizeof(uint64_t), Indium::ResourceOptions::StorageModeShared);
+			auto results = static_cast<uint64_t*>(visibilityResults->contents());
+
+			for (size_t i = 0; i < resultCount; ++i) {
+				results[i] = untouched;
+			}
+
+			auto fullQuad = quad(-32, -32, 64);
+			auto outsideQuad = quad(64, 64, 16);
+			auto topLeft = quad(-32, 0, 32);
+			auto topRight = quad(0, 0, 32);
+			auto bottomLeft = quad(-32, -32, 32);
+
+			auto commandBuffer = commandQueue->commandBuffer();
+
+			Indium::RenderPassDescriptor renderPassDescriptor {};
+			renderPassDescriptor.colorAttachments.emplace_back();
+			renderPassDescriptor.colorAttachments[0].texture = renderTarget;
+			renderPassDescriptor.colorAttachments[0].loadAction = Indium::LoadAction::Clear;
+			renderPassDescriptor.colorAttachments[0].storeAction = Indium::StoreAction::Store;
+			renderPassDescriptor.visibilityResultBuffer = visibilityResults;
+
+			auto renderEncoder = commandBuffer->renderCommandEncoder(renderPassDescriptor);
+
+			uint32_t viewportSize[2] = { renderTargetSize, renderTargetSize };
+
+			renderEncoder->setViewport(Indium::Viewport { 0, 0, static_cast<double>(renderTargetSize), static_cast<double>(renderTargetSize), 0, 1 });
+			renderEncoder->setRenderPipelineState(pipelineState);
+			renderEncoder->setVertexBytes(viewportSize, sizeof(viewportSize), 1);
+
+			auto draw = [&](const std::vector<Vertex>& vertices) {
+				renderEncoder->setVertexBytes(vertices.data(), sizeof(Vertex) * vertices.size(), 0);
+				renderEncoder->drawPrimitives(Indium::PrimitiveType::Triangle, 0, vertices.size());
+			};
+
+			// offset 0: the whole render target
+			renderEncoder->setVisibilityResultMode(mode, 0);
+			draw(fullQuad);
+
+			// offset 8: nothing (the quad is outside the viewport)
+			renderEncoder->setVisibilityResultMode(mode, 8);
+			draw(outsideQuad);
+
+			// offsets 16 and 24: two quarters and one quarter, with offset 16 used twice
+			renderEncoder->setVisibilityResultMode(mode, 16);
+			draw(topLeft);
+			renderEncoder->setVisibilityResultMode(mode, 24);
+			draw(topRight);
+			renderEncoder->setVisibilityResultMode(mode, 16);
+			draw(bottomLeft);
+
+			// draws with visibility results disabled don't count towards anything
+			renderEncoder->setVisibilityResultMode(Indium::VisibilityResultMode::Disabled, 0);
+			draw(fullQuad);
+
+			// offset 32 is never used
+
+			renderEncoder->endEncoding();
+			commandBuffer->commit();
+			commandBuffer->waitUntilCompleted();
+
+			uint64_t quarter = (renderTargetSize / 2) * (renderTargetSize / 2);
+
+			auto checkResult = [&](size_t offset, uint64_t expectedCount) {
+				auto actual = results[offset / sizeof(uint64_t)];
+				bool matches = counting ? (actual == expectedCount) : ((actual != 0) == (expectedCount != 0));
+
+				if (!matches) {
+					std::cerr << "Visibility ERROR: offset=" << offset << " result=" << actual << " vs " << expectedCount << (counting ? "" : " (boolean)") << std::endl;
+					ok = false;
+				}
+			};
+
+			checkResult(0, quarter * 4);
+			checkResult(8, 0);
+			checkResult(16, quarter * 2);
+			checkResult(24, quarter);
+
+			if (results[4] != untouched) {
+				std::cerr << "Visibility ERROR: the unused offset was overwritten with " << results[4] << std::endl;
+				ok = false;
+			}
+
+			if (ok) {
+				std::cout << "Visibility results as expected (" << (counting ? "counting" : "boolean") << ")" << std::endl;
+			}
+		}
+
+		keepPollingDevice = false;
+		device->wakeupEventLoop();
+		devicePollingThread.join();
+	}
+
+	Indium::finit();
+
+	std::cout << "Execution finished" << std::endl;
+
+	return ok ? 0 : 1;
+};